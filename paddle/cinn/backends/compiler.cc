@@ -14,8 +14,13 @@
 
 #include "paddle/cinn/backends/compiler.h"
 
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/Host.h>
 #include <sys/stat.h>
 #include <fstream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
 
 #include "paddle/cinn/backends/llvm/runtime_symbol_registry.h"
 #include "paddle/cinn/common/context.h"
@@ -67,6 +72,26 @@ bool MakeDirectory(const std::string& dirname, mode_t mode) {
   }
   return true;
 }
+
+#ifdef CINN_WITH_CUDA
+// The compute capability of a device, cudaDeviceGetAttribute is called once
+// per device.
+std::string ComputeCapability(int device) {
+  static std::mutex mutex;
+  static std::unordered_map<int, std::string> capabilities;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto iter = capabilities.find(device);
+  if (iter == capabilities.end()) {
+    int major = 0, minor = 0;
+    cudaDeviceGetAttribute(&major, cudaDevAttrComputeCapabilityMajor, device);
+    cudaDeviceGetAttribute(&minor, cudaDevAttrComputeCapabilityMinor, device);
+    iter = capabilities
+               .emplace(device, std::to_string(major) + std::to_string(minor))
+               .first;
+  }
+  return iter->second;
+}
+#endif
 }  // namespace
 
 namespace cinn {
@@ -319,11 +344,19 @@ void Compiler::RegisterCudaModuleSymbol() {
   auto ptx = compiler(source_code);
   CHECK(!ptx.empty()) << "Compile PTX failed from source code:\n"
                       << source_code;
+  LoadCudaModule(ptx, compiler.compile_to_cubin());
+#else
+  CINN_NOT_IMPLEMENTED
+#endif
+}
+
+void Compiler::LoadCudaModule(const std::string& device_code, bool is_cubin) {
+#ifdef CINN_WITH_CUDA
   using runtime::cuda::CUDAModule;
-  cuda_module_.reset(new CUDAModule(ptx,
-                                    compiler.compile_to_cubin()
-                                        ? CUDAModule::Kind::CUBIN
-                                        : CUDAModule::Kind::PTX));
+  device_code_ = device_code;
+  device_code_is_cubin_ = is_cubin;
+  cuda_module_.reset(new CUDAModule(
+      device_code, is_cubin ? CUDAModule::Kind::CUBIN : CUDAModule::Kind::PTX));
 
   RuntimeSymbols symbols;
   for (const auto& kernel_fn_name : device_fn_name_) {
@@ -339,6 +372,45 @@ void Compiler::RegisterCudaModuleSymbol() {
 #endif
 }
 
+std::unique_ptr<Compiler> Compiler::Create(const Target& target,
+                                           const CompiledCode& code) {
+  std::unique_ptr<Compiler> compiler(new Compiler(target));
+  // the host code refers to the kernels by symbols the device module defines
+  if (!code.device_fn_names.empty()) {
+    compiler->device_fn_name_ = code.device_fn_names;
+    compiler->LoadCudaModule(code.device_code, code.device_code_is_cubin);
+  }
+  compiler->engine_->AddObjectCode(code.host_object);
+  return compiler;
+}
+
+std::string Compiler::CodeVersion(const Target& target) {
+  std::stringstream ss;
+  ss << target << ";llvm=" << LLVM_VERSION_STRING
+     << ";cpu=" << llvm::sys::getHostCPUName().str();
+#ifdef CINN_WITH_CUDA
+  // the kernels are built for the current device
+  int device = 0;
+  cudaGetDevice(&device);
+  ss << ";cuda=" << CUDA_VERSION << ";sm=" << ComputeCapability(device);
+#endif
+  return ss.str();
+}
+
+CompiledCode Compiler::ExportCompiledCode() const {
+  CompiledCode code;
+  code.host_object = engine_->GetSelfObjectCode();
+  PADDLE_ENFORCE_EQ(code.host_object.empty(),
+                    false,
+                    ::common::errors::PreconditionNotMet(
+                        "The host module is not compiled yet, please call "
+                        "EndCompile and Lookup before exporting it."));
+  code.device_code = device_code_;
+  code.device_code_is_cubin = device_code_is_cubin_;
+  code.device_fn_names = device_fn_name_;
+  return code;
+}
+
 void Compiler::CompileCudaModule(const Module& module,
                                  const std::string& code) {
 #ifdef CINN_WITH_CUDA
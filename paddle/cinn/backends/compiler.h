@@ -94,12 +94,37 @@ class SourceCodePrint {
   std::mutex mtx_;
 };
 
+/**
+ * Everything a Compiler produced for its modules, enough to load them in
+ * another process without compiling again.
+ */
+struct CompiledCode {
+  // object code of the host module
+  std::string host_object;
+  // ptx or cubin of the device module, empty on X86
+  std::string device_code;
+  bool device_code_is_cubin{false};
+  std::vector<std::string> device_fn_names;
+};
+
 class Compiler final {
  public:
   static std::unique_ptr<Compiler> Create(const Target& target) {
     return std::unique_ptr<Compiler>(new Compiler(target));
   }
 
+  /**
+   * Create a compiler that holds code exported by ExportCompiledCode.
+   */
+  static std::unique_ptr<Compiler> Create(const Target& target,
+                                          const CompiledCode& code);
+
+  /**
+   * Identify the compilers and the devices code of this process is valid
+   * for, which differs once LLVM, CUDA or the device change.
+   */
+  static std::string CodeVersion(const Target& target);
+
   /**
    * Compile and link to a CINN module.
    */
@@ -125,12 +150,20 @@ class Compiler final {
 
   std::vector<void*> GetFnPtr() const { return fn_ptr_; }
 
+  /**
+   * Export the compiled code, which requires EndCompile and a Lookup
+   * before.
+   */
+  CompiledCode ExportCompiledCode() const;
+
  private:
   // do not register device symbol until end=true for build fucntion
   void RegisterDeviceModuleSymbol();
 
   void RegisterCudaModuleSymbol();
 
+  void LoadCudaModule(const std::string& device_code, bool is_cubin);
+
   void CompileCudaModule(const ir::Module& module,
                          const std::string& code = "");
 
@@ -151,6 +184,9 @@ class Compiler final {
   // only heterogeneous systems need to record device func and module
   std::vector<std::string> device_fn_name_;
   std::string device_fn_code_;
+  // ptx or cubin compiled from device_fn_code_
+  std::string device_code_;
+  bool device_code_is_cubin_{false};
 #ifdef CINN_WITH_CUDA
   std::unique_ptr<runtime::cuda::CUDAModule> cuda_module_;
 #endif
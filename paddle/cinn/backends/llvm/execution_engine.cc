@@ -107,6 +107,15 @@ std::unique_ptr<llvm::MemoryBuffer> NaiveObjectCache::getObject(
   return llvm::MemoryBuffer::getMemBuffer(it->second->getMemBufferRef());
 }
 
+std::string NaiveObjectCache::GetObjectCode(
+    const std::string &module_id) const {
+  auto it = cached_objects_.find(module_id);
+  if (it == cached_objects_.end()) {
+    return "";
+  }
+  return it->second->getBuffer().str();
+}
+
 /*static*/ std::unique_ptr<ExecutionEngine> ExecutionEngine::Create(
     const ExecutionOptions &config) {
   VLOG(1) << "===================== Create CINN ExecutionEngine begin "
@@ -240,9 +249,23 @@ void ExecutionEngine::RegisterModuleRuntimeSymbols(
 }
 
 bool ExecutionEngine::AddSelfModule() {
+  self_module_id_ = m->getModuleIdentifier();
   return AddModule(std::move(m), std::move(ctx));
 }
 
+std::string ExecutionEngine::GetSelfObjectCode() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return cache_->GetObjectCode(self_module_id_);
+}
+
+bool ExecutionEngine::AddObjectCode(const std::string &object_code) {
+  utils::RecordEvent("ExecutionEngine AddObjectCode",
+                     utils::EventType::kOrdinary);
+  llvm::cantFail(jit_->addObjectFile(
+      llvm::MemoryBuffer::getMemBufferCopy(AsStringRef(object_code))));
+  return true;
+}
+
 void ExecutionEngine::ExportObject(const std::string &path) {
   FILE *of = fopen(path.c_str(), "w");
   fwrite(buffer_.data(), 1, buffer_.size(), of);
@@ -56,6 +56,10 @@ class NaiveObjectCache : public llvm::ObjectCache {
                             llvm::MemoryBufferRef) override;
   std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *) override;
 
+  // The object code compiled for the module of `module_id`, or an empty
+  // string while it is not compiled yet.
+  std::string GetObjectCode(const std::string &module_id) const;
+
  private:
   llvm::StringMap<std::unique_ptr<llvm::MemoryBuffer>> cached_objects_;
 };
@@ -87,6 +91,14 @@ class ExecutionEngine {
 
   bool AddSelfModule();
 
+  // The object code of the module added by AddSelfModule. LLJIT compiles it
+  // lazily, so it is only there after the first Lookup.
+  std::string GetSelfObjectCode() const;
+
+  // Links object code returned by GetSelfObjectCode of another engine,
+  // possibly of another process, instead of compiling a module.
+  bool AddObjectCode(const std::string &object_code);
+
  protected:
   explicit ExecutionEngine(bool enable_object_cache)
       : cache_(std::make_unique<NaiveObjectCache>()),
@@ -111,6 +123,7 @@ class ExecutionEngine {
   std::unique_ptr<llvm::LLVMContext> ctx;
   std::unique_ptr<llvm::Module> m;
   std::unique_ptr<llvm::IRBuilder<>> b;
+  std::string self_module_id_;
 };
 
 }  // namespace cinn::backends
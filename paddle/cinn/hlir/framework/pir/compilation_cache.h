@@ -39,6 +39,16 @@ class BackendResource final {
     backend_compiler_ = backends::Compiler::Create(target);
   }
 
+  // Wraps a compiler that already holds the compiled functions.
+  BackendResource(const std::shared_ptr<backends::Compiler>& backend_compiler,
+                  const std::string& host_fn_name,
+                  const std::string& infer_fn_name,
+                  const std::map<int, CINNKernelInfo::ArgDimIdx>& int_args_map)
+      : host_fn_name_(host_fn_name),
+        infer_fn_name_(infer_fn_name),
+        int_args_map_(int_args_map),
+        backend_compiler_(backend_compiler) {}
+
   void* GetHostFuncPtr() const;
   void* GetInferFuncPtr() const;
   void* GetCX86HostFuncPtr() const;
@@ -50,6 +60,7 @@ class BackendResource final {
   }
   pir::CINNKernelInfo GenerateKernelInfo() const;
   const std::string& GetHostFuncName() const { return host_fn_name_; }
+  const std::string& GetInferFuncName() const { return infer_fn_name_; }
 
  private:
   std::string host_fn_name_;
@@ -25,6 +25,7 @@ class AttributeInfo {
       : name_(name), attr_(attr) {}
 
   std::size_t hash() const;
+  void Serialize(std::ostream *os) const;
   friend std::ostream &operator<<(std::ostream &os, const AttributeInfo &info);
 
  private:
@@ -37,6 +38,7 @@ class ValueInfo {
   explicit ValueInfo(const ::pir::Value &value) : type_(value.type()) {}
 
   std::size_t hash() const;
+  void Serialize(std::ostream *os) const;
   friend std::ostream &operator<<(std::ostream &os, const ValueInfo &info);
 
  private:
@@ -49,6 +51,7 @@ class OperationInfo {
   explicit OperationInfo(const ::pir::Operation &op);
 
   std::size_t hash() const;
+  void Serialize(std::ostream *os) const;
   friend std::ostream &operator<<(std::ostream &os, const OperationInfo &info);
 
  private:
@@ -68,6 +71,7 @@ class OpDepInfo {
   }
 
   std::size_t hash() const;
+  size_t upstream_index() const { return upstream_index_; }
   friend std::ostream &operator<<(std::ostream &os, const OpDepInfo &info);
 
  private:
@@ -82,6 +86,7 @@ class FusionOpInfo {
       : op_info_(op), inner_deps_(deps) {}
 
   std::size_t hash() const;
+  void Serialize(std::ostream *os) const;
   friend std::ostream &operator<<(std::ostream &os, const FusionOpInfo &info);
 
  private:
@@ -101,6 +106,11 @@ class FusionInfo {
 
   std::size_t hash() const;
 
+  // Unlike hash(), which hashes the addresses of IR storages and thus only
+  // holds within a process, the serialized string is the same for the same
+  // fusion group in every process. It keys the persistent compilation cache.
+  std::string SerializeToString() const;
+
   bool operator==(const FusionInfo &other) const {
     return this->hash() == other.hash();
   }
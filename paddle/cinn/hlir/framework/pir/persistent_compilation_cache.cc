@@ -0,0 +1,369 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/cinn/hlir/framework/pir/persistent_compilation_cache.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "paddle/common/enforce.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/framework/commit.h"
+
+PD_DECLARE_string(cinn_compilation_cache_dir);
+PD_DECLARE_bool(cinn_new_group_scheduler);
+PD_DECLARE_bool(cinn_bucket_compile);
+PD_DECLARE_bool(group_schedule_tiling_first);
+PD_DECLARE_bool(cinn_use_common_subexpression_elimination);
+PD_DECLARE_bool(cinn_enable_map_expr);
+PD_DECLARE_bool(cinn_enable_map_expr_schedule);
+PD_DECLARE_bool(cinn_enable_map_expr_inline);
+PD_DECLARE_bool(cinn_enable_map_expr_dynamic_shape);
+PD_DECLARE_bool(cinn_enable_map_expr_index_detail);
+PD_DECLARE_bool(cinn_bc_branch_optimize);
+PD_DECLARE_bool(cinn_use_cuda_vectorize);
+PD_DECLARE_bool(cinn_use_custom_call);
+PD_DECLARE_bool(cinn_compile_with_nvrtc);
+PD_DECLARE_bool(nvrtc_compile_to_cubin);
+PD_DECLARE_bool(cinn_nvrtc_cubin_with_fmad);
+PD_DECLARE_bool(cinn_use_cutlass);
+PD_DECLARE_bool(cinn_check_tensor_buffer_map);
+PD_DECLARE_bool(cinn_runtime_display_debug_info);
+PD_DECLARE_string(cinn_custom_call_deny_ops);
+PD_DECLARE_string(tile_config_policy);
+PD_DECLARE_string(cinn_tile_config_filename_label);
+PD_DECLARE_string(cinn_x86_builtin_code_root);
+PD_DECLARE_string(cinn_nvcc_cmd_path);
+PD_DECLARE_string(cinn_debug_custom_code_path);
+
+namespace cinn::hlir::framework {
+
+namespace {
+
+constexpr char kEntryMagic[] = "CINNPCC1";
+constexpr size_t kEntryMagicSize = sizeof(kEntryMagic) - 1;
+
+void PutU64(uint64_t value, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void PutString(const std::string& value, std::string* out) {
+  PutU64(value.size(), out);
+  out->append(value);
+}
+
+class EntryReader {
+ public:
+  explicit EntryReader(const std::string& data) : data_(data) {}
+
+  bool GetU64(uint64_t* value) {
+    if (data_.size() - pos_ < sizeof(*value)) return false;
+    memcpy(value, data_.data() + pos_, sizeof(*value));
+    pos_ += sizeof(*value);
+    return true;
+  }
+
+  bool GetInt(int* value) {
+    uint64_t raw;
+    if (!GetU64(&raw)) return false;
+    *value = static_cast<int>(static_cast<int64_t>(raw));
+    return true;
+  }
+
+  bool GetString(std::string* value) {
+    uint64_t size;
+    if (!GetU64(&size) || data_.size() - pos_ < size) return false;
+    value->assign(data_, pos_, size);
+    pos_ += size;
+    return true;
+  }
+
+  bool Done() const { return pos_ == data_.size(); }
+
+ private:
+  const std::string& data_;
+  size_t pos_{kEntryMagicSize};
+};
+
+uint64_t Fnv1a(const std::string& data, uint64_t seed) {
+  uint64_t hash = seed;
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// Other processes may create the same directories at the same time.
+bool MakeDirectories(const std::string& dirname) {
+  for (size_t pos = dirname.find('/', 1); true;
+       pos = dirname.find('/', pos + 1)) {
+    std::string path = dirname.substr(0, pos);
+    if (mkdir(path.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0 &&
+        errno != EEXIST) {
+      return false;
+    }
+    if (pos == std::string::npos) return true;
+  }
+}
+
+std::string CompilerId() {
+#if defined(_MSC_FULL_VER)
+  return "msvc " + std::to_string(_MSC_FULL_VER);
+#elif defined(__VERSION__)
+  return __VERSION__;
+#else
+  return "unknown";
+#endif
+}
+
+// The flags that change the code lowered from the same fusion.
+std::string CodegenFlags() {
+  std::stringstream ss;
+  ss << "new_group_scheduler=" << FLAGS_cinn_new_group_scheduler
+     << ";bucket_compile=" << FLAGS_cinn_bucket_compile
+     << ";tiling_first=" << FLAGS_group_schedule_tiling_first
+     << ";cse=" << FLAGS_cinn_use_common_subexpression_elimination
+     << ";map_expr=" << FLAGS_cinn_enable_map_expr
+     << FLAGS_cinn_enable_map_expr_schedule
+     << FLAGS_cinn_enable_map_expr_inline
+     << FLAGS_cinn_enable_map_expr_dynamic_shape
+     << FLAGS_cinn_enable_map_expr_index_detail
+     << ";bc_branch=" << FLAGS_cinn_bc_branch_optimize
+     << ";cuda_vectorize=" << FLAGS_cinn_use_cuda_vectorize
+     << ";custom_call=" << FLAGS_cinn_use_custom_call << ","
+     << FLAGS_cinn_custom_call_deny_ops
+     << ";nvrtc=" << FLAGS_cinn_compile_with_nvrtc
+     << FLAGS_nvrtc_compile_to_cubin << FLAGS_cinn_nvrtc_cubin_with_fmad
+     << ";cutlass=" << FLAGS_cinn_use_cutlass
+     << ";check_buffer_map=" << FLAGS_cinn_check_tensor_buffer_map
+     << ";debug_info=" << FLAGS_cinn_runtime_display_debug_info
+     << ";tile_config=" << FLAGS_tile_config_policy << ","
+     << FLAGS_cinn_tile_config_filename_label
+     << ";x86_builtin=" << FLAGS_cinn_x86_builtin_code_root
+     << ";nvcc=" << FLAGS_cinn_nvcc_cmd_path
+     << ";custom_code=" << FLAGS_cinn_debug_custom_code_path;
+  return ss.str();
+}
+
+// An entry may only be reused by the same build of paddle, compiled by the
+// same toolchain and lowering with the same flags.
+std::string MakeKey(const pir::FusionInfo& info, const Target& target) {
+  return "version: " + backends::Compiler::CodeVersion(target) +
+         ";commit=" + paddle::framework::paddle_commit() +
+         ";cxx=" + CompilerId() + "\nflags: " + CodegenFlags() + "\n" +
+         info.SerializeToString();
+}
+
+}  // namespace
+
+std::string EncodePersistentCacheEntry(const PersistentCacheEntry& entry) {
+  std::string out(kEntryMagic, kEntryMagicSize);
+  PutString(entry.key, &out);
+  PutString(entry.host_fn_name, &out);
+  PutString(entry.infer_fn_name, &out);
+  PutU64(entry.int_args_map.size(), &out);
+  for (const auto& [arg, dim_idx] : entry.int_args_map) {
+    PutU64(static_cast<int64_t>(arg), &out);
+    PutU64(static_cast<int64_t>(dim_idx.arg_idx), &out);
+    PutU64(static_cast<int64_t>(dim_idx.dim_idx), &out);
+  }
+  PutString(entry.code.host_object, &out);
+  PutString(entry.code.device_code, &out);
+  PutU64(entry.code.device_code_is_cubin ? 1 : 0, &out);
+  PutU64(entry.code.device_fn_names.size(), &out);
+  for (const auto& name : entry.code.device_fn_names) {
+    PutString(name, &out);
+  }
+  return out;
+}
+
+bool DecodePersistentCacheEntry(const std::string& data,
+                                PersistentCacheEntry* entry) {
+  if (data.size() < kEntryMagicSize ||
+      data.compare(0, kEntryMagicSize, kEntryMagic) != 0) {
+    return false;
+  }
+  EntryReader reader(data);
+  uint64_t num_int_args;
+  if (!reader.GetString(&entry->key) ||
+      !reader.GetString(&entry->host_fn_name) ||
+      !reader.GetString(&entry->infer_fn_name) ||
+      !reader.GetU64(&num_int_args)) {
+    return false;
+  }
+  entry->int_args_map.clear();
+  for (uint64_t i = 0; i < num_int_args; ++i) {
+    int arg;
+    pir::CINNKernelInfo::ArgDimIdx dim_idx;
+    if (!reader.GetInt(&arg) || !reader.GetInt(&dim_idx.arg_idx) ||
+        !reader.GetInt(&dim_idx.dim_idx)) {
+      return false;
+    }
+    entry->int_args_map[arg] = dim_idx;
+  }
+  uint64_t is_cubin, num_device_fns;
+  if (!reader.GetString(&entry->code.host_object) ||
+      !reader.GetString(&entry->code.device_code) ||
+      !reader.GetU64(&is_cubin) || !reader.GetU64(&num_device_fns)) {
+    return false;
+  }
+  entry->code.device_code_is_cubin = is_cubin != 0;
+  entry->code.device_fn_names.clear();
+  for (uint64_t i = 0; i < num_device_fns; ++i) {
+    std::string name;
+    if (!reader.GetString(&name)) return false;
+    entry->code.device_fn_names.push_back(std::move(name));
+  }
+  return reader.Done();
+}
+
+bool PersistentCompilationCache::Enabled() const {
+  return !FLAGS_cinn_compilation_cache_dir.empty();
+}
+
+std::string PersistentCompilationCache::EntryPath(
+    const std::string& key) const {
+  char name[64];
+  snprintf(name,
+           sizeof(name),
+           "%016llx%016llx.cinn",
+           static_cast<unsigned long long>(  // NOLINT
+               Fnv1a(key, 14695981039346656037ULL)),
+           static_cast<unsigned long long>(  // NOLINT
+               Fnv1a(key, 0x9e3779b97f4a7c15ULL)));
+  return FLAGS_cinn_compilation_cache_dir + "/" + name;
+}
+
+std::shared_ptr<pir::CompilationResult> PersistentCompilationCache::Load(
+    const pir::FusionInfo& info, const Target& target) {
+  if (!Enabled()) return nullptr;
+  const std::string key = MakeKey(info, target);
+  const std::string path = EntryPath(key);
+
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    VLOG(4) << "Miss in persistent compilation cache: " << path;
+    ++misses_;
+    return nullptr;
+  }
+  std::stringstream ss;
+  ss << file.rdbuf();
+  PersistentCacheEntry entry;
+  if (!DecodePersistentCacheEntry(ss.str(), &entry)) {
+    LOG(WARNING) << "Ignore corrupted persistent compilation cache entry "
+                 << path;
+    ++errors_;
+    ++misses_;
+    return nullptr;
+  }
+  if (entry.key != key) {
+    VLOG(4) << "Hash collision in persistent compilation cache: " << path;
+    ++misses_;
+    return nullptr;
+  }
+
+  auto result = std::make_shared<pir::CompilationResult>(target);
+  try {
+    std::shared_ptr<backends::Compiler> compiler =
+        backends::Compiler::Create(target, entry.code);
+    result->SetBackendResource(
+        std::make_shared<pir::BackendResource>(compiler,
+                                               entry.host_fn_name,
+                                               entry.infer_fn_name,
+                                               entry.int_args_map));
+    // links the object code and checks that the functions are there
+    result->GetKernelInfo();
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Failed to load persistent compilation cache entry "
+                 << path << ": " << e.what();
+    ++errors_;
+    ++misses_;
+    return nullptr;
+  }
+  VLOG(4) << "Hit in persistent compilation cache: " << path;
+  ++hits_;
+  return result;
+}
+
+void PersistentCompilationCache::Store(const pir::FusionInfo& info,
+                                       const Target& target,
+                                       const pir::CompilationResult& result) {
+  if (!Enabled()) return;
+  const std::string key = MakeKey(info, target);
+  const std::string path = EntryPath(key);
+  // written by another process already
+  if (access(path.c_str(), F_OK) == 0) return;
+
+  const auto& backend_resource = result.GetBackendResource();
+  PADDLE_ENFORCE_NOT_NULL(backend_resource,
+                          ::common::errors::PreconditionNotMet(
+                              "Found backend_resource_ is nullptr, please "
+                              "call SetBackendResource first."));
+  PersistentCacheEntry entry;
+  entry.key = key;
+  entry.host_fn_name = backend_resource->GetHostFuncName();
+  entry.infer_fn_name = backend_resource->GetInferFuncName();
+  entry.int_args_map = backend_resource->GetIntArgsMap();
+  entry.code = backend_resource->GetBackendCompiler()->ExportCompiledCode();
+  const std::string data = EncodePersistentCacheEntry(entry);
+
+  static std::atomic<uint64_t> tmp_file_id{0};
+  const std::string tmp_path = path + ".tmp." + std::to_string(getpid()) +
+                               "." + std::to_string(tmp_file_id++);
+  if (!MakeDirectories(FLAGS_cinn_compilation_cache_dir)) {
+    LOG(WARNING) << "Failed to create the persistent compilation cache "
+                 << "directory " << FLAGS_cinn_compilation_cache_dir;
+    ++errors_;
+    return;
+  }
+  std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+  file.write(data.data(), data.size());
+  file.close();
+  if (!file || rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "Failed to write persistent compilation cache entry "
+                 << path;
+    unlink(tmp_path.c_str());
+    ++errors_;
+    return;
+  }
+  VLOG(4) << "Store in persistent compilation cache: " << path;
+  ++stores_;
+}
+
+PersistentCompilationCache::Stats PersistentCompilationCache::GetStats()
+    const {
+  Stats stats;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.stores = stores_;
+  stats.errors = errors_;
+  return stats;
+}
+
+void PersistentCompilationCache::ResetStats() {
+  hits_ = 0;
+  misses_ = 0;
+  stores_ = 0;
+  errors_ = 0;
+}
+
+}  // namespace cinn::hlir::framework
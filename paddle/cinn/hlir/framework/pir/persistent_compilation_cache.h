@@ -0,0 +1,98 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "paddle/cinn/backends/compiler.h"
+#include "paddle/cinn/common/macros.h"
+#include "paddle/cinn/common/target.h"
+#include "paddle/cinn/hlir/framework/pir/compilation_cache.h"
+#include "paddle/cinn/hlir/framework/pir/fusion_info.h"
+
+namespace cinn::hlir::framework {
+
+struct PersistentCacheEntry {
+  std::string key;
+  std::string host_fn_name;
+  std::string infer_fn_name;
+  std::map<int, pir::CINNKernelInfo::ArgDimIdx> int_args_map;
+  backends::CompiledCode code;
+};
+
+std::string EncodePersistentCacheEntry(const PersistentCacheEntry& entry);
+
+// Returns false if `data` is not a complete entry.
+bool DecodePersistentCacheEntry(const std::string& data,
+                                PersistentCacheEntry* entry);
+
+/**
+ * Keeps compiled fusion groups in the directory of
+ * FLAGS_cinn_compilation_cache_dir, so that a new process loads them instead
+ * of compiling them again.
+ *
+ * The key of an entry covers the serialized FusionInfo, the target and the
+ * versions of the compilers and the device. An entry is a file named by a
+ * hash of its key that holds the key itself, so a hash collision reads as a
+ * miss. Writers write a file of their own and rename it into place, which
+ * is atomic: readers take no lock and never see a partial entry, and
+ * concurrent writers of an entry replace one complete file with another.
+ */
+class PersistentCompilationCache {
+ public:
+  struct Stats {
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t stores{0};
+    // unreadable entries and failed writes
+    uint64_t errors{0};
+  };
+
+  static PersistentCompilationCache& Instance() {
+    static PersistentCompilationCache instance;
+    return instance;
+  }
+
+  bool Enabled() const;
+
+  // Returns nullptr on a miss.
+  std::shared_ptr<pir::CompilationResult> Load(const pir::FusionInfo& info,
+                                               const Target& target);
+
+  // Requires the functions of `result` to be compiled, which a
+  // GetKernelInfo does.
+  void Store(const pir::FusionInfo& info,
+             const Target& target,
+             const pir::CompilationResult& result);
+
+  Stats GetStats() const;
+  void ResetStats();
+
+ private:
+  PersistentCompilationCache() = default;
+  CINN_DISALLOW_COPY_AND_ASSIGN(PersistentCompilationCache);
+
+  std::string EntryPath(const std::string& key) const;
+
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+  std::atomic<uint64_t> stores_{0};
+  std::atomic<uint64_t> errors_{0};
+};
+
+}  // namespace cinn::hlir::framework
@@ -15,6 +15,7 @@
 #include "paddle/cinn/hlir/framework/pir_compiler.h"
 #include "paddle/cinn/ir/group_schedule/config/schedule_config_manager.h"
 
+#include "paddle/cinn/hlir/framework/pir/persistent_compilation_cache.h"
 #include "paddle/cinn/hlir/framework/pir/utils.h"
 #include "paddle/cinn/runtime/arch_device.h"
 #include "paddle/cinn/utils/multi_threading.h"
@@ -28,7 +29,8 @@ namespace cinn::hlir::framework {
 class CompilationContextMapper {
  public:
   CompilationContextMapper(const Target& target,
-                           const std::vector<pir::OpLoweringGroupPtr>& groups) {
+                           const std::vector<pir::OpLoweringGroupPtr>& groups)
+      : target_(target) {
     Construct(target, groups);
   }
   std::vector<GroupCompilationContext>& UniqueCompilationContexts() {
@@ -41,11 +43,13 @@ class CompilationContextMapper {
 
   std::vector<pir::CINNKernelInfo> RecoverKernelInfos();
   void UpdateGlobalCache();
+  void UpdatePersistentCache();
   void SetFinalize(bool val) { is_finalized_ = val; }
 
  private:
   void Construct(const Target& target,
                  const std::vector<pir::OpLoweringGroupPtr>& groups);
+  Target target_;
   std::vector<size_t> mapper_index_;
   std::vector<pir::FusionInfo> fusion_infos_;
   std::vector<GroupCompilationContext> group_compilation_contexts_;
@@ -94,6 +98,7 @@ std::vector<pir::CINNKernelInfo> PirCompiler::Build(
   VLOG(5) << "Finished compiling " << task_size << " Cinn Kernel info.";
   ctx_mapper.SetFinalize(true);
   ctx_mapper.UpdateGlobalCache();
+  ctx_mapper.UpdatePersistentCache();
   return ctx_mapper.RecoverKernelInfos();
 }
 
@@ -104,6 +109,13 @@ pir::CINNKernelInfo PirCompiler::BuildBroadcastTree(
   if (CompilationCache::Instance().Has(fusion_info)) {
     return CompilationCache::Instance().GetKernelInfo(fusion_info);
   }
+  auto& persistent_cache = PersistentCompilationCache::Instance();
+  if (FLAGS_enable_cinn_compile_cache && persistent_cache.Enabled()) {
+    if (auto result = persistent_cache.Load(fusion_info, target_)) {
+      CompilationCache::Instance().Insert(fusion_info, result);
+      return result->GetKernelInfo();
+    }
+  }
 
   std::vector<GroupCompilationContext> group_compilation_contexts;
   for (const auto& group : leaf_groups) {
@@ -134,6 +146,9 @@ pir::CINNKernelInfo PirCompiler::BuildBroadcastTree(
         &group_compilation_contexts, shape_idx);
     const auto kernel_info = result->GetKernelInfo();
     CompilationCache::Instance().Insert(fusion_info, result);
+    if (FLAGS_enable_cinn_compile_cache && persistent_cache.Enabled()) {
+      persistent_cache.Store(fusion_info, target_, *result);
+    }
     return kernel_info;
   };
 
@@ -147,11 +162,18 @@ pir::CINNKernelInfo PirCompiler::BuildBroadcastTree(
 void CompilationContextMapper::Construct(
     const Target& target, const std::vector<pir::OpLoweringGroupPtr>& groups) {
   std::unordered_set<size_t> unique_infos;
-  const auto IsNewAndUnique =
-      [&unique_infos](const pir::FusionInfo& info) -> bool {
+  auto& persistent_cache = PersistentCompilationCache::Instance();
+  const auto IsNewAndUnique = [&](const pir::FusionInfo& info) -> bool {
     const bool is_unique = unique_infos.find(info.hash()) == unique_infos.end();
-    const bool is_new = !CompilationCache::Instance().Has(info);
-    return is_new && is_unique;
+    if (!is_unique || CompilationCache::Instance().Has(info)) return false;
+    // A group compiled by an earlier process is as good as a cached one.
+    if (FLAGS_enable_cinn_compile_cache && persistent_cache.Enabled()) {
+      if (auto result = persistent_cache.Load(info, target)) {
+        CompilationCache::Instance().Insert(info, result);
+        return false;
+      }
+    }
+    return true;
   };
 
   for (size_t i = 0; i < groups.size(); ++i) {
@@ -213,4 +235,15 @@ void CompilationContextMapper::UpdateGlobalCache() {
     CompilationCache::Instance().Insert(fusion_info, compilation_results_[i]);
   }
 }
+
+void CompilationContextMapper::UpdatePersistentCache() {
+  auto& persistent_cache = PersistentCompilationCache::Instance();
+  if (!FLAGS_enable_cinn_compile_cache || !persistent_cache.Enabled()) {
+    return;
+  }
+  for (size_t i = 0; i < compilation_results_.size(); ++i) {
+    persistent_cache.Store(
+        fusion_infos_[mapper_index_[i]], target_, *compilation_results_[i]);
+  }
+}
 }  // namespace cinn::hlir::framework
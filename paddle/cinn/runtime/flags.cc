@@ -228,6 +228,11 @@ PD_DEFINE_string(cinn_debug_custom_code_path,
                  StringFromEnv("FLAGS_cinn_debug_custom_code_path", ""),
                  "Specify custom code path for cinn.");
 
+PD_DEFINE_string(cinn_compilation_cache_dir,
+                 StringFromEnv("FLAGS_cinn_compilation_cache_dir", ""),
+                 "Specify the directory where compiled fusion groups are "
+                 "kept for other processes, empty disables it.");
+
 PD_DEFINE_string(cinn_pass_visualize_dir,
                  StringFromEnv("FLAGS_cinn_pass_visualize_dir", ""),
                  "Specify the directory path of pass visualize file of graph, "
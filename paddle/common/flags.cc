@@ -248,6 +248,22 @@ PHI_DEFINE_EXPORTED_int64(
     "operator. The deterministic algorithm may be slower. If "
     "it is larger than 0, the algorithm is deterministic.");
 
+/**
+ * CPU related FLAG
+ * Name: FLAGS_selected_rows_radix_merge_threshold
+ * Since Version: 3.0.0
+ * Value Range: int64, default=65536
+ * Example:
+ * Note: MergeAdd and MergeAverage of SelectedRows on CPU sort the rows with
+ *       a parallel radix sort instead of a hash map when the inputs have at
+ *       least this many rows in total. A negative value disables it.
+ */
+PHI_DEFINE_EXPORTED_int64(
+    selected_rows_radix_merge_threshold,
+    65536,
+    "Merge the rows of SelectedRows on CPU by a parallel radix sort when "
+    "the inputs have at least this many rows. Negative to disable.");
+
 /**
  * CUDNN related FLAG
  * Name: FLAGS_cudnn_exhaustive_search
@@ -374,6 +390,97 @@ PHI_DEFINE_EXPORTED_bool(
 PHI_DEFINE_EXPORTED_int32(communicator_send_queue_size,
                           20,
                           "queue size to recv gradient before send");
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_communicator_sparse_merge_stage
+ * Since Version: 3.0.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: If true, the async communicator merges the queued sparse gradients
+ *       of a variable by key with a hash table instead of MergeVars, encodes
+ *       them as FLAGS_communicator_sparse_push_quant and merges the next
+ *       batch while the push of the previous one is in flight.
+ */
+PHI_DEFINE_EXPORTED_bool(communicator_sparse_merge_stage,
+                         false,
+                         "merge sparse gradients by key and pipeline pushes");
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_communicator_sparse_push_quant
+ * Since Version: 3.0.0
+ * Value Range: string, fp32|fp16|int8, default=fp32
+ * Example:
+ * Note: Encoding of the sparse gradients pushed by the merge stage. fp16 and
+ *       int8 (with a scale per row) keep what a row loses to the encoding
+ *       on the trainer and add it to the next gradient of the same key.
+ *       Only for tables whose push values are gradients.
+ */
+PHI_DEFINE_EXPORTED_string(communicator_sparse_push_quant,
+                           "fp32",
+                           "encoding of the pushed sparse gradients");
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_communicator_sparse_residual_capacity
+ * Since Version: 3.0.0
+ * Value Range: int64, default=1048576
+ * Example:
+ * Note: Most keys whose encoding residual is kept per sparse variable. When
+ *       it is full, the residual of a key not pushed recently is dropped to
+ *       make room for a new key.
+ */
+PHI_DEFINE_EXPORTED_int64(communicator_sparse_residual_capacity,
+                          1 << 20,
+                          "most residual rows kept per sparse variable");
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_gloo_allreduce_bucket_size_mb
+ * Since Version: 3.0.0
+ * Value Range: int32, default=0
+ * Example: FLAGS_gloo_allreduce_bucket_size_mb=25
+ * Note: If positive, ProcessGroupGloo fuses the tensors of an all-reduce, or
+ *       of all the all-reduces between StartCoalescing and EndCoalescing,
+ *       into buckets of at most this many MB and reduces them on background
+ *       threads. 0 reduces every call synchronously with gloo::allreduce.
+ */
+PHI_DEFINE_EXPORTED_int32(gloo_allreduce_bucket_size_mb,
+                          0,
+                          "bucket size of the gloo all-reduce in MB");
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_gloo_allreduce_ring_threshold_kb
+ * Since Version: 3.0.0
+ * Value Range: int32, default=512
+ * Example:
+ * Note: Buckets smaller than this are reduced by halving-doubling when the
+ *       number of ranks is a power of two, larger ones by the ring.
+ */
+PHI_DEFINE_EXPORTED_int32(gloo_allreduce_ring_threshold_kb,
+                          512,
+                          "smallest gloo all-reduce bucket to use the ring");
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_gloo_allreduce_chunk_kb
+ * Since Version: 3.0.0
+ * Value Range: int32, default=256
+ * Example:
+ * Note: The ring all-reduce of buckets sends segments in chunks of this
+ *       size, so that receiving a chunk overlaps reducing the previous one.
+ */
+PHI_DEFINE_EXPORTED_int32(gloo_allreduce_chunk_kb,
+                          256,
+                          "chunk size of the gloo ring all-reduce in KB");
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_gloo_allreduce_threads
+ * Since Version: 3.0.0
+ * Value Range: int32, default=2
+ * Example:
+ * Note: Number of background threads of a ProcessGroupGloo that reduce
+ *       buckets, which may run at the same time.
+ */
+PHI_DEFINE_EXPORTED_int32(gloo_allreduce_threads,
+                          2,
+                          "threads of the bucketed gloo all-reduce");
 #endif
 
 /**
@@ -879,6 +986,20 @@ PHI_DEFINE_EXPORTED_bool(graph_load_in_parallel,
                          "It controls whether load graph node and edge with "
                          "multi threads parallelly.");
 
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_graph_csr_sampling
+ * Since Version: 3.0.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: Control whether GraphTable copies the edges to compact CSR shards with
+ *       alias tables after loading, and samples neighbors from them
+ */
+PHI_DEFINE_EXPORTED_bool(graph_csr_sampling,
+                         false,
+                         "It controls whether sample graph neighbors from CSR "
+                         "shards built after the edges are loaded.");
+
 /**
  * Distributed related FLAG
  * Name: FLAGS_enable_neighbor_list_use_uva
@@ -1195,6 +1316,21 @@ PD_DEFINE_bool(enable_slotrecord_reset_shrink,  // NOLINT
 PD_DEFINE_bool(enable_ins_parser_file,  // NOLINT
                false,
                "enable parser ins file, default false");
+PD_DEFINE_bool(fs_read_in_process,  // NOLINT
+               false,
+               "read local files and decompress gzip in process instead of "
+               "through zcat/cat pipes, every reader holds "
+               "fs_read_ahead_buffer_num buffers of fs_read_ahead_buffer_size "
+               "bytes, default false");
+PD_DEFINE_int64(fs_read_ahead_buffer_size,
+                4 << 20,
+                "bytes of every read-ahead buffer of in process readers");
+PD_DEFINE_int32(fs_read_ahead_buffer_num,
+                4,
+                "read-ahead buffer num of every in process reader");
+PD_DEFINE_bool(fs_read_direct_io,  // NOLINT
+               false,
+               "open local files read in process with O_DIRECT, default false");
 PHI_DEFINE_EXPORTED_bool(
     gpugraph_enable_hbm_table_collision_stat,
     false,
@@ -1293,6 +1429,21 @@ PHI_DEFINE_EXPORTED_bool(
     "Default cuda is asynchronous device, set to True will"
     "force op run in synchronous mode.");
 
+/**
+ * Eager backward related FLAG
+ * Name: FLAGS_eager_parallel_backward_threads
+ * Since Version: 3.0.0
+ * Value Range: int32, default=0
+ * Example: FLAGS_eager_parallel_backward_threads=4 runs independent grad
+ *          nodes of a backward pass on 4 threads, the calling one included.
+ * Note: 0 or 1 keeps the sequential engine. The parallel engine is not used
+ *       by backward passes that create a graph or compute partial grads.
+ */
+PHI_DEFINE_EXPORTED_int32(eager_parallel_backward_threads,
+                          0,
+                          "threads that run the grad nodes of an eager "
+                          "backward pass, 0 or 1 means sequential");
+
 /**
  * Autotune related FLAG
  * Name: FLAGS_use_autotune
@@ -1676,6 +1827,21 @@ PHI_DEFINE_EXPORTED_bool(pir_apply_shape_optimization_pass,
                          "Whether to apply shape_optimization pass "
                          "to infer symbolic shape");
 
+/**
+ * PIR pass manager FLAG
+ * Name: pir_pass_manager_num_threads
+ * Since Version: 3.0.0
+ * Value Range: int32, default=0
+ * Example: FLAGS_pir_pass_manager_num_threads=8
+ * Note: If larger than 1, a pass manager whose passes are all region-local
+ * runs them on the operations with regions of a block on this many threads.
+ * Operations whose regions use the same outer value share a thread.
+ */
+PHI_DEFINE_EXPORTED_int32(pir_pass_manager_num_threads,
+                          0,
+                          "Number of threads a pass manager runs region-local "
+                          "passes on sibling regions with.");
+
 PHI_DEFINE_EXPORTED_int64(
     pir_broadcast_tree_limit,
     32,
@@ -1892,3 +2058,18 @@ PHI_DEFINE_EXPORTED_bool(
     pinned_memory_as_cpu_backend,
     false,
     "Whether use CPU backend, when tensor is pinned_memory.");
+
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_tcp_store_reactor_threads
+ * Since Version: 3.0.0
+ * Value Range: int32, default=0
+ * Example: FLAGS_tcp_store_reactor_threads=8
+ * Note: The number of threads serving the connections of the TCPStore
+ *       master on Linux, each waiting on its own epoll instance. 0 means
+ *       the number of cores, at most 4.
+ */
+PHI_DEFINE_EXPORTED_int32(tcp_store_reactor_threads,
+                          0,
+                          "Number of reactor threads of the TCPStore server, "
+                          "0 means the number of cores, at most 4.");
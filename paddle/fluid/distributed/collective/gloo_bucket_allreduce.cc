@@ -0,0 +1,414 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/collective/gloo_bucket_allreduce.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "gloo/transport/unbound_buffer.h"
+#include "gloo/types.h"
+#include "paddle/phi/common/data_type.h"
+#include "paddle/phi/core/distributed/gloo_utils.h"
+#include "paddle/phi/core/enforce.h"
+
+namespace paddle::distributed {
+
+namespace {
+
+// 0x08 is taken by send_recv
+constexpr uint8_t kBucketAllreduceSlotPrefix = 0x09;
+
+bool IsPowerOfTwo(int n) { return n > 0 && (n & (n - 1)) == 0; }
+
+// elements [first, second) of segment `i` when `count` elements are split
+// into `n` segments
+std::pair<size_t, size_t> Segment(size_t count, int n, int i) {
+  size_t base = count / n;
+  size_t rem = count % n;
+  size_t index = static_cast<size_t>(i);
+  size_t begin = index * base + std::min(index, rem);
+  return {begin, begin + base + (index < rem ? 1 : 0)};
+}
+
+// receives of a collective, reused by the thread that runs it
+std::vector<char>* Scratch(size_t bytes) {
+  thread_local std::vector<char> scratch;
+  if (scratch.size() < bytes) {
+    scratch.resize(bytes);
+  }
+  return &scratch;
+}
+
+// adapts SetReduceFunc of gloo_utils to a plain function pointer
+struct ReduceFuncHolder {
+  void setReduceFunction(GlooReduceFunc fn) { reduce = fn; }
+  GlooReduceFunc reduce = nullptr;
+};
+
+}  // namespace
+
+GlooAllreduceAlgo ChooseGlooAllreduceAlgo(int world_size,
+                                          size_t bytes,
+                                          size_t ring_threshold_bytes) {
+  if (IsPowerOfTwo(world_size) && bytes < ring_threshold_bytes) {
+    return GlooAllreduceAlgo::kHalvingDoubling;
+  }
+  return GlooAllreduceAlgo::kRing;
+}
+
+void GlooRingAllreduce(const std::shared_ptr<gloo::Context>& context,
+                       char* data,
+                       size_t count,
+                       size_t elem_size,
+                       GlooReduceFunc reduce,
+                       uint32_t tag,
+                       size_t chunk_bytes) {
+  const int size = context->size;
+  const int rank = context->rank;
+  if (size == 1 || count == 0) {
+    return;
+  }
+  const int right = (rank + 1) % size;
+  const int left = (rank + size - 1) % size;
+  const auto slot = gloo::Slot::build(kBucketAllreduceSlotPrefix, tag);
+  const auto timeout = context->getTimeout();
+  const size_t chunk = std::max<size_t>(1, chunk_bytes / elem_size);
+
+  std::vector<char>* scratch = Scratch(Segment(count, size, 0).second *
+                                       elem_size);
+  auto buffer = context->createUnboundBuffer(data, count * elem_size);
+  auto scratch_buffer =
+      context->createUnboundBuffer(scratch->data(), scratch->size());
+  size_t pending_sends = 0;
+  auto send = [&](size_t begin, size_t end) {
+    buffer->send(right, slot, begin * elem_size, (end - begin) * elem_size);
+    ++pending_sends;
+  };
+  auto wait_sends = [&]() {
+    for (; pending_sends > 0; --pending_sends) {
+      buffer->waitSend(timeout);
+    }
+  };
+
+  // Reduce-scatter. Step s receives segment rank - s - 1 and reduces it
+  // into the local one, chunk by chunk, and the chunks are sent on to be
+  // reduced by the next rank in step s + 1. Ends with segment rank + 1
+  // reduced over all ranks.
+  auto own = Segment(count, size, rank);
+  for (size_t begin = own.first; begin < own.second; begin += chunk) {
+    send(begin, std::min(own.second, begin + chunk));
+  }
+  for (int step = 0; step < size - 1; ++step) {
+    auto segment = Segment(count, size, (rank + 2 * size - step - 1) % size);
+    for (size_t begin = segment.first; begin < segment.second;
+         begin += chunk) {
+      size_t end = std::min(segment.second, begin + chunk);
+      scratch_buffer->recv(left,
+                           slot,
+                           (begin - segment.first) * elem_size,
+                           (end - begin) * elem_size);
+    }
+    for (size_t begin = segment.first; begin < segment.second;
+         begin += chunk) {
+      size_t end = std::min(segment.second, begin + chunk);
+      // receives from the same rank on a slot complete in order
+      scratch_buffer->waitRecv(timeout);
+      char* dst = data + begin * elem_size;
+      reduce(dst,
+             dst,
+             scratch->data() + (begin - segment.first) * elem_size,
+             end - begin);
+      if (step < size - 2) {
+        send(begin, end);
+      }
+    }
+  }
+
+  // All-gather. The receives below land on segments sent above.
+  wait_sends();
+  auto reduced = Segment(count, size, (rank + 1) % size);
+  for (size_t begin = reduced.first; begin < reduced.second; begin += chunk) {
+    send(begin, std::min(reduced.second, begin + chunk));
+  }
+  for (int step = 0; step < size - 1; ++step) {
+    auto segment = Segment(count, size, (rank + size - step) % size);
+    for (size_t begin = segment.first; begin < segment.second;
+         begin += chunk) {
+      size_t end = std::min(segment.second, begin + chunk);
+      buffer->recv(left, slot, begin * elem_size, (end - begin) * elem_size);
+    }
+    for (size_t begin = segment.first; begin < segment.second;
+         begin += chunk) {
+      buffer->waitRecv(timeout);
+      if (step < size - 2) {
+        send(begin, std::min(segment.second, begin + chunk));
+      }
+    }
+  }
+  wait_sends();
+}
+
+void GlooHalvingDoublingAllreduce(const std::shared_ptr<gloo::Context>& context,
+                                  char* data,
+                                  size_t count,
+                                  size_t elem_size,
+                                  GlooReduceFunc reduce,
+                                  uint32_t tag) {
+  const int size = context->size;
+  const int rank = context->rank;
+  if (size == 1 || count == 0) {
+    return;
+  }
+  PADDLE_ENFORCE_EQ(IsPowerOfTwo(size),
+                    true,
+                    common::errors::InvalidArgument(
+                        "Halving-doubling all-reduce needs a power of two "
+                        "ranks, but got %d.",
+                        size));
+  const auto slot = gloo::Slot::build(kBucketAllreduceSlotPrefix, tag);
+  const auto timeout = context->getTimeout();
+
+  std::vector<char>* scratch = Scratch((count + 1) / 2 * elem_size);
+  auto buffer = context->createUnboundBuffer(data, count * elem_size);
+  auto scratch_buffer =
+      context->createUnboundBuffer(scratch->data(), scratch->size());
+  size_t pending_sends = 0;
+
+  // Reduce-scatter: at each distance, from n / 2 down to 1, the range is
+  // halved with the peer, which keeps the other half.
+  size_t begin = 0;
+  size_t end = count;
+  std::vector<std::pair<size_t, size_t>> parents;
+  for (int distance = size / 2; distance >= 1; distance /= 2) {
+    const int peer = rank ^ distance;
+    const bool lower = (rank & distance) == 0;
+    const size_t mid = begin + (end - begin) / 2;
+    size_t send_begin = lower ? mid : begin;
+    size_t send_end = lower ? end : mid;
+    parents.emplace_back(begin, end);
+    if (!lower) {
+      begin = mid;
+    } else {
+      end = mid;
+    }
+    if (send_end > send_begin) {
+      buffer->send(peer,
+                   slot,
+                   send_begin * elem_size,
+                   (send_end - send_begin) * elem_size);
+      ++pending_sends;
+    }
+    if (end > begin) {
+      scratch_buffer->recv(peer, slot, 0, (end - begin) * elem_size);
+      scratch_buffer->waitRecv(timeout);
+      char* dst = data + begin * elem_size;
+      reduce(dst, dst, scratch->data(), end - begin);
+    }
+  }
+
+  // All-gather: the same peers in reverse, each step doubling the range.
+  for (; pending_sends > 0; --pending_sends) {
+    buffer->waitSend(timeout);
+  }
+  for (int distance = 1; distance < size; distance *= 2) {
+    const int peer = rank ^ distance;
+    const bool lower = (rank & distance) == 0;
+    auto parent = parents.back();
+    parents.pop_back();
+    size_t recv_begin = lower ? end : parent.first;
+    size_t recv_end = lower ? parent.second : begin;
+    if (end > begin) {
+      buffer->send(peer, slot, begin * elem_size, (end - begin) * elem_size);
+      ++pending_sends;
+    }
+    if (recv_end > recv_begin) {
+      buffer->recv(peer,
+                   slot,
+                   recv_begin * elem_size,
+                   (recv_end - recv_begin) * elem_size);
+      buffer->waitRecv(timeout);
+    }
+    begin = parent.first;
+    end = parent.second;
+  }
+  for (; pending_sends > 0; --pending_sends) {
+    buffer->waitSend(timeout);
+  }
+}
+
+GlooBucketAllreducer::GlooBucketAllreducer(
+    std::shared_ptr<gloo::Context> context,
+    const GlooBucketAllreduceOptions& options)
+    : context_(std::move(context)), options_(options) {
+  int num_threads = std::max(1, options_.num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    workers_.emplace_back([this]() { WorkerLoop(); });
+  }
+}
+
+GlooBucketAllreducer::~GlooBucketAllreducer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+std::vector<std::shared_future<void>> GlooBucketAllreducer::AllReduce(
+    const std::vector<GlooAllreduceEntry>& entries,
+    const std::function<uint32_t()>& next_tag) {
+  std::vector<std::shared_future<void>> futures;
+  futures.reserve(entries.size());
+  std::vector<std::unique_ptr<Bucket>> buckets;
+  std::unique_ptr<Bucket> bucket;
+  phi::DataType dtype = phi::DataType::UNDEFINED;
+  ReduceOp reduce_op = ReduceOp::SUM;
+  std::shared_future<void> future;
+  auto flush = [&]() {
+    if (bucket != nullptr) {
+      bucket->tag = next_tag();
+      buckets.push_back(std::move(bucket));
+    }
+  };
+
+  for (auto& entry : entries) {
+    PADDLE_ENFORCE_EQ(
+        entry.input.numel(),
+        entry.output.numel(),
+        common::errors::InvalidArgument(
+            "The input and output of an all-reduce must have the same number "
+            "of elements, but got %d and %d.",
+            entry.input.numel(),
+            entry.output.numel()));
+    PADDLE_ENFORCE_EQ(entry.input.dtype(),
+                      entry.output.dtype(),
+                      common::errors::InvalidArgument(
+                          "The input and output of an all-reduce must have "
+                          "the same dtype."));
+    size_t elem_size = phi::SizeOf(entry.input.dtype());
+    size_t bytes = entry.input.numel() * elem_size;
+    bool fits = bucket != nullptr && entry.input.dtype() == dtype &&
+                entry.reduce_op == reduce_op &&
+                (bucket->count * elem_size + bytes <= options_.bucket_bytes);
+    if (!fits) {
+      flush();
+      dtype = entry.input.dtype();
+      reduce_op = entry.reduce_op;
+      ReduceFuncHolder holder;
+      GENERATE_FUNC(dtype,
+                    phi::distributed::SetReduceFunc,
+                    &holder,
+                    static_cast<int>(reduce_op));
+      bucket = std::make_unique<Bucket>();
+      bucket->elem_size = elem_size;
+      bucket->reduce = holder.reduce;
+      future = bucket->done.get_future().share();
+    }
+    bucket->entries.push_back(entry);
+    bucket->count += entry.input.numel();
+    futures.push_back(future);
+  }
+  flush();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& item : buckets) {
+      queue_.push_back(std::move(item));
+    }
+  }
+  cv_.notify_all();
+  return futures;
+}
+
+void GlooBucketAllreducer::WorkerLoop() {
+  std::vector<char> staging;
+  while (true) {
+    std::unique_ptr<Bucket> bucket;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      bucket = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    try {
+      Run(bucket.get(), &staging);
+      bucket->done.set_value();
+    } catch (...) {
+      bucket->done.set_exception(std::current_exception());
+    }
+  }
+}
+
+void GlooBucketAllreducer::Run(Bucket* bucket, std::vector<char>* staging) {
+  const size_t elem_size = bucket->elem_size;
+  const size_t bytes = bucket->count * elem_size;
+  auto& entries = bucket->entries;
+  char* data = nullptr;
+  if (entries.size() == 1) {
+    // reduced in the output itself
+    auto& entry = entries[0];
+    data = static_cast<char*>(entry.output.data());
+    const void* input = entry.input.data();
+    if (input != data && bytes > 0) {
+      std::memcpy(data, input, bytes);
+    }
+  } else {
+    staging->resize(bytes);
+    data = staging->data();
+    size_t offset = 0;
+    for (auto& entry : entries) {
+      size_t size = entry.input.numel() * elem_size;
+      if (size > 0) {
+        std::memcpy(data + offset, entry.input.data(), size);
+      }
+      offset += size;
+    }
+  }
+
+  auto algo = ChooseGlooAllreduceAlgo(
+      context_->size, bytes, options_.ring_threshold_bytes);
+  if (algo == GlooAllreduceAlgo::kHalvingDoubling) {
+    GlooHalvingDoublingAllreduce(
+        context_, data, bucket->count, elem_size, bucket->reduce, bucket->tag);
+  } else {
+    GlooRingAllreduce(context_,
+                      data,
+                      bucket->count,
+                      elem_size,
+                      bucket->reduce,
+                      bucket->tag,
+                      options_.chunk_bytes);
+  }
+
+  if (entries.size() > 1) {
+    size_t offset = 0;
+    for (auto& entry : entries) {
+      size_t size = entry.output.numel() * elem_size;
+      if (size > 0) {
+        std::memcpy(entry.output.data(), data + offset, size);
+      }
+      offset += size;
+    }
+  }
+}
+
+}  // namespace paddle::distributed
@@ -0,0 +1,132 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gloo/context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/distributed/types.h"
+
+namespace paddle {
+namespace distributed {
+
+using phi::distributed::ReduceOp;
+
+// c[i] = a[i] op b[i] for n elements, as the reduce functions of gloo
+using GlooReduceFunc = void (*)(void*, const void*, const void*, size_t);
+
+enum class GlooAllreduceAlgo { kRing, kHalvingDoubling };
+
+// Halving-doubling takes log2(n) steps instead of the 2(n - 1) of the ring,
+// which matters while latency dominates, but needs a power of two ranks.
+GlooAllreduceAlgo ChooseGlooAllreduceAlgo(int world_size,
+                                          size_t bytes,
+                                          size_t ring_threshold_bytes);
+
+// In place all-reduce of `count` elements of `elem_size` bytes at `data`.
+//
+// A reduce-scatter around the ring and then an all-gather. Segments move in
+// chunks of `chunk_bytes`: a chunk is reduced as soon as it arrives and
+// forwarded right away, so the transfer of a step overlaps the summation of
+// the previous one.
+void GlooRingAllreduce(const std::shared_ptr<gloo::Context>& context,
+                       char* data,
+                       size_t count,
+                       size_t elem_size,
+                       GlooReduceFunc reduce,
+                       uint32_t tag,
+                       size_t chunk_bytes);
+
+// In place all-reduce by recursive halving reduce-scatter and recursive
+// doubling all-gather.
+void GlooHalvingDoublingAllreduce(const std::shared_ptr<gloo::Context>& context,
+                                  char* data,
+                                  size_t count,
+                                  size_t elem_size,
+                                  GlooReduceFunc reduce,
+                                  uint32_t tag);
+
+struct GlooBucketAllreduceOptions {
+  size_t bucket_bytes = 25 << 20;
+  size_t ring_threshold_bytes = 512 << 10;
+  size_t chunk_bytes = 256 << 10;
+  int num_threads = 2;
+};
+
+struct GlooAllreduceEntry {
+  phi::DenseTensor input;
+  // may share the memory of the input
+  phi::DenseTensor output;
+  ReduceOp reduce_op;
+};
+
+// Fuses all-reduces into buckets and runs them on background threads.
+//
+// Consecutive entries of the same dtype and reduce op are packed into one
+// contiguous bucket of at most bucket_bytes (a larger tensor is a bucket of
+// its own and is reduced in its output without a copy). Every bucket gets a
+// tag of its own, so the threads may run them in any order as long as every
+// rank queues the same buckets in the same order.
+class GlooBucketAllreducer {
+ public:
+  GlooBucketAllreducer(std::shared_ptr<gloo::Context> context,
+                       const GlooBucketAllreduceOptions& options);
+  // runs the queued buckets, then stops the threads
+  ~GlooBucketAllreducer();
+
+  GlooBucketAllreducer(const GlooBucketAllreducer&) = delete;
+  GlooBucketAllreducer& operator=(const GlooBucketAllreducer&) = delete;
+
+  // Queues `entries` and returns, for each of them, the future of its
+  // bucket. `next_tag` is called once per bucket.
+  std::vector<std::shared_future<void>> AllReduce(
+      const std::vector<GlooAllreduceEntry>& entries,
+      const std::function<uint32_t()>& next_tag);
+
+  const GlooBucketAllreduceOptions& options() const { return options_; }
+
+ private:
+  struct Bucket {
+    std::vector<GlooAllreduceEntry> entries;
+    size_t elem_size = 0;
+    size_t count = 0;
+    GlooReduceFunc reduce = nullptr;
+    uint32_t tag = 0;
+    std::promise<void> done;
+  };
+
+  void WorkerLoop();
+  void Run(Bucket* bucket, std::vector<char>* staging);
+
+  std::shared_ptr<gloo::Context> context_;
+  const GlooBucketAllreduceOptions options_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::unique_ptr<Bucket>> queue_;
+  bool stop_ = false;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -26,11 +26,17 @@
 
 #include <gloo/reduce.h>
 
+#include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/collective/common.h"
 #include "paddle/fluid/distributed/collective/process_group_gloo.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/phi/core/distributed/comm_context_manager.h"
 
+COMMON_DECLARE_int32(gloo_allreduce_bucket_size_mb);
+COMMON_DECLARE_int32(gloo_allreduce_ring_threshold_kb);
+COMMON_DECLARE_int32(gloo_allreduce_chunk_kb);
+COMMON_DECLARE_int32(gloo_allreduce_threads);
+
 namespace paddle::distributed {
 
 #ifdef _WIN32
@@ -349,6 +355,74 @@ class AllreduceGlooTask : public ProcessGroupGloo::GlooTask {
   }
 };
 
+// The all-reduce of buckets queued on the background threads of
+// GlooBucketAllreducer.
+class BucketAllreduceGlooTask : public ProcessGroupGloo::GlooTask {
+ public:
+  BucketAllreduceGlooTask(int rank,
+                          const std::vector<phi::DenseTensor>& inputs)
+      : ProcessGroupGloo::GlooTask(rank, inputs, CommType::ALLREDUCE) {}
+
+  void Run() override {}
+
+  void SetFutures(std::vector<std::shared_future<void>> futures) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    _futures = std::move(futures);
+    _queued = true;
+  }
+
+  bool IsCompleted() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!_queued) {
+        return false;
+      }
+    }
+    for (auto& future : Futures()) {
+      if (future.wait_for(std::chrono::seconds(0)) !=
+          std::future_status::ready) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // a timeout of 0 waits as long as it takes
+  bool Wait(std::chrono::milliseconds timeout) override {
+    auto futures = Futures();
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (auto& future : futures) {
+      if (timeout == kWaitTimeout) {
+        future.wait();
+      } else if (future.wait_until(deadline) != std::future_status::ready) {
+        return false;
+      }
+    }
+    // rethrows what the background thread threw
+    for (auto& future : futures) {
+      future.get();
+    }
+    return true;
+  }
+
+  void Synchronize() override { Wait(kWaitTimeout); }
+
+ private:
+  std::vector<std::shared_future<void>> Futures() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    PADDLE_ENFORCE_EQ(
+        _queued,
+        true,
+        common::errors::PreconditionNotMet(
+            "The all-reduce is coalesced, please call EndCoalescing before "
+            "waiting for it."));
+    return _futures;
+  }
+
+  bool _queued{false};
+  std::vector<std::shared_future<void>> _futures;
+};
+
 std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
     phi::DenseTensor* out_tensor,
     const phi::DenseTensor& in_tensor,
@@ -356,6 +430,9 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
     bool sync_op) {
   std::vector<phi::DenseTensor> in_wrapper{in_tensor};
   std::vector<phi::DenseTensor> out_wrapper{*out_tensor};
+  // NOTE: the python bindings always pass sync_op=false here and expect the
+  // result to be ready on return, so only the vector overload below may
+  // return before the reduction is done.
   return AllReduce(in_wrapper, out_wrapper, opts, true);
 }
 
@@ -374,15 +451,88 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
   CheckTensorContiguous(inputs);
   CheckTensorContiguous(outputs);
 
-  auto tag = next_tag();
-  std::shared_ptr<GlooTask> task;
-  auto comm_context = this->GetCommContext();
-  task = std::make_shared<AllreduceGlooTask>(
-      rank_, comm_context, inputs, outputs, opts.reduce_op, tag);
-  task->Run();
+  if (FLAGS_gloo_allreduce_bucket_size_mb <= 0) {
+    auto tag = next_tag();
+    std::shared_ptr<GlooTask> task;
+    auto comm_context = this->GetCommContext();
+    task = std::make_shared<AllreduceGlooTask>(
+        rank_, comm_context, inputs, outputs, opts.reduce_op, tag);
+    task->Run();
+    return task;
+  }
+
+  PADDLE_ENFORCE_EQ(
+      inputs.size(),
+      outputs.size(),
+      common::errors::InvalidArgument(
+          "The number of inputs and outputs of an all-reduce must be the "
+          "same, but got %d and %d.",
+          inputs.size(),
+          outputs.size()));
+  std::vector<GlooAllreduceEntry> entries;
+  entries.reserve(inputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    entries.push_back({inputs[i], outputs[i], opts.reduce_op});
+  }
+  auto task = std::make_shared<BucketAllreduceGlooTask>(rank_, inputs);
+  if (_is_coalescing) {
+    _coalescing_entries.insert(
+        _coalescing_entries.end(), entries.begin(), entries.end());
+    _coalescing_tasks.emplace_back(task, entries.size());
+    return task;
+  }
+  task->SetFutures(GetBucketAllreducer()->AllReduce(
+      entries, [this]() { return next_tag(); }));
+  if (sync_op) {
+    task->Wait(kWaitTimeout);
+  }
   return task;
 }
 
+void ProcessGroupGloo::StartCoalescing() {
+  PADDLE_ENFORCE_EQ(_is_coalescing,
+                    false,
+                    common::errors::PreconditionNotMet(
+                        "Coalescing is on, please call EndCoalesce."));
+  _is_coalescing = true;
+}
+
+void ProcessGroupGloo::EndCoalescing(
+    std::optional<std::vector<std::shared_ptr<ProcessGroup::Task>>>
+        tasks_opt) {
+  _is_coalescing = false;
+  if (_coalescing_entries.empty()) {
+    return;
+  }
+  auto futures = GetBucketAllreducer()->AllReduce(
+      _coalescing_entries, [this]() { return next_tag(); });
+  auto begin = futures.begin();
+  for (auto& pending : _coalescing_tasks) {
+    auto* task = static_cast<BucketAllreduceGlooTask*>(pending.first.get());
+    task->SetFutures(
+        std::vector<std::shared_future<void>>(begin, begin + pending.second));
+    begin += pending.second;
+  }
+  _coalescing_entries.clear();
+  _coalescing_tasks.clear();
+}
+
+GlooBucketAllreducer* ProcessGroupGloo::GetBucketAllreducer() {
+  if (_bucket_allreducer == nullptr) {
+    GlooBucketAllreduceOptions options;
+    options.bucket_bytes =
+        static_cast<size_t>(FLAGS_gloo_allreduce_bucket_size_mb) << 20;
+    options.ring_threshold_bytes =
+        static_cast<size_t>(FLAGS_gloo_allreduce_ring_threshold_kb) << 10;
+    options.chunk_bytes = static_cast<size_t>(FLAGS_gloo_allreduce_chunk_kb)
+                          << 10;
+    options.num_threads = FLAGS_gloo_allreduce_threads;
+    _bucket_allreducer =
+        std::make_unique<GlooBucketAllreducer>(_context, options);
+  }
+  return _bucket_allreducer.get();
+}
+
 class BarrierGlooTask : public ProcessGroupGloo::GlooTask {
  public:
   BarrierGlooTask(int rank, phi::distributed::GlooCommContext* comm_context)
@@ -17,7 +17,11 @@
 #include <future>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
 
+#include "paddle/fluid/distributed/collective/gloo_bucket_allreduce.h"
 #include "paddle/fluid/distributed/collective/process_group.h"
 #include "paddle/fluid/distributed/collective/process_group_without_stream.h"
 #include "paddle/phi/core/distributed/gloo_comm_context.h"
@@ -180,6 +184,10 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
       std::vector<phi::DenseTensor>& outputs,
       const AllreduceOptions& opts = AllreduceOptions()) override;
 
+  // Returns before the reduction is done only when sync_op is false and
+  // FLAGS_gloo_allreduce_bucket_size_mb is positive, the caller must then
+  // wait for the task before touching the outputs. The other overloads of
+  // AllReduce are always synchronous.
   std::shared_ptr<ProcessGroup::Task> AllReduce(
       std::vector<phi::DenseTensor>& inputs,
       std::vector<phi::DenseTensor>& outputs,
@@ -189,6 +197,15 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
   std::shared_ptr<ProcessGroup::Task> Barrier(
       const BarrierOptions& = BarrierOptions()) override;
 
+  // All-reduces between them are bucketed together when EndCoalescing is
+  // called, their tasks can only be waited for after that. Other
+  // collectives run at once.
+  void StartCoalescing() override;
+
+  void EndCoalescing(
+      std::optional<std::vector<std::shared_ptr<ProcessGroup::Task>>>
+          tasks_opt = std::nullopt) override;
+
   std::shared_ptr<ProcessGroup::Task> AllGather(
       std::vector<phi::DenseTensor>& in_tensors,
       std::vector<phi::DenseTensor>& out_tensors) override;
@@ -236,9 +253,19 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
   static std::shared_ptr<::gloo::transport::Device> createDefaultDevice();
 
  private:
+  // created on the first bucketed all-reduce
+  GlooBucketAllreducer* GetBucketAllreducer();
+
   uint32_t _tag;
   std::shared_ptr<gloo::rendezvous::Context> _context;
   std::shared_ptr<::gloo::rendezvous::Store> _store;
+  // reduces on _context, which the other collectives do not use
+  std::unique_ptr<GlooBucketAllreducer> _bucket_allreducer;
+
+  bool _is_coalescing{false};
+  std::vector<GlooAllreduceEntry> _coalescing_entries;
+  // the task of each coalesced call with its number of entries
+  std::vector<std::pair<std::shared_ptr<GlooTask>, size_t>> _coalescing_tasks;
 };
 
 }  // namespace distributed
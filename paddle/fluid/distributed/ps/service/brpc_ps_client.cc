@@ -1073,6 +1073,78 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
   return fut;
 }
 
+std::future<int32_t> BrpcPsClient::PushSparseCompressedGradient(
+    size_t table_id,
+    const uint64_t *keys,
+    const char **rows,
+    size_t num,
+    SparseGradCompressType type,
+    void *done) {
+  auto *accessor = GetTableAccessor(table_id);
+  DownpourBrpcClosure *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
+  auto promise = std::make_shared<std::promise<int32_t>>();
+  closure->add_promise(promise);
+  std::future<int> fut = promise->get_future();
+
+  size_t request_call_num = _server_channels.size();
+  std::vector<std::vector<uint64_t>> ids(request_call_num);
+  std::vector<std::vector<const char *>> row_ptrs(request_call_num);
+
+  const auto &server_param = _config.server_param().downpour_server_param();
+  uint64_t shard_num = FLAGS_pserver_sparse_table_shard_num;
+  for (int i = 0; i < server_param.downpour_table_param_size(); ++i) {
+    const auto &table_param = server_param.downpour_table_param(i);
+    if (table_param.table_id() == table_id) {
+      shard_num = table_param.shard_num();
+      break;
+    }
+  }
+
+  for (size_t i = 0; i < num; ++i) {
+    size_t pserver_idx = get_sparse_shard(shard_num, request_call_num, keys[i]);
+    ids[pserver_idx].push_back(keys[i]);
+    row_ptrs[pserver_idx].push_back(rows[i]);
+  }
+
+  size_t row_bytes =
+      SparseGradRowBytes(type, accessor->GetAccessorInfo().update_dim);
+  uint32_t compress_type = static_cast<uint32_t>(type);
+  for (size_t shard_idx = 0; shard_idx < request_call_num; ++shard_idx) {
+    const auto &kvs = ids[shard_idx];
+    uint32_t kv_size = kvs.size();
+
+    /*
+    Push Content:
+    |---keysData---|---encoded rows---|
+    |---8*{num}B---|--{num}*row_bytes-|
+    */
+    auto *push_request = closure->request(shard_idx);
+    push_request->set_cmd_id(PS_PUSH_SPARSE_TABLE);
+    push_request->set_table_id(table_id);
+    push_request->set_client_id(_client_id);
+    push_request->add_params((char *)&kv_size, sizeof(uint32_t));  // NOLINT
+    push_request->add_params((char *)&compress_type,              // NOLINT
+                             sizeof(uint32_t));
+    auto *push_data = push_request->mutable_data();
+    push_data->resize(kv_size * (sizeof(uint64_t) + row_bytes));
+    char *push_data_ptr = const_cast<char *>(push_data->data());
+    memcpy(push_data_ptr, kvs.data(), kv_size * sizeof(uint64_t));
+    push_data_ptr += kv_size * sizeof(uint64_t);
+    for (const char *row : row_ptrs[shard_idx]) {
+      memcpy(push_data_ptr, row, row_bytes);
+      push_data_ptr += row_bytes;
+    }
+    PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
+    closure->cntl(shard_idx)->set_request_compress_type(
+        (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
+    rpc_stub.service(closure->cntl(shard_idx),
+                     closure->request(shard_idx),
+                     closure->response(shard_idx),
+                     closure);
+  }
+  return fut;
+}
+
 std::future<int32_t> BrpcPsClient::PushDenseRawGradient(
     int table_id,
     float *total_send_data,
@@ -403,6 +403,14 @@ class BrpcPsClient : public PSClient {
                                              size_t num,
                                              void *done) override;
 
+  std::future<int32_t> PushSparseCompressedGradient(
+      size_t table_id,
+      const uint64_t *keys,
+      const char **rows,
+      size_t num,
+      SparseGradCompressType type,
+      void *done) override;
+
   std::future<int32_t> PushSparseRawGradientPartial(size_t table_id,
                                                     const uint64_t *keys,
                                                     const float **update_values,
@@ -18,6 +18,7 @@
 
 #include "butil/object_pool.h"
 #include "paddle/fluid/distributed/common/cost_timer.h"
+#include "paddle/fluid/distributed/ps/service/communicator/sparse_grad_compressor.h"
 #include "paddle/fluid/distributed/ps/table/depends/sparse_utils.h"
 #include "paddle/fluid/distributed/ps/table/table.h"
 #include "paddle/fluid/framework/archive.h"
@@ -586,6 +587,38 @@ int32_t BrpcPsService::PushSparse(Table *table,
   table_context.push_context.values =
       (const float *)(push_data.data() + sizeof(uint64_t) * num);
   table_context.num = num;
+  // rows encoded by PushSparseCompressedGradient
+  std::vector<float> decoded;
+  SparseGradCompressType compress_type = SparseGradCompressType::kFp32;
+  if (request.params_size() > 1) {
+    if (request.params(1).size() != sizeof(uint32_t)) {
+      set_response_code(
+          response, -1, "PushSparse compress type should be 4 bytes");
+      return 0;
+    }
+    uint32_t type =
+        *(reinterpret_cast<const uint32_t *>(request.params(1).c_str()));
+    if (type > static_cast<uint32_t>(SparseGradCompressType::kInt8)) {
+      set_response_code(response, -1, "PushSparse unknown compress type");
+      return 0;
+    }
+    compress_type = static_cast<SparseGradCompressType>(type);
+  }
+  if (compress_type != SparseGradCompressType::kFp32) {
+    size_t dim = table->GetValueAccessor()->GetAccessorInfo().update_dim;
+    size_t row_bytes = SparseGradRowBytes(compress_type, dim);
+    if (push_data.size() != num * (sizeof(uint64_t) + row_bytes)) {
+      set_response_code(response, -1, "PushSparse encoded data size error");
+      return 0;
+    }
+    decoded.resize(num * dim);
+    const char *rows = push_data.data() + sizeof(uint64_t) * num;
+    for (size_t i = 0; i < num; ++i) {
+      DecodeSparseGradRow(
+          compress_type, rows + i * row_bytes, dim, decoded.data() + i * dim);
+    }
+    table_context.push_context.values = decoded.data();
+  }
   // const uint64_t *keys = (const uint64_t *)push_data.data();
   // const float *values = (const float *)(push_data.data() + sizeof(uint64_t) *
   // num);
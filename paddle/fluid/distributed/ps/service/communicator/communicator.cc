@@ -539,6 +539,20 @@ void AsyncCommunicator::SendByCommunicator() {
       }
       if (merged_var_num == 0) return;
 
+      if (FLAGS_communicator_sparse_merge_stage && ctx.is_sparse &&
+          !ctx.is_tensor_table) {
+        PADDLE_ENFORCE_EQ(
+            varnames.size(),
+            1,
+            common::errors::InvalidArgument(
+                "sparse variables can only be merged by one variables"));
+        PushSparseByMergeStage(varnames[0], table_id, vars[0]);
+        if (independent_recv_) {
+          grad_num_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+      }
+
       for (size_t i = 0; i < var_nums; i++) {
         auto &var_name = varnames[i];
         if (var_name == STEP_COUNTER) {
@@ -577,6 +591,70 @@ void AsyncCommunicator::SendByCommunicator() {
   return;
 }
 
+void AsyncCommunicator::PushSparseByMergeStage(
+    const std::string &var_name,
+    int table_id,
+    const std::vector<std::shared_ptr<Variable>> &vars) {
+  platform::RecordEvent record_event("Communicator->PushSparseByMergeStage",
+                                     platform::TracerEventType::Communication,
+                                     1);
+  auto &compressor = sparse_compressors_.at(var_name);
+  for (auto &var : vars) {
+    auto &slr = var->Get<phi::SelectedRows>();
+    if (compressor == nullptr) {
+      compressor = std::make_unique<SparseGradCompressor>(
+          sparse_push_type_,
+          slr.value().dims()[1],
+          FLAGS_communicator_sparse_residual_capacity);
+    }
+    compressor->Merge(
+        slr.rows().data(), slr.value().data<float>(), slr.rows().size());
+  }
+
+  // the previous push of the variable was in flight while merging
+  auto &push = sparse_pushes_.at(var_name);
+  if (push.valid()) {
+    push.wait();
+  }
+  compressor->Encode();
+  if (compressor->size() == 0) {
+    return;
+  }
+  VLOG(3) << "push " << var_name << " keys: " << compressor->size()
+          << " bytes: " << compressor->encoded_bytes()
+          << " residual keys: " << compressor->residual_size();
+
+  size_t request_call_num = _worker_ptr->GetServerNums();
+  ++_async_call_num;
+  DownpourBrpcClosure *closure = new DownpourBrpcClosure(
+      request_call_num, [this, request_call_num](void *done) {
+        int ret = 0;
+        auto *closure = (DownpourBrpcClosure *)done;  // NOLINT
+        for (size_t i = 0; i < request_call_num; ++i) {
+          if (closure->check_response(i, PS_PUSH_SPARSE_TABLE) != 0) {
+            ret = -1;
+            break;
+          }
+        }
+        closure->set_promise_value(ret);
+        --_async_call_num;
+      });
+  push = _worker_ptr->PushSparseCompressedGradient(table_id,
+                                                   compressor->keys(),
+                                                   compressor->rows(),
+                                                   compressor->size(),
+                                                   compressor->type(),
+                                                   closure);
+}
+
+void AsyncCommunicator::WaitSparsePushes() {
+  for (auto &iter : sparse_pushes_) {
+    if (iter.second.valid()) {
+      iter.second.wait();
+    }
+  }
+}
+
 void AsyncCommunicator::PushDensePostProcessing() {
   if (independent_recv_) {
     grad_num_.fetch_add(1, std::memory_order_relaxed);
@@ -862,6 +940,17 @@ void AsyncCommunicator::InitImpl(const RpcCtxMap &send_varname_to_ctx,
               send_queue_size_);
     }
   }
+  if (FLAGS_communicator_sparse_merge_stage) {
+    sparse_push_type_ =
+        ParseSparseGradCompressType(FLAGS_communicator_sparse_push_quant);
+    for (auto &iter : send_varname_to_ctx_) {
+      auto &ctx = iter.second;
+      if (ctx.is_sparse && !ctx.is_tensor_table) {
+        sparse_compressors_[ctx.origin_varnames[0]] = nullptr;
+        sparse_pushes_[ctx.origin_varnames[0]] = std::future<int32_t>();
+      }
+    }
+  }
   send_threadpool_ = std::make_unique<::ThreadPool>(thread_pool_size_);
 }
 
@@ -909,6 +998,7 @@ void AsyncCommunicator::Stop() {
       main_thread_->join();
       main_thread_.reset(nullptr);
     }
+    WaitSparsePushes();
   }
   VLOG(1) << "Communicator stop done";
 }
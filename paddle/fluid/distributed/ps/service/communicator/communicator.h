@@ -31,6 +31,7 @@ limitations under the License. */
 
 #include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/ps/service/communicator/communicator_common.h"
+#include "paddle/fluid/distributed/ps/service/communicator/sparse_grad_compressor.h"
 #include "paddle/fluid/distributed/ps/service/coordinator_client.h"
 #include "paddle/fluid/distributed/ps/service/ps_client.h"
 #include "paddle/fluid/framework/channel.h"
@@ -53,6 +54,9 @@ struct CommContext;
 }  // namespace paddle
 
 COMMON_DECLARE_bool(communicator_is_sgd_optimizer);
+COMMON_DECLARE_bool(communicator_sparse_merge_stage);
+COMMON_DECLARE_string(communicator_sparse_push_quant);
+COMMON_DECLARE_int64(communicator_sparse_residual_capacity);
 
 namespace paddle {
 namespace distributed {
@@ -477,6 +481,14 @@ class AsyncCommunicator : public Communicator {
 
   void PushDensePostProcessing();
 
+  // Merges the queued gradients of a sparse variable by key and pushes them
+  // encoded. Only waits for the previous push of the variable after merging.
+  void PushSparseByMergeStage(
+      const std::string &var_name,
+      int table_id,
+      const std::vector<std::shared_ptr<Variable>> &vars);
+  void WaitSparsePushes();
+
   void PullSparseToTensorSync(
       const uint64_t table_id,
       int fea_dim,
@@ -516,6 +528,13 @@ class AsyncCommunicator : public Communicator {
 
   std::unique_ptr<Scope> send_scope_;  // an independent scope
   std::atomic_uint grad_num_{0};  // the num of gradient sent since last recv
+
+  // state of the sparse merge stage per variable, the entries are made in
+  // InitImpl so the send tasks of different variables can use them at once
+  SparseGradCompressType sparse_push_type_ = SparseGradCompressType::kFp32;
+  std::unordered_map<std::string, std::unique_ptr<SparseGradCompressor>>
+      sparse_compressors_;
+  std::unordered_map<std::string, std::future<int32_t>> sparse_pushes_;
 };
 
 class HalfAsyncCommunicator : public AsyncCommunicator {
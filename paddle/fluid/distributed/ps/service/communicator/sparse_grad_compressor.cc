@@ -0,0 +1,213 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/service/communicator/sparse_grad_compressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/phi/common/float16.h"
+
+namespace paddle::distributed {
+
+SparseGradCompressType ParseSparseGradCompressType(const std::string &name) {
+  if (name == "fp32") {
+    return SparseGradCompressType::kFp32;
+  }
+  if (name == "fp16") {
+    return SparseGradCompressType::kFp16;
+  }
+  if (name == "int8") {
+    return SparseGradCompressType::kInt8;
+  }
+  PADDLE_THROW(common::errors::InvalidArgument(
+      "The sparse gradient encoding must be fp32, fp16 or int8, but got %s.",
+      name));
+}
+
+size_t SparseGradRowBytes(SparseGradCompressType type, size_t dim) {
+  switch (type) {
+    case SparseGradCompressType::kFp16:
+      return dim * sizeof(phi::dtype::float16);
+    case SparseGradCompressType::kInt8:
+      return sizeof(float) + dim * sizeof(int8_t);
+    default:
+      return dim * sizeof(float);
+  }
+}
+
+void EncodeSparseGradRow(SparseGradCompressType type,
+                         const float *src,
+                         size_t dim,
+                         char *dst,
+                         float *decoded) {
+  switch (type) {
+    case SparseGradCompressType::kFp16: {
+      for (size_t i = 0; i < dim; ++i) {
+        phi::dtype::float16 half(src[i]);
+        memcpy(dst + i * sizeof(half), &half, sizeof(half));
+        if (decoded != nullptr) {
+          decoded[i] = static_cast<float>(half);
+        }
+      }
+      break;
+    }
+    case SparseGradCompressType::kInt8: {
+      float max_abs = 0.0f;
+      for (size_t i = 0; i < dim; ++i) {
+        max_abs = std::max(max_abs, std::fabs(src[i]));
+      }
+      float scale = max_abs / 127.0f;
+      float inv_scale = scale > 0.0f ? 1.0f / scale : 0.0f;
+      memcpy(dst, &scale, sizeof(float));
+      int8_t *quant = reinterpret_cast<int8_t *>(dst + sizeof(float));
+      for (size_t i = 0; i < dim; ++i) {
+        float q = std::round(src[i] * inv_scale);
+        quant[i] = static_cast<int8_t>(std::min(127.0f, std::max(-127.0f, q)));
+        if (decoded != nullptr) {
+          decoded[i] = quant[i] * scale;
+        }
+      }
+      break;
+    }
+    default:
+      memcpy(dst, src, dim * sizeof(float));
+      if (decoded != nullptr) {
+        memcpy(decoded, src, dim * sizeof(float));
+      }
+  }
+}
+
+void DecodeSparseGradRow(SparseGradCompressType type,
+                         const char *src,
+                         size_t dim,
+                         float *dst) {
+  switch (type) {
+    case SparseGradCompressType::kFp16: {
+      for (size_t i = 0; i < dim; ++i) {
+        phi::dtype::float16 half;
+        memcpy(&half, src + i * sizeof(half), sizeof(half));
+        dst[i] = static_cast<float>(half);
+      }
+      break;
+    }
+    case SparseGradCompressType::kInt8: {
+      float scale;
+      memcpy(&scale, src, sizeof(float));
+      const int8_t *quant =
+          reinterpret_cast<const int8_t *>(src + sizeof(float));
+      for (size_t i = 0; i < dim; ++i) {
+        dst[i] = quant[i] * scale;
+      }
+      break;
+    }
+    default:
+      memcpy(dst, src, dim * sizeof(float));
+  }
+}
+
+void SparseGradMerger::Add(const int64_t *keys,
+                           const float *values,
+                           size_t num) {
+  for (size_t i = 0; i < num; ++i) {
+    uint64_t key = static_cast<uint64_t>(keys[i]);
+    auto iter = index_.find(key);
+    const float *value = values + i * dim_;
+    if (iter == index_.end()) {
+      index_.emplace(key, static_cast<uint32_t>(keys_.size()));
+      keys_.push_back(key);
+      values_.insert(values_.end(), value, value + dim_);
+      continue;
+    }
+    float *merged = row(iter->second);
+    for (size_t j = 0; j < dim_; ++j) {
+      merged[j] += value[j];
+    }
+  }
+}
+
+void SparseGradMerger::Clear() {
+  index_.clear();
+  keys_.clear();
+  values_.clear();
+}
+
+SparseGradCompressor::SparseGradCompressor(SparseGradCompressType type,
+                                           size_t dim,
+                                           size_t residual_capacity)
+    : type_(type),
+      row_bytes_(SparseGradRowBytes(type, dim)),
+      merger_(dim),
+      residual_capacity_(std::max<size_t>(residual_capacity, 1)) {}
+
+float *SparseGradCompressor::residual(uint64_t key) {
+  auto iter = residual_index_.find(key);
+  if (iter != residual_index_.end()) {
+    // referenced again since it was added or the hand last passed it
+    residual_used_[iter->second] = 1;
+    return residuals_.data() + iter->second * dim();
+  }
+  size_t slot = residual_keys_.size();
+  if (slot < residual_capacity_) {
+    residual_keys_.push_back(key);
+    residual_used_.push_back(0);
+    residuals_.resize(residuals_.size() + dim(), 0.0f);
+  } else {
+    // every slot is taken, reuse the first one not used since the last sweep
+    while (residual_used_[residual_hand_]) {
+      residual_used_[residual_hand_] = 0;
+      residual_hand_ = (residual_hand_ + 1) % residual_capacity_;
+    }
+    slot = residual_hand_;
+    residual_hand_ = (residual_hand_ + 1) % residual_capacity_;
+    residual_index_.erase(residual_keys_[slot]);
+    residual_keys_[slot] = key;
+    residual_used_[slot] = 0;
+    std::fill_n(residuals_.data() + slot * dim(), dim(), 0.0f);
+  }
+  residual_index_.emplace(key, static_cast<uint32_t>(slot));
+  return residuals_.data() + slot * dim();
+}
+
+void SparseGradCompressor::Encode() {
+  size_t num = merger_.size();
+  size_t dim = merger_.dim();
+  keys_.assign(merger_.keys().begin(), merger_.keys().end());
+  encoded_.resize(num * row_bytes_);
+  row_ptrs_.resize(num);
+  decoded_.resize(dim);
+  for (size_t i = 0; i < num; ++i) {
+    float *grad = merger_.row(i);
+    char *dst = encoded_.data() + i * row_bytes_;
+    row_ptrs_[i] = dst;
+    if (type_ == SparseGradCompressType::kFp32) {
+      EncodeSparseGradRow(type_, grad, dim, dst, nullptr);
+      continue;
+    }
+    // error feedback: send gradient + residual, keep what did not make it
+    float *res = residual(keys_[i]);
+    for (size_t j = 0; j < dim; ++j) {
+      grad[j] += res[j];
+    }
+    EncodeSparseGradRow(type_, grad, dim, dst, decoded_.data());
+    for (size_t j = 0; j < dim; ++j) {
+      res[j] = grad[j] - decoded_[j];
+    }
+  }
+  merger_.Clear();
+}
+
+}  // namespace paddle::distributed
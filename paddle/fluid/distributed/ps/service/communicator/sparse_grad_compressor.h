@@ -0,0 +1,136 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/distributed/ps/thirdparty/round_robin.h"
+
+namespace paddle {
+namespace distributed {
+
+// Encoding of the rows of a sparse push. The value is sent to the server as
+// the second param of PS_PUSH_SPARSE_TABLE, so it must not change.
+enum class SparseGradCompressType : uint32_t {
+  kFp32 = 0,
+  // every value as an IEEE half
+  kFp16 = 1,
+  // a float scale per row, then every value as round(value / scale)
+  kInt8 = 2,
+};
+
+// "fp32", "fp16" or "int8"
+SparseGradCompressType ParseSparseGradCompressType(const std::string &name);
+
+// bytes of an encoded row of `dim` values
+size_t SparseGradRowBytes(SparseGradCompressType type, size_t dim);
+
+// Encodes `dim` values of `src` to `dst`, which has SparseGradRowBytes of
+// room. If `decoded` is not null it gets the values the server will see.
+void EncodeSparseGradRow(SparseGradCompressType type,
+                         const float *src,
+                         size_t dim,
+                         char *dst,
+                         float *decoded);
+
+void DecodeSparseGradRow(SparseGradCompressType type,
+                         const char *src,
+                         size_t dim,
+                         float *dst);
+
+// Sums the rows of the same key. Keeps the keys in the order they were
+// first added.
+class SparseGradMerger {
+ public:
+  explicit SparseGradMerger(size_t dim) : dim_(dim) {}
+
+  void Add(const int64_t *keys, const float *values, size_t num);
+  void Clear();
+
+  size_t size() const { return keys_.size(); }
+  size_t dim() const { return dim_; }
+  const std::vector<uint64_t> &keys() const { return keys_; }
+  float *row(size_t i) { return values_.data() + i * dim_; }
+
+ private:
+  size_t dim_;
+  robin_hood::unordered_flat_map<uint64_t, uint32_t> index_;
+  std::vector<uint64_t> keys_;
+  std::vector<float> values_;
+};
+
+// Merge stage of the sparse gradients of one variable before they are
+// pushed.
+//
+// Gradients are merged by key, then encoded with `type`. What a row loses
+// to the encoding is kept as the residual of its key and added to the next
+// gradient of that key, so the sum of the pushed values follows the sum of
+// the gradients whatever the encoding.
+//
+// At most `residual_capacity` residuals are kept. When all are taken, a
+// CLOCK sweep drops the residual of a key that has not been pushed since the
+// hand last passed it, which loses at most one encoding error of that key.
+class SparseGradCompressor {
+ public:
+  SparseGradCompressor(SparseGradCompressType type,
+                       size_t dim,
+                       size_t residual_capacity = 1 << 20);
+
+  // adds rows to the pending gradients
+  void Merge(const int64_t *keys, const float *values, size_t num) {
+    merger_.Add(keys, values, num);
+  }
+
+  // Encodes the pending gradients and clears them. The encoded rows stay
+  // valid until the next call.
+  void Encode();
+
+  SparseGradCompressType type() const { return type_; }
+  size_t dim() const { return merger_.dim(); }
+  size_t row_bytes() const { return row_bytes_; }
+  size_t size() const { return keys_.size(); }
+  const uint64_t *keys() const { return keys_.data(); }
+  const char **rows() { return row_ptrs_.data(); }
+  // keys and encoded values of the last Encode
+  size_t encoded_bytes() const {
+    return keys_.size() * (sizeof(uint64_t) + row_bytes_);
+  }
+  size_t residual_size() const { return residual_index_.size(); }
+  size_t residual_capacity() const { return residual_capacity_; }
+
+ private:
+  float *residual(uint64_t key);
+
+  SparseGradCompressType type_;
+  size_t row_bytes_;
+  SparseGradMerger merger_;
+  std::vector<uint64_t> keys_;
+  std::vector<char> encoded_;
+  std::vector<const char *> row_ptrs_;
+  std::vector<float> decoded_;
+  size_t residual_capacity_;
+  robin_hood::unordered_flat_map<uint64_t, uint32_t> residual_index_;
+  std::vector<float> residuals_;
+  // key and reference bit of every residual slot, and the clock hand
+  std::vector<uint64_t> residual_keys_;
+  std::vector<uint8_t> residual_used_;
+  size_t residual_hand_ = 0;
+};
+
+}  // namespace distributed
+}  // namespace paddle
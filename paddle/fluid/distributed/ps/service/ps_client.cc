@@ -68,6 +68,23 @@ int32_t PSClient::Configure(  // called in FleetWrapper::InitWorker
   return Initialize();
 }
 
+std::future<int32_t> PSClient::PushSparseCompressedGradient(
+    size_t table_id,
+    const uint64_t *keys,
+    const char **rows,
+    size_t num,
+    SparseGradCompressType type,
+    void *done) {
+  size_t dim = GetTableAccessor(table_id)->GetAccessorInfo().update_dim;
+  std::vector<float> values(num * dim);
+  std::vector<const float *> value_ptrs(num);
+  for (size_t i = 0; i < num; ++i) {
+    DecodeSparseGradRow(type, rows[i], dim, values.data() + i * dim);
+    value_ptrs[i] = values.data() + i * dim;
+  }
+  return PushSparseRawGradient(table_id, keys, value_ptrs.data(), num, done);
+}
+
 PSClient *PSClientFactory::Create(const PSParameter &ps_config) {
   const auto &config = ps_config.server_param();
   if (!config.has_downpour_server_param()) {
@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "paddle/fluid/distributed/common/cost_timer.h"
+#include "paddle/fluid/distributed/ps/service/communicator/sparse_grad_compressor.h"
 #include "paddle/fluid/distributed/ps/service/env.h"
 #include "paddle/fluid/distributed/ps/service/sendrecv.pb.h"
 #include "paddle/fluid/distributed/ps/service/sparse_shard_value.h"
@@ -272,6 +273,17 @@ class PSClient {
       size_t num,
       void *done) = 0;
 
+  // Pushes `num` rows encoded by EncodeSparseGradRow with `type`. Decodes
+  // them and calls PushSparseRawGradient unless the client sends them
+  // encoded.
+  virtual std::future<int32_t> PushSparseCompressedGradient(
+      size_t table_id,
+      const uint64_t *keys,
+      const char **rows,
+      size_t num,
+      SparseGradCompressType type,
+      void *done);
+
   virtual std::future<int32_t> PushSparseRawGradientPartial(
       size_t table_id,
       const uint64_t *keys,
@@ -37,6 +37,7 @@
 #include "paddle/utils/string/string_helper.h"
 
 COMMON_DECLARE_bool(graph_load_in_parallel);
+COMMON_DECLARE_bool(graph_csr_sampling);
 COMMON_DECLARE_bool(graph_get_neighbor_id);
 COMMON_DECLARE_int32(gpugraph_storage_mode);
 COMMON_DECLARE_uint64(gpugraph_slot_feasign_max_num);
@@ -1772,6 +1773,7 @@ int32_t GraphTable::remove_graph_node(int idx, std::vector<uint64_t> &id_list) {
 }
 
 void GraphShard::clear() {
+  drop_csr();
   for (auto &item : bucket) {
     delete item;
   }
@@ -1784,6 +1786,7 @@ GraphShard::~GraphShard() { clear(); }
 void GraphShard::delete_node(uint64_t id) {
   auto iter = node_location.find(id);
   if (iter == node_location.end()) return;
+  drop_csr();
   int pos = iter->second;
   delete bucket[pos];
   if (pos != static_cast<int>(bucket.size()) - 1) {
@@ -1794,6 +1797,7 @@ void GraphShard::delete_node(uint64_t id) {
   bucket.pop_back();
 }
 GraphNode *GraphShard::add_graph_node(uint64_t id) {
+  drop_csr();
   if (node_location.find(id) == node_location.end()) {
     node_location[id] = bucket.size();
     bucket.push_back(new GraphNode(id));
@@ -1802,6 +1806,7 @@ GraphNode *GraphShard::add_graph_node(uint64_t id) {
 }
 
 GraphNode *GraphShard::add_graph_node(Node *node) {
+  drop_csr();
   auto id = node->get_id();
   if (node_location.find(id) == node_location.end()) {
     node_location[id] = bucket.size();
@@ -1829,9 +1834,16 @@ FeatureNode *GraphShard::add_feature_node(uint64_t id,
 }
 
 void GraphShard::add_neighbor(uint64_t id, uint64_t dst_id, float weight) {
+  drop_csr();
   find_node(id)->add_edge(dst_id, weight);
 }
 
+void GraphShard::build_csr(bool weighted) {
+  auto csr = std::make_shared<CsrGraphShard>();
+  csr->build(bucket, weighted);
+  std::atomic_store(&csr_, std::shared_ptr<const CsrGraphShard>(csr));
+}
+
 Node *GraphShard::find_node(uint64_t id) {
   auto iter = node_location.find(id);
   return iter == node_location.end() ? nullptr : bucket[iter->second];
@@ -2475,9 +2487,59 @@ int32_t GraphTable::build_sampler(int idx, std::string sample_type) {
       item->build_sampler(sample_type);
     }
   }
+  if (FLAGS_graph_csr_sampling) {
+    build_csr_shards(idx, sample_type);
+  }
+  return 0;
+}
+
+int32_t GraphTable::build_csr_shards(int idx, const std::string &sample_type) {
+  PADDLE_ENFORCE_EQ(
+      sample_type == "random" || sample_type == "weighted",
+      true,
+      common::errors::InvalidArgument(
+          "The sample type of CSR shards should be random or weighted, but "
+          "received %s.",
+          sample_type));
+  bool weighted = sample_type == "weighted";
+  auto &shards = edge_shards[idx];
+  std::vector<std::future<size_t>> tasks;
+  for (size_t i = 0; i < shards.size(); ++i) {
+    tasks.push_back(_shards_task_pool[get_thread_pool_index_by_shard_index(i)]
+                        ->enqueue([&shards, i, weighted]() -> size_t {
+                          shards[i]->build_csr(weighted);
+                          return shards[i]->get_csr()->bytes();
+                        }));
+  }
+  size_t bytes = 0;
+  for (auto &task : tasks) {
+    bytes += task.get();
+  }
+  VLOG(0) << "built CSR shards of edge type " << idx << ", " << bytes
+          << " bytes";
   return 0;
 }
 
+bool GraphTable::get_csr_shards(
+    int idx, std::vector<std::shared_ptr<const CsrGraphShard>> *csrs) {
+  if (use_cache) {
+    return false;
+  }
+#ifdef PADDLE_WITH_HETERPS
+  if (search_level == 2) {
+    return false;
+  }
+#endif
+  csrs->clear();
+  for (auto *shard : edge_shards[idx]) {
+    csrs->push_back(shard->get_csr());
+    if (csrs->back() == nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+
 std::pair<uint64_t, uint64_t> GraphTable::parse_edge_file(
     const std::string &path, int idx, bool reverse, bool use_weight) {
   is_weighted_ = use_weight;
@@ -2635,6 +2697,9 @@ int32_t GraphTable::load_edges(const std::string &path,
         item->build_sampler(sample_type);
       }
     }
+    if (FLAGS_graph_csr_sampling) {
+      build_csr_shards(idx, sample_type);
+    }
   }
 
   return 0;
@@ -2776,6 +2841,13 @@ int32_t GraphTable::random_sample_neighbors(
     std::vector<std::shared_ptr<char>> &buffers,
     std::vector<int> &actual_sizes,
     bool need_weight) {
+  if (FLAGS_graph_csr_sampling) {
+    std::vector<std::shared_ptr<const CsrGraphShard>> csrs;
+    if (get_csr_shards(idx, &csrs)) {
+      return random_sample_neighbors_csr(
+          csrs, node_ids, sample_size, buffers, actual_sizes, need_weight);
+    }
+  }
   size_t node_num = buffers.size();
   std::function<void(char *)> char_del = [](char *c) { delete[] c; };
   std::vector<std::future<int>> tasks;
@@ -2796,7 +2868,7 @@ int32_t GraphTable::random_sample_neighbors(
       LRUResponse response = LRUResponse::blocked;
       if (use_cache) {
         response =
-            scaled_lru->query(i, id_list[i].data(), id_list[i].size(), r);
+            sample_cache->query(i, id_list[i].data(), id_list[i].size(), r);
       }
       size_t index = 0;
       std::vector<SampleResult> sample_res;
@@ -2864,7 +2936,7 @@ int32_t GraphTable::random_sample_neighbors(
         }
       }
       if (!sample_res.empty()) {
-        scaled_lru->insert(
+        sample_cache->insert(
             i, sample_keys.data(), sample_res.data(), sample_keys.size());
       }
       return 0;
@@ -2876,6 +2948,85 @@ int32_t GraphTable::random_sample_neighbors(
   return 0;
 }
 
+int32_t GraphTable::random_sample_neighbors_csr(
+    const std::vector<std::shared_ptr<const CsrGraphShard>> &csr_shards,
+    uint64_t *node_ids,
+    int sample_size,
+    std::vector<std::shared_ptr<char>> &buffers,
+    std::vector<int> &actual_sizes,
+    bool need_weight) {
+  size_t node_num = buffers.size();
+  size_t item_size =
+      need_weight ? Node::id_size + Node::weight_size : Node::id_size;
+  std::vector<std::vector<size_t>> seq_id(task_pool_size_);
+  for (size_t idy = 0; idy < node_num; ++idy) {
+    seq_id[get_thread_pool_index(node_ids[idy])].push_back(idy);
+  }
+
+  std::vector<std::future<int>> tasks;
+  for (size_t i = 0; i < seq_id.size(); i++) {
+    if (seq_id[i].empty()) continue;
+    tasks.push_back(_shards_task_pool[i]->enqueue([&, i, this]() -> int {
+      const std::vector<size_t> &ids = seq_id[i];
+      // Look up all the rows first, so the samples of all the nodes of the
+      // task go to one buffer.
+      std::vector<const CsrGraphShard *> csrs(ids.size(), nullptr);
+      std::vector<int64_t> rows(ids.size(), -1);
+      size_t total_num = 0;
+      for (size_t k = 0; k < ids.size(); ++k) {
+        uint64_t node_id = node_ids[ids[k]];
+        size_t shard_id = node_id % shard_num;
+        if (shard_id >= shard_end || shard_id < shard_start) {
+          continue;
+        }
+        csrs[k] = csr_shards[shard_id - shard_start].get();
+        rows[k] = csrs[k]->find_row(node_id);
+        if (rows[k] >= 0 && sample_size > 0) {
+          total_num += std::min(static_cast<size_t>(sample_size),
+                                static_cast<size_t>(csrs[k]->degree(rows[k])));
+        }
+      }
+
+      std::shared_ptr<char> batch(new char[total_num * item_size],
+                                  std::default_delete<char[]>());
+      char *buffer_addr = batch.get();
+      std::vector<uint32_t> positions;
+      std::mt19937_64 *rng = _shards_task_rng_pool[i].get();
+      for (size_t k = 0; k < ids.size(); ++k) {
+        size_t idy = ids[k];
+        if (rows[k] < 0) {
+          actual_sizes[idy] = 0;
+          continue;
+        }
+        csrs[k]->sample_k(rows[k], sample_size, rng, &positions);
+        buffers[idy] = std::shared_ptr<char>(batch, buffer_addr);
+        actual_sizes[idy] = static_cast<int>(positions.size() * item_size);
+        for (uint32_t pos : positions) {
+          uint64_t id = csrs[k]->neighbor_id(rows[k], pos);
+          memcpy(buffer_addr, &id, Node::id_size);
+          buffer_addr += Node::id_size;
+          if (need_weight) {
+            // same weights as the node path, which only keeps them for gpu
+            // graph tables
+#if defined(PADDLE_WITH_HETERPS) && defined(PADDLE_WITH_PSCORE)
+            float weight = csrs[k]->neighbor_weight(rows[k], pos);
+#else
+            float weight = 1.0;
+#endif
+            memcpy(buffer_addr, &weight, Node::weight_size);
+            buffer_addr += Node::weight_size;
+          }
+        }
+      }
+      return 0;
+    }));
+  }
+  for (auto &t : tasks) {
+    t.get();
+  }
+  return 0;
+}
+
 int32_t GraphTable::get_nodes_ids_by_ranges(
     GraphTableType table_type,
     int idx,
@@ -3442,11 +3593,15 @@ int32_t GraphTable::Initialize(const GraphParameter &graph) {
     _shard_idx = 0;
     shard_num = graph.shard_num();
   }
-  use_cache = graph.use_cache();
-  if (use_cache) {
+  use_cache = false;
+  if (graph.use_cache()) {
     cache_size_limit = graph.cache_size_limit();
     cache_ttl = graph.cache_ttl();
-    make_neighbor_sample_cache(cache_size_limit, cache_ttl);
+    // without a byte budget, count 256 bytes per cached sample result
+    size_t capacity_bytes = graph.cache_bytes_limit() > 0
+                                ? graph.cache_bytes_limit()
+                                : static_cast<size_t>(cache_size_limit) * 256;
+    make_neighbor_sample_cache(capacity_bytes, cache_ttl);
   }
   _shards_task_pool.resize(task_pool_size_);
   for (size_t i = 0; i < _shards_task_pool.size(); ++i) {
@@ -41,7 +41,9 @@
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/common_table.h"
 #include "paddle/fluid/distributed/ps/table/graph/class_macro.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr_shard.h"
 #include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_sample_cache.h"
 #include "paddle/fluid/distributed/ps/thirdparty/round_robin.h"
 #include "paddle/phi/core/utils/rw_lock.h"
 #include "paddle/utils/string/string_helper.h"
@@ -132,6 +134,13 @@ class GraphShard {
   std::unordered_map<uint64_t, int> &get_node_location() {
     return node_location;
   }
+  // Builds the CSR copy of the edges, which adding or deleting nodes drops.
+  void build_csr(bool weighted);
+  // Snapshot of the CSR copy, null if it has been dropped. Samplers keep the
+  // snapshot, so a concurrent drop does not free it under them.
+  std::shared_ptr<const CsrGraphShard> get_csr() const {
+    return std::atomic_load(&csr_);
+  }
 
   void shrink_to_fit() {
     bucket.shrink_to_fit();
@@ -141,6 +150,7 @@ class GraphShard {
   }
 
   void merge_shard(GraphShard *&shard) {  // NOLINT
+    drop_csr();
     bucket.reserve(bucket.size() + shard->bucket.size());
     for (size_t i = 0; i < shard->bucket.size(); i++) {
       auto node_id = shard->bucket[i]->get_id();
@@ -158,9 +168,14 @@ class GraphShard {
  public:
   std::unordered_map<uint64_t, int> node_location;
   std::vector<Node *> bucket;
-};
 
-enum LRUResponse { ok = 0, blocked = 1, err = 2 };
+ private:
+  void drop_csr() {
+    std::atomic_store(&csr_, std::shared_ptr<const CsrGraphShard>());
+  }
+
+  std::shared_ptr<const CsrGraphShard> csr_;
+};
 
 struct SampleKey {
   int idx;
@@ -194,252 +209,6 @@ class SampleResult {
   ~SampleResult() {}
 };
 
-template <typename K, typename V>
-class LRUNode {
- public:
-  LRUNode(K _key, V _data, size_t _ttl) : key(_key), data(_data), ttl(_ttl) {
-    next = pre = NULL;
-  }
-  K key;
-  V data;
-  size_t ttl;
-  // time to live
-  LRUNode<K, V> *pre, *next;
-};
-template <typename K, typename V>
-class ScaledLRU;
-
-template <typename K, typename V>
-class RandomSampleLRU {
- public:
-  explicit RandomSampleLRU(ScaledLRU<K, V> *_father) {
-    father = _father;
-    remove_count = 0;
-    node_size = 0;
-    node_head = node_end = NULL;
-    global_ttl = father->ttl;
-    total_diff = 0;
-  }
-
-  ~RandomSampleLRU() {
-    LRUNode<K, V> *p;
-    while (node_head != NULL) {
-      p = node_head->next;
-      delete node_head;
-      node_head = p;
-    }
-  }
-  LRUResponse query(K *keys,
-                    size_t length,
-                    std::vector<std::pair<K, V>> &res) {  // NOLINT
-    if (pthread_rwlock_tryrdlock(&father->rwlock) != 0)
-      return LRUResponse::blocked;
-    // pthread_rwlock_rdlock(&father->rwlock);
-    int init_size = node_size - remove_count;
-    process_redundant(length * 3);
-
-    for (size_t i = 0; i < length; i++) {
-      auto iter = key_map.find(keys[i]);
-      if (iter != key_map.end()) {
-        res.emplace_back(keys[i], iter->second->data);
-        iter->second->ttl--;
-        if (iter->second->ttl == 0) {
-          remove(iter->second);
-          if (remove_count != 0) remove_count--;
-        } else {
-          move_to_tail(iter->second);
-        }
-      }
-    }
-    total_diff += node_size - remove_count - init_size;
-    if (total_diff >= 500 || total_diff < -500) {
-      father->handle_size_diff(total_diff);
-      total_diff = 0;
-    }
-    pthread_rwlock_unlock(&father->rwlock);
-    return LRUResponse::ok;
-  }
-  LRUResponse insert(K *keys, V *data, size_t length) {
-    if (pthread_rwlock_tryrdlock(&father->rwlock) != 0)
-      return LRUResponse::blocked;
-    // pthread_rwlock_rdlock(&father->rwlock);
-    int init_size = node_size - remove_count;
-    process_redundant(length * 3);
-    for (size_t i = 0; i < length; i++) {
-      auto iter = key_map.find(keys[i]);
-      if (iter != key_map.end()) {
-        move_to_tail(iter->second);
-        iter->second->ttl = global_ttl;
-        iter->second->data = data[i];
-      } else {
-        LRUNode<K, V> *temp = new LRUNode<K, V>(keys[i], data[i], global_ttl);
-        add_new(temp);
-      }
-    }
-    total_diff += node_size - remove_count - init_size;
-    if (total_diff >= 500 || total_diff < -500) {
-      father->handle_size_diff(total_diff);
-      total_diff = 0;
-    }
-
-    pthread_rwlock_unlock(&father->rwlock);
-    return LRUResponse::ok;
-  }
-  void remove(LRUNode<K, V> *node) {
-    fetch(node);
-    node_size--;
-    key_map.erase(node->key);
-    delete node;
-  }
-
-  void process_redundant(int process_size) {
-    int length = std::min(remove_count, process_size);
-    while (length--) {
-      remove(node_head);
-      remove_count--;
-    }
-  }
-
-  void move_to_tail(LRUNode<K, V> *node) {
-    fetch(node);
-    place_at_tail(node);
-  }
-
-  void add_new(LRUNode<K, V> *node) {
-    node->ttl = global_ttl;
-    place_at_tail(node);
-    node_size++;
-    key_map[node->key] = node;
-  }
-  void place_at_tail(LRUNode<K, V> *node) {
-    if (node_end == NULL) {
-      node_head = node_end = node;
-      node->next = node->pre = NULL;
-    } else {
-      node_end->next = node;
-      node->pre = node_end;
-      node->next = NULL;
-      node_end = node;
-    }
-  }
-
-  void fetch(LRUNode<K, V> *node) {
-    if (node->pre) {
-      node->pre->next = node->next;
-    } else {
-      node_head = node->next;
-    }
-    if (node->next) {
-      node->next->pre = node->pre;
-    } else {
-      node_end = node->pre;
-    }
-  }
-
- private:
-  std::unordered_map<K, LRUNode<K, V> *> key_map;
-  ScaledLRU<K, V> *father;
-  size_t global_ttl, size_limit;
-  int node_size, total_diff;
-  LRUNode<K, V> *node_head, *node_end;
-  friend class ScaledLRU<K, V>;
-  int remove_count;
-};
-
-template <typename K, typename V>
-class ScaledLRU {
- public:
-  ScaledLRU(size_t _shard_num, size_t size_limit, size_t _ttl)
-      : size_limit(size_limit), ttl(_ttl) {
-    shard_num = _shard_num;
-    pthread_rwlock_init(&rwlock, NULL);
-    stop = false;
-    thread_pool.reset(new ::ThreadPool(1));
-    global_count = 0;
-    lru_pool = std::vector<RandomSampleLRU<K, V>>(shard_num,
-                                                  RandomSampleLRU<K, V>(this));
-    shrink_job = std::thread([this]() -> void {
-      while (true) {
-        {
-          std::unique_lock<std::mutex> lock(mutex_);
-          cv_.wait_for(lock, std::chrono::milliseconds(20000));
-          if (stop) {
-            return;
-          }
-        }
-        auto status =
-            thread_pool->enqueue([this]() -> int { return Shrink(); });
-        status.wait();
-      }
-    });
-    shrink_job.detach();
-  }
-  ~ScaledLRU() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    stop = true;
-    cv_.notify_one();
-  }
-  LRUResponse query(size_t index,
-                    K *keys,
-                    size_t length,
-                    std::vector<std::pair<K, V>> &res) {  // NOLINT
-    return lru_pool[index].query(keys, length, res);
-  }
-  LRUResponse insert(size_t index, K *keys, V *data, size_t length) {
-    return lru_pool[index].insert(keys, data, length);
-  }
-  int Shrink() {
-    size_t node_size = 0;
-    for (size_t i = 0; i < lru_pool.size(); i++) {
-      node_size += lru_pool[i].node_size - lru_pool[i].remove_count;
-    }
-
-    if (node_size <= static_cast<size_t>(1.1 * size_limit) + 1) return 0;
-    if (pthread_rwlock_wrlock(&rwlock) == 0) {
-      global_count = 0;
-      for (size_t i = 0; i < lru_pool.size(); i++) {
-        global_count += lru_pool[i].node_size - lru_pool[i].remove_count;
-      }
-      if (static_cast<size_t>(global_count) > size_limit) {
-        size_t remove = global_count - size_limit;
-        for (size_t i = 0; i < lru_pool.size(); i++) {
-          lru_pool[i].total_diff = 0;
-          lru_pool[i].remove_count +=
-              1.0 * (lru_pool[i].node_size - lru_pool[i].remove_count) /
-              global_count * remove;
-        }
-      }
-      pthread_rwlock_unlock(&rwlock);
-      return 0;
-    }
-    return 0;
-  }
-
-  void handle_size_diff(int diff) {
-    if (diff != 0) {
-      __sync_fetch_and_add(&global_count, diff);
-      if (global_count > static_cast<int>(1.25 * size_limit)) {
-        thread_pool->enqueue([this]() -> int { return Shrink(); });
-      }
-    }
-  }
-
-  size_t get_ttl() { return ttl; }
-
- private:
-  pthread_rwlock_t rwlock;
-  size_t shard_num;
-  int global_count;
-  size_t size_limit, total, hit;
-  size_t ttl;
-  bool stop;
-  std::thread shrink_job;
-  std::vector<RandomSampleLRU<K, V>> lru_pool;
-  mutable std::mutex mutex_;
-  std::condition_variable cv_;
-  std::shared_ptr<::ThreadPool> thread_pool;
-  friend class RandomSampleLRU<K, V>;
-};
 enum GraphTableType { EDGE_TABLE, FEATURE_TABLE, NODE_TABLE };
 class GraphTable : public Table {
   class GraphNodeRank {
@@ -551,6 +320,15 @@ class GraphTable : public Table {
       std::vector<int> &actual_sizes,               // NOLINT
       bool need_weight);
 
+  // random_sample_neighbors over snapshots of the CSR shards of edge type idx
+  int32_t random_sample_neighbors_csr(
+      const std::vector<std::shared_ptr<const CsrGraphShard>> &csrs,
+      uint64_t *node_ids,
+      int sample_size,
+      std::vector<std::shared_ptr<char>> &buffers,  // NOLINT
+      std::vector<int> &actual_sizes,               // NOLINT
+      bool need_weight);
+
   int32_t random_sample_nodes(GraphTableType table_type,
                               int idx,
                               int sample_size,
@@ -703,17 +481,23 @@ class GraphTable : public Table {
   void release_graph();
   void release_graph_edge();
   void release_graph_node();
-  virtual int32_t make_neighbor_sample_cache(size_t size_limit, size_t ttl) {
+  // Caches the sampled neighbors within `capacity_bytes`, each result is
+  // served `ttl` times before the node is sampled again.
+  virtual int32_t make_neighbor_sample_cache(size_t capacity_bytes,
+                                             size_t ttl) {
     {
       std::unique_lock<std::mutex> lock(mutex_);
       if (use_cache == false) {
-        scaled_lru.reset(new ScaledLRU<SampleKey, SampleResult>(
-            task_pool_size_, size_limit, ttl));
+        sample_cache.reset(new ShardedSampleCache<SampleKey, SampleResult>(
+            task_pool_size_, capacity_bytes, ttl));
         use_cache = true;
       }
     }
     return 0;
   }
+  SampleCacheStats neighbor_sample_cache_stats() const {
+    return sample_cache ? sample_cache->stats() : SampleCacheStats();
+  }
   virtual void load_node_weight(int type_id, int idx, std::string path);
 #ifdef PADDLE_WITH_HETERPS
   virtual void make_partitions(int idx, int64_t gb_size, int device_len);
@@ -769,6 +553,16 @@ class GraphTable : public Table {
 #endif
   virtual int32_t add_comm_edge(int idx, uint64_t src_id, uint64_t dst_id);
   virtual int32_t build_sampler(int idx, std::string sample_type = "random");
+  // Builds the CSR copies of the edge shards of edge type idx, which
+  // random_sample_neighbors samples from under FLAGS_graph_csr_sampling.
+  virtual int32_t build_csr_shards(int idx,
+                                   const std::string &sample_type = "random");
+  // Snapshots the CSR copies of the edge shards of edge type idx, returns
+  // false if the CSR path does not apply: one of the copies has been dropped,
+  // or the sample cache or the ssd fallback, which only the node path
+  // implements, is in use.
+  bool get_csr_shards(
+      int idx, std::vector<std::shared_ptr<const CsrGraphShard>> *csrs);
   void set_slot_feature_separator(const std::string &ch);
   void set_feature_separator(const std::string &ch);
 
@@ -825,7 +619,7 @@ class GraphTable : public Table {
   std::vector<std::shared_ptr<::ThreadPool>> _cpu_worker_pool;
   std::vector<std::shared_ptr<std::mt19937_64>> _shards_task_rng_pool;
   std::shared_ptr<::ThreadPool> load_node_edge_task_pool;
-  std::shared_ptr<ScaledLRU<SampleKey, SampleResult>> scaled_lru;
+  std::shared_ptr<ShardedSampleCache<SampleKey, SampleResult>> sample_cache;
   std::unordered_set<uint64_t> extra_nodes;
   std::unordered_map<uint64_t, size_t> extra_nodes_to_thread_index;
   bool use_cache, use_duplicate_nodes;
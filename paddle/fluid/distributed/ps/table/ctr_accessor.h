@@ -178,12 +178,18 @@ class CtrCommonAccessor : public ValueAccessor {
   int32_t ParseFromString(const std::string& str, float* v) override;
   virtual bool CreateValue(int type, const float* value);
 
-  // 这个接口目前只用来取show
+  // 取show、click以及show/click综合得分, 得分用于SSD分层存储的准入
   float GetField(float* value, const std::string& name) override {
-    // CHECK(name == "show");
     if (name == "show") {
       return common_feature_value.Show(value);
     }
+    if (name == "click") {
+      return common_feature_value.Click(value);
+    }
+    if (name == "show_click_score") {
+      return ShowClickScore(common_feature_value.Show(value),
+                            common_feature_value.Click(value));
+    }
     return 0.0;
   }
 
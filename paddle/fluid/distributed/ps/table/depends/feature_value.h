@@ -136,6 +136,11 @@ struct alignas(64) SparseTableShard {
     }
     return {it, bucket, _buckets};
   }
+  // The mct buckets are opaque, so only the map header of the target bucket
+  // can be prefetched ahead of a `find(key)`.
+  void prefetch(const KEY& key) {
+    __builtin_prefetch(&_buckets[compute_bucket(_hasher(key))], 0, 1);
+  }
   VALUE& operator[](const KEY& key) { return emplace(key).first.value(); }
   std::pair<iterator, bool> insert(const KEY& key, const VALUE& val) {
     return emplace(key, val);
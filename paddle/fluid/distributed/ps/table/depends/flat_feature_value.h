@@ -0,0 +1,490 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <sys/mman.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace distributed {
+
+// A feature value whose floats are stored inline right after this header,
+// inside a fixed-stride slot of FlatValueSlab. It keeps the same interface
+// as FixedFeatureValue, but `resize` can not grow beyond the capacity the
+// slot was created with (the accessor's full value dim).
+class FlatFeatureValue {
+ public:
+  float* data() { return reinterpret_cast<float*>(this + 1); }
+  size_t size() { return _size; }
+  size_t capacity() { return _capacity; }
+  void resize(size_t size) {
+    PADDLE_ENFORCE_LE(
+        size,
+        _capacity,
+        common::errors::OutOfRange(
+            "FlatFeatureValue can not be resized to %d, capacity is %d.",
+            size,
+            _capacity));
+    if (size > _size) {
+      memset(data() + _size, 0, sizeof(float) * (size - _size));
+    }
+    _size = static_cast<uint32_t>(size);
+  }
+  void shrink_to_fit() {}
+
+ private:
+  friend class FlatValueSlab;
+  uint32_t _size;
+  uint32_t _capacity;
+};
+
+// Allocates FlatFeatureValue slots of `dim` floats from large aligned slabs.
+// Released slots are kept in an intrusive free list and reused first. A slab
+// may also adopt an mmaped region that already holds values of the same
+// stride, see SparseSnapshotReader.
+class FlatValueSlab {
+ public:
+  explicit FlatValueSlab(size_t dim = 0, size_t slab_value_num = 4096)
+      : _slab_value_num(slab_value_num) {
+    set_dim(dim);
+  }
+  FlatValueSlab(const FlatValueSlab&) = delete;
+  ~FlatValueSlab() {
+    for (auto* slab : _slabs) {
+      free(slab);
+    }
+    for (auto& mapping : _mappings) {
+      munmap(mapping.first, mapping.second);
+    }
+  }
+
+  static size_t stride_of(size_t dim) {
+    // keep every slot 8 bytes aligned, so that a released slot can hold the
+    // free list pointer.
+    return (sizeof(FlatFeatureValue) + sizeof(float) * dim + 7) & ~7UL;
+  }
+
+  void set_dim(size_t dim) {
+    PADDLE_ENFORCE_EQ(_counter,
+                      0,
+                      common::errors::PreconditionNotMet(
+                          "FlatValueSlab dim can only be changed when empty."));
+    _dim = dim;
+    _stride = stride_of(dim);
+  }
+  size_t dim() const { return _dim; }
+  size_t stride() const { return _stride; }
+  size_t size() const { return _counter; }
+  size_t memory_size() const {
+    return _slabs.size() * _slab_value_num * _stride;
+  }
+
+  FlatFeatureValue* acquire() {
+    if (_free_nodes == nullptr) {
+      create_new_slab();
+    }
+    FreeNode* node = _free_nodes;
+    _free_nodes = node->next;
+    auto* value = reinterpret_cast<FlatFeatureValue*>(node);
+    value->_size = 0;
+    value->_capacity = static_cast<uint32_t>(_dim);
+    _counter++;
+    return value;
+  }
+  // Takes the ownership of a mapping holding `value_num` acquired values,
+  // the mapping is unmapped when the slab is destroyed.
+  void adopt(char* base, size_t length, size_t value_num) {
+    _mappings.emplace_back(base, length);
+    _counter += value_num;
+  }
+  void release(FlatFeatureValue* value) {
+    FreeNode* node = reinterpret_cast<FreeNode*>(value);
+    node->next = _free_nodes;
+    _free_nodes = node;
+    _counter--;
+  }
+
+ private:
+  struct FreeNode {
+    FreeNode* next;
+  };
+
+  void create_new_slab() {
+    char* slab = nullptr;
+    size_t alloc_size = _stride * _slab_value_num;
+    int error = posix_memalign(reinterpret_cast<void**>(&slab), 64, alloc_size);
+    PADDLE_ENFORCE_EQ(error,
+                      0,
+                      common::errors::ResourceExhausted(
+                          "Fail to alloc memory of %ld size, error code is %d.",
+                          alloc_size,
+                          error));
+    _slabs.push_back(slab);
+    // push in reverse order so that values are handed out by address.
+    for (size_t i = _slab_value_num; i > 0; --i) {
+      FreeNode* node = reinterpret_cast<FreeNode*>(slab + (i - 1) * _stride);
+      node->next = _free_nodes;
+      _free_nodes = node;
+    }
+  }
+
+  size_t _dim = 0;
+  size_t _stride = 0;
+  size_t _slab_value_num;
+  std::vector<char*> _slabs;
+  std::vector<std::pair<char*, size_t>> _mappings;
+  FreeNode* _free_nodes = nullptr;
+  size_t _counter = 0;
+};
+
+// std::hash of integral keys is the identity, and all keys of one local shard
+// share the same residue of `key % shard_num`, so the bits are mixed before
+// they are split into the probe position and the control byte.
+template <class KEY>
+struct FlatKeyHasher {
+  size_t operator()(const KEY& key) const {
+    uint64_t x = static_cast<uint64_t>(std::hash<KEY>()(key));
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return static_cast<size_t>(x);
+  }
+};
+
+// Control bytes of FlatSparseTableShard. A full slot stores the low 7 bits
+// of the key hash, empty and deleted slots have the sign bit set.
+static const int8_t FLAT_CTRL_EMPTY = -128;
+static const int8_t FLAT_CTRL_DELETED = -2;
+static const size_t FLAT_GROUP_WIDTH = 16;
+
+// Bit i is set if byte i of a 16 bytes control group matches.
+class FlatProbeGroup {
+ public:
+  explicit FlatProbeGroup(const int8_t* ctrl) {
+#if defined(__SSE2__)
+    _ctrl = _mm_load_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+    _ctrl = ctrl;
+#endif
+  }
+  uint32_t Match(int8_t h2) const {
+#if defined(__SSE2__)
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), _ctrl)));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < FLAT_GROUP_WIDTH; ++i) {
+      mask |= static_cast<uint32_t>(_ctrl[i] == h2) << i;
+    }
+    return mask;
+#endif
+  }
+  uint32_t MatchEmpty() const { return Match(FLAT_CTRL_EMPTY); }
+  uint32_t MatchEmptyOrDeleted() const {
+#if defined(__SSE2__)
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), _ctrl)));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < FLAT_GROUP_WIDTH; ++i) {
+      mask |= static_cast<uint32_t>(_ctrl[i] < -1) << i;
+    }
+    return mask;
+#endif
+  }
+
+ private:
+#if defined(__SSE2__)
+  __m128i _ctrl;
+#else
+  const int8_t* _ctrl;
+#endif
+};
+
+// An open-addressing shard for MemorySparseTable. Keys live in a flat slot
+// array probed a group of 16 control bytes at a time (SwissTable style), and
+// values live inline in a FlatValueSlab, so a lookup touches one control
+// group, one slot and the value itself. Value addresses are stable across
+// rehash. It exposes the subset of the SparseTableShard interface used by
+// MemorySparseTable.
+template <class KEY, class HASH = FlatKeyHasher<KEY>>
+struct alignas(64) FlatSparseTableShard {
+ public:
+  typedef FlatFeatureValue value_type;
+  struct slot_type {
+    KEY key;
+    FlatFeatureValue* value;
+  };
+  struct iterator {
+    FlatSparseTableShard* shard;
+    size_t index;
+    friend bool operator==(const iterator& a, const iterator& b) {
+      return a.index == b.index;
+    }
+    friend bool operator!=(const iterator& a, const iterator& b) {
+      return a.index != b.index;
+    }
+    const KEY& key() const { return shard->_slots[index].key; }
+    FlatFeatureValue& value() const { return *shard->_slots[index].value; }
+    FlatFeatureValue* value_ptr() const { return shard->_slots[index].value; }
+    iterator& operator++() {
+      index = shard->next_full(index + 1);
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator ret = *this;
+      ++*this;
+      return ret;
+    }
+  };
+
+  FlatSparseTableShard() = default;
+  FlatSparseTableShard(const FlatSparseTableShard&) = delete;
+  ~FlatSparseTableShard() {
+    clear();
+    free(_ctrl);
+    free(_slots);
+  }
+
+  // Must be called before the first insertion, `value_dim` is the number of
+  // floats reserved inline for every value.
+  void set_value_dim(size_t value_dim) { _alloc.set_dim(value_dim); }
+  size_t value_dim() const { return _alloc.dim(); }
+  bool empty() { return _size == 0; }
+  size_t size() { return _size; }
+  size_t capacity() { return _capacity; }
+  size_t memory_size() {
+    return _capacity * (sizeof(slot_type) + 1) + _alloc.memory_size();
+  }
+  void set_max_load_factor(float x) { _max_load_factor = x; }
+  void reserve(size_t num) {
+    size_t need = static_cast<size_t>(num / _max_load_factor) + 1;
+    if (need > _capacity) {
+      rehash(normalize_capacity(need));
+    }
+  }
+  void clear() {
+    for (size_t i = 0; i < _capacity; ++i) {
+      if (_ctrl[i] >= 0) {
+        _alloc.release(_slots[i].value);
+      }
+    }
+    if (_ctrl != nullptr) {
+      memset(_ctrl, FLAT_CTRL_EMPTY, _capacity);
+    }
+    _size = 0;
+    _deleted = 0;
+  }
+  iterator begin() { return {this, next_full(0)}; }
+  iterator end() { return {this, _capacity}; }
+  iterator find(const KEY& key) {
+    size_t hash = _hasher(key);
+    return {this, find_with_hash(key, hash)};
+  }
+  // Hints the cpu to load the control group a later `find(key)` will probe.
+  void prefetch(const KEY& key) {
+    if (_capacity == 0) {
+      return;
+    }
+    size_t group = probe_start(_hasher(key));
+    __builtin_prefetch(_ctrl + group * FLAT_GROUP_WIDTH, 0, 1);
+    __builtin_prefetch(_slots + group * FLAT_GROUP_WIDTH, 0, 1);
+  }
+  FlatFeatureValue& operator[](const KEY& key) {
+    return emplace(key).first.value();
+  }
+  std::pair<iterator, bool> emplace(const KEY& key) {
+    size_t hash = _hasher(key);
+    size_t index = find_with_hash(key, hash);
+    if (index != _capacity) {
+      return {{this, index}, false};
+    }
+    if ((_size + _deleted + 1) > _capacity * _max_load_factor) {
+      // drop tombstones in place if they take most of the space, otherwise
+      // grow.
+      rehash(_size * 2 < _capacity ? _capacity
+                                   : normalize_capacity(_capacity * 2));
+    }
+    index = find_insert_slot(hash);
+    if (_ctrl[index] == FLAT_CTRL_DELETED) {
+      --_deleted;
+    }
+    _ctrl[index] = h2(hash);
+    _slots[index].key = key;
+    _slots[index].value = _alloc.acquire();
+    ++_size;
+    return {{this, index}, true};
+  }
+  // Inserts a value that was not acquired from this shard, e.g. one inside a
+  // mapping handed over by `adopt_values`.
+  bool insert_value(const KEY& key, FlatFeatureValue* value) {
+    size_t hash = _hasher(key);
+    if (find_with_hash(key, hash) != _capacity) {
+      return false;
+    }
+    if ((_size + _deleted + 1) > _capacity * _max_load_factor) {
+      rehash(normalize_capacity(_capacity * 2));
+    }
+    size_t index = find_insert_slot(hash);
+    if (_ctrl[index] == FLAT_CTRL_DELETED) {
+      --_deleted;
+    }
+    _ctrl[index] = h2(hash);
+    _slots[index].key = key;
+    _slots[index].value = value;
+    ++_size;
+    return true;
+  }
+  void adopt_values(char* base, size_t length, size_t value_num) {
+    _alloc.adopt(base, length, value_num);
+  }
+  iterator erase(iterator it) {
+    quick_erase(it);
+    return {this, next_full(it.index + 1)};
+  }
+  void quick_erase(iterator it) {
+    _alloc.release(_slots[it.index].value);
+    _ctrl[it.index] = FLAT_CTRL_DELETED;
+    --_size;
+    ++_deleted;
+  }
+  size_t erase(const KEY& key) {
+    auto it = find(key);
+    if (it == end()) {
+      return 0;
+    }
+    quick_erase(it);
+    return 1;
+  }
+
+ private:
+  static int8_t h2(size_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+  static size_t normalize_capacity(size_t num) {
+    size_t capacity = FLAT_GROUP_WIDTH;
+    while (capacity < num) {
+      capacity <<= 1;
+    }
+    return capacity;
+  }
+  size_t probe_start(size_t hash) const {
+    return (hash >> 7) & (_capacity / FLAT_GROUP_WIDTH - 1);
+  }
+
+  // Triangular probing over groups visits every group once since the group
+  // number is a power of two.
+  size_t find_with_hash(const KEY& key, size_t hash) const {
+    if (_capacity == 0) {
+      return _capacity;
+    }
+    size_t group_mask = _capacity / FLAT_GROUP_WIDTH - 1;
+    size_t group = probe_start(hash);
+    for (size_t step = 1; step <= group_mask + 1; ++step) {
+      size_t base = group * FLAT_GROUP_WIDTH;
+      FlatProbeGroup probe(_ctrl + base);
+      for (uint32_t mask = probe.Match(h2(hash)); mask != 0;
+           mask &= mask - 1) {
+        size_t index = base + __builtin_ctz(mask);
+        if (_slots[index].key == key) {
+          return index;
+        }
+      }
+      if (probe.MatchEmpty() != 0) {
+        break;
+      }
+      group = (group + step) & group_mask;
+    }
+    return _capacity;
+  }
+  size_t find_insert_slot(size_t hash) const {
+    size_t group_mask = _capacity / FLAT_GROUP_WIDTH - 1;
+    size_t group = probe_start(hash);
+    for (size_t step = 1;; ++step) {
+      size_t base = group * FLAT_GROUP_WIDTH;
+      uint32_t mask = FlatProbeGroup(_ctrl + base).MatchEmptyOrDeleted();
+      if (mask != 0) {
+        return base + __builtin_ctz(mask);
+      }
+      group = (group + step) & group_mask;
+    }
+  }
+  size_t next_full(size_t index) const {
+    while (index < _capacity && _ctrl[index] < 0) {
+      ++index;
+    }
+    return index;
+  }
+  void rehash(size_t new_capacity) {
+    int8_t* old_ctrl = _ctrl;
+    slot_type* old_slots = _slots;
+    size_t old_capacity = _capacity;
+
+    int error = posix_memalign(
+        reinterpret_cast<void**>(&_ctrl), FLAT_GROUP_WIDTH, new_capacity);
+    PADDLE_ENFORCE_EQ(error,
+                      0,
+                      common::errors::ResourceExhausted(
+                          "Fail to alloc memory of %ld size, error code is %d.",
+                          new_capacity,
+                          error));
+    error = posix_memalign(reinterpret_cast<void**>(&_slots),
+                           64,
+                           new_capacity * sizeof(slot_type));
+    PADDLE_ENFORCE_EQ(error,
+                      0,
+                      common::errors::ResourceExhausted(
+                          "Fail to alloc memory of %ld size, error code is %d.",
+                          new_capacity * sizeof(slot_type),
+                          error));
+    memset(_ctrl, FLAT_CTRL_EMPTY, new_capacity);
+    _capacity = new_capacity;
+    _deleted = 0;
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (old_ctrl[i] >= 0) {
+        size_t hash = _hasher(old_slots[i].key);
+        size_t index = find_insert_slot(hash);
+        _ctrl[index] = h2(hash);
+        _slots[index] = old_slots[i];
+      }
+    }
+    free(old_ctrl);
+    free(old_slots);
+  }
+
+  int8_t* _ctrl = nullptr;
+  slot_type* _slots = nullptr;
+  size_t _capacity = 0;
+  size_t _size = 0;
+  size_t _deleted = 0;
+  float _max_load_factor = 0.875;
+  FlatValueSlab _alloc;
+  HASH _hasher;
+};
+
+}  // namespace distributed
+}  // namespace paddle
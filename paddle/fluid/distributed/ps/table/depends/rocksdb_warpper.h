@@ -90,8 +90,17 @@ class RocksDBHandler {
     return &handler;
   }
 
-  int initialize(const std::string& db_path, const int colnum) {
-    VLOG(0) << "db path: " << db_path << " colnum: " << colnum;
+  // block_cache_mb: size of the block cache of each column
+  // compression: compression of sst files, cold values of the tiered ssd
+  // table are rarely read, so a cheap codec usually pays off
+  int initialize(
+      const std::string& db_path,
+      const int colnum,
+      size_t block_cache_mb = 64,
+      rocksdb::CompressionType compression = rocksdb::kNoCompression) {
+    VLOG(0) << "db path: " << db_path << " colnum: " << colnum
+            << " block cache: " << block_cache_mb
+            << "MB compression: " << static_cast<int>(compression);
     _dbs.resize(colnum);
     for (int i = 0; i < colnum; i++) {
       rocksdb::Options options;
@@ -103,7 +112,7 @@ class RocksDBHandler {
       bbto.use_delta_encoding = false;
       bbto.block_size = 4 * 1024;
       bbto.block_restart_interval = 6;
-      bbto.block_cache = rocksdb::NewLRUCache(64 * 1024 * 1024);
+      bbto.block_cache = rocksdb::NewLRUCache(block_cache_mb * 1024 * 1024);
       // bbto.block_cache_compressed = rocksdb::NewLRUCache(64 * 1024 * 1024);
       bbto.cache_index_and_filter_blocks = false;
       bbto.filter_policy.reset(rocksdb::NewBloomFilterPolicy(15, false));
@@ -134,7 +143,7 @@ class RocksDBHandler {
       options.num_levels = 4;
       options.max_open_files = -1;
 
-      options.compression = rocksdb::kNoCompression;
+      options.compression = compression;
       // options.compaction_options_fifo = rocksdb::CompactionOptionsFIFO();
       // options.compaction_style =
       // rocksdb::CompactionStyle::kCompactionStyleFIFO;
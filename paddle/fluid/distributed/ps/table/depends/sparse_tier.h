@@ -0,0 +1,383 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+// Storage tiers of SSDSparseTable: the hot tier is the in-memory shard that
+// is updated in place, the warm tier keeps compressed values in memory and
+// the cold tier is rocksdb.
+enum SparseTier { HOT_TIER = 0, WARM_TIER = 1, COLD_TIER = 2, SPARSE_TIER_NUM };
+
+// Lossless encoding of a value for the warm tier. Sparse values are mostly
+// zeros (g2sum of unseen slots, embedx of features that never reached the
+// embedx threshold), so only the non-zero floats are kept:
+//
+//   | uint32 size | bitmap of non-zero floats | non-zero floats |
+//
+// Zero is tested on the bit pattern, so -0.0f and NaN survive a round trip.
+class WarmValueCodec {
+ public:
+  static void Encode(const float* data, size_t size, std::string* out) {
+    const uint32_t* bits = reinterpret_cast<const uint32_t*>(data);
+    size_t bitmap_bytes = (size + 7) / 8;
+    size_t nonzero = 0;
+    for (size_t i = 0; i < size; ++i) {
+      nonzero += (bits[i] != 0);
+    }
+    out->assign(sizeof(uint32_t) + bitmap_bytes + nonzero * sizeof(float), 0);
+    char* buf = &(*out)[0];
+    uint32_t size32 = size;
+    memcpy(buf, &size32, sizeof(uint32_t));
+    uint8_t* bitmap = reinterpret_cast<uint8_t*>(buf + sizeof(uint32_t));
+    char* packed = buf + sizeof(uint32_t) + bitmap_bytes;
+    for (size_t i = 0; i < size; ++i) {
+      if (bits[i] != 0) {
+        bitmap[i >> 3] |= static_cast<uint8_t>(1 << (i & 7));
+        memcpy(packed, &bits[i], sizeof(uint32_t));
+        packed += sizeof(uint32_t);
+      }
+    }
+  }
+
+  static size_t DecodedSize(const std::string& code) {
+    uint32_t size32 = 0;
+    memcpy(&size32, code.data(), sizeof(uint32_t));
+    return size32;
+  }
+
+  // `out` must hold DecodedSize(code) floats. Returns the number of floats.
+  static size_t Decode(const std::string& code, float* out) {
+    size_t size = DecodedSize(code);
+    size_t bitmap_bytes = (size + 7) / 8;
+    const uint8_t* bitmap =
+        reinterpret_cast<const uint8_t*>(code.data() + sizeof(uint32_t));
+    const char* packed = code.data() + sizeof(uint32_t) + bitmap_bytes;
+    for (size_t i = 0; i < size; ++i) {
+      if (bitmap[i >> 3] & (1 << (i & 7))) {
+        memcpy(out + i, packed, sizeof(float));
+        packed += sizeof(float);
+      } else {
+        out[i] = 0.0f;
+      }
+    }
+    return size;
+  }
+};
+
+// One shard of the warm tier. Every entry keeps the show/click score of its
+// value at demotion time, which decides what is spilled to the cold tier
+// first when the shard exceeds its memory budget.
+//
+// Eviction is a CLOCK sweep over the entries instead of a sort by score: the
+// hand evicts entries scored below the shard mean, and gives the others one
+// more round, so the lowest scored values go first at O(1) amortized cost
+// per evicted entry.
+class WarmTierShard {
+ public:
+  WarmTierShard() {}
+  WarmTierShard(const WarmTierShard&) = delete;
+
+  void Put(uint64_t key, const float* data, size_t size, float score) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    auto result = _values.emplace(key, Entry());
+    auto& entry = result.first->second;
+    if (result.second) {
+      entry.slot = AllocSlot(key);
+    } else {
+      _memory_size -= EntryBytes(entry);
+      _score_sum -= entry.score;
+    }
+    entry.score = score;
+    entry.referenced = true;
+    _score_sum += score;
+    WarmValueCodec::Encode(data, size, &entry.code);
+    _memory_size += EntryBytes(entry);
+  }
+
+  // Decodes the value of `key` into `out` and removes it from the shard.
+  // Returns false if the key is not in the warm tier.
+  bool Take(uint64_t key, float* out, size_t* size) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    auto it = _values.find(key);
+    if (it == _values.end()) {
+      return false;
+    }
+    *size = WarmValueCodec::Decode(it->second.code, out);
+    Erase(it);
+    return true;
+  }
+
+  // Removes entries until the shard uses no more than `budget` bytes,
+  // handing each of them to `fn(key, data, size)`.
+  template <typename FN>
+  size_t Evict(size_t budget, FN&& fn) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    std::vector<float> buffer;
+    size_t count = 0;
+    while (_memory_size > budget && !_values.empty()) {
+      size_t slot = _hand;
+      _hand = (_hand + 1) % _slot_keys.size();
+      if (!_slot_used[slot]) {
+        continue;
+      }
+      auto it = _values.find(_slot_keys[slot]);
+      auto& entry = it->second;
+      double mean = _score_sum / static_cast<double>(_values.size());
+      if (entry.referenced && entry.score >= mean) {
+        entry.referenced = false;
+        continue;
+      }
+      buffer.resize(WarmValueCodec::DecodedSize(entry.code));
+      size_t size = WarmValueCodec::Decode(entry.code, buffer.data());
+      fn(it->first, buffer.data(), size);
+      Erase(it);
+      ++count;
+    }
+    return count;
+  }
+
+  template <typename FN>
+  size_t Drain(FN&& fn) {
+    return Evict(0, std::forward<FN>(fn));
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> guard(_mutex);
+    _values.clear();
+    _slot_keys.clear();
+    _slot_used.clear();
+    _free_slots.clear();
+    _hand = 0;
+    _score_sum = 0;
+    _memory_size = 0;
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _values.size();
+  }
+
+  size_t memory_size() {
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _memory_size;
+  }
+
+ private:
+  struct Entry {
+    float score = 0;
+    // set by Put, cleared when the clock hand passes a well scored entry
+    bool referenced = false;
+    size_t slot = 0;
+    std::string code;
+  };
+  using EntryMap = std::unordered_map<uint64_t, Entry>;
+
+  // approximate footprint of a node of the hash map and its clock slot
+  static size_t EntryBytes(const Entry& entry) {
+    return entry.code.capacity() + sizeof(uint64_t) + sizeof(Entry) +
+           2 * sizeof(void*) + sizeof(uint64_t) + 1;
+  }
+
+  size_t AllocSlot(uint64_t key) {
+    size_t slot = _slot_keys.size();
+    if (!_free_slots.empty()) {
+      slot = _free_slots.back();
+      _free_slots.pop_back();
+    } else {
+      _slot_keys.push_back(0);
+      _slot_used.push_back(0);
+    }
+    _slot_keys[slot] = key;
+    _slot_used[slot] = 1;
+    return slot;
+  }
+
+  void Erase(EntryMap::iterator it) {
+    _slot_used[it->second.slot] = 0;
+    _free_slots.push_back(it->second.slot);
+    _score_sum -= it->second.score;
+    _memory_size -= EntryBytes(it->second);
+    _values.erase(it);
+    if (_values.empty()) {
+      _score_sum = 0;
+    }
+  }
+
+  std::mutex _mutex;
+  EntryMap _values;
+  // the clock: key of every slot, and whether the slot holds an entry
+  std::vector<uint64_t> _slot_keys;
+  std::vector<uint8_t> _slot_used;
+  std::vector<size_t> _free_slots;
+  size_t _hand = 0;
+  double _score_sum = 0;
+  size_t _memory_size = 0;
+};
+
+// Latency histogram with power of two buckets in microseconds: bucket 0 holds
+// [0, 2us), bucket i holds [2^i, 2^(i+1))us.
+class TierLatencyHistogram {
+ public:
+  static constexpr int BUCKET_NUM = 32;
+
+  TierLatencyHistogram() { Reset(); }
+
+  void Add(uint64_t us) {
+    int bucket = 0;
+    while (bucket + 1 < BUCKET_NUM && (us >> (bucket + 1)) != 0) {
+      ++bucket;
+    }
+    _buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    _sum_us.fetch_add(us, std::memory_order_relaxed);
+  }
+
+  uint64_t Count() const {
+    uint64_t count = 0;
+    for (int i = 0; i < BUCKET_NUM; ++i) {
+      count += _buckets[i].load(std::memory_order_relaxed);
+    }
+    return count;
+  }
+
+  double Mean() const {
+    uint64_t count = Count();
+    return count == 0 ? 0.0
+                      : static_cast<double>(_sum_us.load()) /
+                            static_cast<double>(count);
+  }
+
+  // Upper bound in us of the bucket holding the `ratio` quantile.
+  uint64_t Percentile(double ratio) const {
+    uint64_t count = Count();
+    if (count == 0) {
+      return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(ratio * count);
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_NUM; ++i) {
+      seen += _buckets[i].load(std::memory_order_relaxed);
+      if (seen > target) {
+        return uint64_t(2) << i;
+      }
+    }
+    return uint64_t(2) << (BUCKET_NUM - 1);
+  }
+
+  void Reset() {
+    for (int i = 0; i < BUCKET_NUM; ++i) {
+      _buckets[i].store(0, std::memory_order_relaxed);
+    }
+    _sum_us.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<uint64_t> _buckets[BUCKET_NUM];
+  std::atomic<uint64_t> _sum_us;
+};
+
+// Hit, movement and latency counters of a tiered table.
+class SparseTierStat {
+ public:
+  SparseTierStat() { Reset(); }
+
+  // `tier` served `num` lookups
+  void AddHit(SparseTier tier, uint64_t num) {
+    _hits[tier].fetch_add(num, std::memory_order_relaxed);
+  }
+  // `num` lookups were not found in any tier and created a new value
+  void AddMiss(uint64_t num) {
+    _miss.fetch_add(num, std::memory_order_relaxed);
+  }
+  // `num` values moved into the hot tier from a lower tier
+  void AddPromote(uint64_t num) {
+    _promote.fetch_add(num, std::memory_order_relaxed);
+  }
+  // `num` values moved down into `tier`
+  void AddDemote(SparseTier tier, uint64_t num) {
+    _demote[tier].fetch_add(num, std::memory_order_relaxed);
+  }
+  void AddLatency(SparseTier tier, uint64_t us) { _latency[tier].Add(us); }
+
+  uint64_t Hit(SparseTier tier) const { return _hits[tier].load(); }
+  uint64_t Miss() const { return _miss.load(); }
+  uint64_t Promote() const { return _promote.load(); }
+  uint64_t Demote(SparseTier tier) const { return _demote[tier].load(); }
+  const TierLatencyHistogram& Latency(SparseTier tier) const {
+    return _latency[tier];
+  }
+
+  uint64_t Lookups() const {
+    uint64_t lookups = _miss.load();
+    for (int i = 0; i < SPARSE_TIER_NUM; ++i) {
+      lookups += _hits[i].load();
+    }
+    return lookups;
+  }
+
+  double HitRate(SparseTier tier) const {
+    uint64_t lookups = Lookups();
+    return lookups == 0 ? 0.0
+                        : static_cast<double>(Hit(tier)) /
+                              static_cast<double>(lookups);
+  }
+
+  std::string ToString() const {
+    static const char* names[SPARSE_TIER_NUM] = {"hot", "warm", "cold"};
+    std::stringstream ss;
+    ss << "lookups: " << Lookups() << " miss: " << Miss()
+       << " promote: " << Promote();
+    for (int i = 0; i < SPARSE_TIER_NUM; ++i) {
+      auto tier = static_cast<SparseTier>(i);
+      ss << " | " << names[i] << " hit_rate: " << HitRate(tier)
+         << " demote_in: " << Demote(tier)
+         << " latency_us(mean/p50/p99): " << _latency[i].Mean() << "/"
+         << _latency[i].Percentile(0.5) << "/" << _latency[i].Percentile(0.99);
+    }
+    return ss.str();
+  }
+
+  void Reset() {
+    for (int i = 0; i < SPARSE_TIER_NUM; ++i) {
+      _hits[i].store(0);
+      _demote[i].store(0);
+      _latency[i].Reset();
+    }
+    _miss.store(0);
+    _promote.store(0);
+  }
+
+ private:
+  std::atomic<uint64_t> _hits[SPARSE_TIER_NUM];
+  std::atomic<uint64_t> _demote[SPARSE_TIER_NUM];
+  std::atomic<uint64_t> _miss;
+  std::atomic<uint64_t> _promote;
+  TierLatencyHistogram _latency[SPARSE_TIER_NUM];
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,243 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr_shard.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace paddle::distributed {
+
+namespace {
+
+// Up to this many samples the chosen positions are checked for duplicates by
+// a linear scan, more go to the general algorithms.
+constexpr int kSmallSampleSize = 64;
+
+bool Contains(const std::vector<uint32_t> &res, uint32_t pos) {
+  return std::find(res.begin(), res.end(), pos) != res.end();
+}
+
+// uniform integer in [0, n) from the high 32 bits of `rand`
+inline uint32_t RandBelow(uint64_t rand, uint32_t n) {
+  return static_cast<uint32_t>(((rand >> 32) * n) >> 32);
+}
+
+// uniform float in [0, 1) from the low 24 bits of `rand`
+inline float RandUnit(uint64_t rand) {
+  return static_cast<float>(rand & 0xFFFFFF) * (1.0f / 16777216.0f);
+}
+
+}  // namespace
+
+void CsrGraphShard::build(const std::vector<Node *> &bucket, bool weighted) {
+  weighted_ = weighted;
+  size_t node_num = bucket.size();
+  size_t edge_num = 0;
+  for (Node *node : bucket) {
+    edge_num += node->get_neighbor_size();
+  }
+
+  row_index_.clear();
+  row_index_.reserve(node_num);
+  offsets_.assign(1, 0);
+  offsets_.reserve(node_num + 1);
+  neighbors_.clear();
+  neighbors_.reserve(edge_num);
+  weights_.clear();
+  weights_.reserve(edge_num);
+  alias_prob_.clear();
+  alias_.clear();
+  if (weighted_) {
+    alias_prob_.resize(edge_num);
+    alias_.resize(edge_num);
+  }
+
+  std::vector<uint32_t> small, large;
+  std::vector<double> scaled;
+  for (size_t row = 0; row < node_num; ++row) {
+    Node *node = bucket[row];
+    row_index_[node->get_id()] = static_cast<uint32_t>(row);
+    size_t begin = neighbors_.size();
+    uint32_t deg = static_cast<uint32_t>(node->get_neighbor_size());
+    double weight_sum = 0;
+    for (uint32_t i = 0; i < deg; ++i) {
+      neighbors_.push_back(node->get_neighbor_id(static_cast<int>(i)));
+      float weight =
+          static_cast<float>(node->get_neighbor_weight(static_cast<int>(i)));
+      weights_.push_back(weight);
+      weight_sum += std::max(weight, 0.0f);
+    }
+    offsets_.push_back(neighbors_.size());
+    if (!weighted_ || deg == 0) {
+      continue;
+    }
+
+    // Vose's alias method: slot i keeps position i with probability
+    // alias_prob_ and gives its remaining share to alias_.
+    float *prob = &alias_prob_[begin];
+    uint32_t *alias = &alias_[begin];
+    if (weight_sum <= 0) {
+      std::fill(prob, prob + deg, 1.0f);
+      for (uint32_t i = 0; i < deg; ++i) {
+        alias[i] = i;
+      }
+      continue;
+    }
+    scaled.resize(deg);
+    small.clear();
+    large.clear();
+    for (uint32_t i = 0; i < deg; ++i) {
+      scaled[i] = std::max(weights_[begin + i], 0.0f) * deg / weight_sum;
+      (scaled[i] < 1.0 ? small : large).push_back(i);
+    }
+    while (!small.empty() && !large.empty()) {
+      uint32_t less = small.back();
+      small.pop_back();
+      uint32_t more = large.back();
+      prob[less] = static_cast<float>(scaled[less]);
+      alias[less] = more;
+      scaled[more] -= 1.0 - scaled[less];
+      if (scaled[more] < 1.0) {
+        large.pop_back();
+        small.push_back(more);
+      }
+    }
+    // the rest are 1 up to rounding errors
+    for (uint32_t i : large) {
+      prob[i] = 1.0f;
+      alias[i] = i;
+    }
+    for (uint32_t i : small) {
+      prob[i] = 1.0f;
+      alias[i] = i;
+    }
+  }
+}
+
+size_t CsrGraphShard::bytes() const {
+  return offsets_.capacity() * sizeof(uint64_t) +
+         neighbors_.capacity() * sizeof(uint64_t) +
+         weights_.capacity() * sizeof(float) +
+         alias_prob_.capacity() * sizeof(float) +
+         alias_.capacity() * sizeof(uint32_t);
+}
+
+uint32_t CsrGraphShard::alias_draw(int64_t row,
+                                   uint32_t deg,
+                                   uint64_t rand) const {
+  uint64_t begin = offsets_[row];
+  uint32_t slot = RandBelow(rand, deg);
+  return RandUnit(rand) < alias_prob_[begin + slot] ? slot
+                                                    : alias_[begin + slot];
+}
+
+size_t CsrGraphShard::sample_k(int64_t row,
+                               int k,
+                               std::mt19937_64 *rng,
+                               std::vector<uint32_t> *res) const {
+  res->clear();
+  uint32_t deg = degree(row);
+  if (k <= 0 || deg == 0) {
+    return 0;
+  }
+  if (static_cast<uint32_t>(k) >= deg) {
+    res->resize(deg);
+    for (uint32_t i = 0; i < deg; ++i) {
+      (*res)[i] = i;
+    }
+    return deg;
+  }
+  if (!weighted_) {
+    sample_uniform(deg, k, rng, res);
+    return res->size();
+  }
+
+  // Drawing from all the edges and dropping the repeated ones is the same as
+  // drawing from the ones left. Cheap while k is well below the degree and no
+  // few edges hold most of the weight, otherwise fall back to the keys.
+  if (k <= kSmallSampleSize && static_cast<uint32_t>(k) * 2 <= deg) {
+    size_t sample_size = static_cast<size_t>(k);
+    int max_draws = 8 * k + 32;
+    for (int draw = 0; draw < max_draws && res->size() < sample_size; ++draw) {
+      uint32_t pos = alias_draw(row, deg, (*rng)());
+      if (!Contains(*res, pos)) {
+        res->push_back(pos);
+      }
+    }
+    if (res->size() == sample_size) {
+      return res->size();
+    }
+    res->clear();
+  }
+  sample_by_keys(row, deg, k, rng, res);
+  return res->size();
+}
+
+void CsrGraphShard::sample_uniform(uint32_t deg,
+                                   int k,
+                                   std::mt19937_64 *rng,
+                                   std::vector<uint32_t> *res) const {
+  // Floyd's algorithm, k draws for k distinct positions
+  if (k <= kSmallSampleSize) {
+    for (uint32_t j = deg - k; j < deg; ++j) {
+      uint32_t pos = RandBelow((*rng)(), j + 1);
+      res->push_back(Contains(*res, pos) ? j : pos);
+    }
+    return;
+  }
+  robin_hood::unordered_flat_set<uint32_t> chosen;
+  chosen.reserve(k);
+  for (uint32_t j = deg - k; j < deg; ++j) {
+    uint32_t pos = RandBelow((*rng)(), j + 1);
+    if (!chosen.insert(pos).second) {
+      chosen.insert(j);
+      pos = j;
+    }
+    res->push_back(pos);
+  }
+}
+
+void CsrGraphShard::sample_by_keys(int64_t row,
+                                   uint32_t deg,
+                                   int k,
+                                   std::mt19937_64 *rng,
+                                   std::vector<uint32_t> *res) const {
+  // The k largest log(u) / w. Edges without weight come last.
+  std::vector<std::pair<float, uint32_t>> keys(deg);
+  uint64_t begin = offsets_[row];
+  for (uint32_t i = 0; i < deg; ++i) {
+    float weight = weights_[begin + i];
+    // u in (0, 1]
+    float u = static_cast<float>(((*rng)() >> 40) + 1) * (1.0f / 16777216.0f);
+    keys[i].first = weight > 0 ? std::log(u) / weight
+                               : -std::numeric_limits<float>::infinity();
+    keys[i].second = i;
+  }
+  std::nth_element(keys.begin(),
+                   keys.begin() + k,
+                   keys.end(),
+                   [](const std::pair<float, uint32_t> &lhs,
+                      const std::pair<float, uint32_t> &rhs) {
+                     return lhs.first > rhs.first;
+                   });
+  res->resize(k);
+  for (int i = 0; i < k; ++i) {
+    (*res)[i] = keys[i].second;
+  }
+}
+
+}  // namespace paddle::distributed
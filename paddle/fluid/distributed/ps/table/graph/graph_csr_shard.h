@@ -0,0 +1,96 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
+#include "paddle/fluid/distributed/ps/thirdparty/round_robin.h"
+namespace paddle {
+namespace distributed {
+
+// Immutable compressed sparse row copy of the edges of one graph shard.
+//
+// The neighbors of row r are neighbors_[offsets_[r], offsets_[r + 1]), in the
+// order of the edges of the node, so a position returned by sample_k is the
+// same index the node's get_neighbor_id takes. For weighted sampling every
+// edge also has a slot of a Walker alias table of its node, so one draw costs
+// a random number and two array reads whatever the degree.
+//
+// Built once after the edges are loaded, the shard has to be rebuilt when the
+// nodes change.
+class CsrGraphShard {
+ public:
+  // Builds the rows from the GraphNodes of `bucket`, alias tables from the
+  // edge weights if `weighted`, otherwise neighbors are sampled uniformly.
+  void build(const std::vector<Node *> &bucket, bool weighted);
+
+  // row of node `id`, -1 if the shard does not have it
+  int64_t find_row(uint64_t id) const {
+    auto iter = row_index_.find(id);
+    return iter == row_index_.end() ? -1 : static_cast<int64_t>(iter->second);
+  }
+  uint32_t degree(int64_t row) const {
+    return static_cast<uint32_t>(offsets_[row + 1] - offsets_[row]);
+  }
+  uint64_t neighbor_id(int64_t row, uint32_t pos) const {
+    return neighbors_[offsets_[row] + pos];
+  }
+  float neighbor_weight(int64_t row, uint32_t pos) const {
+    return weights_[offsets_[row] + pos];
+  }
+
+  // Samples min(k, degree) distinct neighbors of `row` without replacement,
+  // each draw proportional to the weight among the ones not drawn yet. Writes
+  // their positions to `res` and returns the number of them.
+  size_t sample_k(int64_t row,
+                  int k,
+                  std::mt19937_64 *rng,
+                  std::vector<uint32_t> *res) const;
+
+  size_t node_num() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+  size_t edge_num() const { return neighbors_.size(); }
+  bool is_weighted() const { return weighted_; }
+  // bytes of the arrays, without the id index
+  size_t bytes() const;
+
+ private:
+  // draw of one position of `row` from its alias table
+  uint32_t alias_draw(int64_t row, uint32_t deg, uint64_t rand) const;
+  void sample_uniform(uint32_t deg,
+                      int k,
+                      std::mt19937_64 *rng,
+                      std::vector<uint32_t> *res) const;
+  // Efraimidis-Spirakis sampling, for large k or skewed weights
+  void sample_by_keys(int64_t row,
+                      uint32_t deg,
+                      int k,
+                      std::mt19937_64 *rng,
+                      std::vector<uint32_t> *res) const;
+
+  bool weighted_ = false;
+  robin_hood::unordered_flat_map<uint64_t, uint32_t> row_index_;
+  std::vector<uint64_t> offsets_;
+  std::vector<uint64_t> neighbors_;
+  std::vector<float> weights_;
+  // alias table slots, empty if not weighted
+  std::vector<float> alias_prob_;
+  std::vector<uint32_t> alias_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,349 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+enum LRUResponse { ok = 0, blocked = 1, err = 2 };
+
+struct SampleCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t inserts = 0;
+  // entries dropped by the CLOCK hand to stay within the budget
+  uint64_t evictions = 0;
+  // entries dropped after being served ttl times
+  uint64_t expirations = 0;
+  size_t entries = 0;
+  size_t bytes = 0;
+};
+
+// bytes charged to the budget for a value, besides the entry itself
+struct SampleCacheCharge {
+  template <typename V>
+  size_t operator()(const V &value) const {
+    return value.actual_size;
+  }
+};
+
+// Concurrent cache of sample results, split into shards that each get an
+// equal part of a memory budget in bytes.
+//
+// Lookups take no lock: a shard is a fixed array of hash chains whose links
+// are atomic, and a writer that unlinks an entry hands it to the shard's
+// epoch based reclamation, which frees it once every lookup that could
+// still see it has finished. Inserts and evictions take the shard's mutex.
+// Eviction is CLOCK: a hit marks the entry, and the hand clears the marks
+// it passes and drops the first unmarked entry.
+//
+// Like the LRU it replaces, an entry is served ttl times and then dropped so
+// that the same node gets a fresh sample.
+template <typename K,
+          typename V,
+          typename Charge = SampleCacheCharge,
+          typename Hash = std::hash<K>>
+class ShardedSampleCache {
+ public:
+  // `expected_entry_bytes` only sizes the hash chains of the shards.
+  ShardedSampleCache(size_t shard_num,
+                     size_t capacity_bytes,
+                     size_t ttl,
+                     size_t expected_entry_bytes = 256)
+      : ttl_(ttl), shards_(shard_num == 0 ? 1 : shard_num) {
+    size_t shard_bytes = capacity_bytes / shards_.size();
+    size_t buckets = 16;
+    int bucket_bits = 4;
+    while (buckets * expected_entry_bytes < shard_bytes) {
+      buckets <<= 1;
+      ++bucket_bits;
+    }
+    for (auto &shard : shards_) {
+      shard.capacity_bytes = shard_bytes;
+      shard.bucket_shift = 64 - bucket_bits;
+      shard.buckets = std::vector<std::atomic<Entry *>>(buckets);
+      for (auto &bucket : shard.buckets) {
+        bucket.store(nullptr, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  ~ShardedSampleCache() {
+    for (auto &shard : shards_) {
+      for (Entry *entry : shard.clock) {
+        delete entry;
+      }
+      for (auto &retired : shard.retired) {
+        delete retired.second;
+      }
+    }
+  }
+
+  ShardedSampleCache(const ShardedSampleCache &) = delete;
+  ShardedSampleCache &operator=(const ShardedSampleCache &) = delete;
+
+  // Appends the cached (key, value) pairs of `keys`, in the order of `keys`,
+  // to `res`. Never blocks, so it always returns ok.
+  LRUResponse query(size_t index,
+                    K *keys,
+                    size_t length,
+                    std::vector<std::pair<K, V>> &res) {  // NOLINT
+    Shard &shard = shards_[index % shards_.size()];
+    ReadGuard guard(&shard);
+    uint64_t hits = 0;
+    for (size_t i = 0; i < length; ++i) {
+      Entry *entry = shard.find(keys[i], hash_(keys[i]));
+      if (entry == nullptr) {
+        continue;
+      }
+      if (entry->ttl.fetch_sub(1, std::memory_order_relaxed) <= 0) {
+        // served ttl times already, the next insert replaces it
+        continue;
+      }
+      entry->referenced.store(true, std::memory_order_relaxed);
+      res.emplace_back(keys[i], entry->value);
+      ++hits;
+    }
+    shard.hits.fetch_add(hits, std::memory_order_relaxed);
+    shard.misses.fetch_add(length - hits, std::memory_order_relaxed);
+    return LRUResponse::ok;
+  }
+
+  // Inserts or replaces the values of `keys`, evicting entries of the shard
+  // to keep it within its part of the budget.
+  LRUResponse insert(size_t index, K *keys, V *data, size_t length) {
+    Shard &shard = shards_[index % shards_.size()];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (size_t i = 0; i < length; ++i) {
+      size_t hash = hash_(keys[i]);
+      Entry *entry = new Entry(keys[i], data[i], hash, ttl_);
+      entry->charge = sizeof(Entry) + charge_(data[i]);
+      if (entry->charge > shard.capacity_bytes) {
+        delete entry;
+        continue;
+      }
+      Entry *old = shard.find(keys[i], hash);
+      if (old != nullptr) {
+        if (old->ttl.load(std::memory_order_relaxed) <= 0) {
+          ++shard.expirations;
+        }
+        remove(&shard, old);
+      }
+      while (shard.bytes + entry->charge > shard.capacity_bytes) {
+        evict_one(&shard);
+      }
+      entry->clock_pos = shard.clock.size();
+      shard.clock.push_back(entry);
+      shard.bytes += entry->charge;
+      std::atomic<Entry *> &bucket = shard.bucket(hash);
+      entry->next.store(bucket.load(std::memory_order_relaxed),
+                        std::memory_order_relaxed);
+      bucket.store(entry, std::memory_order_release);
+    }
+    shard.inserts.fetch_add(length, std::memory_order_relaxed);
+    reclaim(&shard);
+    return LRUResponse::ok;
+  }
+
+  SampleCacheStats stats() const {
+    SampleCacheStats stats;
+    for (auto &shard : shards_) {
+      stats.hits += shard.hits.load(std::memory_order_relaxed);
+      stats.misses += shard.misses.load(std::memory_order_relaxed);
+      stats.inserts += shard.inserts.load(std::memory_order_relaxed);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      stats.evictions += shard.evictions;
+      stats.expirations += shard.expirations;
+      stats.entries += shard.clock.size();
+      stats.bytes += shard.bytes;
+    }
+    return stats;
+  }
+
+  size_t get_ttl() const { return ttl_; }
+  size_t shard_num() const { return shards_.size(); }
+
+ private:
+  struct Entry {
+    Entry(const K &key, const V &value, size_t hash, size_t ttl)
+        : key(key),
+          value(value),
+          hash(hash),
+          ttl(static_cast<int64_t>(ttl)) {}
+    const K key;
+    const V value;
+    const size_t hash;
+    size_t charge = 0;
+    // index in the shard's clock, only touched under the shard's mutex
+    size_t clock_pos = 0;
+    std::atomic<Entry *> next{nullptr};
+    std::atomic<bool> referenced{false};
+    std::atomic<int64_t> ttl;
+  };
+
+  // Lookups of a shard announce themselves in one of two sets of striped
+  // counters, picked by the parity of the epoch they started in. The epoch
+  // only moves on from e when no lookup of epoch e - 1 is left, so an entry
+  // unlinked in epoch e is unreachable once the epoch reaches e + 2.
+  static constexpr size_t kReaderStripes = 16;
+  struct alignas(64) ReaderCounter {
+    std::atomic<int64_t> count{0};
+  };
+
+  struct alignas(64) Shard {
+    // The keys of a shard often share their low bits, as the shard is picked
+    // from them, so the bucket comes from the high bits of a multiplication.
+    std::atomic<Entry *> &bucket(size_t hash) {
+      return buckets[(static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL) >>
+                     bucket_shift];
+    }
+    Entry *find(const K &key, size_t hash) {
+      Entry *entry = bucket(hash).load(std::memory_order_acquire);
+      while (entry != nullptr) {
+        if (entry->hash == hash && entry->key == key) {
+          return entry;
+        }
+        entry = entry->next.load(std::memory_order_acquire);
+      }
+      return nullptr;
+    }
+
+    std::vector<std::atomic<Entry *>> buckets;
+    int bucket_shift = 60;
+    std::atomic<uint64_t> epoch{0};
+    ReaderCounter readers[2][kReaderStripes];
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> inserts{0};
+
+    // the rest is guarded by the mutex
+    mutable std::mutex mutex;
+    size_t capacity_bytes = 0;
+    size_t bytes = 0;
+    std::vector<Entry *> clock;
+    size_t hand = 0;
+    // unlinked entries with the epoch they were unlinked in
+    std::vector<std::pair<uint64_t, Entry *>> retired;
+    uint64_t evictions = 0;
+    uint64_t expirations = 0;
+  };
+
+  class ReadGuard {
+   public:
+    explicit ReadGuard(Shard *shard) {
+      static std::atomic<size_t> next_stripe{0};
+      thread_local size_t stripe =
+          next_stripe.fetch_add(1, std::memory_order_relaxed) % kReaderStripes;
+      while (true) {
+        uint64_t epoch = shard->epoch.load(std::memory_order_seq_cst);
+        counter_ = &shard->readers[epoch & 1][stripe].count;
+        counter_->fetch_add(1, std::memory_order_seq_cst);
+        if (shard->epoch.load(std::memory_order_seq_cst) == epoch) {
+          break;
+        }
+        counter_->fetch_sub(1, std::memory_order_release);
+      }
+    }
+    ~ReadGuard() { counter_->fetch_sub(1, std::memory_order_release); }
+
+   private:
+    std::atomic<int64_t> *counter_;
+  };
+
+  // Unlinks `entry` from its chain and the clock and retires it. Needs the
+  // shard's mutex.
+  void remove(Shard *shard, Entry *entry) {
+    std::atomic<Entry *> *link = &shard->bucket(entry->hash);
+    Entry *cur = link->load(std::memory_order_relaxed);
+    while (cur != entry) {
+      link = &cur->next;
+      cur = link->load(std::memory_order_relaxed);
+    }
+    link->store(entry->next.load(std::memory_order_relaxed),
+                std::memory_order_release);
+
+    Entry *last = shard->clock.back();
+    shard->clock[entry->clock_pos] = last;
+    last->clock_pos = entry->clock_pos;
+    shard->clock.pop_back();
+    if (shard->hand >= shard->clock.size()) {
+      shard->hand = 0;
+    }
+    shard->bytes -= entry->charge;
+    shard->retired.emplace_back(
+        shard->epoch.load(std::memory_order_relaxed), entry);
+  }
+
+  void evict_one(Shard *shard) {
+    while (true) {
+      Entry *entry = shard->clock[shard->hand];
+      if (entry->ttl.load(std::memory_order_relaxed) <= 0) {
+        ++shard->expirations;
+        remove(shard, entry);
+        return;
+      }
+      if (!entry->referenced.exchange(false, std::memory_order_relaxed)) {
+        ++shard->evictions;
+        remove(shard, entry);
+        return;
+      }
+      shard->hand = (shard->hand + 1) % shard->clock.size();
+    }
+  }
+
+  // Moves the epoch on if the lookups of the previous one are done and frees
+  // the entries no lookup can reach anymore. Needs the shard's mutex.
+  void reclaim(Shard *shard) {
+    if (shard->retired.empty()) {
+      return;
+    }
+    uint64_t epoch = shard->epoch.load(std::memory_order_relaxed);
+    bool quiescent = true;
+    for (auto &reader : shard->readers[(epoch + 1) & 1]) {
+      if (reader.count.load(std::memory_order_seq_cst) != 0) {
+        quiescent = false;
+        break;
+      }
+    }
+    if (quiescent) {
+      shard->epoch.store(++epoch, std::memory_order_seq_cst);
+    }
+    size_t kept = 0;
+    for (auto &retired : shard->retired) {
+      if (retired.first + 2 <= epoch) {
+        delete retired.second;
+      } else {
+        shard->retired[kept++] = retired;
+      }
+    }
+    shard->retired.resize(kept);
+  }
+
+  const size_t ttl_;
+  std::vector<Shard> shards_;
+  Hash hash_;
+  Charge charge_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
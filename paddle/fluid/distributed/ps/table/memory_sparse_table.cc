@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include <omp.h>
+
+#include <algorithm>
 #include <sstream>
 
 #include "glog/logging.h"
@@ -38,9 +40,64 @@ PD_DEFINE_bool(pserver_enable_create_feasign_randomly,
 PD_DEFINE_int32(pserver_table_save_max_retry,
                 3,
                 "pserver_table_save_max_retry");
+PD_DEFINE_bool(pserver_sparse_snapshot_verify_values,
+               false,
+               "verify the value checksums of sparse snapshots at load, which "
+               "faults in all the mapped values");
+PD_DEFINE_int32(pserver_sparse_prefetch_group_size,
+                16,
+                "number of keys whose buckets and values are prefetched "
+                "together in sparse pull and push, <= 1 disables prefetch");
 
 namespace paddle::distributed {
 
+// Visits the values of `keys` in one local shard with group prefetching: the
+// buckets of a whole group are prefetched before any of them is probed, and
+// the values found are prefetched before any of them is read, so the cache
+// misses of a group overlap instead of stalling one key after another.
+// `fn(item, value)` gets nullptr when the key is missing at visit time, keys
+// created by `fn` for an earlier duplicate are found again.
+template <typename SHARD, typename FN>
+static void ForEachShardValue(SHARD *shard,
+                              const std::vector<std::pair<uint64_t, int>> &keys,
+                              FN &&fn) {
+  typedef typename std::remove_reference<decltype(
+      shard->begin().value())>::type value_type;
+  auto find_value = [shard](uint64_t key) -> value_type * {
+    auto itr = shard->find(key);
+    return itr == shard->end() ? nullptr : itr.value_ptr();
+  };
+  const size_t group_size = FLAGS_pserver_sparse_prefetch_group_size;
+  if (group_size <= 1) {
+    for (auto &item : keys) {
+      fn(item, find_value(item.first));
+    }
+    return;
+  }
+  std::vector<value_type *> values(group_size);
+  for (size_t begin = 0; begin < keys.size(); begin += group_size) {
+    size_t end = std::min(keys.size(), begin + group_size);
+    for (size_t i = begin; i < end; ++i) {
+      shard->prefetch(keys[i].first);
+    }
+    for (size_t i = begin; i < end; ++i) {
+      values[i - begin] = find_value(keys[i].first);
+      if (values[i - begin] != nullptr) {
+        __builtin_prefetch(values[i - begin], 1, 1);
+      }
+    }
+    for (size_t i = begin; i < end; ++i) {
+      if (values[i - begin] != nullptr) {
+        __builtin_prefetch(values[i - begin]->data(), 1, 1);
+      }
+    }
+    for (size_t i = begin; i < end; ++i) {
+      value_type *value = values[i - begin];
+      fn(keys[i], value != nullptr ? value : find_value(keys[i].first));
+    }
+  }
+}
+
 int32_t MemorySparseTable::Initialize() {
   auto &profiler = CostProfiler::instance();
   profiler.register_profiler("pserver_sparse_update_all");
@@ -76,7 +133,23 @@ int32_t MemorySparseTable::InitializeValue() {
           << " _task_pool_size:" << _task_pool_size
           << " _use_gpu_graph:" << _use_gpu_graph;
 
-  _local_shards.reset(new shard_type[_real_local_shard_num]);
+  _use_flat_shard = _config.sparse_shard_type() == FLAT_HASH_SHARD;
+  if (_use_flat_shard) {
+    PADDLE_ENFORCE_EQ(
+        _config.enable_revert() || _use_gpu_graph,
+        false,
+        common::errors::InvalidArgument(
+            "FLAT_HASH_SHARD of MemorySparseTable does not support "
+            "enable_revert or use_gpu_graph, table_id: %d.",
+            _config.table_id()));
+    size_t value_dim = _value_accessor->GetAccessorInfo().dim;
+    _local_flat_shards.reset(new flat_shard_type[_real_local_shard_num]);
+    for (int i = 0; i < _real_local_shard_num; ++i) {
+      _local_flat_shards[i].set_value_dim(value_dim);
+    }
+  } else {
+    _local_shards.reset(new shard_type[_real_local_shard_num]);
+  }
 
   if (_config.enable_revert()) {
     // calculate merged shard number based on config param;
@@ -130,16 +203,87 @@ int32_t MemorySparseTable::Load(const std::string &path,
   if (load_param == 5) {
     return LoadPatch(file_list, load_param);
   }
+  // a table may hold snapshot files next to text ones, e.g. when only some
+  // shards were saved after snapshots were turned on, so every file is
+  // checked on its own.
+  if (std::any_of(file_list.begin(), file_list.end(), IsSparseSnapshotFile)) {
+    if (_use_flat_shard) {
+      return LoadSnapshotShards(
+          _local_flat_shards.get(), file_list, load_param);
+    }
+    return LoadSnapshotShards(_local_shards.get(), file_list, load_param);
+  }
+  if (_use_flat_shard) {
+    return LoadLocalShards(_local_flat_shards.get(), file_list, load_param);
+  }
+  return LoadLocalShards(_local_shards.get(), file_list, load_param);
+}
 
+template <typename SHARD>
+void MemorySparseTable::LoadLocalShard(SHARD *local_shard,
+                                       const std::string &path,
+                                       int shard_id,
+                                       int load_param) {
+  size_t feature_value_size =
+      _value_accessor->GetAccessorInfo().size / sizeof(float);
+  FsChannelConfig channel_config = {};
+  channel_config.path = path;
+  VLOG(1) << "MemorySparseTable::load begin load " << channel_config.path
+          << " into local shard " << shard_id;
+  channel_config.converter = _value_accessor->Converter(load_param).converter;
+  channel_config.deconverter =
+      _value_accessor->Converter(load_param).deconverter;
+
+  bool is_read_failed = false;
+  int retry_num = 0;
+  int err_no = 0;
+  do {
+    is_read_failed = false;
+    err_no = 0;
+    std::string line_data;
+    auto read_channel = _afs_client.open_r(channel_config, 0, &err_no);
+    char *end = nullptr;
+    auto &shard = *local_shard;
+    try {
+      while (read_channel->read_line(line_data) == 0 && line_data.size() > 1) {
+        uint64_t key = std::strtoul(line_data.data(), &end, 10);
+        auto &value = shard[key];
+        value.resize(feature_value_size);
+        int parse_size = _value_accessor->ParseFromString(++end, value.data());
+        value.resize(parse_size);
+      }
+      read_channel->close();
+      if (err_no == -1) {
+        ++retry_num;
+        is_read_failed = true;
+        LOG(ERROR)
+            << "MemorySparseTable load failed after read, retry it! path:"
+            << channel_config.path << " , retry_num=" << retry_num;
+      }
+    } catch (...) {
+      ++retry_num;
+      is_read_failed = true;
+      LOG(ERROR) << "MemorySparseTable load failed, retry it! path:"
+                 << channel_config.path << " , retry_num=" << retry_num;
+    }
+    if (retry_num > FLAGS_pserver_table_save_max_retry) {
+      LOG(ERROR) << "MemorySparseTable load failed reach max limit!";
+      exit(-1);
+    }
+  } while (is_read_failed);
+}
+
+template <typename SHARD>
+int32_t MemorySparseTable::LoadLocalShards(
+    SHARD *local_shards,
+    const std::vector<std::string> &file_list,
+    int load_param) {
   size_t file_start_idx = _shard_idx * _avg_local_shard_num;
 
   if (file_start_idx >= file_list.size()) {
     return 0;
   }
 
-  size_t feature_value_size =
-      _value_accessor->GetAccessorInfo().size / sizeof(float);
-
 #ifdef PADDLE_WITH_HETERPS
   int thread_num = _real_local_shard_num;
 #else
@@ -149,55 +293,106 @@ int32_t MemorySparseTable::Load(const std::string &path,
   omp_set_num_threads(thread_num);
 #pragma omp parallel for schedule(dynamic)
   for (int i = 0; i < _real_local_shard_num; ++i) {
-    FsChannelConfig channel_config = {};
-    channel_config.path = file_list[file_start_idx + i];
-    VLOG(1) << "MemorySparseTable::load begin load " << channel_config.path
-            << " into local shard " << i;
-    channel_config.converter = _value_accessor->Converter(load_param).converter;
-    channel_config.deconverter =
-        _value_accessor->Converter(load_param).deconverter;
+    LoadLocalShard(
+        &local_shards[i], file_list[file_start_idx + i], i, load_param);
+  }
+  LOG(INFO) << "MemorySparseTable load success, path from "
+            << file_list[file_start_idx] << " to "
+            << file_list[file_start_idx + _real_local_shard_num - 1];
+  return 0;
+}
 
-    bool is_read_failed = false;
-    int retry_num = 0;
-    int err_no = 0;
-    do {
-      is_read_failed = false;
-      err_no = 0;
-      std::string line_data;
-      auto read_channel = _afs_client.open_r(channel_config, 0, &err_no);
-      char *end = nullptr;
-      auto &shard = _local_shards[i];
-      try {
-        while (read_channel->read_line(line_data) == 0 &&
-               line_data.size() > 1) {
-          uint64_t key = std::strtoul(line_data.data(), &end, 10);
-          auto &value = shard[key];
-          value.resize(feature_value_size);
-          int parse_size =
-              _value_accessor->ParseFromString(++end, value.data());
-          value.resize(parse_size);
-        }
-        read_channel->close();
-        if (err_no == -1) {
-          ++retry_num;
-          is_read_failed = true;
-          LOG(ERROR)
-              << "MemorySparseTable load failed after read, retry it! path:"
-              << channel_config.path << " , retry_num=" << retry_num;
-        }
-      } catch (...) {
-        ++retry_num;
-        is_read_failed = true;
-        LOG(ERROR) << "MemorySparseTable load failed, retry it! path:"
-                   << channel_config.path << " , retry_num=" << retry_num;
-      }
-      if (retry_num > FLAGS_pserver_table_save_max_retry) {
-        LOG(ERROR) << "MemorySparseTable load failed reach max limit!";
-        exit(-1);
+// Values of a closed hash shard live in their own vectors, so they are copied
+// out of the snapshot.
+static void LoadSnapshotValues(MemorySparseTable::shard_type *shard,
+                               SparseSnapshotReader *reader) {
+  for (size_t i = 0; i < reader->key_num(); ++i) {
+    auto *value = reader->value(i);
+    auto &feature_value = (*shard)[reader->key(i)];
+    feature_value.resize(value->size());
+    memcpy(feature_value.data(), value->data(), value->size() * sizeof(float));
+  }
+}
+
+// A flat shard indexes the mapped values in place and takes the mapping over.
+static void LoadSnapshotValues(MemorySparseTable::flat_shard_type *shard,
+                               SparseSnapshotReader *reader) {
+  shard->reserve(shard->size() + reader->key_num());
+  size_t value_num = 0;
+  for (size_t i = 0; i < reader->key_num(); ++i) {
+    auto *value = reader->value(i);
+    if (shard->insert_value(reader->key(i), value)) {
+      ++value_num;
+      continue;
+    }
+    auto &feature_value = shard->find(reader->key(i)).value();
+    feature_value.resize(value->size());
+    memcpy(feature_value.data(), value->data(), value->size() * sizeof(float));
+  }
+  auto mapping = reader->Release();
+  shard->adopt_values(mapping.first, mapping.second, value_num);
+}
+
+template <typename SHARD>
+int32_t MemorySparseTable::LoadSnapshotShards(
+    SHARD *local_shards,
+    const std::vector<std::string> &file_list,
+    int load_param) {
+  size_t file_start_idx = _shard_idx * _avg_local_shard_num;
+  if (file_start_idx >= file_list.size()) {
+    return 0;
+  }
+  const auto &info = _value_accessor->GetAccessorInfo();
+  std::atomic<int> failed_num{0};
+  int thread_num = _real_local_shard_num < 15 ? _real_local_shard_num : 15;
+  omp_set_num_threads(thread_num);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    const std::string &path = file_list[file_start_idx + i];
+    if (!IsSparseSnapshotFile(path)) {
+      LoadLocalShard(&local_shards[i], path, i, load_param);
+      continue;
+    }
+    SparseSnapshotReader reader;
+    if (reader.Open(path, info) != 0) {
+      ++failed_num;
+      continue;
+    }
+    bool is_corrupted = false;
+    for (size_t block = 0; block < reader.block_num(); ++block) {
+      if (!reader.VerifyBlock(block,
+                              FLAGS_pserver_sparse_snapshot_verify_values)) {
+        LOG(ERROR) << "MemorySparseTable snapshot checksum mismatch, path:"
+                   << path << " block:" << block;
+        is_corrupted = true;
+        break;
       }
-    } while (is_read_failed);
+    }
+    if (is_corrupted) {
+      ++failed_num;
+      continue;
+    }
+    // the shard is only filled once all the records pass, so a bad snapshot
+    // leaves nothing pointing into its mapping
+    try {
+      reader.CheckValues();
+    } catch (const std::exception &e) {
+      LOG(ERROR) << "MemorySparseTable snapshot records mismatch, path:" << path
+                 << " " << e.what();
+      ++failed_num;
+      continue;
+    }
+    size_t key_num = reader.key_num();
+    LoadSnapshotValues(&local_shards[i], &reader);
+    VLOG(1) << "MemorySparseTable::load snapshot " << path
+            << " into local shard " << i << " feasign_size: " << key_num;
   }
-  LOG(INFO) << "MemorySparseTable load success, path from "
+  if (failed_num > 0) {
+    LOG(ERROR) << "MemorySparseTable load snapshot failed, failed file num:"
+               << failed_num;
+    return -1;
+  }
+  LOG(INFO) << "MemorySparseTable load snapshot success, path from "
             << file_list[file_start_idx] << " to "
             << file_list[file_start_idx + _real_local_shard_num - 1];
   return 0;
@@ -205,6 +400,11 @@ int32_t MemorySparseTable::Load(const std::string &path,
 
 int32_t MemorySparseTable::LoadPatch(const std::vector<std::string> &file_list,
                                      int load_param) {
+  // the patch is read into the map shards
+  PADDLE_ENFORCE_EQ(_use_flat_shard,
+                    false,
+                    common::errors::Unimplemented(
+                        "LoadPatch does not support FLAT_HASH_SHARD."));
   if (!_config.enable_revert()) {
     LOG(INFO) << "MemorySparseTable should be enabled revert.";
     return 0;
@@ -342,6 +542,24 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
     return 0;
   }
 
+  if (_config.save_sparse_snapshot() && !_use_gpu_graph &&
+      (save_param == 0 || save_param == 3) &&
+      ::paddle::framework::fs_select_internal(dirname) == 0) {
+    if (_use_flat_shard) {
+      return SaveSnapshotShards(_local_flat_shards.get(), dirname, save_param);
+    }
+    return SaveSnapshotShards(_local_shards.get(), dirname, save_param);
+  }
+  if (_use_flat_shard) {
+    return SaveLocalShards(_local_flat_shards.get(), dirname, save_param);
+  }
+  return SaveLocalShards(_local_shards.get(), dirname, save_param);
+}
+
+template <typename SHARD>
+int32_t MemorySparseTable::SaveLocalShards(SHARD *local_shards,
+                                           const std::string &dirname,
+                                           int save_param) {
   // cache model
   int64_t tk_size = LocalSize() * _config.sparse_table_cache_rate();
   TopkCalculator tk(_real_local_shard_num, tk_size);
@@ -381,7 +599,7 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
     int feasign_size = 0;
     int retry_num = 0;
     int err_no = 0;
-    auto &shard = _local_shards[i];
+    auto &shard = local_shards[i];
 #if defined(PADDLE_WITH_HETERPS) && defined(PADDLE_WITH_PSCORE)
     // for incremental training, batch_model increase unseenday before save
     if (_use_gpu_graph && save_param == 3) {
@@ -453,9 +671,70 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
   return 0;
 }
 
+template <typename SHARD>
+int32_t MemorySparseTable::SaveSnapshotShards(SHARD *local_shards,
+                                              const std::string &dirname,
+                                              int save_param) {
+  std::string table_path = TableDir(dirname);
+  ::paddle::framework::localfs_mkdir(table_path);
+  _afs_client.remove(::paddle::string::format_string(
+      "%s/part-%03d-*", table_path.c_str(), _shard_idx));
+  const auto &info = _value_accessor->GetAccessorInfo();
+  const std::string &accessor_class = _config.accessor().accessor_class();
+  size_t file_start_idx = _avg_local_shard_num * _shard_idx;
+  std::atomic<uint64_t> feasign_size_all{0};
+
+  int thread_num = _real_local_shard_num < 20 ? _real_local_shard_num : 20;
+  omp_set_num_threads(thread_num);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    auto &shard = local_shards[i];
+    std::string path = ::paddle::string::format_string(
+        "%s/part-%03d-%05d" PSERVER_SNAPSHOT_SUFFIX,
+        table_path.c_str(),
+        _shard_idx,
+        file_start_idx + i);
+    std::vector<SparseSnapshotEntry> entries;
+    entries.reserve(shard.size());
+    for (auto it = shard.begin(); it != shard.end(); ++it) {
+      if (_value_accessor->Save(it.value().data(), save_param)) {
+        entries.push_back({it.key(),
+                           it.value().data(),
+                           static_cast<uint32_t>(it.value().size())});
+      }
+    }
+    int retry_num = 0;
+    while (WriteSparseSnapshot(path, info, accessor_class, &entries) != 0) {
+      ++retry_num;
+      LOG(ERROR) << "MemorySparseTable save snapshot failed, retry it! path:"
+                 << path << " , retry_num=" << retry_num;
+      if (retry_num > FLAGS_pserver_table_save_max_retry) {
+        LOG(ERROR) << "MemorySparseTable save snapshot failed reach max limit!";
+        exit(-1);
+      }
+    }
+    feasign_size_all += entries.size();
+    for (auto it = shard.begin(); it != shard.end(); ++it) {
+      _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
+    }
+    LOG(INFO) << "MemorySparseTable save snapshot success, path: " << path
+              << " feasign_size: " << entries.size();
+  }
+  VLOG(0) << "MemorySparseTable::save snapshot feasign_size: "
+          << feasign_size_all;
+  // snapshots are only written for checkpoints, which collect no cache
+  // model, so the threshold is left at the empty top k like SaveLocalShards.
+  _local_show_threshold = 0;
+  return 0;
+}
+
 #if defined(PADDLE_WITH_HETERPS) && defined(PADDLE_WITH_PSCORE)
 int32_t MemorySparseTable::Save_v2(const std::string &dirname,
                                    const std::string &param) {
+  PADDLE_ENFORCE_EQ(_use_flat_shard,
+                    false,
+                    common::errors::Unimplemented(
+                        "Save_v2 does not support FLAT_HASH_SHARD."));
   if (_real_local_shard_num == 0) {
     _local_show_threshold = -1;
     return 0;
@@ -754,6 +1033,10 @@ int64_t MemorySparseTable::CacheShuffle(
         &shuffled_channel,
     const std::vector<Table *> &table_ptrs) {
   LOG(INFO) << "cache shuffle with cache threshold: " << cache_threshold;
+  PADDLE_ENFORCE_EQ(_use_flat_shard,
+                    false,
+                    common::errors::Unimplemented(
+                        "CacheShuffle does not support FLAT_HASH_SHARD."));
   int save_param = atoi(param.c_str());  // batch_model:0  xbox:1
   if (!_config.enable_sparse_table_cache() || cache_threshold < 0) {
     LOG(WARNING)
@@ -909,20 +1192,29 @@ int32_t MemorySparseTable::SaveCache(
 int64_t MemorySparseTable::LocalSize() {
   int64_t local_size = 0;
   for (int i = 0; i < _real_local_shard_num; ++i) {
-    local_size += _local_shards[i].size();
+    local_size += _use_flat_shard ? _local_flat_shards[i].size()
+                                  : _local_shards[i].size();
   }
   return local_size;
 }
 
 int64_t MemorySparseTable::LocalMFSize() {
+  if (_use_flat_shard) {
+    return LocalMFSizeImpl(_local_flat_shards.get());
+  }
+  return LocalMFSizeImpl(_local_shards.get());
+}
+
+template <typename SHARD>
+int64_t MemorySparseTable::LocalMFSizeImpl(SHARD *local_shards) {
   std::vector<int64_t> size_arr(_real_local_shard_num, 0);
   std::vector<std::future<int>> tasks(_real_local_shard_num);
   int64_t ret_size = 0;
   for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
     tasks[shard_id] =
         _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
-            [this, shard_id, &size_arr]() -> int {
-              auto &local_shard = _local_shards[shard_id];
+            [this, local_shards, shard_id, &size_arr]() -> int {
+              auto &local_shard = local_shards[shard_id];
               for (auto it = local_shard.begin(); it != local_shard.end();
                    ++it) {
                 if (_value_accessor->HasMF(it.value().size())) {
@@ -975,6 +1267,16 @@ int32_t MemorySparseTable::Push(TableContext &context) {
 
 int32_t MemorySparseTable::PullSparse(float *pull_values,
                                       const PullSparseValue &pull_value) {
+  if (_use_flat_shard) {
+    return PullSparseImpl(_local_flat_shards.get(), pull_values, pull_value);
+  }
+  return PullSparseImpl(_local_shards.get(), pull_values, pull_value);
+}
+
+template <typename SHARD>
+int32_t MemorySparseTable::PullSparseImpl(SHARD *local_shards,
+                                          float *pull_values,
+                                          const PullSparseValue &pull_value) {
   CostTimer timer("pserver_sparse_select_all");
   std::vector<std::future<int>> tasks(_real_local_shard_num);
 
@@ -998,47 +1300,53 @@ int32_t MemorySparseTable::PullSparse(float *pull_values,
     tasks[shard_id] =
         _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
             [this,
+             local_shards,
              shard_id,
              &task_keys,
              value_size,
              pull_values,
              mf_value_size,
              select_value_size]() -> int {
-              auto &local_shard = _local_shards[shard_id];
+              auto &local_shard = local_shards[shard_id];
               float data_buffer[value_size];  // NOLINT
               float *data_buffer_ptr = data_buffer;
 
               auto &keys = task_keys[shard_id];
-              for (auto &item : keys) {
-                uint64_t key = item.first;
-                auto itr = local_shard.find(key);
-                size_t data_size = value_size - mf_value_size;
-                if (itr == local_shard.end()) {
-                  // ++missed_keys;
-                  if (FLAGS_pserver_create_value_when_push) {
-                    memset(data_buffer, 0, sizeof(float) * data_size);
-                  } else {
-                    auto &feature_value = local_shard[key];
-                    feature_value.resize(data_size);
-                    float *data_ptr = feature_value.data();
-                    _value_accessor->Create(&data_buffer_ptr, 1);
-                    memcpy(
-                        data_ptr, data_buffer_ptr, data_size * sizeof(float));
-                  }
-                } else {
-                  data_size = itr.value().size();
-                  memcpy(data_buffer_ptr,
-                         itr.value().data(),
-                         data_size * sizeof(float));
-                }
-                for (size_t mf_idx = data_size; mf_idx < value_size; ++mf_idx) {
-                  data_buffer[mf_idx] = 0.0;
-                }
-                auto offset = item.second;
-                float *select_data = pull_values + select_value_size * offset;
-                _value_accessor->Select(
-                    &select_data, (const float **)&data_buffer_ptr, 1);
-              }
+              ForEachShardValue(
+                  &local_shard,
+                  keys,
+                  [&](const std::pair<uint64_t, int> &item, auto *value) {
+                    uint64_t key = item.first;
+                    size_t data_size = value_size - mf_value_size;
+                    if (value == nullptr) {
+                      // ++missed_keys;
+                      if (FLAGS_pserver_create_value_when_push) {
+                        memset(data_buffer_ptr, 0, sizeof(float) * data_size);
+                      } else {
+                        auto &feature_value = local_shard[key];
+                        feature_value.resize(data_size);
+                        float *data_ptr = feature_value.data();
+                        _value_accessor->Create(&data_buffer_ptr, 1);
+                        memcpy(data_ptr,
+                               data_buffer_ptr,
+                               data_size * sizeof(float));
+                      }
+                    } else {
+                      data_size = value->size();
+                      memcpy(data_buffer_ptr,
+                             value->data(),
+                             data_size * sizeof(float));
+                    }
+                    for (size_t mf_idx = data_size; mf_idx < value_size;
+                         ++mf_idx) {
+                      data_buffer_ptr[mf_idx] = 0.0;
+                    }
+                    auto offset = item.second;
+                    float *select_data =
+                        pull_values + select_value_size * offset;
+                    _value_accessor->Select(
+                        &select_data, (const float **)&data_buffer_ptr, 1);
+                  });
 
               return 0;
             });
@@ -1055,6 +1363,11 @@ int32_t MemorySparseTable::PullSparsePtr(int shard_id,  // fake num
                                          const uint64_t *keys,
                                          size_t num,
                                          uint16_t pass_id) {
+  // the returned pointers are read as FixedFeatureValue by heter ps
+  PADDLE_ENFORCE_EQ(_use_flat_shard,
+                    false,
+                    common::errors::Unimplemented(
+                        "PullSparsePtr does not support FLAT_HASH_SHARD."));
   CostTimer timer("pscore_sparse_select_all");
   size_t value_size = _value_accessor->GetAccessorInfo().size / sizeof(float);
   size_t mf_value_size =
@@ -1081,25 +1394,27 @@ int32_t MemorySparseTable::PullSparsePtr(int shard_id,  // fake num
               auto &local_shard = _local_shards[shard_id];
               float data_buffer[value_size];  // NOLINT
               float *data_buffer_ptr = data_buffer;
-              for (auto &item : keys) {
-                uint64_t key = item.first;
-                auto itr = local_shard.find(key);
-                size_t data_size = value_size - mf_value_size;
-                FixedFeatureValue *ret = NULL;
-                if (itr == local_shard.end()) {
-                  // ++missed_keys;
-                  auto &feature_value = local_shard[key];
-                  feature_value.resize(data_size);
-                  float *data_ptr = feature_value.data();
-                  _value_accessor->Create(&data_buffer_ptr, 1);
-                  memcpy(data_ptr, data_buffer_ptr, data_size * sizeof(float));
-                  ret = &feature_value;
-                } else {
-                  ret = itr.value_ptr();
-                }
-                int pull_data_idx = item.second;
-                pull_values[pull_data_idx] = reinterpret_cast<char *>(ret);
-              }
+              ForEachShardValue(
+                  &local_shard,
+                  keys,
+                  [&](const std::pair<uint64_t, int> &item,
+                      FixedFeatureValue *ret) {
+                    uint64_t key = item.first;
+                    size_t data_size = value_size - mf_value_size;
+                    if (ret == nullptr) {
+                      // ++missed_keys;
+                      auto &feature_value = local_shard[key];
+                      feature_value.resize(data_size);
+                      float *data_ptr = feature_value.data();
+                      _value_accessor->Create(&data_buffer_ptr, 1);
+                      memcpy(data_ptr,
+                             data_buffer_ptr,
+                             data_size * sizeof(float));
+                      ret = &feature_value;
+                    }
+                    int pull_data_idx = item.second;
+                    pull_values[pull_data_idx] = reinterpret_cast<char *>(ret);
+                  });
               return 0;
             });
   }
@@ -1112,6 +1427,17 @@ int32_t MemorySparseTable::PullSparsePtr(int shard_id,  // fake num
 int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
                                       const float *values,
                                       size_t num) {
+  if (_use_flat_shard) {
+    return PushSparseImpl(_local_flat_shards.get(), keys, values, num);
+  }
+  return PushSparseImpl(_local_shards.get(), keys, values, num);
+}
+
+template <typename SHARD>
+int32_t MemorySparseTable::PushSparseImpl(SHARD *local_shards,
+                                          const uint64_t *keys,
+                                          const float *values,
+                                          size_t num) {
   CostTimer timer("pserver_sparse_update_all");
   std::vector<std::future<int>> tasks(_real_local_shard_num);
   std::vector<std::vector<std::pair<uint64_t, int>>> task_keys(
@@ -1131,6 +1457,7 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
   for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
     tasks[shard_id] = _shards_task_pool[shard_id % _task_pool_size]->enqueue(
         [this,
+         local_shards,
          shard_id,
          value_col,
          mf_value_col,
@@ -1138,58 +1465,64 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
          values,
          &task_keys]() -> int {
           auto &keys = task_keys[shard_id];
-          auto &local_shard = _local_shards[shard_id];
+          auto &local_shard = local_shards[shard_id];
           auto &local_shard_new = _local_shards_new[shard_id];
           float data_buffer[value_col];  // NOLINT
           float *data_buffer_ptr = data_buffer;
-          for (auto &item : keys) {
-            uint64_t key = item.first;
-            uint64_t push_data_idx = item.second;
-            const float *update_data =
-                values + push_data_idx * update_value_col;
-            auto itr = local_shard.find(key);
-            if (itr == local_shard.end()) {
-              if (FLAGS_pserver_enable_create_feasign_randomly &&
-                  !_value_accessor->CreateValue(1, update_data)) {
-                continue;
-              }
-              auto value_size = value_col - mf_value_col;
-              auto &feature_value = local_shard[key];
-              feature_value.resize(value_size);
-              _value_accessor->Create(&data_buffer_ptr, 1);
-              memcpy(feature_value.data(),
-                     data_buffer_ptr,
-                     value_size * sizeof(float));
-              itr = local_shard.find(key);
-            }
+          ForEachShardValue(
+              &local_shard,
+              keys,
+              [&](const std::pair<uint64_t, int> &item, auto *value) {
+                uint64_t key = item.first;
+                uint64_t push_data_idx = item.second;
+                const float *update_data =
+                    values + push_data_idx * update_value_col;
+                if (value == nullptr) {
+                  if (FLAGS_pserver_enable_create_feasign_randomly &&
+                      !_value_accessor->CreateValue(1, update_data)) {
+                    return;
+                  }
+                  auto value_size = value_col - mf_value_col;
+                  value = &local_shard[key];
+                  value->resize(value_size);
+                  _value_accessor->Create(&data_buffer_ptr, 1);
+                  memcpy(value->data(),
+                         data_buffer_ptr,
+                         value_size * sizeof(float));
+                }
 
-            auto &feature_value = itr.value();
-            float *value_data = feature_value.data();
-            size_t value_size = feature_value.size();
-
-            if (value_size == value_col) {  // 已拓展到最大size, 则就地update
-              _value_accessor->Update(&value_data, &update_data, 1);
-            } else {
-              // 拷入buffer区进行update，然后再回填，不需要的mf则回填时抛弃了
-              memcpy(data_buffer_ptr, value_data, value_size * sizeof(float));
-              _value_accessor->Update(&data_buffer_ptr, &update_data, 1);
-
-              if (_value_accessor->NeedExtendMF(data_buffer)) {
-                feature_value.resize(value_col);
-                value_data = feature_value.data();
-                _value_accessor->Create(&value_data, 1);
-              }
-              memcpy(value_data, data_buffer_ptr, value_size * sizeof(float));
-            }
-            if (_config.enable_revert()) {
-              FixedFeatureValue *feature_value_new = &(local_shard_new[key]);
-              auto new_size = feature_value.size();
-              feature_value_new->resize(new_size);
-              memcpy(feature_value_new->data(),
-                     value_data,
-                     new_size * sizeof(float));
-            }
-          }
+                auto &feature_value = *value;
+                float *value_data = feature_value.data();
+                size_t value_size = feature_value.size();
+
+                // 已拓展到最大size, 则就地update
+                if (value_size == value_col) {
+                  _value_accessor->Update(&value_data, &update_data, 1);
+                } else {
+                  // 拷入buffer区进行update，然后再回填，
+                  // 不需要的mf则回填时抛弃了
+                  memcpy(
+                      data_buffer_ptr, value_data, value_size * sizeof(float));
+                  _value_accessor->Update(&data_buffer_ptr, &update_data, 1);
+
+                  if (_value_accessor->NeedExtendMF(data_buffer_ptr)) {
+                    feature_value.resize(value_col);
+                    value_data = feature_value.data();
+                    _value_accessor->Create(&value_data, 1);
+                  }
+                  memcpy(
+                      value_data, data_buffer_ptr, value_size * sizeof(float));
+                }
+                if (_config.enable_revert()) {
+                  FixedFeatureValue *feature_value_new =
+                      &(local_shard_new[key]);
+                  auto new_size = feature_value.size();
+                  feature_value_new->resize(new_size);
+                  memcpy(feature_value_new->data(),
+                         value_data,
+                         new_size * sizeof(float));
+                }
+              });
           return 0;
         });
   }
@@ -1203,6 +1536,17 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
 int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
                                       const float **values,
                                       size_t num) {
+  if (_use_flat_shard) {
+    return PushSparseImpl(_local_flat_shards.get(), keys, values, num);
+  }
+  return PushSparseImpl(_local_shards.get(), keys, values, num);
+}
+
+template <typename SHARD>
+int32_t MemorySparseTable::PushSparseImpl(SHARD *local_shards,
+                                          const uint64_t *keys,
+                                          const float **values,
+                                          size_t num) {
   std::vector<std::future<int>> tasks(_real_local_shard_num);
   std::vector<std::vector<std::pair<uint64_t, int>>> task_keys(
       _real_local_shard_num);
@@ -1217,47 +1561,58 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
 
   for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
     tasks[shard_id] = _shards_task_pool[shard_id % _task_pool_size]->enqueue(
-        [this, shard_id, value_col, mf_value_col, values, &task_keys]() -> int {
+        [this,
+         local_shards,
+         shard_id,
+         value_col,
+         mf_value_col,
+         values,
+         &task_keys]() -> int {
           auto &keys = task_keys[shard_id];
-          auto &local_shard = _local_shards[shard_id];
+          auto &local_shard = local_shards[shard_id];
           float data_buffer[value_col];  // NOLINT
           float *data_buffer_ptr = data_buffer;
-          for (auto &item : keys) {
-            uint64_t key = item.first;
-            uint64_t push_data_idx = item.second;
-            const float *update_data = values[push_data_idx];
-            auto itr = local_shard.find(key);
-            if (itr == local_shard.end()) {
-              if (FLAGS_pserver_enable_create_feasign_randomly &&
-                  !_value_accessor->CreateValue(1, update_data)) {
-                continue;
-              }
-              auto value_size = value_col - mf_value_col;
-              auto &feature_value = local_shard[key];
-              feature_value.resize(value_size);
-              _value_accessor->Create(&data_buffer_ptr, 1);
-              memcpy(feature_value.data(),
-                     data_buffer_ptr,
-                     value_size * sizeof(float));
-              itr = local_shard.find(key);
-            }
-            auto &feature_value = itr.value();
-            float *value_data = feature_value.data();
-            size_t value_size = feature_value.size();
-            if (value_size == value_col) {  // 已拓展到最大size, 则就地update
-              _value_accessor->Update(&value_data, &update_data, 1);
-            } else {
-              // 拷入buffer区进行update，然后再回填，不需要的mf则回填时抛弃了
-              memcpy(data_buffer_ptr, value_data, value_size * sizeof(float));
-              _value_accessor->Update(&data_buffer_ptr, &update_data, 1);
-              if (_value_accessor->NeedExtendMF(data_buffer)) {
-                feature_value.resize(value_col);
-                value_data = feature_value.data();
-                _value_accessor->Create(&value_data, 1);
-              }
-              memcpy(value_data, data_buffer_ptr, value_size * sizeof(float));
-            }
-          }
+          ForEachShardValue(
+              &local_shard,
+              keys,
+              [&](const std::pair<uint64_t, int> &item, auto *value) {
+                uint64_t key = item.first;
+                uint64_t push_data_idx = item.second;
+                const float *update_data = values[push_data_idx];
+                if (value == nullptr) {
+                  if (FLAGS_pserver_enable_create_feasign_randomly &&
+                      !_value_accessor->CreateValue(1, update_data)) {
+                    return;
+                  }
+                  auto value_size = value_col - mf_value_col;
+                  value = &local_shard[key];
+                  value->resize(value_size);
+                  _value_accessor->Create(&data_buffer_ptr, 1);
+                  memcpy(value->data(),
+                         data_buffer_ptr,
+                         value_size * sizeof(float));
+                }
+                auto &feature_value = *value;
+                float *value_data = feature_value.data();
+                size_t value_size = feature_value.size();
+                // 已拓展到最大size, 则就地update
+                if (value_size == value_col) {
+                  _value_accessor->Update(&value_data, &update_data, 1);
+                } else {
+                  // 拷入buffer区进行update，然后再回填，
+                  // 不需要的mf则回填时抛弃了
+                  memcpy(
+                      data_buffer_ptr, value_data, value_size * sizeof(float));
+                  _value_accessor->Update(&data_buffer_ptr, &update_data, 1);
+                  if (_value_accessor->NeedExtendMF(data_buffer_ptr)) {
+                    feature_value.resize(value_col);
+                    value_data = feature_value.data();
+                    _value_accessor->Create(&value_data, 1);
+                  }
+                  memcpy(
+                      value_data, data_buffer_ptr, value_size * sizeof(float));
+                }
+              });
           return 0;
         });
   }
@@ -1272,6 +1627,14 @@ int32_t MemorySparseTable::Flush() { return 0; }
 
 int32_t MemorySparseTable::Shrink(const std::string &param) {
   VLOG(0) << "MemorySparseTable::Shrink";
+  if (_use_flat_shard) {
+    return ShrinkImpl(_local_flat_shards.get());
+  }
+  return ShrinkImpl(_local_shards.get());
+}
+
+template <typename SHARD>
+int32_t MemorySparseTable::ShrinkImpl(SHARD *local_shards) {
   std::atomic<uint32_t> shrink_size_all{0};
   int thread_num = _real_local_shard_num;
   omp_set_num_threads(thread_num);
@@ -1279,7 +1642,7 @@ int32_t MemorySparseTable::Shrink(const std::string &param) {
   for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
     // Shrink
     int feasign_size = 0;
-    auto &shard = _local_shards[shard_id];
+    auto &shard = local_shards[shard_id];
     for (auto it = shard.begin(); it != shard.end();) {
       if (_value_accessor->Shrink(it.value().data())) {
         it = shard.erase(it);
@@ -29,6 +29,8 @@
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/common_table.h"
 #include "paddle/fluid/distributed/ps/table/depends/feature_value.h"
+#include "paddle/fluid/distributed/ps/table/depends/flat_feature_value.h"
+#include "paddle/fluid/distributed/ps/table/sparse_snapshot.h"
 #include "paddle/utils/string/string_helper.h"
 
 #define PSERVER_SAVE_SUFFIX ".shard"
@@ -39,6 +41,7 @@ namespace distributed {
 class MemorySparseTable : public Table {
  public:
   typedef SparseTableShard<uint64_t, FixedFeatureValue> shard_type;
+  typedef FlatSparseTableShard<uint64_t> flat_shard_type;
   MemorySparseTable() {}
   virtual ~MemorySparseTable() {}
 
@@ -108,6 +111,9 @@ class MemorySparseTable : public Table {
   void Clear() override;
 
   void* GetShard(size_t shard_idx) override {
+    if (_use_flat_shard) {
+      return &_local_flat_shards[shard_idx];
+    }
     return &_local_shards[shard_idx];
   }
 
@@ -119,12 +125,57 @@ class MemorySparseTable : public Table {
   virtual int32_t LoadPatch(const std::vector<std::string>& file_list,
                             int save_param);
 
+  // the implementations below are shared by both shard backends, see
+  // TableParameter.sparse_shard_type
+  template <typename SHARD>
+  void LoadLocalShard(SHARD* local_shard,
+                      const std::string& path,
+                      int shard_id,
+                      int load_param);
+  template <typename SHARD>
+  int32_t LoadLocalShards(SHARD* local_shards,
+                          const std::vector<std::string>& file_list,
+                          int load_param);
+  template <typename SHARD>
+  int32_t SaveLocalShards(SHARD* local_shards,
+                          const std::string& dirname,
+                          int save_param);
+  // binary snapshot format, see sparse_snapshot.h
+  template <typename SHARD>
+  int32_t LoadSnapshotShards(SHARD* local_shards,
+                             const std::vector<std::string>& file_list,
+                             int load_param);
+  template <typename SHARD>
+  int32_t SaveSnapshotShards(SHARD* local_shards,
+                             const std::string& dirname,
+                             int save_param);
+  template <typename SHARD>
+  int32_t PullSparseImpl(SHARD* local_shards,
+                         float* pull_values,
+                         const PullSparseValue& pull_value);
+  template <typename SHARD>
+  int32_t PushSparseImpl(SHARD* local_shards,
+                         const uint64_t* keys,
+                         const float* values,
+                         size_t num);
+  template <typename SHARD>
+  int32_t PushSparseImpl(SHARD* local_shards,
+                         const uint64_t* keys,
+                         const float** values,
+                         size_t num);
+  template <typename SHARD>
+  int64_t LocalMFSizeImpl(SHARD* local_shards);
+  template <typename SHARD>
+  int32_t ShrinkImpl(SHARD* local_shards);
+
   int _task_pool_size = 24;
   int _avg_local_shard_num;
   int _real_local_shard_num;
   int _sparse_table_shard_num;
   std::vector<std::shared_ptr<::ThreadPool>> _shards_task_pool;
   std::unique_ptr<shard_type[]> _local_shards;
+  bool _use_flat_shard = false;
+  std::unique_ptr<flat_shard_type[]> _local_flat_shards;
 
   // for patch model
   int _m_avg_local_shard_num;
@@ -0,0 +1,316 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/table/sparse_snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <xxhash.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "glog/logging.h"
+
+namespace paddle {
+namespace distributed {
+
+static const char SNAPSHOT_MAGIC[8] = {'P', 'D', 'S', 'P', 'S', 'N', 'P', '1'};
+static const uint32_t SNAPSHOT_VERSION = 1;
+static const size_t SNAPSHOT_PAGE_SIZE = 4096;
+
+static uint64_t AlignToPage(uint64_t offset) {
+  return (offset + SNAPSHOT_PAGE_SIZE - 1) & ~(SNAPSHOT_PAGE_SIZE - 1);
+}
+
+// Whether `num` items of `item_size` bytes starting at `offset` lie within a
+// file of `file_size` bytes, without overflowing on a corrupted header.
+static bool SectionInFile(uint64_t offset,
+                          uint64_t num,
+                          uint64_t item_size,
+                          uint64_t file_size) {
+  if (offset > file_size || offset % SNAPSHOT_PAGE_SIZE != 0) {
+    return false;
+  }
+  return item_size == 0 || num <= (file_size - offset) / item_size;
+}
+
+static bool WriteAt(FILE* fp, uint64_t offset, const void* data, size_t len) {
+  if (fseeko(fp, static_cast<off_t>(offset), SEEK_SET) != 0) {
+    return false;
+  }
+  return len == 0 || fwrite(data, 1, len, fp) == len;
+}
+
+bool IsSparseSnapshotFile(const std::string& path) {
+  size_t suffix_len = strlen(PSERVER_SNAPSHOT_SUFFIX);
+  return path.size() > suffix_len &&
+         path.compare(path.size() - suffix_len,
+                      suffix_len,
+                      PSERVER_SNAPSHOT_SUFFIX) == 0;
+}
+
+int32_t WriteSparseSnapshot(const std::string& path,
+                            const AccessorInfo& info,
+                            const std::string& accessor_class,
+                            std::vector<SparseSnapshotEntry>* entries,
+                            uint32_t block_key_num) {
+  std::sort(entries->begin(),
+            entries->end(),
+            [](const SparseSnapshotEntry& a, const SparseSnapshotEntry& b) {
+              return a.key < b.key;
+            });
+  const size_t value_dim = info.dim;
+  const size_t value_stride = FlatValueSlab::stride_of(value_dim);
+  const uint64_t key_num = entries->size();
+  const uint64_t block_num = (key_num + block_key_num - 1) / block_key_num;
+
+  SparseSnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.value_dim = value_dim;
+  header.value_size = info.size;
+  header.select_dim = info.select_dim;
+  header.update_dim = info.update_dim;
+  header.mf_size = info.mf_size;
+  header.value_stride = value_stride;
+  header.block_key_num = block_key_num;
+  header.key_num = key_num;
+  header.block_num = block_num;
+  header.block_offset = AlignToPage(sizeof(header));
+  header.key_offset = AlignToPage(header.block_offset +
+                                  block_num * sizeof(SparseSnapshotBlock));
+  header.value_offset =
+      AlignToPage(header.key_offset + key_num * sizeof(uint64_t));
+  header.file_size = header.value_offset + key_num * value_stride;
+  snprintf(header.accessor_class,
+           sizeof(header.accessor_class),
+           "%s",
+           accessor_class.c_str());
+
+  std::string tmp_path = path + ".tmp";
+  FILE* fp = fopen(tmp_path.c_str(), "wb");
+  if (fp == nullptr) {
+    LOG(ERROR) << "open sparse snapshot failed, path: " << tmp_path;
+    return -1;
+  }
+  bool ok = true;
+  std::vector<SparseSnapshotBlock> blocks(block_num);
+  std::vector<uint64_t> keys;
+  std::vector<char> values;
+  for (uint64_t block = 0; ok && block < block_num; ++block) {
+    uint64_t begin = block * block_key_num;
+    uint64_t end = std::min<uint64_t>(key_num, begin + block_key_num);
+    keys.resize(end - begin);
+    values.assign((end - begin) * value_stride, 0);
+    for (uint64_t i = begin; i < end; ++i) {
+      const auto& entry = (*entries)[i];
+      keys[i - begin] = entry.key;
+      char* record = values.data() + (i - begin) * value_stride;
+      uint32_t capacity = value_dim;
+      memcpy(record, &entry.size, sizeof(uint32_t));
+      memcpy(record + sizeof(uint32_t), &capacity, sizeof(uint32_t));
+      memcpy(record + sizeof(FlatFeatureValue),
+             entry.data,
+             entry.size * sizeof(float));
+    }
+    auto& meta = blocks[block];
+    meta.first_key = keys.front();
+    meta.key_begin = begin;
+    meta.key_num = end - begin;
+    meta.key_checksum =
+        XXH64(keys.data(), keys.size() * sizeof(uint64_t), block);
+    meta.value_checksum = XXH64(values.data(), values.size(), block);
+    ok = WriteAt(fp,
+                 header.key_offset + begin * sizeof(uint64_t),
+                 keys.data(),
+                 keys.size() * sizeof(uint64_t)) &&
+         WriteAt(fp,
+                 header.value_offset + begin * value_stride,
+                 values.data(),
+                 values.size());
+  }
+  ok = ok &&
+       WriteAt(fp,
+               header.block_offset,
+               blocks.data(),
+               blocks.size() * sizeof(SparseSnapshotBlock)) &&
+       WriteAt(fp, 0, &header, sizeof(header)) &&
+       ftruncate(fileno(fp), static_cast<off_t>(header.file_size)) == 0;
+  ok = (fclose(fp) == 0) && ok;
+  if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(ERROR) << "write sparse snapshot failed, path: " << path;
+    unlink(tmp_path.c_str());
+    return -1;
+  }
+  return 0;
+}
+
+SparseSnapshotReader::~SparseSnapshotReader() {
+  if (_base != nullptr) {
+    munmap(_base, _length);
+  }
+}
+
+int32_t SparseSnapshotReader::Open(const std::string& path,
+                                   const AccessorInfo& info) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(ERROR) << "open sparse snapshot failed, path: " << path;
+    return -1;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 ||
+      static_cast<size_t>(file_stat.st_size) < sizeof(SparseSnapshotHeader)) {
+    LOG(ERROR) << "invalid sparse snapshot size, path: " << path;
+    close(fd);
+    return -1;
+  }
+  _length = file_stat.st_size;
+  void* base = mmap(
+      nullptr, _length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    LOG(ERROR) << "mmap sparse snapshot failed, path: " << path;
+    _length = 0;
+    return -1;
+  }
+  _base = reinterpret_cast<char*>(base);
+  _header = reinterpret_cast<const SparseSnapshotHeader*>(_base);
+
+  if (memcmp(_header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+      _header->version != SNAPSHOT_VERSION || _header->file_size != _length) {
+    LOG(ERROR) << "corrupted sparse snapshot header, path: " << path;
+    return -1;
+  }
+  if (_header->value_stride == 0 || _header->block_key_num == 0 ||
+      _header->block_offset < sizeof(SparseSnapshotHeader) ||
+      !SectionInFile(_header->block_offset,
+                     _header->block_num,
+                     sizeof(SparseSnapshotBlock),
+                     _length) ||
+      _header->key_offset < _header->block_offset +
+                                _header->block_num *
+                                    sizeof(SparseSnapshotBlock) ||
+      !SectionInFile(_header->key_offset,
+                     _header->key_num,
+                     sizeof(uint64_t),
+                     _length) ||
+      _header->value_offset <
+          _header->key_offset + _header->key_num * sizeof(uint64_t) ||
+      !SectionInFile(_header->value_offset,
+                     _header->key_num,
+                     _header->value_stride,
+                     _length)) {
+    LOG(ERROR) << "sparse snapshot section out of file bounds, path: " << path
+               << " file_size: " << _length
+               << " block_offset: " << _header->block_offset
+               << " block_num: " << _header->block_num
+               << " key_offset: " << _header->key_offset
+               << " value_offset: " << _header->value_offset
+               << " key_num: " << _header->key_num;
+    return -1;
+  }
+  if (_header->value_dim != info.dim || _header->value_size != info.size ||
+      _header->mf_size != info.mf_size ||
+      _header->value_stride != FlatValueSlab::stride_of(info.dim)) {
+    LOG(ERROR) << "sparse snapshot accessor layout mismatch, path: " << path
+               << " saved dim: " << _header->value_dim
+               << " accessor dim: " << info.dim;
+    return -1;
+  }
+  _blocks = reinterpret_cast<const SparseSnapshotBlock*>(
+      _base + _header->block_offset);
+  _keys = reinterpret_cast<const uint64_t*>(_base + _header->key_offset);
+  _values = _base + _header->value_offset;
+  // the block table is small, check that its key ranges tile the key section
+  // so that VerifyBlock never reads past it.
+  uint64_t key_begin = 0;
+  for (size_t block = 0; block < _header->block_num; ++block) {
+    const auto& meta = _blocks[block];
+    if (meta.key_begin != key_begin || meta.key_num == 0 ||
+        meta.key_num > _header->block_key_num ||
+        meta.key_num > _header->key_num - key_begin) {
+      LOG(ERROR) << "corrupted sparse snapshot block table, path: " << path
+                 << " block: " << block;
+      return -1;
+    }
+    key_begin += meta.key_num;
+  }
+  if (key_begin != _header->key_num) {
+    LOG(ERROR) << "corrupted sparse snapshot block table, path: " << path
+               << " covered keys: " << key_begin
+               << " key_num: " << _header->key_num;
+    return -1;
+  }
+  // keys are scanned once to build the index, values are hit randomly.
+  madvise(_base + _header->key_offset,
+          _header->value_offset - _header->key_offset,
+          MADV_SEQUENTIAL);
+  madvise(_values, _length - _header->value_offset, MADV_RANDOM);
+  return 0;
+}
+
+bool SparseSnapshotReader::VerifyBlock(size_t block, bool check_values) const {
+  const auto& meta = _blocks[block];
+  if (XXH64(_keys + meta.key_begin, meta.key_num * sizeof(uint64_t), block) !=
+      meta.key_checksum) {
+    return false;
+  }
+  return !check_values ||
+         XXH64(_values + meta.key_begin * _header->value_stride,
+               meta.key_num * _header->value_stride,
+               block) == meta.value_checksum;
+}
+
+void SparseSnapshotReader::CheckValues() const {
+  PADDLE_ENFORCE_LE(
+      _header->value_offset + _header->key_num * _header->value_stride,
+      _length,
+      common::errors::InvalidArgument(
+          "The sparse snapshot ends in the middle of a record."));
+  for (size_t i = 0; i < _header->key_num; ++i) {
+    auto* record = value(i);
+    PADDLE_ENFORCE_EQ(record->capacity(),
+                      _header->value_dim,
+                      common::errors::InvalidArgument(
+                          "Record %d of the sparse snapshot has capacity %d, "
+                          "but the value dim is %d.",
+                          i,
+                          record->capacity(),
+                          _header->value_dim));
+    PADDLE_ENFORCE_LE(record->size(),
+                      record->capacity(),
+                      common::errors::InvalidArgument(
+                          "Record %d of the sparse snapshot has %d floats, "
+                          "more than its capacity %d.",
+                          i,
+                          record->size(),
+                          record->capacity()));
+  }
+}
+
+std::pair<char*, size_t> SparseSnapshotReader::Release() {
+  std::pair<char*, size_t> mapping(_base, _length);
+  _base = nullptr;
+  _length = 0;
+  return mapping;
+}
+
+}  // namespace distributed
+}  // namespace paddle
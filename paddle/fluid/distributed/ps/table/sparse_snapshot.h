@@ -0,0 +1,126 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/distributed/ps/table/accessor.h"
+#include "paddle/fluid/distributed/ps/table/depends/flat_feature_value.h"
+
+#define PSERVER_SNAPSHOT_SUFFIX ".snapshot"
+
+namespace paddle {
+namespace distributed {
+
+// Binary snapshot of one local shard of a sparse table. The file is laid out
+// so that it can be mmaped and used in place:
+//
+//   | header | block table | sorted keys | values |
+//
+// Every section starts on a page boundary. Values are stored in key order as
+// FlatFeatureValue records of `value_stride` bytes, which is exactly the slot
+// layout of FlatValueSlab, so a FLAT_HASH_SHARD can index them without
+// copying or parsing anything.
+struct SparseSnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  // accessor layout the values were saved with
+  uint32_t value_dim;
+  uint32_t value_size;
+  uint32_t select_dim;
+  uint32_t update_dim;
+  uint32_t mf_size;
+  uint32_t value_stride;
+  uint32_t block_key_num;
+  uint64_t key_num;
+  uint64_t block_num;
+  uint64_t block_offset;
+  uint64_t key_offset;
+  uint64_t value_offset;
+  uint64_t file_size;
+  char accessor_class[64];
+};
+
+// Keys of a snapshot are split into blocks of `block_key_num` keys, and each
+// block carries XXH64 checksums of its keys and values.
+struct SparseSnapshotBlock {
+  uint64_t first_key;
+  uint64_t key_begin;
+  uint64_t key_num;
+  uint64_t key_checksum;
+  uint64_t value_checksum;
+};
+
+struct SparseSnapshotEntry {
+  uint64_t key;
+  const float* data;
+  uint32_t size;
+};
+
+bool IsSparseSnapshotFile(const std::string& path);
+
+// Sorts `entries` by key and writes them to `path` through a temporary file
+// which is renamed into place once complete. Returns 0 on success.
+int32_t WriteSparseSnapshot(const std::string& path,
+                            const AccessorInfo& info,
+                            const std::string& accessor_class,
+                            std::vector<SparseSnapshotEntry>* entries,
+                            uint32_t block_key_num = 65536);
+
+// Maps a snapshot privately (copy on write), so values can be updated in
+// place by the table without touching the file. Pages of the value section
+// are only faulted in when a value is used.
+class SparseSnapshotReader {
+ public:
+  SparseSnapshotReader() {}
+  ~SparseSnapshotReader();
+  SparseSnapshotReader(const SparseSnapshotReader&) = delete;
+
+  // Returns 0 on success, -1 if the file can not be mapped or its header
+  // does not match `info`.
+  int32_t Open(const std::string& path, const AccessorInfo& info);
+  // Checks the key checksum of `block`, and the value checksum as well if
+  // `check_values` is set, which faults in all values of the block.
+  bool VerifyBlock(size_t block, bool check_values) const;
+  // Enforces that every record is a slot of the accessor dim holding at most
+  // that many floats, and that the last one ends within the file. It reads
+  // the header of every record, so all value pages are faulted in.
+  void CheckValues() const;
+
+  const SparseSnapshotHeader& header() const { return *_header; }
+  size_t key_num() const { return _header->key_num; }
+  size_t block_num() const { return _header->block_num; }
+  uint64_t key(size_t i) const { return _keys[i]; }
+  FlatFeatureValue* value(size_t i) const {
+    return reinterpret_cast<FlatFeatureValue*>(
+        _values + i * _header->value_stride);
+  }
+  // Hands the mapping over to the caller, who must munmap it. The values
+  // returned by `value` stay valid.
+  std::pair<char*, size_t> Release();
+
+ private:
+  char* _base = nullptr;
+  size_t _length = 0;
+  const SparseSnapshotHeader* _header = nullptr;
+  const SparseSnapshotBlock* _blocks = nullptr;
+  const uint64_t* _keys = nullptr;
+  char* _values = nullptr;
+};
+
+}  // namespace distributed
+}  // namespace paddle
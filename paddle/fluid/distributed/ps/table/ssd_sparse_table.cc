@@ -14,6 +14,9 @@
 
 #include "paddle/fluid/distributed/ps/table/ssd_sparse_table.h"
 
+#include <chrono>
+#include <thread>
+
 #include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/common/cost_timer.h"
 #include "paddle/fluid/distributed/common/local_random.h"
@@ -28,14 +31,126 @@ PD_DEFINE_int32(pserver_load_batch_size, 5000, "load batch size for ssd");
 PHI_DEFINE_EXPORTED_string(rocksdb_path,
                            "database",
                            "path of sparse table rocksdb file");
+PD_DEFINE_int32(pserver_rocksdb_block_cache_mb,
+                64,
+                "block cache size in MB of every rocksdb shard");
+PD_DEFINE_string(pserver_rocksdb_compression,
+                 "none",
+                 "compression of rocksdb sst files: none, snappy, lz4 or zstd");
+PD_DEFINE_int64(pserver_ssd_hot_capacity,
+                0,
+                "max feasign num kept in the hot tier of every ssd table "
+                "shard, 0 disables background demotion");
+PD_DEFINE_int32(pserver_ssd_warm_capacity_mb,
+                0,
+                "memory budget in MB of the compressed warm tier of every "
+                "ssd table shard, 0 demotes hot values to rocksdb directly");
+PD_DEFINE_double(pserver_ssd_warm_admit_score,
+                 1.0,
+                 "values demoted from the hot tier whose show/click score "
+                 "reaches this threshold are kept in the warm tier");
+PD_DEFINE_int32(pserver_ssd_tier_interval_ms,
+                1000,
+                "interval of the background tier demotion of ssd table");
+PD_DEFINE_int32(pserver_ssd_cold_read_batch,
+                1024,
+                "key num of every async rocksdb MultiGet of ssd table pull");
+PD_DEFINE_int32(pserver_ssd_cold_read_thread_num,
+                8,
+                "thread num of the async rocksdb read pool of ssd table");
 
 namespace paddle {
 namespace distributed {
 
+static rocksdb::CompressionType RocksDBCompression(const std::string& name) {
+  if (name == "none") {
+    return rocksdb::kNoCompression;
+  } else if (name == "snappy") {
+    return rocksdb::kSnappyCompression;
+  } else if (name == "lz4") {
+    return rocksdb::kLZ4Compression;
+  } else if (name == "zstd") {
+    return rocksdb::kZSTD;
+  }
+  PADDLE_THROW(common::errors::InvalidArgument(
+      "Unsupported rocksdb compression [%s], expected none, snappy, lz4 or "
+      "zstd.",
+      name));
+}
+
+static uint64_t ElapsedUs(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - begin)
+      .count();
+}
+
+// 攒批写入rocksdb的降级值
+class ColdWriteBatch {
+ public:
+  ColdWriteBatch(RocksDBHandler* db, int shard_id)
+      : _db(db), _shard_id(shard_id) {}
+  ~ColdWriteBatch() { Flush(); }
+
+  void Add(uint64_t key, const float* data, size_t size) {
+    _keys.push_back(key);
+    _values.emplace_back(data, data + size);
+    if (_keys.size() >= static_cast<size_t>(FLAGS_pserver_load_batch_size)) {
+      Flush();
+    }
+  }
+
+  void Flush() {
+    if (_keys.empty()) {
+      return;
+    }
+    std::vector<std::pair<char*, int>> ssd_keys;
+    std::vector<std::pair<char*, int>> ssd_values;
+    for (size_t i = 0; i < _keys.size(); ++i) {
+      ssd_keys.emplace_back(reinterpret_cast<char*>(&_keys[i]),
+                            sizeof(uint64_t));
+      ssd_values.emplace_back(reinterpret_cast<char*>(_values[i].data()),
+                              _values[i].size() * sizeof(float));
+    }
+    _db->put_batch(_shard_id, ssd_keys, ssd_values, ssd_keys.size());
+    _keys.clear();
+    _values.clear();
+  }
+
+ private:
+  RocksDBHandler* _db;
+  int _shard_id;
+  std::vector<uint64_t> _keys;
+  std::vector<std::vector<float>> _values;
+};
+
+SSDSparseTable::~SSDSparseTable() {
+  {
+    std::lock_guard<std::mutex> guard(_tier_thread_mutex);
+    _tier_thread_stop = true;
+  }
+  _tier_thread_cond.notify_all();
+  if (_tier_thread.joinable()) {
+    _tier_thread.join();
+  }
+}
+
 int32_t SSDSparseTable::Initialize() {
+  PADDLE_ENFORCE_EQ(_config.sparse_shard_type(),
+                    CLOSED_HASH_SHARD,
+                    common::errors::InvalidArgument(
+                        "SSDSparseTable only supports CLOSED_HASH_SHARD."));
   MemorySparseTable::Initialize();
   _db = ::paddle::distributed::RocksDBHandler::GetInstance();
-  _db->initialize(FLAGS_rocksdb_path, _real_local_shard_num);
+  _db->initialize(FLAGS_rocksdb_path,
+                  _real_local_shard_num,
+                  FLAGS_pserver_rocksdb_block_cache_mb,
+                  RocksDBCompression(FLAGS_pserver_rocksdb_compression));
+  _warm_shards.reset(new WarmTierShard[_real_local_shard_num]);
+  _cold_read_pool.reset(
+      new ::ThreadPool(FLAGS_pserver_ssd_cold_read_thread_num));
+  if (FLAGS_pserver_ssd_hot_capacity > 0) {
+    _tier_thread = std::thread([this]() { TierMaintainLoop(); });
+  }
   VLOG(0) << "initialize SSDSparseTable succ";
   VLOG(0) << "SSD FLAGS_pserver_print_missed_key_num_every_push:"
           << FLAGS_pserver_print_missed_key_num_every_push;
@@ -107,63 +222,124 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
                &missed_keys]() -> int {
                 auto& keys = task_keys[shard_id];
                 auto& local_shard = _local_shards[shard_id];
+                auto& warm_shard = _warm_shards[shard_id];
                 float data_buffer[value_size];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
+                auto select_value = [&](const float* data,
+                                        size_t data_size,
+                                        int pull_data_idx) {
+                  if (data != data_buffer_ptr) {
+                    memcpy(data_buffer_ptr, data, data_size * sizeof(float));
+                  }
+                  for (size_t mf_idx = data_size; mf_idx < value_size;
+                       ++mf_idx) {
+                    data_buffer_ptr[mf_idx] = 0.0;
+                  }
+                  float* select_data =
+                      pull_values + pull_data_idx * select_value_size;
+                  _value_accessor->Select(
+                      &select_data, (const float**)&data_buffer_ptr, 1);
+                };
+
+                // 热层和温层命中的key直接处理, 其余key攒批后异步读rocksdb,
+                // 冷层读与内存命中的处理重叠
+                std::vector<std::unique_ptr<RocksDBItem>> cold_items;
+                std::vector<std::future<int>> cold_reads;
+                uint64_t hot_hits = 0;
+                uint64_t warm_hits = 0;
+                auto mem_begin = std::chrono::steady_clock::now();
                 for (size_t i = 0; i < keys.size(); ++i) {
                   uint64_t key = keys[i].first;
                   auto itr = local_shard.find(key);
-                  size_t data_size = value_size - mf_value_size;
-                  if (itr == local_shard.end()) {
-                    // pull rocksdb
-                    std::string tmp_string("");
-                    if (_db->get(shard_id,
-                                 reinterpret_cast<char*>(&key),
-                                 sizeof(uint64_t),
-                                 tmp_string) > 0) {
+                  if (itr != local_shard.end()) {
+                    ++hot_hits;
+                    select_value(itr.value().data(),
+                                 itr.value().size(),
+                                 keys[i].second);
+                    continue;
+                  }
+                  size_t data_size = 0;
+                  auto warm_begin = std::chrono::steady_clock::now();
+                  if (warm_shard.Take(key, data_buffer_ptr, &data_size)) {
+                    ++warm_hits;
+                    AdmitHotValue(shard_id, key, data_buffer_ptr, data_size);
+                    select_value(data_buffer_ptr, data_size, keys[i].second);
+                    _tier_stat.AddLatency(WARM_TIER, ElapsedUs(warm_begin));
+                    continue;
+                  }
+                  if (cold_items.empty()) {
+                    cold_items.emplace_back(new RocksDBItem());
+                  }
+                  auto* item = cold_items.back().get();
+                  item->batch_keys.emplace_back(
+                      reinterpret_cast<const char*>(&keys[i].first),
+                      sizeof(uint64_t));
+                  item->batch_index.push_back(keys[i].second);
+                  if (item->batch_keys.size() ==
+                      static_cast<size_t>(FLAGS_pserver_ssd_cold_read_batch)) {
+                    cold_reads.push_back(ReadColdAsync(shard_id, item));
+                    cold_items.emplace_back(new RocksDBItem());
+                  }
+                }
+                if (!cold_items.empty() &&
+                    !cold_items.back()->batch_keys.empty()) {
+                  cold_reads.push_back(
+                      ReadColdAsync(shard_id, cold_items.back().get()));
+                }
+                _tier_stat.AddLatency(HOT_TIER, ElapsedUs(mem_begin));
+
+                uint64_t cold_hits = 0;
+                uint64_t misses = 0;
+                for (size_t x = 0; x < cold_reads.size(); ++x) {
+                  cold_reads[x].wait();
+                  auto* item = cold_items[x].get();
+                  for (size_t idx = 0; idx < item->status.size(); ++idx) {
+                    uint64_t key = *(reinterpret_cast<const uint64_t*>(
+                        item->batch_keys[idx].data()));
+                    int pull_data_idx = item->batch_index[idx];
+                    // 同一请求中重复的key已经被前面的处理放入热层
+                    auto itr = local_shard.find(key);
+                    if (itr != local_shard.end()) {
+                      ++hot_hits;
+                      select_value(itr.value().data(),
+                                   itr.value().size(),
+                                   pull_data_idx);
+                    } else if (item->status[idx].IsNotFound()) {
                       ++missed_keys;
+                      ++misses;
+                      size_t data_size = value_size - mf_value_size;
                       if (FLAGS_pserver_create_value_when_push) {
-                        memset(data_buffer, 0, sizeof(float) * data_size);
+                        memset(data_buffer_ptr, 0, sizeof(float) * data_size);
                       } else {
                         auto& feature_value = local_shard[key];
                         feature_value.resize(data_size);
-                        float* data_ptr =
-                            const_cast<float*>(feature_value.data());
                         _value_accessor->Create(&data_buffer_ptr, 1);
-                        memcpy(data_ptr,
+                        memcpy(feature_value.data(),
                                data_buffer_ptr,
                                data_size * sizeof(float));
                       }
+                      select_value(data_buffer_ptr, data_size, pull_data_idx);
                     } else {
-                      data_size = tmp_string.size() / sizeof(float);
-                      memcpy(data_buffer_ptr,
-                             ::paddle::string::str_to_float(tmp_string),
-                             data_size * sizeof(float));
+                      ++cold_hits;
                       // from rocksdb to mem
-                      auto& feature_value = local_shard[key];
-                      feature_value.resize(data_size);
-                      memcpy(const_cast<float*>(feature_value.data()),
-                             data_buffer_ptr,
-                             data_size * sizeof(float));
+                      auto* value = AdmitHotValue(
+                          shard_id,
+                          key,
+                          ::paddle::string::str_to_float(
+                              item->batch_values[idx].data()),
+                          item->batch_values[idx].size() / sizeof(float));
                       _db->del_data(shard_id,
                                     reinterpret_cast<char*>(&key),
                                     sizeof(uint64_t));
+                      select_value(
+                          value->data(), value->size(), pull_data_idx);
                     }
-                  } else {
-                    data_size = itr.value().size();
-                    memcpy(data_buffer_ptr,
-                           itr.value().data(),
-                           data_size * sizeof(float));
-                  }
-                  for (size_t mf_idx = data_size; mf_idx < value_size;
-                       ++mf_idx) {
-                    data_buffer[mf_idx] = 0.0;
                   }
-                  int pull_data_idx = keys[i].second;
-                  float* select_data =
-                      pull_values + pull_data_idx * select_value_size;
-                  _value_accessor->Select(
-                      &select_data, (const float**)&data_buffer_ptr, 1);
                 }
+                _tier_stat.AddHit(HOT_TIER, hot_hits);
+                _tier_stat.AddHit(WARM_TIER, warm_hits);
+                _tier_stat.AddHit(COLD_TIER, cold_hits);
+                _tier_stat.AddMiss(misses);
                 return 0;
               });
     }
@@ -187,144 +363,106 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
   size_t value_size = _value_accessor->GetAccessorInfo().size / sizeof(float);
   size_t mf_value_size =
       _value_accessor->GetAccessorInfo().mf_size / sizeof(float);
+  // 之后的降级推迟到pass结束, 并等待进行中的一轮降级完成
+  _ptr_values_pinned.store(true);
+  while (_demoting.load()) {
+    std::this_thread::yield();
+  }
 
   {  // 从table取值 or create
-    RocksDBCtx context;
-    std::vector<std::future<int>> tasks;
-    RocksDBItem* cur_ctx = context.switch_item();
-    cur_ctx->reset();
+    std::vector<std::unique_ptr<RocksDBItem>> cold_items;
+    std::vector<std::future<int>> cold_reads;
     FixedFeatureValue* ret = nullptr;
     auto& local_shard = _local_shards[shard_id];
+    auto& warm_shard = _warm_shards[shard_id];
     float data_buffer[value_size];  // NOLINT
     float* data_buffer_ptr = data_buffer;
+    auto set_pull_value = [&](FixedFeatureValue* value, size_t pull_data_idx) {
+      _value_accessor->UpdateTimeDecay(value->data(), true);
+#ifdef PADDLE_WITH_PSLIB
+      _value_accessor->UpdatePassId(value->data(), pass_id);
+#endif
+      pull_values[pull_data_idx] = reinterpret_cast<char*>(value);
+    };
 
+    uint64_t hot_hits = 0;
+    uint64_t warm_hits = 0;
+    auto mem_begin = std::chrono::steady_clock::now();
     for (size_t i = 0; i < num; ++i) {
       uint64_t key = pull_keys[i];
       auto itr = local_shard.find(key);
-      if (itr == local_shard.end()) {
-        cur_ctx->batch_index.push_back(i);
-        cur_ctx->batch_keys.emplace_back(
-            reinterpret_cast<const char*>(&(pull_keys[i])), sizeof(uint64_t));
-        if (cur_ctx->batch_keys.size() == 1024) {
-          cur_ctx->batch_values.resize(cur_ctx->batch_keys.size());
-          cur_ctx->status.resize(cur_ctx->batch_keys.size());
-          auto fut =
-              _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
-                  [this, shard_id, cur_ctx]() -> int {
-                    _db->multi_get(shard_id,
-                                   cur_ctx->batch_keys.size(),
-                                   cur_ctx->batch_keys.data(),
-                                   cur_ctx->batch_values.data(),
-                                   cur_ctx->status.data());
-                    return 0;
-                  });
-          cur_ctx = context.switch_item();
-          for (size_t x = 0; x < tasks.size(); ++x) {
-            tasks[x].wait();
-            for (size_t idx = 0; idx < cur_ctx->status.size(); idx++) {
-              uint64_t cur_key = *(reinterpret_cast<uint64_t*>(
-                  const_cast<char*>(cur_ctx->batch_keys[idx].data())));
-              if (cur_ctx->status[idx].IsNotFound()) {
-                auto& feature_value = local_shard[cur_key];
-                int init_size = value_size - mf_value_size;
-                feature_value.resize(init_size);
-                _value_accessor->Create(&data_buffer_ptr, 1);
-                memcpy(const_cast<float*>(feature_value.data()),
-                       data_buffer_ptr,
-                       init_size * sizeof(float));
-                ret = &feature_value;
-              } else {
-                int data_size =
-                    cur_ctx->batch_values[idx].size() / sizeof(float);
-                // from rocksdb to mem
-                auto& feature_value = local_shard[cur_key];
-                feature_value.resize(data_size);
-                memcpy(const_cast<float*>(feature_value.data()),
-                       ::paddle::string::str_to_float(
-                           cur_ctx->batch_values[idx].data()),
-                       data_size * sizeof(float));
-                _db->del_data(shard_id,
-                              reinterpret_cast<char*>(&cur_key),
-                              sizeof(uint64_t));
-                ret = &feature_value;
-              }
-
-              _value_accessor->UpdateTimeDecay(ret->data(), true);
-#ifdef PADDLE_WITH_PSLIB
-              _value_accessor->UpdatePassId(ret->data(), pass_id);
-#endif
-              int pull_data_idx = cur_ctx->batch_index[idx];
-              pull_values[pull_data_idx] = reinterpret_cast<char*>(ret);
-            }
-          }
-          cur_ctx->reset();
-          tasks.clear();
-          tasks.push_back(std::move(fut));
-        }
-      } else {
-        ret = itr.value_ptr();
-        // int pull_data_idx = keys[i].second;
-        _value_accessor->UpdateTimeDecay(ret->data(), true);
-#ifdef PADDLE_WITH_PSLIB
-        _value_accessor->UpdatePassId(ret->data(), pass_id);
-#endif
-        pull_values[i] = reinterpret_cast<char*>(ret);
+      if (itr != local_shard.end()) {
+        ++hot_hits;
+        set_pull_value(itr.value_ptr(), i);
+        continue;
+      }
+      size_t data_size = 0;
+      auto warm_begin = std::chrono::steady_clock::now();
+      if (warm_shard.Take(key, data_buffer_ptr, &data_size)) {
+        ++warm_hits;
+        set_pull_value(
+            AdmitHotValue(shard_id, key, data_buffer_ptr, data_size), i);
+        _tier_stat.AddLatency(WARM_TIER, ElapsedUs(warm_begin));
+        continue;
+      }
+      if (cold_items.empty()) {
+        cold_items.emplace_back(new RocksDBItem());
+      }
+      auto* item = cold_items.back().get();
+      item->batch_index.push_back(i);
+      item->batch_keys.emplace_back(
+          reinterpret_cast<const char*>(&(pull_keys[i])), sizeof(uint64_t));
+      if (item->batch_keys.size() ==
+          static_cast<size_t>(FLAGS_pserver_ssd_cold_read_batch)) {
+        cold_reads.push_back(ReadColdAsync(shard_id, item));
+        cold_items.emplace_back(new RocksDBItem());
       }
     }
-    if (!cur_ctx->batch_keys.empty()) {
-      cur_ctx->batch_values.resize(cur_ctx->batch_keys.size());
-      cur_ctx->status.resize(cur_ctx->batch_keys.size());
-      auto fut =
-          _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
-              [this, shard_id, cur_ctx]() -> int {
-                _db->multi_get(shard_id,
-                               cur_ctx->batch_keys.size(),
-                               cur_ctx->batch_keys.data(),
-                               cur_ctx->batch_values.data(),
-                               cur_ctx->status.data());
-                return 0;
-              });
-      tasks.push_back(std::move(fut));
-    }
-    for (size_t x = 0; x < tasks.size(); ++x) {
-      tasks[x].wait();
+    if (!cold_items.empty() && !cold_items.back()->batch_keys.empty()) {
+      cold_reads.push_back(ReadColdAsync(shard_id, cold_items.back().get()));
     }
-    for (size_t x = 0; x < 2; x++) {
-      cur_ctx = context.switch_item();
-      for (size_t idx = 0; idx < cur_ctx->status.size(); idx++) {
-        uint64_t cur_key = *(reinterpret_cast<uint64_t*>(
-            const_cast<char*>(cur_ctx->batch_keys[idx].data())));
-        if (cur_ctx->status[idx].IsNotFound()) {
+    _tier_stat.AddLatency(HOT_TIER, ElapsedUs(mem_begin));
+
+    uint64_t cold_hits = 0;
+    uint64_t misses = 0;
+    for (size_t x = 0; x < cold_reads.size(); ++x) {
+      cold_reads[x].wait();
+      auto* item = cold_items[x].get();
+      for (size_t idx = 0; idx < item->status.size(); idx++) {
+        uint64_t cur_key = *(reinterpret_cast<const uint64_t*>(
+            item->batch_keys[idx].data()));
+        auto itr = local_shard.find(cur_key);
+        if (itr != local_shard.end()) {
+          ++hot_hits;
+          ret = itr.value_ptr();
+        } else if (item->status[idx].IsNotFound()) {
+          ++misses;
           auto& feature_value = local_shard[cur_key];
           int init_size = value_size - mf_value_size;
           feature_value.resize(init_size);
           _value_accessor->Create(&data_buffer_ptr, 1);
-          memcpy(const_cast<float*>(feature_value.data()),
+          memcpy(feature_value.data(),
                  data_buffer_ptr,
                  init_size * sizeof(float));
           ret = &feature_value;
         } else {
-          int data_size = cur_ctx->batch_values[idx].size() / sizeof(float);
+          ++cold_hits;
           // from rocksdb to mem
-          auto& feature_value = local_shard[cur_key];
-          feature_value.resize(data_size);
-          memcpy(
-              const_cast<float*>(feature_value.data()),
-              ::paddle::string::str_to_float(cur_ctx->batch_values[idx].data()),
-              data_size * sizeof(float));
+          ret = AdmitHotValue(
+              shard_id,
+              cur_key,
+              ::paddle::string::str_to_float(item->batch_values[idx].data()),
+              item->batch_values[idx].size() / sizeof(float));
           _db->del_data(
               shard_id, reinterpret_cast<char*>(&cur_key), sizeof(uint64_t));
-          ret = &feature_value;
         }
-        _value_accessor->UpdateTimeDecay(ret->data(), true);
-#ifdef PADDLE_WITH_PSLIB
-        _value_accessor->UpdatePassId(ret->data(), pass_id);
-#endif
-        int pull_data_idx = cur_ctx->batch_index[idx];
-        pull_values[pull_data_idx] = reinterpret_cast<char*>(ret);
+        set_pull_value(ret, item->batch_index[idx]);
       }
-      cur_ctx->reset();
     }
+    _tier_stat.AddHit(HOT_TIER, hot_hits);
+    _tier_stat.AddHit(WARM_TIER, warm_hits);
+    _tier_stat.AddHit(COLD_TIER, cold_hits);
+    _tier_stat.AddMiss(misses);
   }
   return 0;
 }
@@ -361,6 +499,7 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                 auto& local_shard = _local_shards[shard_id];
                 float data_buffer[value_col];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
+                PromoteKeys(shard_id, keys, data_buffer_ptr);
                 for (size_t i = 0; i < keys.size(); ++i) {
                   uint64_t key = keys[i].first;
                   uint64_t push_data_idx = keys[i].second;
@@ -462,6 +601,7 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                 auto& local_shard = _local_shards[shard_id];
                 float data_buffer[value_col];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
+                PromoteKeys(shard_id, keys, data_buffer_ptr);
                 for (size_t i = 0; i < keys.size(); ++i) {
                   uint64_t key = keys[i].first;
                   uint64_t push_data_idx = keys[i].second;
@@ -515,6 +655,8 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
 }
 
 int32_t SSDSparseTable::Shrink(const std::string& param) {
+  std::lock_guard<std::mutex> tier_guard(_tier_mutex);
+  SpillWarmTier();
   int thread_num = _real_local_shard_num < 20 ? _real_local_shard_num : 20;
   omp_set_num_threads(thread_num);
 #pragma omp parallel for schedule(dynamic)
@@ -551,10 +693,12 @@ int32_t SSDSparseTable::Shrink(const std::string& param) {
               << mem_count << "] SSD[" << ssd_count << "]";
     // _db->flush(i);
   }
+  _ptr_values_pinned.store(false);
   return 0;
 }
 
 int32_t SSDSparseTable::UpdateTable() {
+  std::lock_guard<std::mutex> tier_guard(_tier_mutex);
   int count = 0;
   for (int i = 0; i < _real_local_shard_num; ++i) {
     auto& shard = _local_shards[i];
@@ -574,14 +718,212 @@ int32_t SSDSparseTable::UpdateTable() {
     }
     _db->flush(i);
   }
+  _ptr_values_pinned.store(false);
   LOG(INFO) << "Table>> update count: " << count;
   return 0;
 }
 
+std::future<int> SSDSparseTable::ReadColdAsync(int shard_id,
+                                               RocksDBItem* item) {
+  item->batch_values.resize(item->batch_keys.size());
+  item->status.resize(item->batch_keys.size());
+  return _cold_read_pool->enqueue([this, shard_id, item]() -> int {
+    auto begin = std::chrono::steady_clock::now();
+    _db->multi_get(shard_id,
+                   item->batch_keys.size(),
+                   item->batch_keys.data(),
+                   item->batch_values.data(),
+                   item->status.data(),
+                   false);
+    _tier_stat.AddLatency(COLD_TIER, ElapsedUs(begin));
+    return 0;
+  });
+}
+
+FixedFeatureValue* SSDSparseTable::AdmitHotValue(int shard_id,
+                                                 uint64_t key,
+                                                 const float* data,
+                                                 size_t size) {
+  auto& feature_value = _local_shards[shard_id][key];
+  feature_value.resize(size);
+  memcpy(feature_value.data(), data, size * sizeof(float));
+  _tier_stat.AddPromote(1);
+  return &feature_value;
+}
+
+void SSDSparseTable::PromoteKeys(
+    int shard_id,
+    const std::vector<std::pair<uint64_t, int>>& keys,
+    float* buffer) {
+  auto& local_shard = _local_shards[shard_id];
+  auto& warm_shard = _warm_shards[shard_id];
+  std::vector<std::unique_ptr<RocksDBItem>> cold_items;
+  std::vector<std::future<int>> cold_reads;
+  for (auto& key : keys) {
+    if (local_shard.find(key.first) != local_shard.end()) {
+      continue;
+    }
+    size_t data_size = 0;
+    if (warm_shard.Take(key.first, buffer, &data_size)) {
+      AdmitHotValue(shard_id, key.first, buffer, data_size);
+      continue;
+    }
+    if (cold_items.empty()) {
+      cold_items.emplace_back(new RocksDBItem());
+    }
+    auto* item = cold_items.back().get();
+    item->batch_keys.emplace_back(reinterpret_cast<const char*>(&key.first),
+                                  sizeof(uint64_t));
+    if (item->batch_keys.size() ==
+        static_cast<size_t>(FLAGS_pserver_ssd_cold_read_batch)) {
+      cold_reads.push_back(ReadColdAsync(shard_id, item));
+      cold_items.emplace_back(new RocksDBItem());
+    }
+  }
+  if (!cold_items.empty() && !cold_items.back()->batch_keys.empty()) {
+    cold_reads.push_back(ReadColdAsync(shard_id, cold_items.back().get()));
+  }
+  for (size_t x = 0; x < cold_reads.size(); ++x) {
+    cold_reads[x].wait();
+    auto* item = cold_items[x].get();
+    for (size_t idx = 0; idx < item->status.size(); ++idx) {
+      if (!item->status[idx].ok()) {
+        continue;
+      }
+      uint64_t key =
+          *(reinterpret_cast<const uint64_t*>(item->batch_keys[idx].data()));
+      // 同一个key在一次push中可能出现多次
+      if (local_shard.find(key) != local_shard.end()) {
+        continue;
+      }
+      AdmitHotValue(
+          shard_id,
+          key,
+          ::paddle::string::str_to_float(item->batch_values[idx].data()),
+          item->batch_values[idx].size() / sizeof(float));
+      _db->del_data(shard_id, reinterpret_cast<char*>(&key), sizeof(uint64_t));
+    }
+  }
+}
+
+int32_t SSDSparseTable::DemoteShard(int shard_id) {
+  auto begin = std::chrono::steady_clock::now();
+  auto& shard = _local_shards[shard_id];
+  auto& warm_shard = _warm_shards[shard_id];
+  size_t hot_capacity = FLAGS_pserver_ssd_hot_capacity;
+  size_t warm_budget =
+      static_cast<size_t>(FLAGS_pserver_ssd_warm_capacity_mb) << 20;
+  ColdWriteBatch cold_batch(_db, shard_id);
+  uint64_t warm_count = 0;
+  uint64_t cold_count = 0;
+  if (hot_capacity > 0 && shard.size() > hot_capacity) {
+    // 降到容量的90%, 避免每一轮都只降级少量的值
+    size_t demote_num = shard.size() - hot_capacity * 9 / 10;
+    std::vector<std::pair<float, uint64_t>> scores;
+    scores.reserve(shard.size());
+    for (auto it = shard.begin(); it != shard.end(); ++it) {
+      scores.emplace_back(
+          _value_accessor->GetField(it.value().data(), "show_click_score"),
+          it.key());
+    }
+    std::nth_element(
+        scores.begin(), scores.begin() + demote_num - 1, scores.end());
+    for (size_t i = 0; i < demote_num; ++i) {
+      auto it = shard.find(scores[i].second);
+      auto& value = it.value();
+      if (warm_budget > 0 &&
+          scores[i].first >= FLAGS_pserver_ssd_warm_admit_score) {
+        warm_shard.Put(it.key(), value.data(), value.size(), scores[i].first);
+        ++warm_count;
+      } else {
+        cold_batch.Add(it.key(), value.data(), value.size());
+        ++cold_count;
+      }
+      shard.erase(it);
+    }
+  }
+  if (warm_budget > 0) {
+    cold_count += warm_shard.Evict(
+        warm_budget, [&cold_batch](uint64_t key, const float* data, size_t n) {
+          cold_batch.Add(key, data, n);
+        });
+  }
+  cold_batch.Flush();
+  _tier_stat.AddDemote(WARM_TIER, warm_count);
+  _tier_stat.AddDemote(COLD_TIER, cold_count);
+  if (warm_count + cold_count > 0) {
+    VLOG(1) << "SSDSparseTable demote shard " << shard_id
+            << " to warm: " << warm_count << " to cold: " << cold_count
+            << " cost: " << ElapsedUs(begin) << "us";
+  }
+  return 0;
+}
+
+int32_t SSDSparseTable::DemoteTiers() {
+  // save/shrink/load等进行中时跳过本轮
+  std::unique_lock<std::mutex> tier_guard(_tier_mutex, std::try_to_lock);
+  if (!tier_guard.owns_lock()) {
+    return 0;
+  }
+  // 与PullSparsePtr配对: 两边先置位自己的标记再检查对方的,
+  // 保证降级不会释放已交出指针的值
+  _demoting.store(true);
+  if (_ptr_values_pinned.load()) {
+    _demoting.store(false);
+    return 0;
+  }
+  // 降级任务与pull/push在同一个shard线程中串行执行
+  std::vector<std::future<int>> tasks(_real_local_shard_num);
+  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+    tasks[shard_id] =
+        _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
+            [this, shard_id]() -> int { return DemoteShard(shard_id); });
+  }
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    tasks[i].wait();
+  }
+  _demoting.store(false);
+  return 0;
+}
+
+int32_t SSDSparseTable::SpillWarmTier() {
+  std::vector<std::future<int>> tasks(_real_local_shard_num);
+  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+    tasks[shard_id] =
+        _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
+            [this, shard_id]() -> int {
+              ColdWriteBatch cold_batch(_db, shard_id);
+              size_t count = _warm_shards[shard_id].Drain(
+                  [&cold_batch](uint64_t key, const float* data, size_t n) {
+                    cold_batch.Add(key, data, n);
+                  });
+              cold_batch.Flush();
+              _tier_stat.AddDemote(COLD_TIER, count);
+              return 0;
+            });
+  }
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    tasks[i].wait();
+  }
+  return 0;
+}
+
+void SSDSparseTable::TierMaintainLoop() {
+  std::unique_lock<std::mutex> lock(_tier_thread_mutex);
+  while (!_tier_thread_cond.wait_for(
+      lock,
+      std::chrono::milliseconds(FLAGS_pserver_ssd_tier_interval_ms),
+      [this]() { return _tier_thread_stop; })) {
+    lock.unlock();
+    DemoteTiers();
+    lock.lock();
+  }
+}
+
 int64_t SSDSparseTable::LocalSize() {
   int64_t local_size = 0;
   for (int i = 0; i < _real_local_shard_num; ++i) {
-    local_size += _local_shards[i].size();
+    local_size += _local_shards[i].size() + _warm_shards[i].size();
   }
   return local_size;
 }
@@ -597,6 +939,8 @@ int32_t SSDSparseTable::Save(const std::string& path,
     }
   }
 #endif
+  std::lock_guard<std::mutex> tier_guard(_tier_mutex);
+  SpillWarmTier();
   std::lock_guard<std::mutex> guard(_table_mutex);
 #ifdef PADDLE_WITH_HETERPS
   int save_param = atoi(param.c_str());
@@ -616,6 +960,8 @@ int32_t SSDSparseTable::Save(const std::string& path,
 #if defined(PADDLE_WITH_HETERPS) && defined(PADDLE_WITH_PSCORE)
 int32_t SSDSparseTable::Save_v2(const std::string& path,
                                 const std::string& param) {
+  std::lock_guard<std::mutex> tier_guard(_tier_mutex);
+  SpillWarmTier();
   std::lock_guard<std::mutex> guard(_table_mutex);
 #ifdef PADDLE_WITH_HETERPS
   int save_param = atoi(param.c_str());
@@ -2516,6 +2862,7 @@ int32_t SSDSparseTable::SaveCache(
 
 int32_t SSDSparseTable::Load(const std::string& path,
                              const std::string& param) {
+  std::lock_guard<std::mutex> tier_guard(_tier_mutex);
   VLOG(0) << "LOAD FLAGS_rocksdb_path:" << FLAGS_rocksdb_path;
   std::string table_path = TableDir(path);
   auto file_list = _afs_client.list(table_path);
@@ -2942,10 +3289,12 @@ int32_t SSDSparseTable::LoadWithBinary(const std::string& path, int param) {
 
 std::pair<int64_t, int64_t> SSDSparseTable::PrintTableStat() {
   int64_t feasign_size = LocalSize();
+  VLOG(0) << "SSDSparseTable tier stat, " << _tier_stat.ToString();
   return {feasign_size, -1};
 }
 
 int32_t SSDSparseTable::CacheTable(uint16_t pass_id) {
+  std::lock_guard<std::mutex> tier_guard(_tier_mutex);
   std::lock_guard<std::mutex> guard(_table_mutex);
   VLOG(0) << "cache_table";
   std::atomic<uint32_t> count{0};
@@ -3096,6 +3445,8 @@ int32_t SSDSparseTable::CacheTable(uint16_t pass_id) {
 
   VLOG(0) << "Table>> cache ssd count: " << count.load();
   VLOG(0) << "Table>> after update, mem feasign size:" << LocalSize();
+  // pass已结束, 恢复后台降级
+  _ptr_values_pinned.store(false);
   return 0;
 }
 
@@ -14,8 +14,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+
 #include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/ps/table/depends/rocksdb_warpper.h"
+#include "paddle/fluid/distributed/ps/table/depends/sparse_tier.h"
 #include "paddle/fluid/distributed/ps/table/memory_sparse_table.h"
 
 namespace paddle {
@@ -60,7 +65,7 @@ class SSDSparseTable : public MemorySparseTable {
  public:
   typedef SparseTableShard<uint64_t, FixedFeatureValue> shard_type;
   SSDSparseTable() {}
-  virtual ~SSDSparseTable() {}
+  virtual ~SSDSparseTable();
 
   int32_t Initialize() override;
   int32_t InitializeShard() override;
@@ -86,6 +91,7 @@ class SSDSparseTable : public MemorySparseTable {
   void Clear() override {
     for (int i = 0; i < _real_local_shard_num; ++i) {
       _local_shards[i].clear();
+      _warm_shards[i].clear();
     }
   }
 
@@ -130,13 +136,49 @@ class SSDSparseTable : public MemorySparseTable {
 
   void SetDayId(int day_id) override;
 
+  const SparseTierStat& GetTierStat() const { return _tier_stat; }
+  // 按热层容量将低分值降级到温层/冷层, 并将超出内存预算的温层值溢出到冷层
+  int32_t DemoteTiers();
+  // 将温层全部写入冷层, save/shrink等遍历内存和rocksdb的操作之前调用
+  int32_t SpillWarmTier();
+
  private:
+  void TierMaintainLoop();
+  int32_t DemoteShard(int shard_id);
+  // 将热层未命中的key依次从温层和冷层提升到热层, 冷层按批MultiGet
+  void PromoteKeys(int shard_id,
+                   const std::vector<std::pair<uint64_t, int>>& keys,
+                   float* buffer);
+  // 在冷读线程池中批量读取item中的key
+  std::future<int> ReadColdAsync(int shard_id, RocksDBItem* item);
+  FixedFeatureValue* AdmitHotValue(int shard_id,
+                                   uint64_t key,
+                                   const float* data,
+                                   size_t size);
+
   RocksDBHandler* _db;
   int64_t _cache_tk_size;
   double _local_show_threshold{0.0};
   std::vector<paddle::framework::Channel<std::string>> _fs_channel;
   std::mutex _table_mutex;
   int _day_id = 0;
+
+  // 热层为_local_shards, 温层为内存中压缩存储的值, 冷层为rocksdb
+  std::unique_ptr<WarmTierShard[]> _warm_shards;
+  SparseTierStat _tier_stat;
+  // 冷层读在独立线程池中进行, 与同一请求中内存命中的处理重叠
+  std::shared_ptr<::ThreadPool> _cold_read_pool;
+  // 后台降级线程与save/shrink/load互斥
+  // 加锁顺序: 先_tier_mutex, 再_table_mutex
+  std::mutex _tier_mutex;
+  std::mutex _tier_thread_mutex;
+  std::condition_variable _tier_thread_cond;
+  bool _tier_thread_stop = false;
+  std::thread _tier_thread;
+  // PullSparsePtr交给调用方的值指针在整个pass内都会被使用, 期间不做降级,
+  // 直到pass结束时CacheTable/UpdateTable/Shrink将其释放
+  std::atomic<bool> _ptr_values_pinned{false};
+  std::atomic<bool> _demoting{false};
 };
 
 }  // namespace distributed
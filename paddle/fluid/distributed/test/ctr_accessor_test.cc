@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "paddle/fluid/distributed/common/registerer.h"
@@ -290,6 +291,20 @@ TEST(downpour_feature_value_accessor_test, test_show_click_score) {
   ASSERT_FLOAT_EQ(acc->ShowClickScore(show, click), 6.8);
 }
 
+TEST(downpour_feature_value_accessor_test, test_get_field) {
+  TableAccessorParameter parameter = gen_param();
+  CtrCommonAccessor* acc = new CtrCommonAccessor();
+  ASSERT_EQ(acc->Configure(parameter), 0);
+  ASSERT_EQ(acc->Initialize(), 0);
+
+  std::vector<float> value(acc->GetAccessorInfo().dim, 0);
+  acc->common_feature_value.Show(value.data()) = 10;
+  acc->common_feature_value.Click(value.data()) = 6;
+  ASSERT_FLOAT_EQ(acc->GetField(value.data(), "show"), 10);
+  ASSERT_FLOAT_EQ(acc->GetField(value.data(), "click"), 6);
+  ASSERT_FLOAT_EQ(acc->GetField(value.data(), "show_click_score"), 6.8);
+}
+
 TEST(downpour_feature_value_accessor_test, test_string_related) {
   TableAccessorParameter parameter = gen_param();
   CtrCommonAccessor* acc = new CtrCommonAccessor();
@@ -0,0 +1,90 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/table/depends/flat_feature_value.h"
+
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle::distributed {
+
+TEST(FlatSparseTableShard, InsertFindErase) {
+  typedef FlatSparseTableShard<uint64_t> shard_type;
+  shard_type shard;
+  shard.set_value_dim(4);
+  ASSERT_TRUE(shard.find(1) == shard.end());
+
+  std::unordered_map<uint64_t, float> expect;
+  // keys of one local shard share the same residue, see FlatKeyHasher
+  for (uint64_t i = 0; i < 100000; ++i) {
+    uint64_t key = i * 1000 + 7;
+    auto& value = shard[key];
+    value.resize(2);
+    value.data()[0] = static_cast<float>(i);
+    expect[key] = static_cast<float>(i);
+  }
+  ASSERT_EQ(shard.size(), expect.size());
+
+  for (auto it = shard.begin(); it != shard.end();) {
+    if (it.key() % 2 == 0) {
+      it = shard.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (auto& kv : expect) {
+    auto it = shard.find(kv.first);
+    if (kv.first % 2 == 0) {
+      ASSERT_TRUE(it == shard.end());
+    } else {
+      ASSERT_TRUE(it != shard.end());
+      ASSERT_EQ(it.value().size(), 2UL);
+      ASSERT_FLOAT_EQ(it.value().data()[0], kv.second);
+    }
+  }
+
+  // reinsert into the tombstones
+  for (auto& kv : expect) {
+    shard[kv.first];
+  }
+  ASSERT_EQ(shard.size(), expect.size());
+  shard.clear();
+  ASSERT_TRUE(shard.empty());
+}
+
+TEST(FlatFeatureValue, Resize) {
+  FlatValueSlab slab(8, 2);
+  std::vector<FlatFeatureValue*> values;
+  for (int i = 0; i < 5; ++i) {
+    values.push_back(slab.acquire());
+  }
+  ASSERT_EQ(slab.size(), 5UL);
+  auto* value = values[0];
+  value->resize(3);
+  ASSERT_EQ(value->size(), 3UL);
+  ASSERT_FLOAT_EQ(value->data()[2], 0.0);
+  value->data()[2] = 1.0;
+  value->resize(8);
+  ASSERT_FLOAT_EQ(value->data()[2], 1.0);
+  ASSERT_FLOAT_EQ(value->data()[7], 0.0);
+  ASSERT_ANY_THROW(value->resize(9));
+  for (auto* v : values) {
+    slab.release(v);
+  }
+  ASSERT_EQ(slab.size(), 0UL);
+}
+
+}  // namespace paddle::distributed
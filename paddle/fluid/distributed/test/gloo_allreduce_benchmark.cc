@@ -0,0 +1,160 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/distributed/collective/process_group_gloo.h"
+#include "paddle/phi/core/distributed/store/tcp_store.h"
+
+COMMON_DECLARE_int32(gloo_allreduce_bucket_size_mb);
+
+PD_DEFINE_int32(gloo_bench_ranks, 4, "local processes");
+PD_DEFINE_int32(gloo_bench_iters, 10, "all-reduces per message size");
+PD_DEFINE_int32(gloo_bench_max_mb, 64, "largest message in MB");
+PD_DEFINE_int32(gloo_bench_tensors, 32, "tensors a message is split into");
+
+namespace paddle {
+namespace distributed {
+
+// a port nobody listens on right now
+static uint16_t FreePort() {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+  socklen_t len = sizeof(addr);
+  ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+  ::close(fd);
+  return ntohs(addr.sin_port);
+}
+
+static void Fill(std::vector<phi::DenseTensor>* tensors, float value) {
+  for (auto& tensor : *tensors) {
+    float* data = tensor.mutable_data<float>(phi::CPUPlace());
+    std::fill(data, data + tensor.numel(), value);
+  }
+}
+
+// Runs one rank and returns the exit code of its process.
+static int RunRank(int rank, int ranks, uint16_t port) {
+  setenv("PADDLE_TRAINER_ID", std::to_string(rank).c_str(), 1);
+  setenv("GLOO_SOCKET_IFNAME", "lo", 1);
+  auto store = std::make_shared<phi::distributed::TCPStore>(
+      "127.0.0.1", port, rank == 0, ranks);
+  auto pg = ProcessGroupGloo::CreateProcessGroupGloo(store, rank, ranks, 0);
+  const float expected = ranks * (ranks + 1) / 2.0f;
+  AllreduceOptions opts;
+
+  if (rank == 0) {
+    std::printf("%d ranks, bus bandwidth in GB/s\n", ranks);
+    std::printf("%12s %10s %10s %10s %10s\n",
+                "bytes",
+                "gloo",
+                "bucketed",
+                ("gloo x" + std::to_string(FLAGS_gloo_bench_tensors)).c_str(),
+                "fused");
+  }
+  for (int64_t bytes = 4096; bytes <= (int64_t{FLAGS_gloo_bench_max_mb} << 20);
+       bytes *= 4) {
+    int64_t numel = bytes / sizeof(float);
+    double busbw[4];
+    for (int mode = 0; mode < 4; ++mode) {
+      // 0, 1: one tensor, 2, 3: the same bytes in many tensors
+      // 0, 2: a synchronous gloo::allreduce per tensor, 1, 3: buckets
+      bool bucketed = mode % 2 == 1;
+      int num = mode < 2 ? 1 : FLAGS_gloo_bench_tensors;
+      FLAGS_gloo_allreduce_bucket_size_mb = bucketed ? 25 : 0;
+      std::vector<phi::DenseTensor> tensors(num);
+      for (auto& tensor : tensors) {
+        tensor.Resize({numel / num});
+      }
+      pg->Barrier();
+      auto start = std::chrono::steady_clock::now();
+      for (int iter = 0; iter < FLAGS_gloo_bench_iters; ++iter) {
+        Fill(&tensors, rank + 1.0f);
+        if (bucketed) {
+          pg->AllReduce(tensors, tensors, opts, true);
+        } else {
+          for (auto& tensor : tensors) {
+            pg->AllReduce(&tensor, tensor, opts, true);
+          }
+        }
+        for (auto& tensor : tensors) {
+          const float* data = tensor.data<float>();
+          if (data[0] != expected || data[tensor.numel() - 1] != expected) {
+            std::fprintf(stderr, "rank %d: wrong result\n", rank);
+            return 1;
+          }
+        }
+      }
+      double seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+      double algbw = bytes * FLAGS_gloo_bench_iters / seconds / 1e9;
+      busbw[mode] = algbw * 2 * (ranks - 1) / ranks;
+    }
+    if (rank == 0) {
+      std::printf("%12ld %10.3f %10.3f %10.3f %10.3f\n",
+                  static_cast<long>(bytes),  // NOLINT
+                  busbw[0],
+                  busbw[1],
+                  busbw[2],
+                  busbw[3]);
+    }
+  }
+  pg->Barrier();
+  return 0;
+}
+
+// Every rank is a process of its own that talks to the others over the
+// loopback device, as the ranks of a node of a CPU cluster do.
+TEST(Benchmark, GlooAllreduceBusBandwidth) {
+  const int ranks = FLAGS_gloo_bench_ranks;
+  const uint16_t port = FreePort();
+  std::vector<pid_t> children;
+  std::fflush(stdout);
+  for (int rank = 0; rank < ranks; ++rank) {
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+      int code = RunRank(rank, ranks, port);
+      std::fflush(stdout);
+      _exit(code);
+    }
+    children.push_back(pid);
+  }
+  for (pid_t pid : children) {
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,162 @@
+/* Copyright (c) 2026 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/distributed/collective/process_group_gloo.h"
+#include "paddle/phi/core/distributed/store/tcp_store.h"
+
+COMMON_DECLARE_int32(gloo_allreduce_bucket_size_mb);
+
+namespace paddle {
+namespace distributed {
+
+// a port nobody listens on right now
+static uint16_t FreePort() {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+  socklen_t len = sizeof(addr);
+  ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+  ::close(fd);
+  return ntohs(addr.sin_port);
+}
+
+// In 1 MB buckets: {1, 1000}, {393216} of 1.5 MB on its own and {70000, 5},
+// the two small buckets are below the ring threshold.
+static const std::vector<int64_t> kNumels = {1, 1000, 393216, 70000, 5};
+
+// rank r holds r + i % 97 + 1 at index i of every tensor
+static std::vector<phi::DenseTensor> MakeTensors(int rank) {
+  std::vector<phi::DenseTensor> tensors(kNumels.size());
+  for (size_t t = 0; t < tensors.size(); ++t) {
+    tensors[t].Resize({kNumels[t]});
+    float* data = tensors[t].mutable_data<float>(phi::CPUPlace());
+    for (int64_t i = 0; i < kNumels[t]; ++i) {
+      data[i] = static_cast<float>(rank + i % 97 + 1);
+    }
+  }
+  return tensors;
+}
+
+static bool Check(const std::vector<phi::DenseTensor>& tensors,
+                  int ranks,
+                  ReduceOp op,
+                  const char* what) {
+  for (const auto& tensor : tensors) {
+    const float* data = tensor.data<float>();
+    for (int64_t i = 0; i < tensor.numel(); ++i) {
+      float base = static_cast<float>(i % 97 + 1);
+      float expected = op == ReduceOp::SUM
+                           ? ranks * base + ranks * (ranks - 1) / 2.0f
+                           : base + ranks - 1;
+      if (data[i] != expected) {
+        std::fprintf(stderr,
+                     "%s: %ld-th of %ld elements is %f, expected %f\n",
+                     what,
+                     static_cast<long>(i),              // NOLINT
+                     static_cast<long>(tensor.numel()),  // NOLINT
+                     data[i],
+                     expected);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Runs one rank and returns the exit code of its process.
+static int RunRank(int rank, int ranks, uint16_t port) {
+  setenv("PADDLE_TRAINER_ID", std::to_string(rank).c_str(), 1);
+  setenv("GLOO_SOCKET_IFNAME", "lo", 1);
+  FLAGS_gloo_allreduce_bucket_size_mb = 1;
+  auto store = std::make_shared<phi::distributed::TCPStore>(
+      "127.0.0.1", port, rank == 0, ranks);
+  auto pg = ProcessGroupGloo::CreateProcessGroupGloo(store, rank, ranks, 0);
+
+  for (ReduceOp op : {ReduceOp::SUM, ReduceOp::MAX}) {
+    AllreduceOptions opts;
+    opts.reduce_op = op;
+
+    // in place
+    auto tensors = MakeTensors(rank);
+    pg->AllReduce(tensors, tensors, opts, true);
+    if (!Check(tensors, ranks, op, "in place")) return 1;
+
+    // into other tensors, waiting for the task
+    auto inputs = MakeTensors(rank);
+    auto outputs = MakeTensors(0);
+    pg->AllReduce(inputs, outputs, opts, false)->Wait();
+    if (!Check(outputs, ranks, op, "out of place")) return 1;
+
+    // one tensor per call, bucketed together by EndCoalescing
+    tensors = MakeTensors(rank);
+    std::vector<std::shared_ptr<ProcessGroup::Task>> tasks;
+    pg->StartCoalescing();
+    for (auto& tensor : tensors) {
+      std::vector<phi::DenseTensor> one{tensor};
+      tasks.push_back(pg->AllReduce(one, one, opts, false));
+    }
+    pg->EndCoalescing();
+    for (auto& task : tasks) {
+      task->Wait();
+    }
+    if (!Check(tensors, ranks, op, "coalesced")) return 1;
+  }
+  pg->Barrier();
+  return 0;
+}
+
+// Every rank is a process of its own. Two ranks reduce the small buckets by
+// halving-doubling and the large one by the ring, three ranks use the ring
+// for all of them.
+TEST(ProcessGroupGloo, BucketedAllReduce) {
+  for (int ranks : {2, 3}) {
+    const uint16_t port = FreePort();
+    std::vector<pid_t> children;
+    std::fflush(stdout);
+    for (int rank = 0; rank < ranks; ++rank) {
+      pid_t pid = fork();
+      ASSERT_GE(pid, 0);
+      if (pid == 0) {
+        int code = RunRank(rank, ranks, port);
+        std::fflush(stderr);
+        _exit(code);
+      }
+      children.push_back(pid);
+    }
+    for (pid_t pid : children) {
+      int status = 0;
+      ASSERT_EQ(waitpid(pid, &status, 0), pid);
+      EXPECT_TRUE(WIFEXITED(status));
+      EXPECT_EQ(WEXITSTATUS(status), 0) << ranks << " ranks";
+    }
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
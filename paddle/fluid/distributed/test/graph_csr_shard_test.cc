@@ -0,0 +1,139 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr_shard.h"
+
+#include <random>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/common_graph_table.h"
+
+namespace paddle::distributed {
+
+// node 7 has 4 edges weighted 1 to 4, node 8 has 1000 edges where every
+// tenth one weighs 10 and the others 1
+static void BuildShard(GraphShard *shard) {
+  GraphNode *node = shard->add_graph_node(7);
+  node->build_edges(true);
+  for (int i = 0; i < 4; ++i) {
+    node->add_edge(100 + i, i + 1);
+  }
+  node = shard->add_graph_node(8);
+  node->build_edges(true);
+  for (int i = 0; i < 1000; ++i) {
+    node->add_edge(1000 + i, i % 10 == 0 ? 10 : 1);
+  }
+  shard->add_graph_node(9)->build_edges(true);
+}
+
+TEST(CsrGraphShard, Build) {
+  GraphShard shard;
+  BuildShard(&shard);
+  shard.build_csr(true);
+  auto csr = shard.get_csr();
+  ASSERT_NE(csr, nullptr);
+  EXPECT_EQ(csr->node_num(), 3UL);
+  EXPECT_EQ(csr->edge_num(), 1004UL);
+  EXPECT_EQ(csr->find_row(10), -1);
+  for (uint64_t id : {7, 8, 9}) {
+    Node *node = shard.find_node(id);
+    int64_t row = csr->find_row(id);
+    ASSERT_GE(row, 0);
+    ASSERT_EQ(csr->degree(row), node->get_neighbor_size());
+    for (uint32_t i = 0; i < csr->degree(row); ++i) {
+      EXPECT_EQ(csr->neighbor_id(row, i), node->get_neighbor_id(i));
+      EXPECT_EQ(csr->neighbor_weight(row, i),
+                static_cast<float>(node->get_neighbor_weight(i)));
+    }
+  }
+
+  // changing the nodes drops the CSR copy, a sampler holding a snapshot can
+  // still use it
+  shard.add_graph_node(11);
+  EXPECT_EQ(shard.get_csr(), nullptr);
+  EXPECT_EQ(csr->node_num(), 3UL);
+  EXPECT_GE(csr->find_row(7), 0);
+}
+
+TEST(CsrGraphShard, WeightedSample) {
+  GraphShard shard;
+  BuildShard(&shard);
+  shard.build_csr(true);
+  auto csr = shard.get_csr();
+  std::mt19937_64 rng(0);
+  std::vector<uint32_t> res;
+
+  const int kRounds = 100000;
+  int64_t row = csr->find_row(7);
+  std::vector<int> counts(4, 0);
+  for (int i = 0; i < kRounds; ++i) {
+    ASSERT_EQ(csr->sample_k(row, 1, &rng, &res), 1UL);
+    ++counts[res[0]];
+  }
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_NEAR(static_cast<double>(counts[i]) / kRounds, (i + 1) / 10.0, 0.01);
+  }
+
+  // without replacement, the first edge is in a sample of two with
+  // probability 0.1 + 0.2 / 8 + 0.3 / 7 + 0.4 / 6
+  int first = 0;
+  for (int i = 0; i < kRounds; ++i) {
+    ASSERT_EQ(csr->sample_k(row, 2, &rng, &res), 2UL);
+    ASSERT_NE(res[0], res[1]);
+    first += (res[0] == 0 || res[1] == 0);
+  }
+  EXPECT_NEAR(static_cast<double>(first) / kRounds, 0.2345, 0.01);
+
+  row = csr->find_row(8);
+  for (int k : {10, 100, 600, 999}) {
+    ASSERT_EQ(csr->sample_k(row, k, &rng, &res), static_cast<size_t>(k));
+    EXPECT_EQ(std::set<uint32_t>(res.begin(), res.end()).size(),
+              static_cast<size_t>(k));
+  }
+  EXPECT_EQ(csr->sample_k(row, 2000, &rng, &res), 1000UL);
+  EXPECT_EQ(csr->sample_k(csr->find_row(9), 3, &rng, &res), 0UL);
+}
+
+TEST(CsrGraphShard, UniformSample) {
+  GraphShard shard;
+  BuildShard(&shard);
+  shard.build_csr(false);
+  auto csr = shard.get_csr();
+  std::mt19937_64 rng(0);
+  std::vector<uint32_t> res;
+
+  int64_t row = csr->find_row(8);
+  const int kRounds = 20000;
+  std::vector<int> counts(1000, 0);
+  for (int i = 0; i < kRounds; ++i) {
+    ASSERT_EQ(csr->sample_k(row, 10, &rng, &res), 10UL);
+    ASSERT_EQ(std::set<uint32_t>(res.begin(), res.end()).size(), 10UL);
+    for (uint32_t pos : res) {
+      ++counts[pos];
+    }
+  }
+  // every edge is drawn 200 times on average, the heavy ones too
+  for (int count : counts) {
+    EXPECT_NEAR(count, 200, 80);
+  }
+  for (int k : {100, 999}) {
+    ASSERT_EQ(csr->sample_k(row, k, &rng, &res), static_cast<size_t>(k));
+    EXPECT_EQ(std::set<uint32_t>(res.begin(), res.end()).size(),
+              static_cast<size_t>(k));
+  }
+}
+
+}  // namespace paddle::distributed
@@ -645,9 +645,10 @@ void RunBrpcPushSparse() {
 }
 
 /*void testCache() {
-  ::paddle::distributed::ScaledLRU<::paddle::distributed::SampleKey,
-                                   ::paddle::distributed::SampleResult>
-      st(1, 2, 4);
+  ::paddle::distributed::ShardedSampleCache<
+      ::paddle::distributed::SampleKey,
+      ::paddle::distributed::SampleResult>
+      st(1, 1 << 10, 4);
   char* str = new char[7];
   strcpy(str, "54321");
   ::paddle::distributed::SampleResult* result =
@@ -0,0 +1,122 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/distributed/ps/table/common_graph_table.h"
+
+PD_DEFINE_int64(graph_bench_node_num,
+                200000,
+                "number of nodes of the synthetic graph");
+PD_DEFINE_double(graph_bench_alpha,
+                 2.0,
+                 "exponent of the power law of the node degrees");
+PD_DEFINE_int32(graph_bench_max_degree, 10000, "max degree of a node");
+PD_DEFINE_int32(graph_bench_sample_size, 10, "neighbors sampled per node");
+PD_DEFINE_int64(graph_bench_query_num,
+                1000000,
+                "number of nodes whose neighbors are sampled");
+
+namespace paddle::distributed {
+
+static double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Degrees follow P(d) ~ d^-alpha, edge weights are uniform in (0, 1].
+static void BuildPowerLawShard(GraphShard *shard, std::mt19937_64 *rng) {
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::uniform_int_distribution<uint64_t> dst(0, FLAGS_graph_bench_node_num);
+  for (int64_t id = 0; id < FLAGS_graph_bench_node_num; ++id) {
+    double u = 1.0 - unit(*rng);
+    int64_t degree = static_cast<int64_t>(
+        std::pow(u, -1.0 / (FLAGS_graph_bench_alpha - 1.0)));
+    degree = std::min<int64_t>(degree, FLAGS_graph_bench_max_degree);
+    GraphNode *node = shard->add_graph_node(id);
+    node->build_edges(true);
+    for (int64_t i = 0; i < degree; ++i) {
+      node->add_edge(dst(*rng), static_cast<float>(1.0 - unit(*rng)));
+    }
+  }
+}
+
+TEST(Benchmark, GraphNeighborSample) {
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  std::uniform_int_distribution<uint64_t> query(
+      0, FLAGS_graph_bench_node_num - 1);
+  std::vector<uint64_t> queries(FLAGS_graph_bench_query_num);
+  for (auto &id : queries) {
+    id = query(*rng);
+  }
+  int sample_size = FLAGS_graph_bench_sample_size;
+
+  for (std::string sample_type : {"random", "weighted"}) {
+    // a node keeps the first sampler built, so every type has its own graph
+    GraphShard shard;
+    std::mt19937_64 graph_rng(1);
+    BuildPowerLawShard(&shard, &graph_rng);
+    for (auto *node : shard.get_bucket()) {
+      node->build_sampler(sample_type);
+    }
+
+    uint64_t checksum = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint64_t id : queries) {
+      Node *node = shard.find_node(id);
+      for (int pos : node->sample_k(sample_size, rng)) {
+        checksum += node->get_neighbor_id(pos);
+      }
+    }
+    double node_ms = ElapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    shard.build_csr(sample_type == "weighted");
+    double build_ms = ElapsedMs(start);
+    auto csr = shard.get_csr();
+    std::vector<uint32_t> positions;
+    uint64_t csr_checksum = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (uint64_t id : queries) {
+      int64_t row = csr->find_row(id);
+      csr->sample_k(row, sample_size, rng.get(), &positions);
+      for (uint32_t pos : positions) {
+        csr_checksum += csr->neighbor_id(row, pos);
+      }
+    }
+    double csr_ms = ElapsedMs(start);
+    EXPECT_NE(checksum, 0UL);
+    EXPECT_NE(csr_checksum, 0UL);
+
+    std::cout << sample_type << " nodes: " << csr->node_num()
+              << " edges: " << csr->edge_num()
+              << " sample size: " << sample_size << std::endl;
+    std::cout << "  node samplers: " << queries.size() / node_ms * 1000
+              << " nodes/s" << std::endl;
+    std::cout << "  csr: " << queries.size() / csr_ms * 1000
+              << " nodes/s, build " << build_ms << " ms, "
+              << csr->bytes() / (1 << 20) << " MB" << std::endl;
+  }
+}
+
+}  // namespace paddle::distributed
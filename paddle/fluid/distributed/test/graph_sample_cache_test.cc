@@ -0,0 +1,147 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_sample_cache.h"
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/common_graph_table.h"
+
+namespace paddle::distributed {
+
+using Cache = ShardedSampleCache<SampleKey, SampleResult>;
+
+// a result of `size` bytes that all hold `fill`
+static SampleResult MakeResult(size_t size, char fill) {
+  char *buffer = new char[size];
+  memset(buffer, fill, size);
+  return SampleResult(size, buffer);
+}
+
+TEST(ShardedSampleCache, QueryAndTtl) {
+  Cache cache(2, 1 << 20, 3);
+  std::vector<SampleKey> keys{{0, 1, 10, false}, {0, 2, 10, false}};
+  std::vector<std::pair<SampleKey, SampleResult>> res;
+  EXPECT_EQ(cache.query(0, keys.data(), keys.size(), res), LRUResponse::ok);
+  EXPECT_TRUE(res.empty());
+
+  std::vector<SampleResult> data{MakeResult(80, 'a')};
+  cache.insert(0, &keys[1], data.data(), 1);
+  for (size_t i = 0; i < cache.get_ttl(); ++i) {
+    res.clear();
+    cache.query(0, keys.data(), keys.size(), res);
+    ASSERT_EQ(res.size(), 1UL);
+    EXPECT_EQ(res[0].first.node_key, 2UL);
+    EXPECT_EQ(res[0].second.actual_size, 80UL);
+    EXPECT_EQ(res[0].second.buffer.get()[79], 'a');
+  }
+  // served ttl times, a new insert replaces it
+  res.clear();
+  cache.query(0, keys.data(), keys.size(), res);
+  EXPECT_TRUE(res.empty());
+  data[0] = MakeResult(40, 'b');
+  cache.insert(0, &keys[1], data.data(), 1);
+  cache.query(0, keys.data(), keys.size(), res);
+  ASSERT_EQ(res.size(), 1UL);
+  EXPECT_EQ(res[0].second.buffer.get()[0], 'b');
+
+  SampleCacheStats stats = cache.stats();
+  EXPECT_EQ(stats.hits, 4UL);
+  EXPECT_EQ(stats.misses, 8UL);
+  EXPECT_EQ(stats.inserts, 2UL);
+  EXPECT_EQ(stats.expirations, 1UL);
+  EXPECT_EQ(stats.entries, 1UL);
+}
+
+TEST(ShardedSampleCache, MemoryBudget) {
+  const size_t kBudget = 64 << 10;
+  const size_t kResultBytes = 1000;
+  Cache cache(1, kBudget, 100000);
+  std::vector<SampleKey> hot{{0, 0, 10, false}};
+  std::vector<SampleResult> data{MakeResult(kResultBytes, 'h')};
+  cache.insert(0, hot.data(), data.data(), 1);
+
+  std::vector<std::pair<SampleKey, SampleResult>> res;
+  for (uint64_t id = 1; id <= 1000; ++id) {
+    // the hot key is marked every time the hand may reach it
+    cache.query(0, hot.data(), 1, res);
+    SampleKey key(0, id, 10, false);
+    data[0] = MakeResult(kResultBytes, 'c');
+    cache.insert(0, &key, data.data(), 1);
+    ASSERT_LE(cache.stats().bytes, kBudget);
+  }
+  res.clear();
+  cache.query(0, hot.data(), 1, res);
+  EXPECT_EQ(res.size(), 1UL);
+
+  SampleCacheStats stats = cache.stats();
+  EXPECT_GT(stats.evictions, 900UL);
+  EXPECT_EQ(stats.entries + stats.evictions, 1001UL);
+  EXPECT_GT(stats.bytes, kBudget - 2 * kResultBytes);
+
+  // a result larger than a shard's budget is not cached
+  SampleKey big(0, 5000, 10, false);
+  data[0] = MakeResult(kBudget, 'x');
+  cache.insert(0, &big, data.data(), 1);
+  res.clear();
+  cache.query(0, &big, 1, res);
+  EXPECT_TRUE(res.empty());
+}
+
+TEST(ShardedSampleCache, ConcurrentQueryInsert) {
+  const int kThreads = 4;
+  const uint64_t kKeys = 2000;
+  Cache cache(2, 256 << 10, 4);
+  std::atomic<bool> corrupted{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      std::vector<std::pair<SampleKey, SampleResult>> res;
+      for (int round = 0; round < 20000; ++round) {
+        uint64_t id = (round * 7919 + t * 104729) % kKeys;
+        SampleKey key(0, id, 10, false);
+        size_t shard = id % 2;
+        res.clear();
+        cache.query(shard, &key, 1, res);
+        if (res.empty()) {
+          // the bytes of a result identify its key
+          SampleResult result =
+              MakeResult(16 + id % 200, static_cast<char>(id % 128));
+          cache.insert(shard, &key, &result, 1);
+        } else {
+          const SampleResult &cached = res[0].second;
+          if (cached.actual_size != 16 + id % 200 ||
+              cached.buffer.get()[15] != static_cast<char>(id % 128)) {
+            corrupted = true;
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_FALSE(corrupted);
+  SampleCacheStats stats = cache.stats();
+  EXPECT_EQ(stats.hits + stats.misses, kThreads * 20000UL);
+  EXPECT_GT(stats.hits, 0UL);
+  EXPECT_LE(stats.bytes, 256UL << 10);
+}
+
+}  // namespace paddle::distributed
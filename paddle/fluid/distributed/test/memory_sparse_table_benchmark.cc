@@ -0,0 +1,208 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/distributed/ps/table/memory_sparse_table.h"
+#include "paddle/fluid/distributed/ps/table/table.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+// Run with --sparse_table_bench_key_num=100000000 for the full size numbers.
+PD_DEFINE_int64(sparse_table_bench_key_num,
+                1000000,
+                "number of distinct keys pulled and pushed by the benchmark");
+PD_DEFINE_int32(sparse_table_bench_batch_size,
+                100000,
+                "number of keys of one pull or push request");
+PD_DECLARE_int32(pserver_sparse_prefetch_group_size);
+
+namespace paddle::distributed {
+
+static Table *CreateBenchmarkTable(SparseShardType shard_type,
+                                   int shard_num = 64) {
+  TableParameter table_config;
+  table_config.set_table_class("MemorySparseTable");
+  table_config.set_shard_num(shard_num);
+  table_config.set_sparse_shard_type(shard_type);
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(5);
+  accessor_config->mutable_embed_sgd_param()->set_name("SparseNaiveSGDRule");
+  auto *naive_param =
+      accessor_config->mutable_embed_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.3);
+  naive_param->add_weight_bounds(-10.0);
+  naive_param->add_weight_bounds(10.0);
+  accessor_config->mutable_embedx_sgd_param()->set_name("SparseNaiveSGDRule");
+  naive_param = accessor_config->mutable_embedx_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.3);
+  naive_param->add_weight_bounds(-10.0);
+  naive_param->add_weight_bounds(10.0);
+
+  FsClientParameter fs_config;
+  Table *table = new MemorySparseTable();
+  table->SetShard(0, 1);
+  PADDLE_ENFORCE_EQ(table->Initialize(table_config, fs_config),
+                    0,
+                    common::errors::Fatal("Initialize table failed."));
+  return table;
+}
+
+static double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+TEST(Benchmark, MemorySparseTablePullPush) {
+  const int64_t key_num = FLAGS_sparse_table_bench_key_num;
+  const int64_t batch_size = FLAGS_sparse_table_bench_batch_size;
+  std::vector<uint64_t> keys(key_num);
+  std::mt19937_64 rng(0);
+  for (auto &key : keys) {
+    key = rng();
+  }
+
+  for (auto shard_type : {CLOSED_HASH_SHARD, FLAT_HASH_SHARD}) {
+    std::unique_ptr<Table> table(CreateBenchmarkTable(shard_type));
+    auto accessor = table->GetValueAccessor();
+    size_t select_dim = accessor->GetAccessorInfo().select_dim;
+    size_t update_dim = accessor->GetAccessorInfo().update_dim;
+    std::vector<float> pull_values(batch_size * select_dim);
+    std::vector<float> push_values(batch_size * update_dim, 0.1);
+    std::vector<uint32_t> frequencies(batch_size, 1);
+
+    auto run_push = [&]() {
+      for (int64_t begin = 0; begin < key_num; begin += batch_size) {
+        TableContext context;
+        context.value_type = Sparse;
+        context.push_context.keys = keys.data() + begin;
+        context.push_context.values = push_values.data();
+        context.num = std::min(batch_size, key_num - begin);
+        table->Push(context);
+      }
+    };
+    auto run_pull = [&]() {
+      for (int64_t begin = 0; begin < key_num; begin += batch_size) {
+        size_t num = std::min(batch_size, key_num - begin);
+        PullSparseValue value(num, select_dim);
+        value.feasigns_ = keys.data() + begin;
+        value.frequencies_ = frequencies.data();
+        TableContext context;
+        context.value_type = Sparse;
+        context.pull_context.pull_value = value;
+        context.pull_context.values = pull_values.data();
+        table->Pull(context);
+      }
+    };
+
+    auto start = std::chrono::high_resolution_clock::now();
+    run_push();
+    double create_ms = ElapsedMs(start);
+    start = std::chrono::high_resolution_clock::now();
+    run_pull();
+    double pull_ms = ElapsedMs(start);
+    start = std::chrono::high_resolution_clock::now();
+    run_push();
+    double push_ms = ElapsedMs(start);
+
+    ASSERT_EQ(table->PrintTableStat().first, key_num);
+    std::cout << SparseShardType_Name(shard_type) << " keys: " << key_num
+              << " create: " << create_ms << " ms"
+              << " pull: " << pull_ms << " ms ("
+              << key_num / pull_ms * 1000 << " keys/s)"
+              << " push: " << push_ms << " ms ("
+              << key_num / push_ms * 1000 << " keys/s)" << std::endl;
+  }
+}
+
+// One local shard is served by one task thread, so the numbers below are
+// keys/s per core. Prefetch group size 0 is the serial lookup path.
+TEST(Benchmark, MemorySparseTableBatchedLookup) {
+  const int64_t key_num = FLAGS_sparse_table_bench_key_num;
+  std::vector<uint64_t> keys(key_num);
+  std::mt19937_64 rng(0);
+  for (auto &key : keys) {
+    key = rng();
+  }
+  const int32_t default_group_size = FLAGS_pserver_sparse_prefetch_group_size;
+
+  for (auto shard_type : {CLOSED_HASH_SHARD, FLAT_HASH_SHARD}) {
+    std::unique_ptr<Table> table(CreateBenchmarkTable(shard_type, 1));
+    auto accessor = table->GetValueAccessor();
+    size_t select_dim = accessor->GetAccessorInfo().select_dim;
+    size_t update_dim = accessor->GetAccessorInfo().update_dim;
+    // create all the keys first, so that only lookups are timed
+    std::vector<float> create_values(key_num * update_dim, 0.1);
+    TableContext create_context;
+    create_context.value_type = Sparse;
+    create_context.push_context.keys = keys.data();
+    create_context.push_context.values = create_values.data();
+    create_context.num = key_num;
+    table->Push(create_context);
+
+    for (int64_t batch_size : {1000, 10000, 100000, 1000000}) {
+      std::vector<float> pull_values(batch_size * select_dim);
+      std::vector<float> push_values(batch_size * update_dim, 0.1);
+      std::vector<uint32_t> frequencies(batch_size, 1);
+      for (int32_t group_size : {0, default_group_size}) {
+        FLAGS_pserver_sparse_prefetch_group_size = group_size;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int64_t begin = 0; begin < key_num; begin += batch_size) {
+          TableContext context;
+          context.value_type = Sparse;
+          context.push_context.keys = keys.data() + begin;
+          context.push_context.values = push_values.data();
+          context.num = std::min(batch_size, key_num - begin);
+          table->Push(context);
+        }
+        double push_ms = ElapsedMs(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        for (int64_t begin = 0; begin < key_num; begin += batch_size) {
+          size_t num = std::min(batch_size, key_num - begin);
+          PullSparseValue value(num, select_dim);
+          value.feasigns_ = keys.data() + begin;
+          value.frequencies_ = frequencies.data();
+          TableContext context;
+          context.value_type = Sparse;
+          context.pull_context.pull_value = value;
+          context.pull_context.values = pull_values.data();
+          table->Pull(context);
+        }
+        double pull_ms = ElapsedMs(start);
+        std::cout << SparseShardType_Name(shard_type)
+                  << " batch: " << batch_size
+                  << " prefetch group: " << group_size
+                  << " pull: " << key_num / pull_ms * 1000 << " keys/s"
+                  << " push: " << key_num / push_ms * 1000 << " keys/s"
+                  << std::endl;
+      }
+    }
+  }
+  FLAGS_pserver_sparse_prefetch_group_size = default_group_size;
+}
+
+}  // namespace paddle::distributed
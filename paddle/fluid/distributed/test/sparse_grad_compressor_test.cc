@@ -0,0 +1,153 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/service/communicator/sparse_grad_compressor.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace distributed {
+
+TEST(SparseGradCompressor, Codec) {
+  const size_t dim = 9;
+  std::vector<float> src{0.5f, -1.25f, 3e-3f, 0.0f, 7.0f, -7.0f, 1e-5f, 2, -3};
+  std::vector<float> dst(dim), decoded(dim);
+  for (auto type : {SparseGradCompressType::kFp32,
+                    SparseGradCompressType::kFp16,
+                    SparseGradCompressType::kInt8}) {
+    std::vector<char> row(SparseGradRowBytes(type, dim));
+    EncodeSparseGradRow(type, src.data(), dim, row.data(), decoded.data());
+    DecodeSparseGradRow(type, row.data(), dim, dst.data());
+    // the error is half a step of the encoding at most
+    float tolerance = type == SparseGradCompressType::kInt8 ? 7.0f / 127 / 2
+                      : type == SparseGradCompressType::kFp16 ? 7.0f / 1024
+                                                              : 0.0f;
+    for (size_t i = 0; i < dim; ++i) {
+      EXPECT_EQ(dst[i], decoded[i]);
+      EXPECT_NEAR(dst[i], src[i], tolerance);
+    }
+  }
+  EXPECT_EQ(SparseGradRowBytes(SparseGradCompressType::kFp16, dim), 18UL);
+  EXPECT_EQ(SparseGradRowBytes(SparseGradCompressType::kInt8, dim), 13UL);
+  EXPECT_EQ(ParseSparseGradCompressType("int8"),
+            SparseGradCompressType::kInt8);
+  EXPECT_ANY_THROW(ParseSparseGradCompressType("int4"));
+}
+
+TEST(SparseGradCompressor, Merge) {
+  SparseGradMerger merger(2);
+  std::vector<int64_t> keys{5, 3, 5};
+  std::vector<float> values{1, 2, 3, 4, 5, 6};
+  merger.Add(keys.data(), values.data(), keys.size());
+  merger.Add(keys.data() + 1, values.data() + 2, 1);
+  ASSERT_EQ(merger.size(), 2UL);
+  EXPECT_EQ(merger.keys()[0], 5UL);
+  EXPECT_EQ(merger.row(0)[0], 6);
+  EXPECT_EQ(merger.row(0)[1], 8);
+  EXPECT_EQ(merger.keys()[1], 3UL);
+  EXPECT_EQ(merger.row(1)[0], 6);
+  EXPECT_EQ(merger.row(1)[1], 8);
+}
+
+TEST(SparseGradCompressor, ErrorFeedback) {
+  const size_t dim = 8;
+  const int64_t key_num = 50;
+  std::mt19937 rng(0);
+  // one large value per row makes int8 drop most of the small ones
+  std::normal_distribution<float> grad(0.0f, 1e-3f);
+  for (auto type :
+       {SparseGradCompressType::kFp16, SparseGradCompressType::kInt8}) {
+    SparseGradCompressor compressor(type, dim);
+    std::vector<double> grad_sum(key_num * dim, 0.0), pushed_sum(grad_sum);
+    std::vector<int64_t> keys(key_num);
+    std::vector<float> values(key_num * dim);
+    std::vector<float> row(dim);
+    for (int step = 0; step < 200; ++step) {
+      for (int64_t k = 0; k < key_num; ++k) {
+        keys[k] = k;
+        for (size_t j = 0; j < dim; ++j) {
+          float value = j == 0 ? 1.0f : grad(rng);
+          values[k * dim + j] = value;
+          grad_sum[k * dim + j] += value;
+        }
+      }
+      compressor.Merge(keys.data(), values.data(), key_num);
+      compressor.Encode();
+      ASSERT_EQ(compressor.size(), static_cast<size_t>(key_num));
+      EXPECT_EQ(compressor.encoded_bytes(),
+                key_num * (8 + SparseGradRowBytes(type, dim)));
+      for (size_t i = 0; i < compressor.size(); ++i) {
+        DecodeSparseGradRow(type, compressor.rows()[i], dim, row.data());
+        for (size_t j = 0; j < dim; ++j) {
+          pushed_sum[compressor.keys()[i] * dim + j] += row[j];
+        }
+      }
+    }
+    // what is not pushed yet is one residual, below one encoding step
+    for (size_t i = 0; i < grad_sum.size(); ++i) {
+      EXPECT_NEAR(pushed_sum[i], grad_sum[i], 1.0 / 127);
+    }
+    EXPECT_EQ(compressor.residual_size(), static_cast<size_t>(key_num));
+  }
+}
+
+TEST(SparseGradCompressor, ResidualCapacity) {
+  const size_t dim = 4;
+  const size_t capacity = 16;
+  SparseGradCompressor compressor(SparseGradCompressType::kFp16, dim, capacity);
+  std::vector<int64_t> keys(1);
+  std::vector<float> values(dim, 1e-4f);
+  // a hot key pushed every step keeps its residual while the cold keys of
+  // the stream cycle through the other slots
+  for (int64_t step = 0; step < 1000; ++step) {
+    keys[0] = 0;
+    compressor.Merge(keys.data(), values.data(), 1);
+    keys[0] = step + 1;
+    compressor.Merge(keys.data(), values.data(), 1);
+    compressor.Encode();
+    ASSERT_LE(compressor.residual_size(), capacity);
+  }
+  EXPECT_EQ(compressor.residual_size(), capacity);
+
+  // the residual of the hot key still feeds back: its pushed sum follows
+  // the gradient sum
+  SparseGradCompressor reference(SparseGradCompressType::kFp16, dim, capacity);
+  double grad_sum = 0, pushed_sum = 0;
+  std::vector<float> row(dim);
+  for (int64_t step = 0; step < 1000; ++step) {
+    for (int64_t k = 0; k < 4; ++k) {
+      keys[0] = k == 0 ? 0 : step * 4 + k;
+      values[0] = k == 0 ? 1.0f + 1e-4f : 1.0f;
+      reference.Merge(keys.data(), values.data(), 1);
+    }
+    grad_sum += 1.0f + 1e-4f;
+    reference.Encode();
+    for (size_t i = 0; i < reference.size(); ++i) {
+      if (reference.keys()[i] == 0) {
+        DecodeSparseGradRow(
+            reference.type(), reference.rows()[i], dim, row.data());
+        pushed_sum += row[0];
+      }
+    }
+  }
+  EXPECT_NEAR(pushed_sum, grad_sum, 1e-2);
+  EXPECT_EQ(reference.residual_size(), capacity);
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,162 @@
+/* Copyright (c) 2026 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/distributed/ps/service/communicator/sparse_grad_compressor.h"
+#include "paddle/fluid/distributed/ps/service/env.h"
+#include "paddle/fluid/distributed/ps/service/ps_local_client.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+PD_DEFINE_int32(sparse_push_bench_trainers, 4, "trainer threads");
+PD_DEFINE_int32(sparse_push_bench_steps, 20, "pushes per trainer");
+PD_DEFINE_int32(sparse_push_bench_batch, 4096, "keys of a mini-batch");
+PD_DEFINE_int32(sparse_push_bench_merge, 8, "mini-batches merged per push");
+PD_DEFINE_int64(sparse_push_bench_key_num, 1000000, "distinct keys");
+
+namespace paddle {
+namespace distributed {
+
+static PSParameter GetLocalPsProto(int embedx_dim) {
+  PSParameter ps_param;
+  auto *server_param = ps_param.mutable_server_param()
+                           ->mutable_downpour_server_param();
+  server_param->mutable_service_param()->set_client_class("PsLocalClient");
+  auto *table = server_param->add_downpour_table_param();
+  table->set_table_id(0);
+  table->set_table_class("MemorySparseTable");
+  table->set_shard_num(16);
+  auto *accessor = table->mutable_accessor();
+  accessor->set_accessor_class("SparseAccessor");
+  accessor->set_fea_dim(embedx_dim + 1);
+  accessor->set_embedx_dim(embedx_dim);
+  accessor->set_embedx_threshold(0);
+  for (auto *sgd : {accessor->mutable_embed_sgd_param(),
+                    accessor->mutable_embedx_sgd_param()}) {
+    sgd->set_name("SparseNaiveSGDRule");
+    sgd->mutable_naive()->set_learning_rate(0.1);
+    sgd->mutable_naive()->set_initial_range(0.0);
+    sgd->mutable_naive()->add_weight_bounds(-10.0);
+    sgd->mutable_naive()->add_weight_bounds(10.0);
+  }
+  return ps_param;
+}
+
+// Every trainer thread merges FLAGS_sparse_push_bench_merge mini-batches of
+// power law keys per push into one PsLocalClient, the way the communicator
+// threads of the trainer processes of a node push to their servers.
+TEST(Benchmark, SparsePushMergeStage) {
+  const int embedx_dim = 8;
+  PSParameter ps_param = GetLocalPsProto(embedx_dim);
+  PaddlePSEnvironment env;
+  PsLocalClient client;
+  ASSERT_EQ(client.Configure(ps_param, {}, env, 0), 0);
+  const size_t dim = client.GetTableAccessor(0)->GetAccessorInfo().update_dim;
+
+  for (std::string quant : {"unmerged", "fp32", "fp16", "int8"}) {
+    std::vector<double> bytes(FLAGS_sparse_push_bench_trainers);
+    std::vector<double> push_ms(FLAGS_sparse_push_bench_trainers);
+    std::vector<std::thread> trainers;
+    for (int t = 0; t < FLAGS_sparse_push_bench_trainers; ++t) {
+      trainers.emplace_back([&, t]() {
+        std::mt19937_64 rng(t);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        std::normal_distribution<float> grad(0.0f, 1e-2f);
+        // keys k >= 1 with P(k) ~ k^-1.1
+        double max_pow = std::pow(FLAGS_sparse_push_bench_key_num, -0.1);
+        bool merged = quant != "unmerged";
+        SparseGradCompressor compressor(
+            ParseSparseGradCompressType(merged ? quant : "fp32"), dim);
+        std::vector<int64_t> keys(FLAGS_sparse_push_bench_batch);
+        std::vector<float> values(keys.size() * dim);
+        std::vector<uint64_t> raw_keys;
+        std::vector<const float *> raw_rows;
+        for (int step = 0; step < FLAGS_sparse_push_bench_steps; ++step) {
+          raw_keys.clear();
+          raw_rows.clear();
+          std::vector<std::vector<float>> batches;
+          batches.reserve(FLAGS_sparse_push_bench_merge);
+          for (int m = 0; m < FLAGS_sparse_push_bench_merge; ++m) {
+            for (size_t i = 0; i < keys.size(); ++i) {
+              double u = 1.0 - unit(rng) * (1.0 - max_pow);
+              keys[i] = static_cast<int64_t>(std::pow(u, -10.0));
+              for (size_t j = 0; j < dim; ++j) {
+                values[i * dim + j] = j < 3 ? (j == 1) : grad(rng);
+              }
+            }
+            if (merged) {
+              compressor.Merge(keys.data(), values.data(), keys.size());
+            } else {
+              batches.push_back(values);
+              for (size_t i = 0; i < keys.size(); ++i) {
+                raw_keys.push_back(keys[i]);
+                raw_rows.push_back(batches.back().data() + i * dim);
+              }
+            }
+          }
+
+          auto start = std::chrono::steady_clock::now();
+          std::future<int32_t> status;
+          if (merged) {
+            compressor.Encode();
+            bytes[t] += compressor.encoded_bytes();
+            status = client.PushSparseCompressedGradient(
+                0,
+                compressor.keys(),
+                compressor.rows(),
+                compressor.size(),
+                compressor.type(),
+                new PSClientClosure([](void *) {}));
+          } else {
+            bytes[t] += raw_keys.size() * (sizeof(uint64_t) + dim * 4);
+            status = client.PushSparseRawGradient(
+                0,
+                raw_keys.data(),
+                raw_rows.data(),
+                raw_keys.size(),
+                new PSClientClosure([](void *) {}));
+          }
+          status.wait();
+          push_ms[t] += std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+        }
+      });
+    }
+    for (auto &trainer : trainers) {
+      trainer.join();
+    }
+    double total_bytes = 0, total_ms = 0;
+    for (int t = 0; t < FLAGS_sparse_push_bench_trainers; ++t) {
+      total_bytes += bytes[t];
+      total_ms += push_ms[t];
+    }
+    double pushes = FLAGS_sparse_push_bench_trainers *
+                    static_cast<double>(FLAGS_sparse_push_bench_steps);
+    std::cout << quant << ": " << total_bytes / pushes / 1024
+              << " KB/step per trainer, push latency " << total_ms / pushes
+              << " ms" << std::endl;
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,188 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/table/sparse_snapshot.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle::distributed {
+
+TEST(SparseSnapshot, WriteAndMap) {
+  AccessorInfo info;
+  memset(&info, 0, sizeof(info));
+  info.dim = 6;
+  info.size = info.dim * sizeof(float);
+  info.mf_size = 2 * sizeof(float);
+
+  const size_t key_num = 1000;
+  std::vector<std::vector<float>> values(key_num);
+  std::vector<SparseSnapshotEntry> entries;
+  for (size_t i = 0; i < key_num; ++i) {
+    values[i].resize(i % 3 == 0 ? info.dim : info.dim - 2);
+    for (size_t j = 0; j < values[i].size(); ++j) {
+      values[i][j] = static_cast<float>(i * 10 + j);
+    }
+    // write keys out of order, the writer sorts them
+    entries.push_back({(key_num - i) * 7,
+                       values[i].data(),
+                       static_cast<uint32_t>(values[i].size())});
+  }
+  std::string path = "./sparse_snapshot_test" PSERVER_SNAPSHOT_SUFFIX;
+  ASSERT_TRUE(IsSparseSnapshotFile(path));
+  ASSERT_EQ(WriteSparseSnapshot(path, info, "CtrCommonAccessor", &entries, 64),
+            0);
+
+  AccessorInfo other = info;
+  other.dim = 7;
+  SparseSnapshotReader mismatch;
+  ASSERT_EQ(mismatch.Open(path, other), -1);
+
+  SparseSnapshotReader reader;
+  ASSERT_EQ(reader.Open(path, info), 0);
+  ASSERT_EQ(reader.key_num(), key_num);
+  ASSERT_EQ(reader.block_num(), (key_num + 63) / 64);
+  for (size_t block = 0; block < reader.block_num(); ++block) {
+    ASSERT_TRUE(reader.VerifyBlock(block, true));
+  }
+
+  FlatSparseTableShard<uint64_t> shard;
+  shard.set_value_dim(info.dim);
+  for (size_t i = 0; i < reader.key_num(); ++i) {
+    if (i > 0) {
+      ASSERT_LT(reader.key(i - 1), reader.key(i));
+    }
+    ASSERT_TRUE(shard.insert_value(reader.key(i), reader.value(i)));
+  }
+  auto mapping = reader.Release();
+  shard.adopt_values(mapping.first, mapping.second, key_num);
+  unlink(path.c_str());
+
+  for (size_t i = 0; i < key_num; ++i) {
+    auto it = shard.find((key_num - i) * 7);
+    ASSERT_TRUE(it != shard.end());
+    ASSERT_EQ(it.value().size(), values[i].size());
+    ASSERT_EQ(it.value().capacity(), info.dim);
+    for (size_t j = 0; j < values[i].size(); ++j) {
+      ASSERT_FLOAT_EQ(it.value().data()[j], values[i][j]);
+    }
+  }
+  // mapped values are private copies, and can grow up to the value dim
+  auto it = shard.find(7);
+  it.value().resize(info.dim);
+  it.value().data()[info.dim - 1] = -1.0;
+  shard.erase(7);
+  shard[7].resize(1);
+  ASSERT_EQ(shard.size(), key_num);
+}
+
+// Overwrites `size` bytes at `offset` of the file, and returns whether a
+// reader still accepts it.
+static bool OpenPatched(const std::string& path,
+                        const AccessorInfo& info,
+                        size_t offset,
+                        const void* data,
+                        size_t size) {
+  std::string patched = path + ".patched";
+  std::string copy = "cp " + path + " " + patched;
+  EXPECT_EQ(system(copy.c_str()), 0);
+  int fd = open(patched.c_str(), O_WRONLY);
+  EXPECT_GE(fd, 0);
+  EXPECT_EQ(pwrite(fd, data, size, offset), static_cast<ssize_t>(size));
+  close(fd);
+  SparseSnapshotReader reader;
+  bool ok = reader.Open(patched, info) == 0;
+  unlink(patched.c_str());
+  return ok;
+}
+
+TEST(SparseSnapshot, RejectCorruptedSections) {
+  AccessorInfo info;
+  memset(&info, 0, sizeof(info));
+  info.dim = 4;
+  info.size = info.dim * sizeof(float);
+
+  std::vector<float> value(info.dim, 1.0);
+  std::vector<SparseSnapshotEntry> entries;
+  for (uint64_t key = 1; key <= 100; ++key) {
+    entries.push_back({key, value.data(), static_cast<uint32_t>(info.dim)});
+  }
+  std::string path = "./sparse_snapshot_corrupted" PSERVER_SNAPSHOT_SUFFIX;
+  ASSERT_EQ(WriteSparseSnapshot(path, info, "CtrCommonAccessor", &entries, 16),
+            0);
+  SparseSnapshotReader reader;
+  ASSERT_EQ(reader.Open(path, info), 0);
+  SparseSnapshotHeader header = reader.header();
+  uint64_t block_offset = header.block_offset;
+
+  // sizes that overflow or run past the end of the file
+  uint64_t key_num = ~0ULL / sizeof(uint64_t) + 2;
+  ASSERT_FALSE(OpenPatched(path,
+                           info,
+                           offsetof(SparseSnapshotHeader, key_num),
+                           &key_num,
+                           sizeof(key_num)));
+  uint64_t value_offset = header.file_size + 4096;
+  ASSERT_FALSE(OpenPatched(path,
+                           info,
+                           offsetof(SparseSnapshotHeader, value_offset),
+                           &value_offset,
+                           sizeof(value_offset)));
+  uint64_t key_offset = ~0ULL - 4095;
+  ASSERT_FALSE(OpenPatched(path,
+                           info,
+                           offsetof(SparseSnapshotHeader, key_offset),
+                           &key_offset,
+                           sizeof(key_offset)));
+  uint64_t block_num = header.block_num + 1;
+  ASSERT_FALSE(OpenPatched(path,
+                           info,
+                           offsetof(SparseSnapshotHeader, block_num),
+                           &block_num,
+                           sizeof(block_num)));
+  // a block pointing past the key section
+  uint64_t block_key_num = header.key_num;
+  size_t block_key_num_offset =
+      block_offset + offsetof(SparseSnapshotBlock, key_num);
+  ASSERT_FALSE(OpenPatched(path,
+                           info,
+                           block_key_num_offset,
+                           &block_key_num,
+                           sizeof(block_key_num)));
+  // records which do not match the value dim
+  reader.CheckValues();
+  SparseSnapshotReader mismatch;
+  ASSERT_EQ(mismatch.Open(path, info), 0);
+  // the capacity follows the size in the record header, and the mapping is
+  // private so the file is not changed
+  auto* record = mismatch.value(17);
+  uint32_t capacity = info.dim + 1;
+  memcpy(reinterpret_cast<char*>(record) + sizeof(uint32_t),
+         &capacity,
+         sizeof(capacity));
+  EXPECT_THROW(mismatch.CheckValues(), common::enforce::EnforceNotMet);
+  // a truncated file
+  ASSERT_EQ(truncate(path.c_str(), header.file_size - 1), 0);
+  SparseSnapshotReader truncated;
+  ASSERT_EQ(truncated.Open(path, info), -1);
+  unlink(path.c_str());
+}
+
+}  // namespace paddle::distributed
@@ -0,0 +1,140 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/table/depends/sparse_tier.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle::distributed {
+
+TEST(WarmValueCodec, RoundTrip) {
+  std::vector<float> value = {0.0f,
+                              1.5f,
+                              -0.0f,
+                              0.0f,
+                              std::numeric_limits<float>::quiet_NaN(),
+                              3.0f,
+                              0.0f,
+                              0.0f,
+                              0.0f,
+                              -2.0f};
+  std::string code;
+  WarmValueCodec::Encode(value.data(), value.size(), &code);
+  // 4 bytes size, 2 bytes bitmap and 5 non-zero floats
+  ASSERT_EQ(code.size(), 4u + 2u + 5u * sizeof(float));
+  ASSERT_EQ(WarmValueCodec::DecodedSize(code), value.size());
+
+  std::vector<float> decoded(value.size(), 7.0f);
+  ASSERT_EQ(WarmValueCodec::Decode(code, decoded.data()), value.size());
+  ASSERT_EQ(memcmp(decoded.data(), value.data(), value.size() * sizeof(float)),
+            0);
+}
+
+TEST(WarmTierShard, PutTakeEvict) {
+  WarmTierShard shard;
+  std::vector<float> value(16, 0.0f);
+  for (uint64_t key = 0; key < 100; ++key) {
+    value[0] = static_cast<float>(key);
+    shard.Put(key, value.data(), value.size(), static_cast<float>(key));
+  }
+  ASSERT_EQ(shard.size(), 100u);
+  size_t full_size = shard.memory_size();
+
+  std::vector<float> out(16);
+  size_t size = 0;
+  ASSERT_TRUE(shard.Take(42, out.data(), &size));
+  ASSERT_EQ(size, 16u);
+  ASSERT_FLOAT_EQ(out[0], 42.0f);
+  ASSERT_FALSE(shard.Take(42, out.data(), &size));
+  ASSERT_LT(shard.memory_size(), full_size);
+
+  // the lowest scored values are evicted first, in clock order
+  std::vector<uint64_t> evicted;
+  auto evict_fn = [&](uint64_t key, const float* data, size_t n) {
+    ASSERT_EQ(n, 16u);
+    ASSERT_FLOAT_EQ(data[0], static_cast<float>(key));
+    evicted.push_back(key);
+  };
+  size_t count = shard.Evict(full_size / 2, evict_fn);
+  ASSERT_EQ(count, evicted.size());
+  ASSERT_LE(shard.memory_size(), full_size / 2);
+  for (size_t i = 0; i < evicted.size(); ++i) {
+    // key 42 has been taken out
+    ASSERT_EQ(evicted[i], i < 42 ? i : i + 1);
+  }
+
+  count = shard.Drain([](uint64_t, const float*, size_t) {});
+  ASSERT_EQ(count + evicted.size(), 99u);
+  ASSERT_EQ(shard.size(), 0u);
+  ASSERT_EQ(shard.memory_size(), 0u);
+}
+
+TEST(WarmTierShard, EvictKeepsWellScored) {
+  WarmTierShard shard;
+  std::vector<float> value(16, 1.0f);
+  // the clock hand starts at the best scored entry
+  shard.Put(0, value.data(), value.size(), 100.0f);
+  for (uint64_t key = 1; key < 10; ++key) {
+    shard.Put(key, value.data(), value.size(), 1.0f);
+  }
+  size_t entry_size = shard.memory_size() / 10;
+  std::vector<uint64_t> evicted;
+  shard.Evict(entry_size * 5,
+              [&](uint64_t key, const float*, size_t) {
+                evicted.push_back(key);
+              });
+  ASSERT_EQ(evicted.size(), 5u);
+  for (size_t i = 0; i < evicted.size(); ++i) {
+    ASSERT_EQ(evicted[i], i + 1);
+  }
+  // a new entry reuses a free slot
+  shard.Put(1, value.data(), value.size(), 1.0f);
+  ASSERT_EQ(shard.size(), 6u);
+  size_t count = shard.Drain([](uint64_t, const float*, size_t) {});
+  ASSERT_EQ(count, 6u);
+  ASSERT_EQ(shard.memory_size(), 0u);
+}
+
+TEST(SparseTierStat, HitRateAndLatency) {
+  SparseTierStat stat;
+  stat.AddHit(HOT_TIER, 80);
+  stat.AddHit(WARM_TIER, 10);
+  stat.AddHit(COLD_TIER, 5);
+  stat.AddMiss(5);
+  ASSERT_EQ(stat.Lookups(), 100u);
+  ASSERT_DOUBLE_EQ(stat.HitRate(HOT_TIER), 0.8);
+  ASSERT_DOUBLE_EQ(stat.HitRate(COLD_TIER), 0.05);
+
+  for (int i = 0; i < 99; ++i) {
+    stat.AddLatency(COLD_TIER, 100);
+  }
+  stat.AddLatency(COLD_TIER, 10000);
+  const auto& latency = stat.Latency(COLD_TIER);
+  ASSERT_EQ(latency.Count(), 100u);
+  // 100us falls into [64, 128)
+  ASSERT_EQ(latency.Percentile(0.5), 128u);
+  ASSERT_EQ(latency.Percentile(0.995), 16384u);
+  ASSERT_NEAR(latency.Mean(), 199.0, 1e-6);
+
+  stat.Reset();
+  ASSERT_EQ(stat.Lookups(), 0u);
+  ASSERT_EQ(stat.Latency(COLD_TIER).Count(), 0u);
+}
+
+}  // namespace paddle::distributed
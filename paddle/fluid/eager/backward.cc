@@ -14,10 +14,19 @@
 
 #include "paddle/fluid/eager/backward.h"
 
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+
+#include "paddle/common/flags.h"
 #include "paddle/fluid/eager/general_grad.h"
 #include "paddle/phi/core/memory/stats.h"
+#include "paddle/phi/core/threadpool.h"
 #include "paddle/phi/kernels/autotune/switch_autotune.h"
 
+COMMON_DECLARE_int32(eager_parallel_backward_threads);
+
 namespace egr {
 
 std::unordered_map<GradNodeBase*, int> getInDegreeMap(
@@ -100,6 +109,318 @@ void DuplicateCheck(const std::vector<paddle::Tensor>& inputs, bool is_input) {
   }
 }
 
+namespace {
+
+// Set on the threads running the nodes of a parallel backward pass. A
+// backward started by one of those nodes, e.g. by a PyLayer or recompute,
+// runs sequentially: the pool threads may all be busy waiting for the node
+// that started it, so its own tasks would never be picked up.
+thread_local bool in_parallel_backward = false;
+
+class ParallelBackwardGuard {
+ public:
+  ParallelBackwardGuard() : prev_(in_parallel_backward) {
+    in_parallel_backward = true;
+  }
+  ~ParallelBackwardGuard() { in_parallel_backward = prev_; }
+
+ private:
+  bool prev_;
+};
+
+phi::ThreadPool* ParallelBackwardThreadPool(int num_threads) {
+  static std::mutex mutex;
+  static std::map<int, std::unique_ptr<phi::ThreadPool>> pools;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& pool = pools[num_threads];
+  if (!pool) {
+    pool = std::make_unique<phi::ThreadPool>(num_threads);
+  }
+  return pool.get();
+}
+
+// Runs the grad nodes of a backward pass on several threads.
+//
+// A node becomes ready once its in-degree drops to zero, exactly as in the
+// sequential loop of RunBackward. Ready nodes go to one of two lanes:
+// GradNodeAccumulation nodes, which write the grads of leaf tensors and run
+// their reduce hooks, and force sequential nodes are run one by one by the
+// calling thread in the order they were released; all the other nodes are
+// run by whichever thread is free. The GradTensorHolder and the in-degree of
+// a node are only touched under the lock of that node, so several producers
+// may add into the same holder at the same time.
+class ParallelGradGraphRunner {
+ public:
+  ParallelGradGraphRunner(
+      std::unordered_map<GradNodeBase*, std::unique_ptr<GradTensorHolder>>*
+          node_input_buffers_dict,
+      const std::unordered_map<GradNodeBase*, int>& node_in_degree_map,
+      std::deque<GradNodeBase*>* force_sequential_nodes_queue,
+      const std::set<GradNodeBase*>& force_sequential_nodes_set,
+      std::set<GradNodeBase*>* ready_force_sequential_nodes,
+      bool retain_graph,
+      const phi::Place& place)
+      : force_sequential_nodes_queue_(force_sequential_nodes_queue),
+        force_sequential_nodes_set_(force_sequential_nodes_set),
+        ready_force_sequential_nodes_(ready_force_sequential_nodes),
+        retain_graph_(retain_graph),
+        place_(place) {
+    // Every node that may run is known beforehand, so states_ is never
+    // rehashed while the threads look it up.
+    for (const auto& [node, in_degree] : node_in_degree_map) {
+      states_[node].in_degree = in_degree;
+    }
+    for (auto& [node, buffer] : *node_input_buffers_dict) {
+      states_[node].holder = std::move(buffer);
+    }
+    node_input_buffers_dict->clear();
+  }
+
+  // Runs every node reachable from `queue` and leaves `queue` empty.
+  void Run(std::deque<GradNodeBase*>* queue, int num_threads) {
+    for (GradNodeBase* node : *queue) {
+      if (State(node)->in_degree == 0) {
+        Push(node);
+      }
+    }
+    queue->clear();
+
+    auto tracer = egr::Controller::Instance().GetCurrentTracer();
+    bool has_grad = tracer->HasGrad();
+    auto amp_level = tracer->GetAmpLevel();
+    bool use_promote = tracer->GetUsePromote();
+    std::string amp_dtype = tracer->GetAmpDtype();
+
+    auto* pool = ParallelBackwardThreadPool(num_threads - 1);
+    std::vector<std::future<void>> workers;
+    for (int i = 0; i < num_threads - 1; ++i) {
+      workers.emplace_back(pool->Run([&, this] {
+        ParallelBackwardGuard guard;
+        // the tracer and the amp state are thread local
+        egr::Controller::Instance().SetCurrentTracer(tracer);
+        paddle::imperative::SetCurrentTracer(tracer);
+        tracer->SetHasGrad(has_grad);
+        tracer->SetAmpLevel(amp_level);
+        tracer->SetUsePromote(use_promote);
+        tracer->SetAmpDtype(amp_dtype);
+        Drain(false);
+        egr::Controller::Instance().SetCurrentTracer(nullptr);
+        paddle::imperative::SetCurrentTracer(nullptr);
+      }));
+    }
+    {
+      ParallelBackwardGuard guard;
+      Drain(true);
+    }
+    for (auto& worker : workers) {
+      worker.wait();
+    }
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+ private:
+  struct NodeState {
+    std::mutex mutex;
+    std::unique_ptr<GradTensorHolder> holder;
+    int in_degree = 0;
+  };
+
+  NodeState* State(GradNodeBase* node) {
+    auto iter = states_.find(node);
+    PADDLE_ENFORCE_NE(
+        iter,
+        states_.end(),
+        common::errors::Fatal("Grad node %s is not in the backward graph.",
+                              node->name()));
+    return &iter->second;
+  }
+
+  bool Finished() const {
+    return running_ == 0 && caller_lane_.empty() && worker_lane_.empty();
+  }
+
+  // Requires mutex_.
+  void Push(GradNodeBase* node) {
+    bool is_accumulation =
+        dynamic_cast<egr::GradNodeAccumulation*>(node) != nullptr;
+    bool is_sequential = force_sequential_nodes_set_.count(node) > 0;
+    if (is_accumulation && !is_sequential) {
+      caller_lane_.push_front(node);
+    } else if (is_accumulation || is_sequential) {
+      // the caller lane is FIFO for them, which keeps their release order
+      caller_lane_.push_back(node);
+    } else {
+      worker_lane_.push_back(node);
+    }
+  }
+
+  // Requires mutex_. Keeps the release order of force sequential nodes.
+  void Release(GradNodeBase* node) {
+    if (!force_sequential_nodes_set_.count(node)) {
+      Push(node);
+      return;
+    }
+    if (force_sequential_nodes_queue_->front() != node) {
+      ready_force_sequential_nodes_->insert(node);
+      return;
+    }
+    force_sequential_nodes_queue_->pop_front();
+    Push(node);
+    while (!force_sequential_nodes_queue_->empty() &&
+           ready_force_sequential_nodes_->count(
+               force_sequential_nodes_queue_->front())) {
+      ready_force_sequential_nodes_->erase(
+          force_sequential_nodes_queue_->front());
+      Push(force_sequential_nodes_queue_->front());
+      force_sequential_nodes_queue_->pop_front();
+    }
+  }
+
+  void Drain(bool is_caller) {
+    while (true) {
+      GradNodeBase* node = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] {
+          return error_ || Finished() || !worker_lane_.empty() ||
+                 (is_caller && !caller_lane_.empty());
+        });
+        if (error_ || Finished()) {
+          return;
+        }
+        auto* lane = is_caller && !caller_lane_.empty() ? &caller_lane_
+                                                        : &worker_lane_;
+        node = lane->front();
+        lane->pop_front();
+        ++running_;
+      }
+
+      std::vector<GradNodeBase*> ready_nodes;
+      std::exception_ptr error;
+      try {
+        RunNode(node, &ready_nodes);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --running_;
+        if (error && !error_) {
+          error_ = error;
+        }
+        for (GradNodeBase* next_node : ready_nodes) {
+          Release(next_node);
+        }
+      }
+      cv_.notify_all();
+    }
+  }
+
+  void RunNode(GradNodeBase* node, std::vector<GradNodeBase*>* ready_nodes) {
+    VLOG(3) << "Preparing GradNode:" << node->name() << " addr:" << node;
+    std::unique_ptr<GradTensorHolder> node_input_buffer;
+    {
+      NodeState* state = State(node);
+      std::lock_guard<std::mutex> lock(state->mutex);
+      node_input_buffer = std::move(state->holder);
+    }
+    PADDLE_ENFORCE_NOT_NULL(
+        node_input_buffer,
+        common::errors::Fatal(
+            "Unable to find next node in the GradTensorHolder \n"
+            "Trying to run Node without configuring its GradTensorHolder."));
+
+    EnforceGradNodeHasInput(node);
+
+    phi::RecordEvent grad_node_record_event(
+        "Global_" + std::string((*node).name()),
+        paddle::platform::TracerEventType::Operator,
+        1);
+
+    paddle::small_vector<std::vector<paddle::Tensor>, kSlotSmallVectorSize>
+        grad_output_tensors = (*node)(node_input_buffer->Buffers(),
+                                      /*create_graph=*/false,
+                                      /*is_new_grad=*/false);
+    if (!retain_graph_) {
+      node->ClearTensorWrappers();
+    }
+    node_input_buffer.reset();
+
+    const paddle::small_vector<std::vector<GradSlotMeta>, kSlotSmallVectorSize>&
+        metas = node->OutputMeta();
+    PADDLE_ENFORCE(metas.size() == grad_output_tensors.size() || metas.empty(),
+                   common::errors::Fatal(
+                       "Number of edges should be either empty ( for leaf node "
+                       ") or the same as number of output grad tensors, but we "
+                       "got edges size is: %d, grad_output size is: %d",
+                       metas.size(),
+                       grad_output_tensors.size()));
+
+    for (size_t i = 0; i < metas.size(); i++) {
+      for (size_t j = 0; j < metas[i].size(); j++) {
+        const Edge& edge = metas[i][j].GetEdge();
+        if (!edge.IsInitialized()) {
+          continue;
+        }
+        auto edge_rank = edge.GetEdgeRankInfo();
+        GradNodeBase* next_node = edge.GetMutableGradNode().get();
+        if (!next_node || grad_output_tensors[i].empty()) {
+          continue;
+        }
+        PADDLE_ENFORCE_LT(
+            j,
+            grad_output_tensors[i].size(),
+            common::errors::Fatal(
+                "Rank of grad_output_tensors should be less than "
+                "grad_output_tensors[i].size(), which is: %d. This error may "
+                "indicate autoprune or autograd api error. ",
+                grad_output_tensors.size()));
+
+        NodeState* next_state = State(next_node);
+        std::lock_guard<std::mutex> lock(next_state->mutex);
+        if (!next_state->holder) {
+          next_state->holder =
+              std::make_unique<GradTensorHolder>(next_node->InputMeta());
+        }
+        next_state->holder->add(edge_rank.first,
+                                edge_rank.second,
+                                grad_output_tensors[i][j],
+                                /*create_graph=*/false);
+        --next_state->in_degree;
+        PADDLE_ENFORCE(
+            next_state->in_degree >= 0,
+            common::errors::Fatal(
+                "Detected in-degree value smaller than zero. For Node: %s"
+                "Node's in-degree cannot be negative.",
+                next_node->name()));
+        if (next_state->in_degree == 0) {
+          ready_nodes->push_back(next_node);
+        }
+      }
+    }
+    paddle::memory::LogDeviceMemoryStats(place_, std::string((*node).name()));
+  }
+
+  std::unordered_map<GradNodeBase*, NodeState> states_;
+  std::deque<GradNodeBase*>* force_sequential_nodes_queue_;
+  const std::set<GradNodeBase*>& force_sequential_nodes_set_;
+  std::set<GradNodeBase*>* ready_force_sequential_nodes_;
+  const bool retain_graph_;
+  const phi::Place place_;
+
+  // guards the lanes, the force sequential state, running_ and error_
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<GradNodeBase*> caller_lane_;
+  std::deque<GradNodeBase*> worker_lane_;
+  int running_ = 0;
+  std::exception_ptr error_;
+};
+
+}  // namespace
+
 GeneralGrad* GeneralGrad::general_grad_ = new GeneralGrad();
 
 std::vector<paddle::Tensor> RunBackward(
@@ -243,6 +564,24 @@ std::vector<paddle::Tensor> RunBackward(
 
   VLOG(5) << "Startup_ops's size is " << queue.size();
 
+  // The parallel runner empties the queue, which leaves nothing to the
+  // sequential loop below. Creating a graph and the GeneralGrad bookkeeping
+  // are not thread safe and always run sequentially, so does a backward
+  // started from inside a parallel one.
+  int num_threads = FLAGS_eager_parallel_backward_threads;
+  if (num_threads > 1 && !create_graph && !is_general_grad &&
+      !in_parallel_backward) {
+    VLOG(3) << "Run backward on " << num_threads << " threads";
+    ParallelGradGraphRunner runner(&node_input_buffers_dict,
+                                   node_in_degree_map,
+                                   &force_sequential_nodes_queue,
+                                   force_sequential_nodes_set,
+                                   &ready_force_sequential_nodes,
+                                   retain_graph,
+                                   place);
+    runner.Run(&queue, num_threads);
+  }
+
   /* --- Topological Visit --- */
   // 1. Pop queue
   // 2. Run node
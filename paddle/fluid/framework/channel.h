@@ -22,32 +22,65 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>  // NOLINT
 #include <deque>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <utility>
 #include <vector>
 
+#include "paddle/fluid/framework/mpmc_ring_buffer.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/phi/core/expect.h"
 
 namespace paddle {
 namespace framework {
 
+enum class ChannelMode {
+  // std::deque guarded by a mutex, capacity may be unbounded
+  kMutex,
+  // bounded lock-free MPMC ring buffer, for channels that are written and
+  // read concurrently by many threads. Writers block once capacity elements
+  // are buffered, so it must not be used to stage a whole dataset.
+  kLockFreeRing,
+};
+
 template <class T>
 class ChannelObject {
  public:
   ChannelObject() {}
 
   // capacity can be zero
-  explicit ChannelObject(size_t capacity) {
+  explicit ChannelObject(size_t capacity,
+                         ChannelMode mode = ChannelMode::kMutex) {
     capacity_ = (std::min)(MaxCapacity(), capacity);
+    if (mode == ChannelMode::kLockFreeRing) {
+      InitRing(capacity_);
+    }
   }
 
-  const std::deque<T>& GetData() const { return data_; }
+  ChannelMode Mode() const {
+    return ring_ ? ChannelMode::kLockFreeRing : ChannelMode::kMutex;
+  }
+
+  const std::deque<T>& GetData() const {
+    PADDLE_ENFORCE_EQ(ring_,
+                      nullptr,
+                      phi::errors::Unimplemented(
+                          "GetData is not supported by lock-free channels."));
+    return data_;
+  }
   void Clear() {
+    if (ring_) {
+      std::vector<T> drop(BlockSize());
+      while (ring_->TryPopBatch(drop.data(), drop.size()) != 0) {
+      }
+      ring_not_full_.Notify();
+      return;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     data_.clear();
     data_.shrink_to_fit();
@@ -58,6 +91,11 @@ class ChannelObject {
   }
 
   void SetCapacity(size_t x) {  // capacity can be zero
+    PADDLE_ENFORCE_EQ(
+        ring_,
+        nullptr,
+        phi::errors::Unimplemented(
+            "The capacity of a lock-free channel is fixed at construction."));
     std::lock_guard<std::mutex> lock(mutex_);
     capacity_ = std::min(MaxCapacity(), x);
     Notify();
@@ -83,6 +121,9 @@ class ChannelObject {
     std::lock_guard<std::mutex> lock(mutex_);
     capacity_ = other->Capacity();
     block_size_ = other->BlockSize();
+    if (other->Mode() == ChannelMode::kLockFreeRing) {
+      InitRing(capacity_);
+    }
   }
 
   bool Closed() {
@@ -104,11 +145,17 @@ class ChannelObject {
   }
 
   size_t Size() {
+    if (ring_) {
+      return ring_->Size();
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return data_.size();
   }
 
   bool Empty() {
+    if (ring_) {
+      return ring_->Size() == 0;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return EmptyUnlocked();
   }
@@ -122,6 +169,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_) {
+      return RingRead(n, p, false);
+    }
 
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Read(n, p, lock);
@@ -141,6 +191,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_) {
+      return RingWrite(n, p);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Write(n, p, lock);
     Notify();
@@ -152,6 +205,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_) {
+      return RingWrite(n, std::make_move_iterator(p));
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = WriteMove(n, p, lock);
     Notify();
@@ -170,6 +226,12 @@ class ChannelObject {
     if (size == 0) {
       return 0;
     }
+    if (ring_) {
+      p.resize(size);
+      size_t finished = RingRead(size, &p[0], true);
+      p.resize(finished);
+      return finished;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     p.resize(size);
     size_t finished = Read(size, &p[0], lock, true);
@@ -202,7 +264,7 @@ class ChannelObject {
  private:
   size_t capacity_ = MaxCapacity();
   size_t block_size_ = 1024;
-  bool closed_ = false;
+  std::atomic<bool> closed_{false};
   std::mutex mutex_;
   // use deque to store data
   std::deque<T> data_;
@@ -211,12 +273,76 @@ class ChannelObject {
   int full_waiters_ = 0;
   std::condition_variable empty_cond_;
   std::condition_variable full_cond_;
+  // set in ChannelMode::kLockFreeRing, then all data goes through the ring
+  // and mutex_ only guards the settings
+  std::unique_ptr<MPMCRingBuffer<T>> ring_;
+  SpinParker ring_not_empty_;
+  SpinParker ring_not_full_;
 
   static constexpr size_t MaxCapacity() {
     return (std::numeric_limits<size_t>::max)() / 2;
   }
 
+  static constexpr size_t MaxRingCapacity() { return size_t(1) << 26; }
+
+  void InitRing(size_t capacity) {
+    PADDLE_ENFORCE_LE(
+        capacity,
+        MaxRingCapacity(),
+        phi::errors::InvalidArgument(
+            "The capacity of a lock-free channel should be less than or "
+            "equal to %d, but got %d.",
+            MaxRingCapacity(),
+            capacity));
+    ring_ = std::make_unique<MPMCRingBuffer<T>>(capacity);
+    capacity_ = ring_->Capacity();
+  }
+
+  // Both wait with ring_not_empty_/ring_not_full_, spinning before parking.
+  // Closing the channel wakes every waiter.
+  size_t RingRead(size_t n, T* p, bool once) {
+    size_t finished = 0;
+    while (finished < n) {
+      size_t m = ring_->TryPopBatch(p + finished, n - finished);
+      if (m != 0) {
+        finished += m;
+        ring_not_full_.Notify();
+        if (once) {
+          break;
+        }
+        continue;
+      }
+      if (closed_ && ring_->Size() == 0) {
+        break;
+      }
+      ring_not_empty_.Wait([this] { return ring_->Size() != 0 || closed_; });
+    }
+    return finished;
+  }
+
+  template <class Iter>
+  size_t RingWrite(size_t n, Iter p) {
+    size_t finished = 0;
+    while (finished < n && !closed_) {
+      size_t m = ring_->TryPushBatch(p, n - finished);
+      if (m != 0) {
+        finished += m;
+        p += m;
+        ring_not_empty_.Notify();
+        continue;
+      }
+      ring_not_full_.Wait(
+          [this] { return ring_->Size() < ring_->Capacity() || closed_; });
+    }
+    return finished;
+  }
+
   void Notify() {
+    if (ring_) {
+      ring_not_empty_.Notify();
+      ring_not_full_.Notify();
+      return;
+    }
     if (empty_waiters_ != 0 && (!EmptyUnlocked() || closed_)) {
       empty_cond_.notify_one();
     }
@@ -322,8 +448,9 @@ template <class T>
 using Channel = std::shared_ptr<ChannelObject<T>>;
 
 template <class T>
-Channel<T> MakeChannel(size_t capacity = (std::numeric_limits<size_t>::max)()) {
-  return std::make_shared<ChannelObject<T>>(capacity);
+Channel<T> MakeChannel(size_t capacity = (std::numeric_limits<size_t>::max)(),
+                       ChannelMode mode = ChannelMode::kMutex) {
+  return std::make_shared<ChannelObject<T>>(capacity, mode);
 }
 
 template <class T, class U>
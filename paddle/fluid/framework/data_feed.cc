@@ -26,6 +26,7 @@ limitations under the License. */
 #include <sys/stat.h>
 #endif
 #include "io/fs.h"
+#include "paddle/fluid/framework/slot_text_parser.h"
 #include "paddle/fluid/platform/monitor.h"
 #include "paddle/fluid/platform/timer.h"
 
@@ -43,13 +44,32 @@ class BufferedLineFileReader {
   static const int MAX_FILE_BUFF_SIZE = 4 * 1024 * 1024;
   class FILEReader {
    public:
-    explicit FILEReader(FILE* fp) : fp_(fp) {}
-    int read(char* buf, int len) {
-      return static_cast<int>(fread(buf, sizeof(char), len, fp_));
+    FILEReader(FILE* fp, char* buf) : fp_(fp), buf_(buf) {}
+    bool next(char** data, size_t* size) {
+      *data = buf_;
+      *size = fread(buf_, sizeof(char), MAX_FILE_BUFF_SIZE, fp_);
+      return *size > 0;
     }
 
    private:
     FILE* fp_;
+    char* buf_;
+  };
+  // parses the read-ahead buffers of the stream in place
+  class StreamReader {
+   public:
+    explicit StreamReader(ReadStream* stream) : stream_(stream) {}
+    bool next(char** data, size_t* size) {
+      while (stream_->Next(data, size)) {
+        if (*size > 0) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+   private:
+    ReadStream* stream_;
   };
 
  public:
@@ -67,9 +87,8 @@ class BufferedLineFileReader {
 
     SampleFunc spfunc = get_sample_func();
     std::string x;
-    while (!is_error() && (ret = reader->read(buff_, MAX_FILE_BUFF_SIZE)) > 0) {
+    while (!is_error() && reader->next(&ptr, &ret)) {
       total_len_ += ret;
-      ptr = buff_;
       eol = reinterpret_cast<char*>(memchr(ptr, '\n', ret));
       while (eol != nullptr) {
         int size = static_cast<int>((eol - ptr) + 1);
@@ -113,9 +132,13 @@ class BufferedLineFileReader {
   ~BufferedLineFileReader() { free(buff_); }  // NOLINT
 
   int read_file(FILE* fp, LineFunc func, int skip_lines) {
-    FILEReader reader(fp);
+    FILEReader reader(fp, buff_);
     return read_lines<FILEReader>(&reader, func, skip_lines);
   }
+  int read_stream(ReadStream* stream, LineFunc func, int skip_lines) {
+    StreamReader reader(stream);
+    return read_lines<StreamReader>(&reader, func, skip_lines);
+  }
   uint64_t file_size() { return total_len_; }
   void set_sample_rate(float r) { sample_rate_ = r; }
   size_t get_sample_line() { return sample_line_; }
@@ -1153,44 +1176,28 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
     return false;
   } else {
     const char* str = reader.get();
-    std::string line = std::string(str);
-    // VLOG(3) << line;
-    char* endptr = const_cast<char*>(str);
-    int pos = 0;
+    SlotTextParser parser(str, str + reader.length());
+    size_t len = 0;
     if (parse_ins_id_) {
-      int num = static_cast<int>(strtol(&str[pos], &endptr, 10));
+      int num = static_cast<int>(parser.NextInt());
       CHECK(num == 1);  // NOLINT
-      pos = static_cast<int>(endptr - str + 1);
-      size_t len = 0;
-      while (str[pos + len] != ' ') {
-        ++len;
-      }
-      instance->ins_id_ = std::string(str + pos, len);
-      pos += static_cast<int>(len) + 1;
+      const char* token = parser.NextToken(&len);
+      instance->ins_id_ = std::string(token, len);
       VLOG(3) << "ins_id " << instance->ins_id_;
     }
     if (parse_content_) {
-      int num = static_cast<int>(strtol(&str[pos], &endptr, 10));
+      int num = static_cast<int>(parser.NextInt());
       CHECK(num == 1);  // NOLINT
-      pos = static_cast<int>(endptr - str + 1);
-      size_t len = 0;
-      while (str[pos + len] != ' ') {
-        ++len;
-      }
-      instance->content_ = std::string(str + pos, len);
-      pos += static_cast<int>(len) + 1;
+      const char* token = parser.NextToken(&len);
+      instance->content_ = std::string(token, len);
       VLOG(3) << "content " << instance->content_;
     }
     if (parse_logkey_) {
-      int num = static_cast<int>(strtol(&str[pos], &endptr, 10));
+      int num = static_cast<int>(parser.NextInt());
       CHECK(num == 1);  // NOLINT
-      pos = static_cast<int>(endptr - str + 1);
-      size_t len = 0;
-      while (str[pos + len] != ' ') {
-        ++len;
-      }
+      const char* token = parser.NextToken(&len);
       // parse_logkey
-      std::string log_key = std::string(str + pos, len);
+      std::string log_key = std::string(token, len);
       uint64_t search_id;
       uint32_t cmatch;
       uint32_t rank;
@@ -1200,11 +1207,10 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
       instance->search_id = search_id;
       instance->cmatch = cmatch;
       instance->rank = rank;
-      pos += static_cast<int>(len) + 1;
     }
     for (size_t i = 0; i < use_slots_index_.size(); ++i) {
       int idx = use_slots_index_[i];
-      int num = strtol(&str[pos], &endptr, 10);
+      int num = static_cast<int>(parser.NextInt());
       PADDLE_ENFORCE_NE(
           num,
           0,
@@ -1229,15 +1235,14 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
                            "please check this error line: %s",
                            str));
 
-        char* uidptr = endptr;
-        uint64_t feasign = (uint64_t)strtoull(uidptr, &uidptr, 10);
-        instance->uid_ = feasign;
+        SlotTextParser uid_parser(parser.pos(), str + reader.length());
+        instance->uid_ = uid_parser.NextUint64();
       }
 #endif
       if (idx != -1) {
         if (all_slots_type_[i][0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
+            float feasign = parser.NextFloat();
             // if float feasign is equal to zero, ignore it
             // except when slot is dense
             if (fabs(feasign) < 1e-6 && !use_slots_is_dense_[i]) {
@@ -1249,7 +1254,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
           }
         } else if (all_slots_type_[i][0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
+            uint64_t feasign = parser.NextUint64();
             // if uint64 feasign is equal to zero, ignore it
             // except when slot is dense
             if (feasign == 0 && !use_slots_is_dense_[i]) {
@@ -1260,14 +1265,8 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
             instance->uint64_feasigns_.emplace_back(f, idx);
           }
         }
-        pos = endptr - str;
       } else {
-        for (int j = 0; j <= num; ++j) {
-          // pos = line.find_first_of(' ', pos + 1);
-          while (line[pos + 1] != ' ') {
-            pos++;
-          }
-        }
+        parser.SkipTokens(num);
       }
     }
     instance->float_feasigns_.shrink_to_fit();
@@ -1287,11 +1286,10 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
     VLOG(3) << line;
     // parse line
     const char* str = line.c_str();
-    char* endptr = const_cast<char*>(str);
-    int pos = 0;
+    SlotTextParser parser(str, str + line.size());
     for (size_t i = 0; i < use_slots_index_.size(); ++i) {
       int idx = use_slots_index_[i];
-      int num = strtol(&str[pos], &endptr, 10);
+      int num = static_cast<int>(parser.NextInt());
       PADDLE_ENFORCE_NE(
           num,
           0,
@@ -1312,7 +1310,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
       if (idx != -1) {
         if (all_slots_type_[i][0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
+            float feasign = parser.NextFloat();
             if (fabs(feasign) < 1e-6) {
               continue;
             }
@@ -1322,7 +1320,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
           }
         } else if (all_slots_type_[i][0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
+            uint64_t feasign = parser.NextUint64();
             if (feasign == 0) {
               continue;
             }
@@ -1331,11 +1329,8 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
             instance->uint64_feasigns_.emplace_back(f, idx);
           }
         }
-        pos = endptr - str;
       } else {
-        for (int j = 0; j <= num; ++j) {
-          pos = line.find_first_of(' ', pos + 1);
-        }
+        parser.SkipTokens(num);
       }
     }
     instance->float_feasigns_.shrink_to_fit();
@@ -2325,10 +2320,17 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByLine() {
 
     do {
       int err_no = 0;
-      this->fp_ = fs_open_read(filename, &err_no, this->pipe_command_, true);
-      CHECK(this->fp_ != nullptr);
-      __fsetlocking(&*(this->fp_), FSETLOCKING_BYCALLER);
-      lines = line_reader.read_file(this->fp_.get(), line_func, lines);
+      auto stream =
+          fs_open_read_stream(filename, &err_no, this->pipe_command_, true);
+      // the files which are not read in process keep the FILE reader
+      if (stream != nullptr) {
+        lines = line_reader.read_stream(stream.get(), line_func, lines);
+      } else {
+        this->fp_ = fs_open_read(filename, &err_no, this->pipe_command_, true);
+        CHECK(this->fp_ != nullptr);
+        __fsetlocking(&*(this->fp_), FSETLOCKING_BYCALLER);
+        lines = line_reader.read_file(this->fp_.get(), line_func, lines);
+      }
     } while (line_reader.is_error());
 
     if (offset > 0) {
@@ -2374,29 +2376,34 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByCommand() {
 
     do {
       int err_no = 0;
-      this->fp_ = fs_open_read(filename, &err_no, this->pipe_command_, true);
-      CHECK(this->fp_ != nullptr);
-      __fsetlocking(&*(this->fp_), FSETLOCKING_BYCALLER);
-
-      lines = line_reader.read_file(
-          this->fp_.get(),
-          [this, &record_vec, &offset, &filename](const std::string& line) {
-            if (ParseOneInstance(line, &record_vec[offset])) {
-              ++offset;
-            } else {
-              LOG(WARNING) << "read file:[" << filename
-                           << "] item error, line:[" << line << "]";
-              return false;
-            }
-            if (offset >= OBJPOOL_BLOCK_SIZE) {
-              input_channel_->Write(std::move(record_vec));
-              record_vec.clear();
-              SlotRecordPool().get(&record_vec, OBJPOOL_BLOCK_SIZE);
-              offset = 0;
-            }
-            return true;
-          },
-          lines);
+      auto line_func = [this, &record_vec, &offset, &filename](
+                           const std::string& line) {
+        if (ParseOneInstance(line, &record_vec[offset])) {
+          ++offset;
+        } else {
+          LOG(WARNING) << "read file:[" << filename << "] item error, line:["
+                       << line << "]";
+          return false;
+        }
+        if (offset >= OBJPOOL_BLOCK_SIZE) {
+          input_channel_->Write(std::move(record_vec));
+          record_vec.clear();
+          SlotRecordPool().get(&record_vec, OBJPOOL_BLOCK_SIZE);
+          offset = 0;
+        }
+        return true;
+      };
+      auto stream =
+          fs_open_read_stream(filename, &err_no, this->pipe_command_, true);
+      // the files which are not read in process keep the FILE reader
+      if (stream != nullptr) {
+        lines = line_reader.read_stream(stream.get(), line_func, lines);
+      } else {
+        this->fp_ = fs_open_read(filename, &err_no, this->pipe_command_, true);
+        CHECK(this->fp_ != nullptr);
+        __fsetlocking(&*(this->fp_), FSETLOCKING_BYCALLER);
+        lines = line_reader.read_file(this->fp_.get(), line_func, lines);
+      }
     } while (line_reader.is_error());
     if (offset > 0) {
       input_channel_->WriteMove(offset, &record_vec[0]);
@@ -2439,35 +2446,21 @@ bool SlotRecordInMemoryDataFeed::ParseOneInstance(const std::string& line,
   SlotRecord& rec = (*ins);
   // parse line
   const char* str = line.c_str();
-  char* endptr = const_cast<char*>(str);
-  int pos = 0;
-
-  thread_local std::vector<std::vector<float>> slot_float_feasigns;
-  thread_local std::vector<std::vector<uint64_t>> slot_uint64_feasigns;
-  slot_float_feasigns.resize(float_use_slot_size_);
-  slot_uint64_feasigns.resize(uint64_use_slot_size_);
+  SlotTextParser parser(str, str + line.size());
+  size_t len = 0;
 
   if (parse_ins_id_) {
-    int num = static_cast<int>(strtol(&str[pos], &endptr, 10));
+    int num = static_cast<int>(parser.NextInt());
     CHECK(num == 1);  // NOLINT
-    pos = static_cast<int>(endptr - str + 1);
-    size_t len = 0;
-    while (str[pos + len] != ' ') {
-      ++len;
-    }
-    rec->ins_id_ = std::string(str + pos, len);
-    pos += static_cast<int>(len + 1);
+    const char* token = parser.NextToken(&len);
+    rec->ins_id_ = std::string(token, len);
   }
   if (parse_logkey_) {
-    int num = static_cast<int>(strtol(&str[pos], &endptr, 10));
+    int num = static_cast<int>(parser.NextInt());
     CHECK(num == 1);  // NOLINT
-    pos = static_cast<int>(endptr - str + 1);
-    size_t len = 0;
-    while (str[pos + len] != ' ') {
-      ++len;
-    }
+    const char* token = parser.NextToken(&len);
     // parse_logkey
-    std::string log_key = std::string(str + pos, len);
+    std::string log_key = std::string(token, len);
     uint64_t search_id = 0;
     uint32_t cmatch = 0;
     uint32_t rank = 0;
@@ -2477,14 +2470,18 @@ bool SlotRecordInMemoryDataFeed::ParseOneInstance(const std::string& line,
     rec->search_id = search_id;
     rec->cmatch = cmatch;
     rec->rank = rank;
-    pos += static_cast<int>(len + 1);
   }
 
-  int float_total_slot_num = 0;
-  int uint64_total_slot_num = 0;
+  // slot_value_idx grows in the order of all_slots_info_, so the feasigns
+  // are appended to the record slot after slot without staging buffers
+  auto& float_feasigns = rec->slot_float_feasigns_;
+  auto& uint64_feasigns = rec->slot_uint64_feasigns_;
+  float_feasigns.slot_offsets.resize(float_use_slot_size_ + 1);
+  uint64_feasigns.slot_offsets.resize(uint64_use_slot_size_ + 1);
+  size_t uint64_begin = uint64_feasigns.slot_values.size();
 
   for (auto& info : all_slots_info_) {
-    int num = static_cast<int>(strtol(&str[pos], &endptr, 10));
+    int num = static_cast<int>(parser.NextInt());
     PADDLE_ENFORCE(num,
                    "The number of ids can not be zero, you need padding "
                    "it in data generator; or if there is something wrong with "
@@ -2493,40 +2490,35 @@ bool SlotRecordInMemoryDataFeed::ParseOneInstance(const std::string& line,
                    str);
     if (info.used_idx != -1) {
       if (info.type[0] == 'f') {  // float
-        auto& slot_fea = slot_float_feasigns[info.slot_value_idx];
-        slot_fea.clear();
+        auto& values = float_feasigns.slot_values;
+        float_feasigns.slot_offsets[info.slot_value_idx] =
+            static_cast<uint32_t>(values.size());
+        bool dense = used_slots_info_[info.used_idx].dense;
         for (int j = 0; j < num; ++j) {
-          float feasign = strtof(endptr, &endptr);
-          if (fabs(feasign) < 1e-6 && !used_slots_info_[info.used_idx].dense) {
+          float feasign = parser.NextFloat();
+          if (fabs(feasign) < 1e-6 && !dense) {
             continue;
           }
-          slot_fea.push_back(feasign);
-          ++float_total_slot_num;
+          values.push_back(feasign);
         }
       } else if (info.type[0] == 'u') {  // uint64
-        auto& slot_fea = slot_uint64_feasigns[info.slot_value_idx];
-        slot_fea.clear();
+        auto& values = uint64_feasigns.slot_values;
+        uint64_feasigns.slot_offsets[info.slot_value_idx] =
+            static_cast<uint32_t>(values.size());
         for (int j = 0; j < num; ++j) {
-          uint64_t feasign =
-              static_cast<uint64_t>(strtoull(endptr, &endptr, 10));
-          slot_fea.push_back(feasign);
-          ++uint64_total_slot_num;
+          values.push_back(parser.NextUint64());
         }
       }
-      pos = static_cast<int>(endptr - str);
     } else {
-      for (int j = 0; j <= num; ++j) {
-        // pos = line.find_first_of(' ', pos + 1);
-        while (line[pos + 1] != ' ') {
-          pos++;
-        }
-      }
+      parser.SkipTokens(num);
     }
   }
-  rec->slot_float_feasigns_.add_slot_feasigns(slot_float_feasigns,
-                                              float_total_slot_num);
-  rec->slot_uint64_feasigns_.add_slot_feasigns(slot_uint64_feasigns,
-                                               uint64_total_slot_num);
+  float_feasigns.slot_offsets[float_use_slot_size_] =
+      static_cast<uint32_t>(float_feasigns.slot_values.size());
+  uint64_feasigns.slot_offsets[uint64_use_slot_size_] =
+      static_cast<uint32_t>(uint64_feasigns.slot_values.size());
+  size_t uint64_total_slot_num =
+      uint64_feasigns.slot_values.size() - uint64_begin;
 
   return (uint64_total_slot_num > 0);
 }
@@ -19,8 +19,14 @@ limitations under the License. */
 #include <memory>
 
 #include "glog/logging.h"
+#include "paddle/common/flags.h"
 #include "paddle/fluid/platform/enforce.h"
 
+COMMON_DECLARE_bool(fs_read_in_process);
+COMMON_DECLARE_int64(fs_read_ahead_buffer_size);
+COMMON_DECLARE_int32(fs_read_ahead_buffer_num);
+COMMON_DECLARE_bool(fs_read_direct_io);
+
 namespace paddle {
 namespace framework {
 
@@ -101,6 +107,35 @@ static bool fs_end_with_internal(const std::string& path,
                  str.length()) == 0;
 }
 
+static ReadStreamOptions fs_read_stream_options_internal() {
+  ReadStreamOptions options;
+  options.buffer_size = static_cast<size_t>(FLAGS_fs_read_ahead_buffer_size);
+  options.buffer_num = FLAGS_fs_read_ahead_buffer_num;
+  options.direct_io = FLAGS_fs_read_direct_io;
+  return options;
+}
+
+// "cat" is the default pipe_command of data feeds, forking it changes nothing
+static bool fs_is_identity_converter_internal(const std::string& converter) {
+  std::string x = string::trim_spaces(converter);
+  return x.empty() || x == "cat";
+}
+
+// Decompresses the gzip data of `stream` on another read-ahead thread, so
+// reading, inflating and parsing run in parallel.
+static std::unique_ptr<ReadStream> fs_add_gzip_stream_internal(
+    std::unique_ptr<ReadStream> stream) {
+  return MakeReadAheadStream(MakeGzipReadSource(std::move(stream)),
+                             fs_read_stream_options_internal());
+}
+
+// reads the `hadoop fs -cat` output ahead of the in-process inflate
+static std::unique_ptr<ReadStream> fs_pipe_stream_internal(
+    std::shared_ptr<FILE> fp) {
+  return MakeReadAheadStream(MakePipeReadSource(std::move(fp)),
+                             fs_read_stream_options_internal());
+}
+
 static size_t& localfs_buffer_size_internal() {
   static size_t x = 0;
   return x;
@@ -110,18 +145,62 @@ size_t localfs_buffer_size() { return localfs_buffer_size_internal(); }
 
 void localfs_set_buffer_size(size_t x) { localfs_buffer_size_internal() = x; }
 
-std::shared_ptr<FILE> localfs_open_read(std::string path,
-                                        const std::string& converter) {
+static std::shared_ptr<FILE> localfs_open_read_shell_internal(
+    std::string path, const std::string& converter) {
   bool is_pipe = false;
 
   if (fs_end_with_internal(path, ".gz")) {
     fs_add_read_converter_internal(path, is_pipe, "zcat");
+  } else if (fs_end_with_internal(path, ".zst")) {
+    fs_add_read_converter_internal(path, is_pipe, "zstd -dcq");
   }
 
   fs_add_read_converter_internal(path, is_pipe, converter);
   return fs_open_internal(path, is_pipe, "r", localfs_buffer_size());
 }
 
+// zstd is not linked in, .zst files are always read through the shell
+static bool localfs_read_in_process_internal(const std::string& path,
+                                             const std::string& converter) {
+  return FLAGS_fs_read_in_process &&
+         fs_is_identity_converter_internal(converter) &&
+         !fs_end_with_internal(path, ".zst");
+}
+
+std::unique_ptr<ReadStream> localfs_open_read_stream(
+    std::string path, const std::string& converter) {
+  if (localfs_read_in_process_internal(path, converter)) {
+    // the callers fall back to the shell readers, e.g. when the read-ahead
+    // buffers can not be allocated or the file can not be opened with
+    // direct io
+    try {
+      auto options = fs_read_stream_options_internal();
+      auto stream =
+          MakeReadAheadStream(MakeFileReadSource(path, options), options);
+      if (fs_end_with_internal(path, ".gz")) {
+        stream = fs_add_gzip_stream_internal(std::move(stream));
+      }
+      return stream;
+    } catch (std::exception& e) {
+      LOG(WARNING) << "Failed to read " << path
+                   << " in process, read it through the shell instead: "
+                   << e.what();
+    }
+  }
+  return nullptr;
+}
+
+std::shared_ptr<FILE> localfs_open_read(std::string path,
+                                        const std::string& converter) {
+  if (localfs_read_in_process_internal(path, converter)) {
+    auto fp = ReadStreamToFILE(localfs_open_read_stream(path, converter));
+    if (fp != nullptr) {
+      return fp;
+    }
+  }
+  return localfs_open_read_shell_internal(path, converter);
+}
+
 std::shared_ptr<FILE> localfs_open_write(std::string path,
                                          const std::string& converter) {
   shell_execute(
@@ -276,10 +355,11 @@ void set_download_command(const std::string& x) {
   customized_download_cmd_internal() = x;
 }
 
-std::shared_ptr<FILE> hdfs_open_read(std::string path,
-                                     int* err_no,
-                                     const std::string& converter,
-                                     bool read_data) {
+static std::shared_ptr<FILE> hdfs_open_read_shell_internal(
+    std::string path,
+    int* err_no,
+    const std::string& converter,
+    bool read_data) {
   if (!download_cmd().empty()) {  // use customized download command
     path = string::format_string(
         "%s \"%s\"", download_cmd().c_str(), path.c_str());
@@ -308,6 +388,50 @@ std::shared_ptr<FILE> hdfs_open_read(std::string path,
   return fs_open_internal(path, is_pipe, "r", hdfs_buffer_size(), err_no);
 }
 
+// `-text` decompresses gzip in the hadoop client, in process it is done by
+// zlib on the plain `-cat` output instead
+static bool hdfs_read_in_process_internal(const std::string& path,
+                                          const std::string& converter) {
+  return FLAGS_fs_read_in_process && download_cmd().empty() &&
+         fs_end_with_internal(path, ".gz") &&
+         fs_is_identity_converter_internal(converter);
+}
+
+std::unique_ptr<ReadStream> hdfs_open_read_stream(std::string path,
+                                                  int* err_no,
+                                                  const std::string& converter,
+                                                  bool read_data) {
+  if (hdfs_read_in_process_internal(path, converter)) {
+    try {
+      std::string cmd = string::format_string(
+          "%s -cat \"%s\"",
+          read_data ? dataset_hdfs_command().c_str() : hdfs_command().c_str(),
+          path.c_str());
+      return fs_add_gzip_stream_internal(
+          fs_pipe_stream_internal(fs_open_internal(cmd, true, "r", 0, err_no)));
+    } catch (std::exception& e) {
+      LOG(WARNING) << "Failed to read " << path
+                   << " in process, read it through the shell instead: "
+                   << e.what();
+    }
+  }
+  return nullptr;
+}
+
+std::shared_ptr<FILE> hdfs_open_read(std::string path,
+                                     int* err_no,
+                                     const std::string& converter,
+                                     bool read_data) {
+  if (hdfs_read_in_process_internal(path, converter)) {
+    auto fp = ReadStreamToFILE(
+        hdfs_open_read_stream(path, err_no, converter, read_data));
+    if (fp != nullptr) {
+      return fp;
+    }
+  }
+  return hdfs_open_read_shell_internal(path, err_no, converter, read_data);
+}
+
 std::shared_ptr<FILE> hdfs_open_write(std::string path,
                                       int* err_no,
                                       const std::string& converter) {
@@ -433,6 +557,26 @@ std::shared_ptr<FILE> fs_open_read(const std::string& path,
   return {};
 }
 
+std::unique_ptr<ReadStream> fs_open_read_stream(const std::string& path,
+                                                int* err_no,
+                                                const std::string& converter,
+                                                bool read_data) {
+  switch (fs_select_internal(path)) {
+    case 0:
+      return localfs_open_read_stream(path, converter);
+
+    case 1:
+      return hdfs_open_read_stream(path, err_no, converter, read_data);
+
+    default:
+      PADDLE_THROW(common::errors::Unimplemented(
+          "Unsupport file system. Now only supports local file system and "
+          "HDFS."));
+  }
+
+  return {};
+}
+
 std::shared_ptr<FILE> fs_open_write(const std::string& path,
                                     int* err_no,
                                     const std::string& converter) {
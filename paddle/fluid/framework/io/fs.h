@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "glog/logging.h"
+#include "paddle/fluid/framework/io/read_stream.h"
 #include "paddle/fluid/framework/io/shell.h"
 #include "paddle/utils/string/string_helper.h"
 
@@ -38,6 +39,13 @@ extern void localfs_set_buffer_size(size_t x);
 extern std::shared_ptr<FILE> localfs_open_read(std::string path,
                                                const std::string& converter);
 
+// Reads local files with read-ahead threads, and decompresses .gz files in
+// process, if FLAGS_fs_read_in_process is set and the converter is empty or
+// cat. Returns nullptr for the other files, and when the in-process reader
+// can not be set up, which are read by localfs_open_read instead.
+extern std::unique_ptr<ReadStream> localfs_open_read_stream(
+    std::string path, const std::string& converter);
+
 extern std::shared_ptr<FILE> localfs_open_write(std::string path,
                                                 const std::string& converter);
 
@@ -77,6 +85,15 @@ extern std::shared_ptr<FILE> hdfs_open_read(std::string path,
                                             const std::string& converter,
                                             bool read_data);
 
+// Inflates .gz files of the `-cat` output in process, under the same
+// conditions as localfs_open_read_stream and with no download command, and
+// returns nullptr otherwise.
+extern std::unique_ptr<ReadStream> hdfs_open_read_stream(
+    std::string path,
+    int* err_no,
+    const std::string& converter,
+    bool read_data);
+
 extern std::shared_ptr<FILE> hdfs_open_write(std::string path,
                                              int* err_no,
                                              const std::string& converter);
@@ -99,6 +116,15 @@ extern std::shared_ptr<FILE> fs_open_read(const std::string& path,
                                           const std::string& converter,
                                           bool read_data = false);
 
+// The files fs_open_read reads in process, handed out as spans of the
+// read-ahead buffers. Returns nullptr for the files fs_open_read reads through
+// the shell, see localfs_open_read_stream and hdfs_open_read_stream.
+extern std::unique_ptr<ReadStream> fs_open_read_stream(
+    const std::string& path,
+    int* err_no,
+    const std::string& converter,
+    bool read_data = false);
+
 extern std::shared_ptr<FILE> fs_open_write(const std::string& path,
                                            int* err_no,
                                            const std::string& converter);
@@ -0,0 +1,426 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/io/read_stream.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <zlib.h>
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <malloc.h>
+#endif
+
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+static const size_t kReadStreamAlignment = 4096;
+
+static char* AlignedAlloc(size_t size) {
+#ifdef _WIN32
+  return static_cast<char*>(_aligned_malloc(size, kReadStreamAlignment));
+#else
+  void* ptr = nullptr;
+  if (posix_memalign(&ptr, kReadStreamAlignment, size) != 0) {
+    return nullptr;
+  }
+  return static_cast<char*>(ptr);
+#endif
+}
+
+static void AlignedFree(char* ptr) {
+#ifdef _WIN32
+  _aligned_free(ptr);
+#else
+  free(ptr);  // NOLINT
+#endif
+}
+
+class ReadAheadStream : public ReadStream {
+ public:
+  ReadAheadStream(std::unique_ptr<ReadSource> source,
+                  const ReadStreamOptions& options)
+      : source_(std::move(source)) {
+    buffer_size_ = std::max(options.buffer_size, kReadStreamAlignment);
+    buffer_size_ = (buffer_size_ + kReadStreamAlignment - 1) /
+                   kReadStreamAlignment * kReadStreamAlignment;
+    buffers_.resize(std::max(options.buffer_num, 2));
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      buffers_[i].data = AlignedAlloc(buffer_size_);
+      PADDLE_ENFORCE_NOT_NULL(
+          buffers_[i].data,
+          common::errors::ResourceExhausted(
+              "Failed to allocate %d bytes of read-ahead buffer.",
+              buffer_size_));
+      free_.push_back(i);
+    }
+    thread_ = std::thread([this] { Produce(); });
+  }
+
+  ~ReadAheadStream() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cond_.notify_all();
+    thread_.join();
+    for (auto& buffer : buffers_) {
+      AlignedFree(buffer.data);
+    }
+  }
+
+  bool Next(char** data, size_t* size) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (current_ >= 0) {
+      free_.push_back(current_);
+      current_ = -1;
+      cond_.notify_all();
+    }
+    cond_.wait(lock, [this] { return !filled_.empty() || done_; });
+    if (filled_.empty()) {
+      if (error_) {
+        std::rethrow_exception(error_);
+      }
+      return false;
+    }
+    current_ = static_cast<int>(filled_.front());
+    filled_.pop_front();
+    *data = buffers_[current_].data;
+    *size = buffers_[current_].size;
+    return true;
+  }
+
+ private:
+  struct Buffer {
+    char* data = nullptr;
+    size_t size = 0;
+  };
+
+  void Produce() {
+    try {
+      while (true) {
+        size_t idx = 0;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          cond_.wait(lock, [this] { return stop_ || !free_.empty(); });
+          if (stop_) {
+            break;
+          }
+          idx = free_.front();
+          free_.pop_front();
+        }
+        size_t size = source_->Read(buffers_[idx].data, buffer_size_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (size == 0) {
+          free_.push_back(idx);
+          break;
+        }
+        buffers_[idx].size = size;
+        filled_.push_back(idx);
+        cond_.notify_all();
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      error_ = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+    cond_.notify_all();
+  }
+
+  std::unique_ptr<ReadSource> source_;
+  size_t buffer_size_ = 0;
+  std::vector<Buffer> buffers_;
+  std::deque<size_t> free_;
+  std::deque<size_t> filled_;
+  // buffer handed out by the last Next()
+  int current_ = -1;
+  bool stop_ = false;
+  bool done_ = false;
+  std::exception_ptr error_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::thread thread_;
+};
+
+std::unique_ptr<ReadStream> MakeReadAheadStream(
+    std::unique_ptr<ReadSource> source, const ReadStreamOptions& options) {
+  return std::make_unique<ReadAheadStream>(std::move(source), options);
+}
+
+#ifndef _WIN32
+// Reads until `size` bytes are filled or the end of `fd`.
+static size_t ReadFully(int fd, char* buf, size_t size, bool* direct) {
+  size_t total = 0;
+  while (total < size) {
+    ssize_t n = read(fd, buf + total, size - total);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+#ifdef O_DIRECT
+      // unaligned offsets, e.g. after a short read, are not allowed with
+      // O_DIRECT on some file systems
+      if (errno == EINVAL && direct != nullptr && *direct) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+        *direct = false;
+        continue;
+      }
+#endif
+      PADDLE_THROW(common::errors::Unavailable(
+          "Failed to read file descriptor %d, errno %d.", fd, errno));
+    }
+    if (n == 0) {
+      break;
+    }
+    total += n;
+  }
+  return total;
+}
+
+class FileReadSource : public ReadSource {
+ public:
+  FileReadSource(const std::string& path, const ReadStreamOptions& options) {
+#ifdef O_DIRECT
+    if (options.direct_io) {
+      fd_ = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+      direct_ = (fd_ >= 0);
+    }
+#endif
+    if (fd_ < 0) {
+      fd_ = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    if (fd_ < 0) {
+      PADDLE_THROW(common::errors::Unavailable(
+          "Failed to open file, path[%s], mode[r].", path));
+    }
+#if defined(POSIX_FADV_SEQUENTIAL)
+    if (options.fadvise) {
+      posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#endif
+  }
+
+  ~FileReadSource() override { close(fd_); }
+
+  size_t Read(char* buf, size_t size) override {
+    return ReadFully(fd_, buf, size, &direct_);
+  }
+
+ private:
+  int fd_ = -1;
+  bool direct_ = false;
+};
+
+class PipeReadSource : public ReadSource {
+ public:
+  explicit PipeReadSource(std::shared_ptr<FILE> fp) : fp_(std::move(fp)) {}
+
+  size_t Read(char* buf, size_t size) override {
+    return ReadFully(fileno(fp_.get()), buf, size, nullptr);
+  }
+
+ private:
+  std::shared_ptr<FILE> fp_;
+};
+#else
+class FileReadSource : public ReadSource {
+ public:
+  FileReadSource(const std::string& path, const ReadStreamOptions& options) {
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (fp == nullptr) {
+      PADDLE_THROW(common::errors::Unavailable(
+          "Failed to open file, path[%s], mode[r].", path));
+    }
+    fp_.reset(fp, [](FILE* fp) { fclose(fp); });
+  }
+
+  size_t Read(char* buf, size_t size) override {
+    return fread(buf, 1, size, fp_.get());
+  }
+
+ private:
+  std::shared_ptr<FILE> fp_;
+};
+
+class PipeReadSource : public ReadSource {
+ public:
+  explicit PipeReadSource(std::shared_ptr<FILE> fp) : fp_(std::move(fp)) {}
+
+  size_t Read(char* buf, size_t size) override {
+    return fread(buf, 1, size, fp_.get());
+  }
+
+ private:
+  std::shared_ptr<FILE> fp_;
+};
+#endif
+
+std::unique_ptr<ReadSource> MakeFileReadSource(
+    const std::string& path, const ReadStreamOptions& options) {
+  return std::make_unique<FileReadSource>(path, options);
+}
+
+std::unique_ptr<ReadSource> MakePipeReadSource(std::shared_ptr<FILE> fp) {
+  PADDLE_ENFORCE_NOT_NULL(
+      fp, common::errors::InvalidArgument("The pipe to read is null."));
+  return std::make_unique<PipeReadSource>(std::move(fp));
+}
+
+class GzipReadSource : public ReadSource {
+ public:
+  explicit GzipReadSource(std::unique_ptr<ReadStream> compressed)
+      : compressed_(std::move(compressed)) {
+    memset(&zstream_, 0, sizeof(zstream_));
+    // 15 window bits, +32 detects gzip and zlib headers automatically
+    PADDLE_ENFORCE_EQ(inflateInit2(&zstream_, 15 + 32),
+                      Z_OK,
+                      common::errors::External("Failed to init zlib inflate."));
+  }
+
+  ~GzipReadSource() override { inflateEnd(&zstream_); }
+
+  size_t Read(char* buf, size_t size) override {
+    zstream_.next_out = reinterpret_cast<Bytef*>(buf);
+    zstream_.avail_out = static_cast<uInt>(size);
+    while (zstream_.avail_out > 0 && !finished_) {
+      if (zstream_.avail_in == 0) {
+        char* data = nullptr;
+        size_t len = 0;
+        if (!compressed_->Next(&data, &len)) {
+          PADDLE_ENFORCE_EQ(in_member_,
+                            false,
+                            common::errors::Unavailable(
+                                "Unexpected end of the gzip stream."));
+          finished_ = true;
+          break;
+        }
+        zstream_.next_in = reinterpret_cast<Bytef*>(data);
+        zstream_.avail_in = static_cast<uInt>(len);
+        continue;
+      }
+      int ret = inflate(&zstream_, Z_NO_FLUSH);
+      if (ret == Z_STREAM_END) {
+        // the next gzip member, if any, starts right after this one
+        in_member_ = false;
+        ++member_num_;
+        inflateReset(&zstream_);
+        continue;
+      }
+      if (ret == Z_DATA_ERROR && !in_member_ && member_num_ > 0) {
+        LOG(WARNING) << "Trailing garbage after the gzip stream is ignored.";
+        finished_ = true;
+        break;
+      }
+      PADDLE_ENFORCE_EQ(
+          ret == Z_OK || ret == Z_BUF_ERROR,
+          true,
+          common::errors::InvalidArgument(
+              "Failed to inflate the gzip stream, zlib error %d.", ret));
+      in_member_ = true;
+    }
+    return size - zstream_.avail_out;
+  }
+
+ private:
+  std::unique_ptr<ReadStream> compressed_;
+  z_stream zstream_;
+  // inside a gzip member that has not been fully decompressed
+  bool in_member_ = false;
+  size_t member_num_ = 0;
+  bool finished_ = false;
+};
+
+std::unique_ptr<ReadSource> MakeGzipReadSource(
+    std::unique_ptr<ReadStream> compressed) {
+  return std::make_unique<GzipReadSource>(std::move(compressed));
+}
+
+#if defined(_WIN32) || defined(__APPLE__) || defined(PADDLE_ARM)
+std::shared_ptr<FILE> ReadStreamToFILE(std::unique_ptr<ReadStream> stream) {
+  return nullptr;
+}
+#else
+namespace {
+
+struct ReadStreamCookie {
+  std::unique_ptr<ReadStream> stream;
+  char* data = nullptr;
+  size_t size = 0;
+};
+
+ssize_t ReadStreamCookieRead(void* cookie, char* buf, size_t size) {
+  auto* c = static_cast<ReadStreamCookie*>(cookie);
+  try {
+    while (c->size == 0) {
+      if (!c->stream->Next(&c->data, &c->size)) {
+        return 0;
+      }
+    }
+  } catch (std::exception& e) {
+    // exceptions must not unwind through stdio
+    LOG(ERROR) << "Failed to read stream: " << e.what();
+    errno = EIO;
+    return -1;
+  }
+  size_t n = std::min(size, c->size);
+  memcpy(buf, c->data, n);
+  c->data += n;
+  c->size -= n;
+  return static_cast<ssize_t>(n);
+}
+
+int ReadStreamCookieClose(void* cookie) {
+  delete static_cast<ReadStreamCookie*>(cookie);
+  return 0;
+}
+
+}  // namespace
+
+std::shared_ptr<FILE> ReadStreamToFILE(std::unique_ptr<ReadStream> stream) {
+  if (stream == nullptr) {
+    return nullptr;
+  }
+  auto* cookie = new ReadStreamCookie;
+  cookie->stream = std::move(stream);
+  cookie_io_functions_t funcs = {};
+  funcs.read = ReadStreamCookieRead;
+  funcs.close = ReadStreamCookieClose;
+  FILE* fp = fopencookie(cookie, "r", funcs);
+  if (fp == nullptr) {
+    delete cookie;
+    PADDLE_THROW(
+        common::errors::Unavailable("Failed to wrap the stream into FILE."));
+  }
+  return {fp, [](FILE* fp) { fclose(fp); }};
+}
+#endif
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,80 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdio.h>
+
+#include <memory>
+#include <string>
+
+namespace paddle {
+namespace framework {
+
+struct ReadStreamOptions {
+  // bytes of every read-ahead buffer, rounded up to the page size
+  size_t buffer_size = 4 << 20;
+  // buffers in flight between the reader thread and the consumer
+  int buffer_num = 4;
+  // open local files with O_DIRECT, bypassing the page cache
+  bool direct_io = false;
+  // tell the kernel local files are read sequentially
+  bool fadvise = true;
+};
+
+// Sequential reader that hands out spans of its own buffers, so callers can
+// parse the data in place instead of copying it out. A span stays valid, and
+// may be modified, until the next call of Next().
+class ReadStream {
+ public:
+  virtual ~ReadStream() {}
+  // Returns false at the end of the stream. Errors are thrown.
+  virtual bool Next(char** data, size_t* size) = 0;
+};
+
+// Producer of a read-ahead stream, called on the stream's reader thread.
+class ReadSource {
+ public:
+  virtual ~ReadSource() {}
+  // Fills up to `size` bytes of `buf` and returns the number of bytes filled,
+  // less than `size` only at the end of the data.
+  virtual size_t Read(char* buf, size_t size) = 0;
+};
+
+// Runs `source` on a background thread that fills options.buffer_num page
+// aligned buffers ahead of the consumer.
+extern std::unique_ptr<ReadStream> MakeReadAheadStream(
+    std::unique_ptr<ReadSource> source, const ReadStreamOptions& options);
+
+// Reads a local file with read(2), optionally with O_DIRECT and
+// posix_fadvise.
+extern std::unique_ptr<ReadSource> MakeFileReadSource(
+    const std::string& path, const ReadStreamOptions& options);
+
+// Reads the file descriptor of `fp`, e.g. a pipe from shell_popen. `fp` is
+// closed when the source is destroyed.
+extern std::unique_ptr<ReadSource> MakePipeReadSource(std::shared_ptr<FILE> fp);
+
+// Inflates gzip or zlib data of `compressed` in process. Concatenated gzip
+// members are decompressed one after another, like zcat does.
+extern std::unique_ptr<ReadSource> MakeGzipReadSource(
+    std::unique_ptr<ReadStream> compressed);
+
+// Wraps a stream into a FILE for the readers built on stdio. Returns nullptr
+// for a null stream and on platforms without fopencookie.
+extern std::shared_ptr<FILE> ReadStreamToFILE(
+    std::unique_ptr<ReadStream> stream);
+
+}  // namespace framework
+}  // namespace paddle
@@ -14,7 +14,9 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/lod_tensor.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 
 #include "paddle/fluid/framework/convert_utils.h"
 #include "paddle/fluid/framework/version.h"
@@ -319,6 +321,170 @@ void DeserializeFromStream(std::istream &is,
       is, static_cast<phi::DenseTensor *>(tensor), dev_ctx);
 }
 
+void SerializeToStreamAligned(std::ostream &os,
+                              const phi::DenseTensor &tensor,
+                              size_t alignment) {
+  // The padding takes 3 bytes at least, the 2 bytes of the tag of the field
+  // and 1 byte of length, and fits a length of 1 byte.
+  PADDLE_ENFORCE_EQ(
+      alignment > 0 && alignment <= 64,
+      true,
+      common::errors::InvalidArgument(
+          "The alignment of the tensor data should be in (0, 64], but "
+          "received %d.",
+          alignment));
+  if (!phi::is_cpu_place(tensor.place()) || !tensor.meta().is_contiguous()) {
+    // written unaligned, and copied when loaded
+    SerializeToStream(os, tensor);
+    return;
+  }
+  {  // the 1st field, uint32_t version for DenseTensor
+    os.write(
+        reinterpret_cast<const char *>(&paddle::framework::kCurTensorVersion),
+        sizeof(paddle::framework::kCurTensorVersion));
+  }
+  {  // the 2nd field, LoD information
+    const auto &lod = tensor.lod();
+    uint64_t size = lod.size();
+    os.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    for (auto &each : lod) {
+      size = each.size() * sizeof(framework::LoD::value_type::value_type);
+      os.write(reinterpret_cast<const char *>(&size), sizeof(size));
+      os.write(reinterpret_cast<const char *>(each.data()),
+               static_cast<std::streamsize>(size));
+    }
+  }
+  {  // the 3rd field, uint32_t version of the tensor
+    constexpr uint32_t version = 0;
+    os.write(reinterpret_cast<const char *>(&version), sizeof(version));
+  }
+  {  // the 4th field, the tensor description padded up to the data
+    proto::VarType::TensorDesc desc;
+    desc.set_data_type(framework::TransToProtoVarType(tensor.dtype()));
+    auto dims = common::vectorize(tensor.dims());
+    auto *pb_dims = desc.mutable_dims();
+    pb_dims->Resize(static_cast<int>(dims.size()), 0);
+    std::copy(dims.begin(), dims.end(), pb_dims->begin());
+    auto out = desc.SerializeAsString();
+
+    auto pos = static_cast<int64_t>(os.tellp());
+    PADDLE_ENFORCE_GE(pos,
+                      0,
+                      common::errors::Unavailable(
+                          "Cannot get the position of the output stream."));
+    size_t data_begin = pos + sizeof(int32_t) + out.size();
+    size_t padding = (alignment - data_begin % alignment) % alignment;
+    while (padding < 3) padding += alignment;
+    // the length-delimited field 1000, which TensorDesc does not have
+    out.push_back(static_cast<char>(0xC2));
+    out.push_back(static_cast<char>(0x3E));
+    out.push_back(static_cast<char>(padding - 3));
+    out.append(padding - 3, '\0');
+
+    int32_t size = static_cast<int32_t>(out.size());
+    os.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    os.write(out.data(), size);
+  }
+  {  // the 5th field, tensor data
+    auto size = static_cast<std::streamsize>(tensor.numel() *
+                                             phi::SizeOf(tensor.dtype()));
+    os.write(static_cast<const char *>(tensor.data()), size);
+  }
+}
+
+bool DeserializeFromMemory(const std::shared_ptr<phi::Allocation> &holder,
+                           size_t *offset,
+                           phi::DenseTensor *tensor,
+                           size_t alignment) {
+  const char *base = static_cast<const char *>(holder->ptr());
+  const size_t total = holder->size();
+  auto check_size = [&](size_t bytes) {
+    PADDLE_ENFORCE_LE(
+        bytes,
+        total - *offset,
+        common::errors::InvalidArgument(
+            "The tensor at offset %d is truncated, the memory has %d bytes.",
+            *offset,
+            total));
+  };
+  auto read = [&](void *dst, size_t bytes) {
+    check_size(bytes);
+    std::memcpy(dst, base + *offset, bytes);
+    *offset += bytes;
+  };
+
+  {  // the 1st field, uint32_t version for DenseTensor
+    uint32_t version = 0;
+    read(&version, sizeof(version));
+    PADDLE_ENFORCE_EQ(
+        version,
+        0U,
+        common::errors::InvalidArgument(
+            "Deserialize to tensor failed, maybe the loaded file is "
+            "not a paddle model(expected file format: 0, but %u found).",
+            version));
+  }
+  {  // the 2nd field, LoD information
+    uint64_t lod_level = 0;
+    read(&lod_level, sizeof(lod_level));
+    auto &lod = *tensor->mutable_lod();
+    lod.resize(lod_level);
+    for (uint64_t i = 0; i < lod_level; ++i) {
+      uint64_t size = 0;
+      read(&size, sizeof(size));
+      std::vector<size_t> tmp(size / sizeof(size_t));
+      read(tmp.data(), size);
+      lod[i] = tmp;
+    }
+  }
+  {  // the 3rd field, uint32_t version of the tensor
+    uint32_t version = 0;
+    read(&version, sizeof(version));
+    PADDLE_ENFORCE_EQ(
+        version,
+        0U,
+        common::errors::InvalidArgument(
+            "tensor version %u is not supported, Only version 0 is supported.",
+            version));
+  }
+  proto::VarType::TensorDesc desc;
+  {  // the 4th field, tensor description
+    int32_t size = 0;
+    read(&size, sizeof(size));
+    PADDLE_ENFORCE_GE(size,
+                      0,
+                      common::errors::InvalidArgument(
+                          "phi::DenseTensor desc size should >= 0"));
+    check_size(size);
+    PADDLE_ENFORCE_EQ(
+        desc.ParseFromArray(base + *offset, size),
+        true,
+        common::errors::InvalidArgument("Cannot parse tensor desc"));
+    *offset += size;
+  }
+  // the 5th field, tensor data
+  std::vector<int64_t> dims(desc.dims().begin(), desc.dims().end());
+  tensor->Resize(common::make_ddim(dims));
+  auto dtype = framework::TransToPhiDataType(desc.data_type());
+  size_t size = tensor->numel() * phi::SizeOf(dtype);
+  check_size(size);
+  const char *data = base + *offset;
+  *offset += size;
+  bool shared = reinterpret_cast<uintptr_t>(data) % alignment == 0;
+  if (shared) {
+    // a view of the bytes of the tensor, which keeps the memory alive
+    std::shared_ptr<phi::Allocation> view(
+        new phi::Allocation(const_cast<char *>(data), size, holder->place()),
+        [holder](phi::Allocation *allocation) { delete allocation; });
+    tensor->clear();
+    tensor->ResetHolderWithType(view, dtype);
+  } else {
+    void *dst = tensor->mutable_data(phi::CPUPlace(), dtype);
+    std::memcpy(dst, data, size);
+  }
+  return shared;
+}
+
 LoD ConvertToOffsetBasedLoD(const LoD &length_lod) {
   LoD offset_lod;
   offset_lod.reserve(length_lod.size());
@@ -190,5 +190,26 @@ void SerializeToStream(std::ostream& os, const phi::DenseTensor& tensor);
 
 void DeserializeFromStream(std::istream& os, phi::DenseTensor* tensor);
 
+/*
+ * SerializeToStream with the data of the tensor at a multiple of alignment
+ * from the beginning of os, so that a mapping of the file can be used as the
+ * memory of the tensor. The padding is an unknown field of the tensor
+ * description, so DeserializeFromStream and load_combine still read it.
+ */
+void SerializeToStreamAligned(std::ostream& os,
+                              const phi::DenseTensor& tensor,
+                              size_t alignment);
+
+/*
+ * Deserialize the phi::DenseTensor at *offset of the memory of holder and
+ * move *offset past it. The tensor shares the memory when its data is
+ * aligned to alignment, and copies the data otherwise. Returns whether the
+ * memory is shared.
+ */
+bool DeserializeFromMemory(const std::shared_ptr<phi::Allocation>& holder,
+                           size_t* offset,
+                           phi::DenseTensor* tensor,
+                           size_t alignment);
+
 }  // namespace framework
 }  // namespace paddle
@@ -0,0 +1,216 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>
+#include <utility>
+
+namespace paddle {
+namespace framework {
+
+// Bounded multi-producer multi-consumer queue. Every slot carries a sequence
+// number telling which lap of the ring it is free (seq == pos) or filled
+// (seq == pos + 1) for, so producers and consumers only contend on one CAS of
+// the tail or the head. Batched operations claim a run of consecutive slots
+// with a single CAS.
+template <class T>
+class MPMCRingBuffer {
+ public:
+  // capacity is rounded up to a power of two
+  explicit MPMCRingBuffer(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    mask_ = size - 1;
+    slots_.reset(new Slot[size]);
+    for (size_t i = 0; i < size; ++i) {
+      slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MPMCRingBuffer(const MPMCRingBuffer&) = delete;
+  MPMCRingBuffer& operator=(const MPMCRingBuffer&) = delete;
+
+  size_t Capacity() const { return mask_ + 1; }
+
+  // approximate, includes slots claimed by producers but not yet published
+  size_t Size() const {
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    return tail - head;
+  }
+
+  // Pushes up to n elements assigned from `first`, returns the number pushed.
+  // Returns 0 only if the ring is full.
+  template <class Iter>
+  size_t TryPushBatch(Iter first, size_t n) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    size_t claimed = 0;
+    while (true) {
+      claimed = 0;
+      bool stale = false;
+      while (claimed < n) {
+        Slot& slot = slots_[(pos + claimed) & mask_];
+        intptr_t diff =
+            static_cast<intptr_t>(slot.seq.load(std::memory_order_acquire)) -
+            static_cast<intptr_t>(pos + claimed);
+        if (diff != 0) {
+          // a positive diff on the first slot means pos is out of date
+          stale = (claimed == 0 && diff > 0);
+          break;
+        }
+        ++claimed;
+      }
+      if (claimed == 0) {
+        if (!stale) {
+          return 0;
+        }
+        pos = tail_.load(std::memory_order_relaxed);
+        continue;
+      }
+      if (tail_.compare_exchange_weak(
+              pos, pos + claimed, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    for (size_t i = 0; i < claimed; ++i, ++first) {
+      Slot& slot = slots_[(pos + i) & mask_];
+      slot.value = *first;
+      slot.seq.store(pos + i + 1, std::memory_order_release);
+    }
+    return claimed;
+  }
+
+  // Pops up to n elements into `out`, returns the number popped. Returns 0
+  // only if no published element is available.
+  size_t TryPopBatch(T* out, size_t n) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    size_t claimed = 0;
+    while (true) {
+      claimed = 0;
+      bool stale = false;
+      while (claimed < n) {
+        Slot& slot = slots_[(pos + claimed) & mask_];
+        intptr_t diff =
+            static_cast<intptr_t>(slot.seq.load(std::memory_order_acquire)) -
+            static_cast<intptr_t>(pos + claimed + 1);
+        if (diff != 0) {
+          stale = (claimed == 0 && diff > 0);
+          break;
+        }
+        ++claimed;
+      }
+      if (claimed == 0) {
+        if (!stale) {
+          return 0;
+        }
+        pos = head_.load(std::memory_order_relaxed);
+        continue;
+      }
+      if (head_.compare_exchange_weak(
+              pos, pos + claimed, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    for (size_t i = 0; i < claimed; ++i) {
+      Slot& slot = slots_[(pos + i) & mask_];
+      out[i] = std::move(slot.value);
+      slot.seq.store(pos + i + mask_ + 1, std::memory_order_release);
+    }
+    return claimed;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> seq;
+    T value;
+  };
+
+  static constexpr size_t kCacheLineSize = 64;
+
+  alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+  alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+  alignas(kCacheLineSize) size_t mask_ = 0;
+  std::unique_ptr<Slot[]> slots_;
+};
+
+// Waits for a condition by spinning first and parking on a condition
+// variable only if it does not come true soon. Notify() is cheap when nobody
+// is parked: one fence and one load.
+class SpinParker {
+ public:
+  template <class Pred>
+  void Wait(Pred pred) {
+    // spinning only burns the time slice of the thread we wait for if there
+    // is a single core
+    static const int spin_count =
+        std::thread::hardware_concurrency() > 1 ? kSpinCount : 0;
+    for (int i = 0; i < spin_count; ++i) {
+      if (pred()) {
+        return;
+      }
+      CpuRelax();
+    }
+    for (int i = 0; i < kYieldCount; ++i) {
+      if (pred()) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    // pairs with the fence in Notify(), so either the waiter sees the new
+    // state or the notifier sees the waiter
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!pred()) {
+      cond_.wait(lock);
+    }
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  void Notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cond_.notify_all();
+    }
+  }
+
+ private:
+  static constexpr int kSpinCount = 128;
+  static constexpr int kYieldCount = 16;
+
+  static void CpuRelax() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_ia32_pause();
+#elif defined(__GNUC__) && defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+  }
+
+  std::atomic<int> waiters_{0};
+  std::mutex mutex_;
+  std::condition_variable cond_;
+};
+
+}  // namespace framework
+}  // namespace paddle
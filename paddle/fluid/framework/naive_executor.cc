@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/framework/naive_executor.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -23,6 +24,7 @@
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/framework/variable_helper.h"
 #include "paddle/fluid/platform/denormal.h"
+#include "paddle/phi/core/memory/malloc.h"
 #ifdef PADDLE_WITH_DNNL
 #include "paddle/fluid/platform/onednn_helper.h"
 #endif
@@ -95,6 +97,10 @@ void NaiveExecutor::Run() {
   platform::RegisterModelLayout(ops_, place_);
 #endif
   platform::ScopedFlushDenormal flush;
+  // A run with new input shapes shares the buffers by the reuse plan and
+  // records the arena of these shapes.
+  const bool arena_bound = !arena_tensors_.empty() && BindArena();
+  const bool record_arena = !arena_tensors_.empty() && !arena_bound;
 #ifdef PADDLE_WITH_NVTX
   platform::CudaNvtxRangePush("model", platform::NvtxRangeColor::Yellow);
 #endif
@@ -122,7 +128,7 @@ void NaiveExecutor::Run() {
 #endif
 
     // Update the shared_holder so that only records the max one.
-    if (reuse_cache_.count(op.get())) {
+    if (!arena_bound && reuse_cache_.count(op.get())) {
       for (auto &it : reuse_cache_[op.get()]) {
         if (it.first->memory_size() >
             cluster_buffer_[it.second]->memory_size()) {
@@ -154,6 +160,9 @@ void NaiveExecutor::Run() {
 #ifdef PADDLE_WITH_NVTX
   platform::CudaNvtxRangePop();
 #endif
+  if (record_arena) {
+    BuildArena();
+  }
 }
 
 void NaiveExecutor::CreateVariables(const ProgramDesc &desc,
@@ -291,6 +300,176 @@ void NaiveExecutor::MakeReusePlan(
   }
 }
 
+void NaiveExecutor::MakeStaticMemoryPlan(const StaticMemoryPlan &plan) {
+  std::unordered_set<std::string> planned;
+  for (auto &block : plan.blocks) {
+    planned.insert(block.name);
+  }
+
+  // The lifetimes are taken again in the order of ops_, which needs not be
+  // the topological order the plan was made in.
+  std::unordered_map<std::string, size_t> index;
+  std::unordered_set<std::string> written, inputs;
+  auto use = [&](const std::string &name, int op_idx) {
+    if (!planned.count(name) || inputs.count(name)) return;
+    auto it = index.find(name);
+    if (it != index.end()) {
+      arena_lifetimes_[it->second].second = op_idx;
+      return;
+    }
+    auto *var = scope_->FindVar(name);
+    if (!var || !var->IsType<phi::DenseTensor>()) return;
+    index.emplace(name, arena_tensors_.size());
+    arena_names_.push_back(name);
+    arena_tensors_.push_back(var->GetMutable<phi::DenseTensor>());
+    arena_lifetimes_.emplace_back(op_idx, op_idx);
+  };
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    int op_idx = static_cast<int>(i);
+    for (auto &name : ops_[i]->InputVars()) {
+      if (!written.count(name) && !index.count(name) &&
+          inputs.insert(name).second) {
+        auto *var = scope_->FindLocalVar(name);
+        if (var && var->IsType<phi::DenseTensor>()) {
+          arena_inputs_.push_back(var->GetMutable<phi::DenseTensor>());
+        }
+      }
+      use(name, op_idx);
+    }
+    for (auto &name : ops_[i]->OutputVars(true)) {
+      written.insert(name);
+      use(name, op_idx);
+    }
+  }
+  VLOG(3) << "Static memory plan binds " << arena_tensors_.size() << " of "
+          << plan.blocks.size() << " planned tensors, selected by the shapes "
+          << "of " << arena_inputs_.size() << " inputs";
+}
+
+bool NaiveExecutor::BindArena() {
+  arena_key_.clear();
+  for (auto *input : arena_inputs_) {
+    arena_key_ += input->dims().to_str();
+    arena_key_ += ';';
+  }
+  ++arena_run_;
+  auto it = arenas_.find(arena_key_);
+  if (it == arenas_.end()) {
+    // The tensors are allocated again to record the sizes of these shapes.
+    for (auto *tensor : arena_tensors_) {
+      tensor->clear();
+    }
+    return false;
+  }
+  it->second.last_run = arena_run_;
+  // A tensor is bound again when an operator reallocated it in the last run,
+  // or when the last run had other input shapes.
+  const auto &holders = it->second.holders;
+  int num_bound = 0;
+  for (size_t i = 0; i < arena_tensors_.size(); ++i) {
+    auto *tensor = arena_tensors_[i];
+    if (holders[i] && tensor->Holder() != holders[i]) {
+      tensor->clear();
+      tensor->ResetHolder(holders[i]);
+      ++num_bound;
+    }
+  }
+  VLOG(4) << num_bound << " tensors are bound to the arena again";
+  return true;
+}
+
+void NaiveExecutor::BuildArena() {
+  // Keep the arenas of a few input shapes only, the least recently used one
+  // is dropped for a new shape.
+  constexpr size_t kMaxArenas = 8;
+  if (arenas_.size() >= kMaxArenas) {
+    auto lru = arenas_.begin();
+    for (auto it = arenas_.begin(); it != arenas_.end(); ++it) {
+      if (it->second.last_run < lru->second.last_run) {
+        lru = it;
+      }
+    }
+    VLOG(3) << "Drop the static memory arena of input shapes [" << lru->first
+            << "]";
+    arenas_.erase(lru);
+  }
+
+  // A tensor which shares its buffer with a tensor out of the plan, e.g. an
+  // output of the model, has to outlive its own lifetime, so it is left to
+  // the allocator.
+  std::unordered_set<phi::Allocation *> unplanned;
+  std::unordered_set<std::string> names(arena_names_.begin(),
+                                        arena_names_.end());
+  for (auto &op : ops_) {
+    for (auto &name : op->OutputVars(true)) {
+      if (names.count(name)) continue;
+      auto *var = scope_->FindVar(name);
+      if (var && var->IsType<phi::DenseTensor>()) {
+        unplanned.insert(var->Get<phi::DenseTensor>().Holder().get());
+      }
+    }
+  }
+
+  // The tensors which share a buffer after the run, by the reuse plan or by
+  // an inplace operator, are placed as one block living as long as all of
+  // them.
+  std::vector<MemoryBlock> blocks;
+  std::vector<int> block_of_tensor(arena_tensors_.size(), -1);
+  std::unordered_map<phi::Allocation *, int> block_of_holder;
+  size_t total_size = 0;
+  for (size_t i = 0; i < arena_tensors_.size(); ++i) {
+    auto *holder = arena_tensors_[i]->Holder().get();
+    if (!holder || holder->size() == 0 || unplanned.count(holder) ||
+        holder->place() != place_) {
+      continue;
+    }
+    auto it = block_of_holder.find(holder);
+    if (it == block_of_holder.end()) {
+      it = block_of_holder.emplace(holder, static_cast<int>(blocks.size()))
+               .first;
+      MemoryBlock block;
+      block.name = arena_names_[i];
+      block.size = holder->size();
+      block.lifetime = arena_lifetimes_[i];
+      blocks.push_back(block);
+      total_size += block.size;
+    } else {
+      auto &lifetime = blocks[it->second].lifetime;
+      lifetime.first = std::min(lifetime.first, arena_lifetimes_[i].first);
+      lifetime.second = std::max(lifetime.second, arena_lifetimes_[i].second);
+    }
+    block_of_tensor[i] = it->second;
+  }
+
+  Arena arena;
+  arena.size = AssignMemoryOffsets(&blocks);
+  arena.last_run = arena_run_;
+  // The holders keep the arena alive, as the tensors may outlive the
+  // executor.
+  std::shared_ptr<phi::Allocation> buffer =
+      memory::AllocShared(place_, arena.size);
+  std::vector<std::shared_ptr<phi::Allocation>> block_holders;
+  for (auto &block : blocks) {
+    block_holders.emplace_back(
+        new phi::Allocation(static_cast<uint8_t *>(buffer->ptr()) +
+                                block.offset,
+                            block.size,
+                            place_),
+        [buffer](phi::Allocation *allocation) { delete allocation; });
+  }
+  arena.holders.resize(arena_tensors_.size());
+  for (size_t i = 0; i < arena_tensors_.size(); ++i) {
+    if (block_of_tensor[i] >= 0) {
+      arena.holders[i] = block_holders[block_of_tensor[i]];
+    }
+  }
+  LOG(INFO) << "Static memory plan for input shapes [" << arena_key_
+            << "]: " << blocks.size() << " tensors in an arena of "
+            << (static_cast<double>(arena.size) / (1 << 20)) << "MB instead of "
+            << (static_cast<double>(total_size) / (1 << 20)) << "MB";
+  arenas_.emplace(arena_key_, std::move(arena));
+}
+
 NaiveExecutor::~NaiveExecutor() {
 #ifdef PADDLE_WITH_DNNL
   // Clear mkl-dnn cache,
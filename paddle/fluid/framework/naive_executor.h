@@ -18,11 +18,13 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/static_memory_plan.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/phi/common/place.h"
 
@@ -93,6 +95,14 @@ class NaiveExecutor {
   void MakeReusePlan(
       const std::unordered_map<std::string, std::string>& reuse_table);
 
+  // Place the tensors of the plan in one arena for each shape of the inputs.
+  // The first run with new input shapes allocates the tensors as usual, with
+  // the reuse plan if any, and records their sizes, then the arena of these
+  // sizes is allocated and the later runs with the same shapes bind the
+  // tensors to their offsets in it without calling the allocator. The arenas
+  // of the 8 most recently used shapes are kept.
+  void MakeStaticMemoryPlan(const StaticMemoryPlan& plan);
+
   void ResetTrtOps(int num);
 
   void RegisterOutputHook(const HookFunc& hookfunc);
@@ -103,6 +113,11 @@ class NaiveExecutor {
  private:
   void CreateOps(const ProgramDesc& desc, int block_id);
 
+  // Returns whether the tensors are bound to the arena of the input shapes,
+  // otherwise the run records the sizes of a new arena.
+  bool BindArena();
+  void BuildArena();
+
  private:
   const phi::Place place_;
   // Catch the required resource to avoid recreate.
@@ -120,6 +135,23 @@ class NaiveExecutor {
       reuse_cache_;
   std::vector<phi::DenseTensor*> cluster_buffer_;
 
+  // The tensors of the static memory plan, with their lifetimes in ops_.
+  std::vector<std::string> arena_names_;
+  std::vector<phi::DenseTensor*> arena_tensors_;
+  std::vector<std::pair<int, int>> arena_lifetimes_;
+  // The tensors read before they are written, whose shapes select the arena.
+  std::vector<phi::DenseTensor*> arena_inputs_;
+  struct Arena {
+    size_t size{0};
+    // the holder of each tensor in arena_tensors_, or nullptr
+    std::vector<std::shared_ptr<phi::Allocation>> holders;
+    // the last run binding or recording the arena, for the eviction
+    uint64_t last_run{0};
+  };
+  std::unordered_map<std::string, Arena> arenas_;
+  std::string arena_key_;
+  uint64_t arena_run_{0};
+
   std::unique_ptr<framework::InterpreterCore> interpreter_core_;
 };
 
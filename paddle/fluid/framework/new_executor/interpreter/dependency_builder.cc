@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/framework/new_executor/interpreter/dependency_builder.h"
 
+#include <algorithm>
 #include <queue>
 #include <sstream>
 #include <stack>
@@ -156,6 +157,48 @@ const std::map<size_t, std::set<size_t>>& DependencyBuilder::OpDownstreamMap()
   return *op_downstream_map_;
 }
 
+std::vector<size_t> DependencyBuilder::CriticalPathLength() const {
+  const std::map<size_t, std::set<size_t>>& downstream_map = OpDownstreamMap();
+  // topological order by Kahn's algorithm, the downstream map does not have
+  // to follow the op order
+  std::vector<size_t> upstream_num(op_num_, 0);
+  for (auto& item : downstream_map) {
+    for (size_t next_op : item.second) {
+      ++upstream_num[next_op];
+    }
+  }
+  std::vector<size_t> order;
+  order.reserve(op_num_);
+  for (size_t op_idx = 0; op_idx < op_num_; ++op_idx) {
+    if (upstream_num[op_idx] == 0) {
+      order.push_back(op_idx);
+    }
+  }
+  for (size_t i = 0; i < order.size(); ++i) {
+    auto iter = downstream_map.find(order[i]);
+    if (iter == downstream_map.end()) {
+      continue;
+    }
+    for (size_t next_op : iter->second) {
+      if (--upstream_num[next_op] == 0) {
+        order.push_back(next_op);
+      }
+    }
+  }
+
+  std::vector<size_t> length(op_num_, 1);
+  for (auto op_iter = order.rbegin(); op_iter != order.rend(); ++op_iter) {
+    auto iter = downstream_map.find(*op_iter);
+    if (iter == downstream_map.end()) {
+      continue;
+    }
+    for (size_t next_op : iter->second) {
+      length[*op_iter] = std::max(length[*op_iter], length[next_op] + 1);
+    }
+  }
+  return length;
+}
+
 void DependencyBuilder::AddDependencyForCoalesceTensorOp() {
   for (size_t op_idx = 0; op_idx < op_num_; ++op_idx) {
     if (instructions_->at(op_idx).OpBaseValid() &&
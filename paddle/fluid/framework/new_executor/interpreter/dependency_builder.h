@@ -48,6 +48,11 @@ class DependencyBuilder {
 
   const std::map<size_t, std::set<size_t>>& OpDownstreamMap() const;
 
+  // The number of ops on the longest path from every op to the end of the
+  // program, the op included. Ops on the critical path have the largest
+  // values.
+  std::vector<size_t> CriticalPathLength() const;
+
   bool OpHappensBefore(size_t prior_op_idx, size_t posterior_op_idx) const {
     PADDLE_ENFORCE_GE(
         op_happens_before_->size(),
@@ -52,6 +52,7 @@ COMMON_DECLARE_bool(use_mkldnn);
 COMMON_DECLARE_bool(check_nan_inf);
 COMMON_DECLARE_string(static_runtime_data_save_path);
 COMMON_DECLARE_bool(save_static_runtime_data);
+COMMON_DECLARE_bool(new_executor_critical_path_scheduling);
 
 namespace paddle::framework::interpreter {
 
@@ -100,6 +101,8 @@ const std::vector<WorkQueueOptions> ConstructWorkQueueOptions(
                              /*track_task*/ false,
                              /*detached*/ true,
                              /*events_waiter*/ waiter);
+  group_options.back().bind_numa_node =
+      FLAGS_new_executor_critical_path_scheduling;
   // for launch device Kernel
   group_options.emplace_back(/*name*/ "DeviceKernelLaunch",
                              /*num_threads*/ device_num_threads,
@@ -34,6 +34,12 @@ PHI_DEFINE_EXPORTED_bool(new_executor_use_local_scope,
                          true,
                          "Use local_scope in new executor(especially used "
                          "in UT), can turn off for better performance");
+PHI_DEFINE_EXPORTED_bool(
+    new_executor_critical_path_scheduling,
+    false,
+    "Schedule the instructions of PirInterpreter by the longest remaining "
+    "path, keep the most critical successor on the worker that finished its "
+    "producer, and bind the host workers to NUMA nodes.");
 
 namespace paddle::framework {
 
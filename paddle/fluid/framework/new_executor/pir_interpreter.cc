@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/framework/new_executor/pir_interpreter.h"
 
+#include <algorithm>
 #include <chrono>
 #include <unordered_set>
 
@@ -187,6 +188,10 @@ PirInterpreter::PirInterpreter(const phi::Place& place,
     SchedulingPriority rhs_scheduling_priority =
         vec_instruction_base_[rhs]->GetSchedulingPriority();
     if (lhs_scheduling_priority == rhs_scheduling_priority) {
+      if (!critical_path_length_.empty() &&
+          critical_path_length_[lhs] != critical_path_length_[rhs]) {
+        return critical_path_length_[lhs] < critical_path_length_[rhs];
+      }
       return lhs > rhs;
     }
     return lhs_scheduling_priority > rhs_scheduling_priority;
@@ -278,6 +283,10 @@ PirInterpreter::PirInterpreter(
     SchedulingPriority rhs_scheduling_priority =
         vec_instruction_base_[rhs]->GetSchedulingPriority();
     if (lhs_scheduling_priority == rhs_scheduling_priority) {
+      if (!critical_path_length_.empty() &&
+          critical_path_length_[lhs] != critical_path_length_[rhs]) {
+        return critical_path_length_[lhs] < critical_path_length_[rhs];
+      }
       return lhs > rhs;
     }
     return lhs_scheduling_priority > rhs_scheduling_priority;
@@ -1052,6 +1061,9 @@ void PirInterpreter::BuildInstructionDependences() {
     instructions_ptr.push_back(instr.get());
   }
   auto downstream_map = ir_dependency_builder_.Build(instructions_ptr);
+  if (FLAGS_new_executor_critical_path_scheduling) {
+    critical_path_length_ = ir_dependency_builder_.CriticalPathLength();
+  }
 
   for (size_t instr_id = 0; instr_id < instr_num; ++instr_id) {
     InstructionBase* cur_instr = vec_instruction_base_[instr_id].get();
@@ -1719,16 +1731,28 @@ void PirInterpreter::MultiThreadRunInstructionList(
     }
   }
 
+  std::vector<size_t> first_instrs;
   for (size_t i = 0; i < dependency_count_->size(); ++i) {
     if ((*dependency_count_)[i] == 0) {
-      // NOTE(zhiqiu): hot fix for jit input var
-      RecordMemcpyD2H(vec_instr.at(i).get());
-      if (FLAGS_new_executor_serial_run) {
-        RunInstructionBaseAsync(i);
-      } else {
-        async_work_queue_->AddTask(vec_instr.at(i)->KernelType(),
-                                   [this, i] { RunInstructionBaseAsync(i); });
-      }
+      first_instrs.push_back(i);
+    }
+  }
+  if (!critical_path_length_.empty()) {
+    // start the longest paths first
+    std::stable_sort(first_instrs.begin(),
+                     first_instrs.end(),
+                     [this](size_t lhs, size_t rhs) {
+                       return ir_instruction_scheduling_priority_less(rhs, lhs);
+                     });
+  }
+  for (size_t i : first_instrs) {
+    // NOTE(zhiqiu): hot fix for jit input var
+    RecordMemcpyD2H(vec_instr.at(i).get());
+    if (FLAGS_new_executor_serial_run) {
+      RunInstructionBaseAsync(i);
+    } else {
+      async_work_queue_->AddTask(vec_instr.at(i)->KernelType(),
+                                 [this, i] { RunInstructionBaseAsync(i); });
     }
   }
 
@@ -1829,6 +1853,11 @@ void PirInterpreter::RunNextInstructions(InstructionBase* instr,
   phi::RecordEvent record(
       "RunNextInstructions", platform::TracerEventType::UserDefined, 10);
 
+  if (!critical_path_length_.empty()) {
+    RunNextInstructionsByCriticalPath(instr, reserved_next_ops);
+    return;
+  }
+
   auto IsReady = [this](size_t next_id) {
     VLOG(4) << "op_id: " << next_id
             << ", remain deps: " << deps_[next_id]->DynamicDep();
@@ -1850,6 +1879,46 @@ void PirInterpreter::RunNextInstructions(InstructionBase* instr,
   }
 }
 
+void PirInterpreter::RunNextInstructionsByCriticalPath(
+    InstructionBase* instr, SchedulingQueue* reserved_next_ops) {
+  std::vector<size_t> ready_instrs;
+  for (size_t next_instr_id : instr->NextInstrsInDifferenceThread()) {
+    if (deps_[next_instr_id]->CheckAndDecrease()) {
+      ready_instrs.push_back(next_instr_id);
+    }
+  }
+  for (size_t next_instr_id : instr->NextInstrsInSameThread()) {
+    if (deps_[next_instr_id]->CheckAndDecrease()) {
+      reserved_next_ops->push(next_instr_id);
+    }
+  }
+  if (ready_instrs.empty()) {
+    return;
+  }
+
+  std::sort(ready_instrs.begin(),
+            ready_instrs.end(),
+            ir_instruction_scheduling_priority_less);
+  // Keep the most critical successor on this worker while its inputs are
+  // still in the cache, if nothing else is due here.
+  size_t most_critical = ready_instrs.back();
+  bool is_async = instr->KernelType() == OpFuncType::kGpuAsync;
+  if (reserved_next_ops->empty() &&
+      (vec_instruction_base_[most_critical]->KernelType() ==
+       OpFuncType::kGpuAsync) == is_async) {
+    reserved_next_ops->push(most_critical);
+    ready_instrs.pop_back();
+  }
+  // A worker pushes to the front of its own deque and pops from the front,
+  // so the more critical ones, pushed later, run first here. Idle workers
+  // steal from the back.
+  for (size_t next_instr_id : ready_instrs) {
+    async_work_queue_->AddTask(
+        vec_instruction_base_[next_instr_id]->KernelType(),
+        [this, next_instr_id]() { RunInstructionBaseAsync(next_instr_id); });
+  }
+}
+
 void PirInterpreter::RunInstructionBase(InstructionBase* instr_node) {
   phi::RecordEvent instruction_event(
       instr_node->Name(), platform::TracerEventType::Operator, 1);
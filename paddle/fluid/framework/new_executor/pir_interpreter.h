@@ -198,6 +198,11 @@ class PirInterpreter : public InterpreterBaseImpl {
   std::vector<std::shared_ptr<interpreter::OpDepInfo>> deps_;
   std::vector<std::shared_ptr<interpreter::VarRefInfo>> refs_;
 
+  // critical_path_length_[i] is the number of instructions on the longest
+  // path from the i-th instruction to the end, only built for
+  // FLAGS_new_executor_critical_path_scheduling
+  std::vector<size_t> critical_path_length_;
+
   // used for Trace
   int64_t sync_op_num_{-1};
   int64_t nccl_op_num_{-1};
@@ -239,6 +244,9 @@ class PirInterpreter : public InterpreterBaseImpl {
   void RunNextInstructions(InstructionBase* instr,
                            SchedulingQueue* reserved_next_ops);
 
+  void RunNextInstructionsByCriticalPath(InstructionBase* instr,
+                                         SchedulingQueue* reserved_next_ops);
+
   void RunInstructionBase(InstructionBase* instr_node);
 
   void RecordMemcpyD2H(InstructionBase* instr_node);
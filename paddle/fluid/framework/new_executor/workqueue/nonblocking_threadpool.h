@@ -17,6 +17,7 @@
 #include "paddle/fluid/framework/new_executor/workqueue/event_count.h"
 #include "paddle/fluid/framework/new_executor/workqueue/run_queue.h"
 #include "paddle/fluid/framework/new_executor/workqueue/thread_environment.h"
+#include "paddle/fluid/framework/new_executor/workqueue/workqueue_utils.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
 #include "paddle/phi/core/os_info.h"
 
@@ -33,6 +34,7 @@ class ThreadPoolTempl {
                   int num_threads,
                   bool allow_spinning,
                   bool always_spinning,
+                  bool bind_numa_node = false,
                   Environment env = Environment())
       : env_(env),
         allow_spinning_(allow_spinning),
@@ -60,6 +62,11 @@ class ThreadPoolTempl {
     }
     for (int i = 0; i < num_threads_; i++) {
       SetStealPartition(i, EncodePartition(0, num_threads_));
+    }
+    if (bind_numa_node) {
+      AssignNumaNodes();
+    }
+    for (int i = 0; i < num_threads_; i++) {
       thread_data_[i].thread.reset(
           env_.CreateThread([this, i]() { WorkerLoop(i); }));
     }
@@ -216,6 +223,25 @@ class ThreadPoolTempl {
     }
   }
 
+  // Splits the threads into contiguous ranges, one per NUMA node, which are
+  // also the local steal partitions.
+  void AssignNumaNodes() {
+    size_t num_nodes = NumaNodeCpus().size();
+    if (num_nodes <= 1) {
+      return;
+    }
+    size_t num_threads = static_cast<size_t>(num_threads_);
+    numa_node_.resize(num_threads);
+    for (size_t node = 0; node < num_nodes; ++node) {
+      unsigned start = node * num_threads / num_nodes;
+      unsigned limit = (node + 1) * num_threads / num_nodes;
+      for (unsigned i = start; i < limit; ++i) {
+        numa_node_[i] = node;
+        SetStealPartition(i, EncodePartition(start, limit));
+      }
+    }
+  }
+
   typedef typename Environment::EnvThread Thread;
 
   struct PerThread {
@@ -244,12 +270,17 @@ class ThreadPoolTempl {
   const int num_threads_;
   std::vector<ThreadData> thread_data_;
   std::string name_;
+  // NUMA node of every thread, empty if the threads are not bound
+  std::vector<size_t> numa_node_;
 
   // Main worker thread loop.
   void WorkerLoop(int thread_id) {
     std::string thr_name = name_ + "_thread_" + std::to_string(thread_id);
     VLOG(1) << thr_name << " started ";
     phi::SetCurrentThreadName(thr_name);
+    if (!numa_node_.empty()) {
+      BindCurrentThreadToNumaNode(numa_node_[thread_id]);
+    }
     PerThread* pt = GetPerThread();
     pt->pool = this;
     pt->rand = GlobalThreadIdHash();
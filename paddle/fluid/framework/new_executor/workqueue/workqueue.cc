@@ -50,7 +50,8 @@ class WorkQueueImpl : public WorkQueue {
     queue_ = new NonblockingThreadPool(options_.name,
                                        static_cast<int>(options_.num_threads),
                                        options_.allow_spinning,
-                                       options_.always_spinning);
+                                       options_.always_spinning,
+                                       options_.bind_numa_node);
   }
 
   ~WorkQueueImpl() override {
@@ -143,7 +144,8 @@ WorkQueueGroupImpl::WorkQueueGroupImpl(
         NonblockingThreadPool(options.name,
                               static_cast<int>(options.num_threads),
                               options.allow_spinning,
-                              options.always_spinning);
+                              options.always_spinning,
+                              options.bind_numa_node);
   }
 }
 
@@ -102,6 +102,9 @@ struct WorkQueueOptions {
   // false and set events_waiter.
   bool detached{true};
   EventsWaiter* events_waiter{nullptr};  // not owned
+  // Split the threads among the NUMA nodes, bind every thread to the CPUs of
+  // its node and let idle threads steal from their own node first.
+  bool bind_numa_node{false};
 };
 
 class WorkQueue {
@@ -16,6 +16,14 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <fstream>
+#include <string>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "glog/logging.h"
 
 namespace paddle::framework {
 
@@ -55,4 +63,99 @@ void AlignedFree(void* mem_ptr) {
 #endif
 }
 
+#ifdef __linux__
+namespace {
+
+constexpr int kMaxNumaNodes = 64;
+
+// Parses a cpulist like "0-3,8-11" of sysfs.
+std::vector<int> ParseCpuList(const std::string& list) {
+  std::vector<int> cpus;
+  size_t pos = 0;
+  while (pos < list.size()) {
+    size_t end = list.find(',', pos);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+    std::string range = list.substr(pos, end - pos);
+    size_t dash = range.find('-');
+    int first = std::atoi(range.c_str());
+    int last = dash == std::string::npos ? first
+                                         : std::atoi(range.c_str() + dash + 1);
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+    pos = end + 1;
+  }
+  return cpus;
+}
+
+std::vector<std::vector<int>> ReadNumaNodeCpus() {
+  cpu_set_t usable;
+  CPU_ZERO(&usable);
+  bool has_mask = sched_getaffinity(0, sizeof(usable), &usable) == 0;
+  std::vector<std::vector<int>> nodes;
+  for (int node = 0; node < kMaxNumaNodes; ++node) {
+    std::ifstream fin("/sys/devices/system/node/node" + std::to_string(node) +
+                      "/cpulist");
+    if (!fin) {
+      continue;
+    }
+    std::string list;
+    std::getline(fin, list);
+    std::vector<int> cpus;
+    for (int cpu : ParseCpuList(list)) {
+      if (cpu < CPU_SETSIZE && (!has_mask || CPU_ISSET(cpu, &usable))) {
+        cpus.push_back(cpu);
+      }
+    }
+    if (!cpus.empty()) {
+      nodes.emplace_back(std::move(cpus));
+    }
+  }
+  if (nodes.empty()) {
+    std::vector<int> cpus;
+    for (int cpu = 0; has_mask && cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &usable)) {
+        cpus.push_back(cpu);
+      }
+    }
+    nodes.emplace_back(std::move(cpus));
+  }
+  return nodes;
+}
+
+}  // namespace
+#endif
+
+const std::vector<std::vector<int>>& NumaNodeCpus() {
+#ifdef __linux__
+  static const std::vector<std::vector<int>> nodes = ReadNumaNodeCpus();
+#else
+  static const std::vector<std::vector<int>> nodes(1);
+#endif
+  return nodes;
+}
+
+bool BindCurrentThreadToNumaNode(size_t node) {
+#ifdef __linux__
+  const auto& nodes = NumaNodeCpus();
+  if (node >= nodes.size() || nodes[node].empty()) {
+    return false;
+  }
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (int cpu : nodes[node]) {
+    CPU_SET(cpu, &mask);
+  }
+  if (sched_setaffinity(0, sizeof(mask), &mask) != 0) {
+    VLOG(1) << "Failed to bind the thread to NUMA node " << node;
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
 }  // namespace paddle::framework
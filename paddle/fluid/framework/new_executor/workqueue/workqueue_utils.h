@@ -21,6 +21,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "paddle/fluid/framework/new_executor/workqueue/events_waiter.h"
 #include "paddle/fluid/platform/enforce.h"
@@ -69,6 +70,14 @@ void* AlignedMalloc(size_t size, size_t alignment);
 
 void AlignedFree(void* memory_ptr);
 
+// CPUs usable by this process on every NUMA node. It is a single node with
+// all usable CPUs if the topology is unknown.
+const std::vector<std::vector<int>>& NumaNodeCpus();
+
+// Binds the calling thread to the CPUs of a node of NumaNodeCpus(), returns
+// false if the platform does not support it.
+bool BindCurrentThreadToNumaNode(size_t node);
+
 template <typename Notifier>
 class TaskTracker {
  public:
@@ -0,0 +1,313 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define PADDLE_SLOT_PARSER_X86
+#include "paddle/phi/backends/cpu/cpu_info.h"
+#endif
+
+namespace paddle {
+namespace framework {
+
+// Tokenizer of one line of the slot text format
+//
+//   <num> <feasign> ... <feasign> <num> <feasign> ...
+//
+// that converts the tokens in place, without copying them out of the line.
+// Digit runs are measured with SSE2 compares and converted eight digits at a
+// time, and unused slots are skipped by counting delimiters 32 bytes at a
+// time with AVX2 (16 with SSE2, scalar on other platforms). Results are the
+// same as strtol/strtoull/strtof: tokens the fast paths do not handle
+// (signs, exponents, overflow, long float mantissas) are handed to them.
+//
+// The line [begin, end) must be followed by a '\0', as std::string::c_str()
+// and LineFileReader provide, because of the strtoull/strtof fallbacks.
+class SlotTextParser {
+ public:
+  SlotTextParser(const char* begin, const char* end)
+      : pos_(begin), end_(end) {}
+
+  const char* pos() const { return pos_; }
+
+  bool Done() {
+    SkipSpaces();
+    return pos_ >= end_;
+  }
+
+  // Parses a decimal count like strtol.
+  int64_t NextInt() {
+    SkipSpaces();
+    bool neg = false;
+    if (pos_ < end_ && (*pos_ == '-' || *pos_ == '+')) {
+      neg = (*pos_ == '-');
+      ++pos_;
+    }
+    size_t digits = DigitRun(pos_);
+    if (digits > 18) {
+      char* endptr = nullptr;
+      int64_t value = strtoll(pos_, &endptr, 10);
+      pos_ = endptr;
+      return neg ? -value : value;
+    }
+    int64_t value = static_cast<int64_t>(DigitsToUint64(pos_, digits));
+    pos_ += digits;
+    return neg ? -value : value;
+  }
+
+  // Parses a decimal feasign like strtoull(str, &end, 10).
+  uint64_t NextUint64() {
+    SkipSpaces();
+    const char* p = pos_;
+    size_t digits = DigitRun(p);
+    if (digits > 0 && digits < 20) {
+      pos_ = p + digits;
+      return DigitsToUint64(p, digits);
+    }
+    if (digits == 20) {
+      // hashed feasigns often use all 20 digits of uint64
+      uint64_t high = DigitsToUint64(p, 19);
+      uint64_t low = static_cast<uint64_t>(p[19] - '0');
+      if (high <= (UINT64_MAX - low) / 10) {
+        pos_ = p + digits;
+        return high * 10 + low;
+      }
+    }
+    char* endptr = nullptr;
+    uint64_t value = strtoull(p, &endptr, 10);
+    pos_ = endptr;
+    return value;
+  }
+
+  // Parses a float like strtof. Decimals whose mantissa fits in 24 bits and
+  // that have at most 10 fraction digits are m / 10^k with both operands
+  // exact in float, so one division gives the correctly rounded result.
+  float NextFloat() {
+    static const float kPow10[] = {1e0f,
+                                   1e1f,
+                                   1e2f,
+                                   1e3f,
+                                   1e4f,
+                                   1e5f,
+                                   1e6f,
+                                   1e7f,
+                                   1e8f,
+                                   1e9f,
+                                   1e10f};
+    SkipSpaces();
+    const char* p = pos_;
+    bool neg = false;
+    if (p < end_ && *p == '-') {
+      neg = true;
+      ++p;
+    }
+    size_t int_digits = DigitRun(p);
+    const char* frac = p + int_digits;
+    size_t frac_digits = 0;
+    const char* stop = frac;
+    if (frac < end_ && *frac == '.') {
+      frac_digits = DigitRun(frac + 1);
+      stop = frac + 1 + frac_digits;
+    }
+    if (int_digits + frac_digits > 0 && int_digits + frac_digits < 20 &&
+        frac_digits <= 10 && (stop == end_ || IsDelimiter(*stop))) {
+      uint64_t mantissa = DigitsToUint64(p, int_digits);
+      for (size_t i = 0; i < frac_digits; ++i) {
+        mantissa = mantissa * 10 + static_cast<uint64_t>(frac[1 + i] - '0');
+      }
+      if (mantissa <= (uint64_t(1) << 24)) {
+        float value = static_cast<float>(mantissa) / kPow10[frac_digits];
+        pos_ = stop;
+        return neg ? -value : value;
+      }
+    }
+    char* endptr = nullptr;
+    float value = strtof(pos_, &endptr);
+    pos_ = endptr;
+    return value;
+  }
+
+  // Returns the next space separated token without converting it.
+  const char* NextToken(size_t* len) {
+    SkipSpaces();
+    const char* begin = pos_;
+    const void* space = memchr(begin, ' ', end_ - begin);
+    pos_ = space == nullptr ? end_ : static_cast<const char*>(space);
+    *len = pos_ - begin;
+    return begin;
+  }
+
+  // Skips `num` space separated tokens, e.g. the feasigns of an unused slot.
+  void SkipTokens(int64_t num) {
+    if (num <= 0) {
+      return;
+    }
+#ifdef PADDLE_SLOT_PARSER_X86
+    static const bool use_avx2 =
+        phi::backends::cpu::MayIUse(phi::backends::cpu::avx2);
+    if (use_avx2) {
+      pos_ = SkipTokensAVX2(pos_, end_, num);
+    } else {
+      pos_ = SkipTokensSSE2(pos_, end_, num);
+    }
+#else
+    pos_ = SkipTokensScalar(pos_, end_, num + 1, true);
+#endif
+  }
+
+ private:
+  static bool IsDelimiter(char c) {
+    return c == ' ' || c == '\0' || (c >= '\t' && c <= '\r');
+  }
+
+  void SkipSpaces() {
+    while (pos_ < end_ && (*pos_ == ' ' || (*pos_ >= '\t' && *pos_ <= '\r'))) {
+      ++pos_;
+    }
+  }
+
+  // Number of consecutive ASCII digits starting at p.
+  size_t DigitRun(const char* p) const {
+    size_t n = 0;
+#ifdef PADDLE_SLOT_PARSER_X86
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    while (p + n + 16 <= end_) {
+      __m128i chunk =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n));
+      // digits are the bytes with an unsigned c - '0' <= 9
+      __m128i value = _mm_sub_epi8(chunk, zero);
+      __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(value, nine), value);
+      uint32_t other = ~static_cast<uint32_t>(_mm_movemask_epi8(is_digit)) &
+                       0xFFFFu;
+      if (other != 0) {
+        return n + __builtin_ctz(other);
+      }
+      n += 16;
+    }
+#endif
+    while (p + n < end_ && static_cast<unsigned char>(p[n] - '0') <= 9) {
+      ++n;
+    }
+    return n;
+  }
+
+  // Converts eight ASCII digits with three multiplications.
+  static uint64_t EightDigitsToUint64(const char* p) {
+    uint64_t value = 0;
+    memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    value = ((value & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+    value = ((value & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+    return ((value & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+  }
+
+  // `n` <= 19 digits starting at p, no overflow check.
+  static uint64_t DigitsToUint64(const char* p, size_t n) {
+    uint64_t value = 0;
+    while (n >= 8) {
+      value = value * 100000000ULL + EightDigitsToUint64(p);
+      p += 8;
+      n -= 8;
+    }
+    while (n > 0) {
+      value = value * 10 + static_cast<uint64_t>(*p++ - '0');
+      --n;
+    }
+    return value;
+  }
+
+  // Returns the position of the `remain`-th token start in [p, end), or end.
+  // A token starts at a non space byte that follows a space, `prev_space`
+  // tells whether the byte before p is one.
+  static const char* SkipTokensScalar(const char* p,
+                                      const char* end,
+                                      int64_t remain,
+                                      bool prev_space) {
+    for (; p < end; ++p) {
+      bool is_space = (*p == ' ');
+      if (!is_space && prev_space && --remain == 0) {
+        return p;
+      }
+      prev_space = is_space;
+    }
+    return end;
+  }
+
+#ifdef PADDLE_SLOT_PARSER_X86
+  // Finds the `remain`-th set bit of a mask with at least `remain` bits.
+  static int NthSetBit(uint32_t mask, int64_t remain) {
+    for (int64_t i = 1; i < remain; ++i) {
+      mask &= mask - 1;
+    }
+    return __builtin_ctz(mask);
+  }
+
+  // Skipping `num` tokens lands on the start of token num + 1.
+  static const char* SkipTokensSSE2(const char* p,
+                                    const char* end,
+                                    int64_t num) {
+    int64_t remain = num + 1;
+    uint32_t prev_space = 1;
+    const __m128i space = _mm_set1_epi8(' ');
+    for (; p + 16 <= end; p += 16) {
+      __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      uint32_t spaces = static_cast<uint32_t>(
+          _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, space)));
+      uint32_t starts = ~spaces & ((spaces << 1) | prev_space) & 0xFFFFu;
+      int64_t count = __builtin_popcount(starts);
+      if (count >= remain) {
+        return p + NthSetBit(starts, remain);
+      }
+      remain -= count;
+      prev_space = spaces >> 15;
+    }
+    return SkipTokensScalar(p, end, remain, prev_space != 0);
+  }
+
+  __attribute__((target("avx2,popcnt"))) static const char* SkipTokensAVX2(
+      const char* p, const char* end, int64_t num) {
+    int64_t remain = num + 1;
+    uint32_t prev_space = 1;
+    const __m256i space = _mm256_set1_epi8(' ');
+    for (; p + 32 <= end; p += 32) {
+      __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+      uint32_t spaces = static_cast<uint32_t>(
+          _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, space)));
+      uint32_t starts = ~spaces & ((spaces << 1) | prev_space);
+      int64_t count = __builtin_popcount(starts);
+      if (count >= remain) {
+        return p + NthSetBit(starts, remain);
+      }
+      remain -= count;
+      prev_space = spaces >> 31;
+    }
+    return SkipTokensScalar(p, end, remain, prev_space != 0);
+  }
+#endif
+
+  const char* pos_;
+  const char* end_;
+};
+
+}  // namespace framework
+}  // namespace paddle
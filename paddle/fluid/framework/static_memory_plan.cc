@@ -0,0 +1,83 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/static_memory_plan.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include "paddle/common/enforce.h"
+
+namespace paddle::framework {
+
+size_t AssignMemoryOffsets(std::vector<MemoryBlock>* blocks,
+                           size_t alignment) {
+  PADDLE_ENFORCE_GT(alignment,
+                    0,
+                    common::errors::InvalidArgument(
+                        "The alignment of a memory plan should be positive."));
+  auto& all = *blocks;
+  std::vector<size_t> order(all.size());
+  std::iota(order.begin(), order.end(), 0);
+  // larger blocks first, and the earlier one on ties to be deterministic
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    if (all[a].size != all[b].size) return all[a].size > all[b].size;
+    return all[a].lifetime < all[b].lifetime;
+  });
+
+  auto aligned = [&](size_t size) {
+    return (size + alignment - 1) / alignment * alignment;
+  };
+  auto overlap = [](const std::pair<int, int>& a,
+                    const std::pair<int, int>& b) {
+    return b.second >= a.first && a.second >= b.first;
+  };
+
+  size_t arena_size = 0;
+  std::vector<size_t> placed;
+  std::vector<size_t> conflicts;
+  for (size_t i : order) {
+    auto& block = all[i];
+    const size_t size = aligned(block.size);
+    conflicts.clear();
+    for (size_t j : placed) {
+      if (overlap(block.lifetime, all[j].lifetime)) conflicts.push_back(j);
+    }
+    std::sort(conflicts.begin(), conflicts.end(), [&](size_t a, size_t b) {
+      return all[a].offset < all[b].offset;
+    });
+
+    size_t best_offset = std::numeric_limits<size_t>::max();
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t end = 0;
+    for (size_t j : conflicts) {
+      if (all[j].offset > end) {
+        size_t gap = all[j].offset - end;
+        if (gap >= size && gap < best_gap) {
+          best_gap = gap;
+          best_offset = end;
+        }
+      }
+      end = std::max(end, all[j].offset + aligned(all[j].size));
+    }
+    block.offset =
+        best_offset == std::numeric_limits<size_t>::max() ? end : best_offset;
+    arena_size = std::max(arena_size, block.offset + size);
+    placed.push_back(i);
+  }
+  return arena_size;
+}
+
+}  // namespace paddle::framework
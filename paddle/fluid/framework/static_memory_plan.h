@@ -0,0 +1,58 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// A tensor to place in the arena. The lifetime is the closed interval of the
+// indices of the operators which use the tensor.
+struct MemoryBlock {
+  std::string name;
+  size_t size{0};
+  std::pair<int, int> lifetime;
+  size_t offset{0};
+};
+
+// The offsets of the intermediate tensors of a program in one arena.
+struct StaticMemoryPlan {
+  std::vector<MemoryBlock> blocks;
+  // the size of the arena, i.e. the peak memory of the tensors
+  size_t arena_size{0};
+  // the sum of the sizes of the tensors, i.e. the memory without reuse
+  size_t total_size{0};
+  // whether some sizes were estimated from shapes with unknown dimensions
+  bool has_dynamic_shape{false};
+};
+
+constexpr size_t kStaticMemoryPlanAlignment = 64;
+
+// Assigns an offset to each block so that the blocks whose lifetimes overlap
+// do not overlap in memory, and returns the size of the arena.
+//
+// The blocks are placed greedily from the largest one. A block goes into the
+// smallest gap between the blocks already placed that conflict with it, or
+// after the last of them when no gap fits. The sizes are rounded up to
+// alignment, so every offset is aligned.
+size_t AssignMemoryOffsets(std::vector<MemoryBlock>* blocks,
+                           size_t alignment = kStaticMemoryPlanAlignment);
+
+}  // namespace framework
+}  // namespace paddle
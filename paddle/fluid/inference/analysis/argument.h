@@ -350,6 +350,10 @@ struct Argument {
 
   // Memory optimized related.
   DECL_ARGUMENT_FIELD(enable_memory_optim, EnableMemoryOptim, bool);
+  // Whether to plan the offsets of the intermediate tensors in one arena.
+  DECL_ARGUMENT_FIELD(static_memory_plan, StaticMemoryPlan, bool);
+  // Whether to load the combined params file by mmap.
+  DECL_ARGUMENT_FIELD(mmap_params, MmapParams, bool);
   DECL_ARGUMENT_FIELD(trt_engine_memory_sharing, TrtEngineMemorySharing, bool);
 
   // Indicate which kind of sort algorithm is used for operators, the memory
@@ -19,6 +19,7 @@
 #include <unordered_map>
 #include <utility>
 #include <vector>
+#include "paddle/fluid/framework/static_memory_plan.h"
 #include "paddle/phi/core/enforce.h"
 #include "paddle/utils/variant.h"
 
@@ -31,7 +32,8 @@ class PassResultInfoForRuntime {
   using PassInfo =
       paddle::variant<std::string,
                       std::vector<std::string>,
-                      std::unordered_map<std::string, std::string>>;
+                      std::unordered_map<std::string, std::string>,
+                      framework::StaticMemoryPlan>;
 
   static PassResultInfoForRuntime* Instance() {
     static PassResultInfoForRuntime info;
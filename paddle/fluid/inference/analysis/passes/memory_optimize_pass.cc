@@ -21,6 +21,7 @@
 
 #include "glog/logging.h"
 #include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/static_memory_plan.h"
 #include "paddle/fluid/inference/analysis/pass_result_info.h"
 #include "paddle/fluid/platform/enforce.h"
 
@@ -123,7 +124,7 @@ void MemoryOptimizePass::CollectLifeCycle(
 }
 
 void MemoryOptimizePass::CollectVarMemorySize(
-    Graph* graph, space_table_t* space_table) const {
+    Graph* graph, space_table_t* space_table, bool* has_dynamic_shape) const {
   const int fake_batch_size = 1;
 
   auto valid_var = [&](framework::ir::Node* node) -> bool {
@@ -183,7 +184,10 @@ void MemoryOptimizePass::CollectVarMemorySize(
       if (node->Var()->Persistable()) continue;
       auto shape = node->Var()->GetShape();
       for (auto& v : shape) {
-        if (v < 0) v = fake_batch_size;
+        if (v < 0) {
+          v = fake_batch_size;
+          if (has_dynamic_shape) *has_dynamic_shape = true;
+        }
       }
 
       int size =
@@ -251,6 +255,26 @@ void MakeSimpleReusePlan(
   }
 }
 
+// Place all the tensors in one arena, see framework::AssignMemoryOffsets.
+framework::StaticMemoryPlan MakeStaticMemoryPlan(
+    const std::unordered_map<std::string, std::pair<int, int>>& lifecycles,
+    const std::unordered_map<std::string, size_t>& space_table) {
+  framework::StaticMemoryPlan plan;
+  for (auto& data : lifecycles) {
+    if (!space_table.count(data.first)) continue;
+    // The feed variables are filled by the predictor.
+    if (data.second.second == std::numeric_limits<int>::max()) continue;
+    framework::MemoryBlock block;
+    block.name = data.first;
+    block.size = space_table.at(data.first);
+    block.lifetime = data.second;
+    plan.total_size += block.size;
+    plan.blocks.push_back(block);
+  }
+  plan.arena_size = framework::AssignMemoryOffsets(&plan.blocks);
+  return plan;
+}
+
 std::string MemoryOptimizePass::repr() const { return "memory_optimize_pass"; }
 
 void MemoryOptimizePass::RunImpl(Argument* argument) {
@@ -276,14 +300,35 @@ void MemoryOptimizePass::RunImpl(Argument* argument) {
   std::unordered_map<std::string, std::string> node2cluster;
   std::unordered_map<std::string, int> cluster_size;
 
+  bool has_dynamic_shape = false;
+
   CollectLifeCycle(graph, &lifecycles, sort_kind);
-  CollectVarMemorySize(graph, &space_table);
+  CollectVarMemorySize(graph, &space_table, &has_dynamic_shape);
   MakeSimpleReusePlan(lifecycles, space_table, &node2cluster, &cluster_size);
 
   auto* pass_res_info = PassResultInfoForRuntime::Instance();
   pass_res_info->Set(
       argument->root_predictor_id(), "memory_optimize_pass", node2cluster);
 
+  if (argument->static_memory_plan_valid() && argument->static_memory_plan()) {
+    auto plan = MakeStaticMemoryPlan(lifecycles, space_table);
+    plan.has_dynamic_shape = has_dynamic_shape;
+    double cluster_bytes = 0;
+    for (auto& cluster : cluster_size) {
+      cluster_bytes += cluster.second;
+    }
+    LOG(INFO) << "Static memory plan of " << plan.blocks.size()
+              << " tensors: arena "
+              << (static_cast<double>(plan.arena_size) / (1 << 20))
+              << "MB, reuse clusters " << (cluster_bytes / (1 << 20))
+              << "MB, without reuse "
+              << (static_cast<double>(plan.total_size) / (1 << 20)) << "MB"
+              << (has_dynamic_shape ? " (batch size 1 for unknown dims)" : "");
+    pass_res_info->Set(argument->root_predictor_id(),
+                       "memory_optimize_pass_static_plan",
+                       plan);
+  }
+
   return;
 }
 
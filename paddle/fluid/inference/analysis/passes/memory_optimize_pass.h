@@ -40,6 +40,10 @@ namespace analysis {
  * current name of var.
  * 3. Perform reuse plan: Replace all var's name in the model according to the
  * mapping table.
+ *
+ * With the static memory plan, the pass also assigns every var an offset in
+ * one arena, see framework::AssignMemoryOffsets, and the executor binds the
+ * vars to the arena instead of allocating them one by one.
  */
 class MemoryOptimizePass : public AnalysisPass {
  public:
@@ -58,7 +62,8 @@ class MemoryOptimizePass : public AnalysisPass {
       int sort_kind) const;
 
   void CollectVarMemorySize(framework::ir::Graph *graph,
-                            space_table_t *space_table) const;
+                            space_table_t *space_table,
+                            bool *has_dynamic_shape = nullptr) const;
 
  public:
   std::string repr() const override;
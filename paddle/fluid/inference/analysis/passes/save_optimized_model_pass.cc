@@ -18,7 +18,9 @@ limitations under the License. */
 #include "paddle/fluid/framework/executor.h"
 #include "paddle/fluid/framework/ir/fuse_pass_base.h"
 #include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/phi/core/memory/allocation/mmap_allocator.h"
 
 namespace paddle::inference::analysis {
 
@@ -66,6 +68,8 @@ void SaveOptimizedModelPass::SaveOptimizedModel(Argument* argument) {
     framework::ProgramDesc save_program;
     auto* save_block = save_program.MutableBlock(0);
     std::unordered_set<std::string> save_var_set;
+    // the parameters loaded by mmap are aligned in the file
+    bool aligned = argument->mmap_params_valid() && argument->mmap_params();
     for (size_t i = 0; i < optimized_program_desc.Size(); ++i) {
       const auto& global_block = optimized_program_desc.Block(i);
       for (framework::VarDesc* var : global_block.AllVars()) {
@@ -77,6 +81,9 @@ void SaveOptimizedModelPass::SaveOptimizedModel(Argument* argument) {
           new_var->SetLoDLevel(var->GetLoDLevel());
           new_var->SetPersistable(true);
           save_var_set.insert(new_var->Name());
+          if (var->GetType() != framework::proto::VarType::LOD_TENSOR) {
+            aligned = false;
+          }
         }
       }
     }
@@ -85,6 +92,29 @@ void SaveOptimizedModelPass::SaveOptimizedModel(Argument* argument) {
     std::vector<std::string> save_var_list(save_var_set.begin(),
                                            save_var_set.end());
     std::sort(save_var_list.begin(), save_var_list.end());
+#ifndef _WIN32
+    if (aligned) {
+      std::ofstream fout(save_params_path, std::ios::binary);
+      PADDLE_ENFORCE_EQ(fout.is_open(),
+                        true,
+                        common::errors::Unavailable(
+                            "Cannot open %s to save variables.",
+                            save_params_path));
+      for (auto& name : save_var_list) {
+        auto* var = scope.FindVar(name);
+        PADDLE_ENFORCE_NOT_NULL(
+            var,
+            common::errors::NotFound(
+                "Variable %s is not found in the scope.", name));
+        framework::SerializeToStreamAligned(
+            fout,
+            var->Get<phi::DenseTensor>(),
+            memory::allocation::mmap_alignment);
+      }
+      fout.close();
+      return;
+    }
+#endif
     auto* op = save_block->AppendOp();
     op->SetType("save_combine");
     op->SetInput("X", save_var_list);
@@ -496,6 +496,8 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(enable_low_precision_io_);
 
   CP_MEMBER(enable_memory_optim_);
+  CP_MEMBER(static_memory_plan_);
+  CP_MEMBER(mmap_params_);
   // TensorRT related.
   CP_MEMBER(use_tensorrt_);
   CP_MEMBER(tensorrt_workspace_size_);
@@ -1138,6 +1140,8 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << trt_dla_core_;
 
   ss << enable_memory_optim_;
+  ss << static_memory_plan_;
+  ss << mmap_params_;
   ss << trt_engine_memory_sharing_;
 
   ss << use_mkldnn_;
@@ -1249,6 +1253,25 @@ bool AnalysisConfig::enable_memory_optim() const {
   return enable_memory_optim_;
 }
 
+void AnalysisConfig::EnableStaticMemoryPlan(bool x) {
+  static_memory_plan_ = x;
+  if (x) enable_memory_optim_ = true;
+  Update();
+}
+
+bool AnalysisConfig::static_memory_plan_enabled() const {
+  return static_memory_plan_;
+}
+
+void AnalysisConfig::EnableMemoryMappedParams(bool x) {
+  mmap_params_ = x;
+  Update();
+}
+
+bool AnalysisConfig::memory_mapped_params_enabled() const {
+  return mmap_params_;
+}
+
 bool AnalysisConfig::trt_engine_memory_sharing() const {
   return trt_engine_memory_sharing_;
 }
@@ -1459,6 +1482,9 @@ std::string AnalysisConfig::Summary() {
   os.InsertRow(
       {"use_optimized_model", use_optimized_model_ ? "true" : "false"});
   os.InsertRow({"memory_optim", enable_memory_optim_ ? "true" : "false"});
+  os.InsertRow(
+      {"static_memory_plan", static_memory_plan_ ? "true" : "false"});
+  os.InsertRow({"mmap_params", mmap_params_ ? "true" : "false"});
   os.InsertRow({"enable_profile", with_profile_ ? "true" : "false"});
   os.InsertRow({"enable_log", with_glog_info_ ? "true" : "false"});
   os.InsertRow({"collect_shape_range_info",
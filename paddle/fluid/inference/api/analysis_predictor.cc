@@ -50,6 +50,7 @@
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
 #include "paddle/fluid/inference/api/paddle_inference_pass.h"
 #include "paddle/fluid/inference/api/resource_manager.h"
+#include "paddle/fluid/inference/io.h"
 #include "paddle/fluid/inference/utils/io_utils.h"
 #include "paddle/fluid/inference/utils/model_utils.h"
 #include "paddle/fluid/inference/utils/singleton.h"
@@ -1286,6 +1287,12 @@ bool AnalysisPredictor::PrepareExecutor() {
         pass_res_info->Get<std::unordered_map<std::string, std::string>>(
             root_predictor_id_, "memory_optimize_pass");
     executor_->MakeReusePlan(reuse_table);
+    // The reuse plan still serves the runs which do not bind an arena.
+    if (config_.static_memory_plan_enabled()) {
+      executor_->MakeStaticMemoryPlan(
+          pass_res_info->Get<framework::StaticMemoryPlan>(
+              root_predictor_id_, "memory_optimize_pass_static_plan"));
+    }
   }
   return true;
 }
@@ -2007,6 +2014,8 @@ void AnalysisPredictor::PrepareArgument() {
   argument_->SetGPUDeviceId(config_.gpu_device_id());
   argument_->SetEnableIrOptim(config_.enable_ir_optim_);
   argument_->SetEnableMemoryOptim(config_.enable_memory_optim());
+  argument_->SetStaticMemoryPlan(config_.static_memory_plan_enabled());
+  argument_->SetMmapParams(config_.memory_mapped_params_enabled());
   argument_->SetModelFromMemory(config_.model_from_memory_);
   argument_->SetUsePIR(config_.new_ir_enabled());
   // Analyze inference_program
@@ -3084,6 +3093,14 @@ bool AnalysisPredictor::LoadParameters() {
       new framework::ProgramDesc());
   framework::BlockDesc *load_block = load_program->MutableBlock(0);
   std::vector<std::string> params;
+  // only the dense tensors can be loaded by mmap, on CPU
+  bool mmap_params = config_.memory_mapped_params_enabled() &&
+                     !config_.params_file().empty() &&
+                     !config_.model_from_memory() && phi::is_cpu_place(place_);
+#ifdef _WIN32
+  // Windows keeps the load_combine path
+  mmap_params = false;
+#endif
 
   for (auto *var : global_block->AllVars()) {
     if (IsPersistable(var)) {
@@ -3093,6 +3110,9 @@ bool AnalysisPredictor::LoadParameters() {
       new_var->SetShape(var->GetShape());
       new_var->SetDataType(var->GetDataType());
       new_var->SetType(var->GetType());
+      if (var->GetType() != framework::proto::VarType::LOD_TENSOR) {
+        mmap_params = false;
+      }
       new_var->SetLoDLevel(var->GetLoDLevel());
       new_var->SetPersistable(true);
 
@@ -3112,6 +3132,12 @@ bool AnalysisPredictor::LoadParameters() {
   if (!config_.params_file().empty()) {
     // sort paramlist to have consistent ordering
     std::sort(params.begin(), params.end());
+    if (mmap_params) {
+      LoadCombinedParamsByMmap(scope_.get(), params, config_.params_file());
+      VLOG(3) << "get " << scope_->LocalVarNames().size()
+              << " vars after load";
+      return true;
+    }
     // append just the load_combine op
     framework::OpDesc *op = load_block->AppendOp();
     op->SetType("load_combine");
@@ -3837,6 +3863,187 @@ Predictor *PredictorPool::Retrieve(size_t idx) {
   }
   return preds_[idx - 1].get();
 }
+
+SharedPredictorPool::Handle::Handle(Handle &&other) noexcept
+    : pool_(other.pool_), idx_(other.idx_), pred_(other.pred_) {
+  other.pool_ = nullptr;
+  other.pred_ = nullptr;
+}
+
+SharedPredictorPool::Handle &SharedPredictorPool::Handle::operator=(
+    Handle &&other) noexcept {
+  if (this != &other) {
+    if (pool_ != nullptr) {
+      pool_->Release(idx_);
+    }
+    pool_ = other.pool_;
+    idx_ = other.idx_;
+    pred_ = other.pred_;
+    other.pool_ = nullptr;
+    other.pred_ = nullptr;
+  }
+  return *this;
+}
+
+SharedPredictorPool::Handle::~Handle() {
+  if (pool_ != nullptr) {
+    pool_->Release(idx_);
+  }
+}
+
+SharedPredictorPool::SharedPredictorPool(const Config &config,
+                                         size_t max_contexts,
+                                         size_t trim_interval)
+    : config_(config),
+      max_contexts_(max_contexts),
+      trim_interval_(trim_interval),
+      contexts_(max_contexts) {
+  PADDLE_ENFORCE_GE(
+      max_contexts,
+      1UL,
+      common::errors::InvalidArgument(
+          "The max number of contexts should be at least 1, but it's (%d)",
+          max_contexts));
+  PADDLE_ENFORCE_GE(
+      trim_interval,
+      1UL,
+      common::errors::InvalidArgument(
+          "The trim interval should be at least 1, but it's (%d)",
+          trim_interval));
+  // The first context loads and optimizes the program, the others are cloned
+  // from it.
+  contexts_[0].pred = std::make_unique<Predictor>(config_);
+  num_contexts_ = 1;
+  idle_.push_back(0);
+  // the lower slots are taken first
+  for (size_t i = max_contexts; i > 1; --i) {
+    free_slots_.push_back(i - 1);
+  }
+}
+
+SharedPredictorPool::~SharedPredictorPool() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return num_busy_ == 0 && num_trimming_ == 0; });
+  // the clones go first, the root predictor owns the shared scope
+  for (size_t i = max_contexts_; i > 1; --i) {
+    contexts_[i - 1].pred.reset();
+  }
+}
+
+SharedPredictorPool::Handle SharedPredictorPool::Acquire() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return !idle_.empty() || !free_slots_.empty(); });
+  return TakeLocked(&lock);
+}
+
+SharedPredictorPool::Handle SharedPredictorPool::TryAcquire() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (idle_.empty() && free_slots_.empty()) {
+    return Handle();
+  }
+  return TakeLocked(&lock);
+}
+
+size_t SharedPredictorPool::NumContexts() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_contexts_;
+}
+
+size_t SharedPredictorPool::NumWarmContexts() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return std::count_if(idle_.begin(), idle_.end(), [this](size_t idx) {
+    return contexts_[idx].warm;
+  });
+}
+
+SharedPredictorPool::Handle SharedPredictorPool::TakeLocked(
+    std::unique_lock<std::mutex> *lock) {
+  ++num_busy_;
+  peak_busy_ = std::max(peak_busy_, num_busy_);
+  if (!idle_.empty()) {
+    size_t idx = idle_.back();
+    idle_.pop_back();
+    return Handle(this, idx, contexts_[idx].pred.get());
+  }
+
+  // Clone outside the lock, the slot is out of free_slots_ and nobody else
+  // touches it.
+  size_t idx = free_slots_.back();
+  free_slots_.pop_back();
+  lock->unlock();
+  std::unique_ptr<Predictor> pred;
+  try {
+    if (config_.tensorrt_engine_enabled()) {
+      // the same as PredictorPool, every TensorRT predictor builds its engines
+      pred = std::make_unique<Predictor>(config_);
+    } else {
+      pred = contexts_[0].pred->Clone();
+    }
+  } catch (...) {
+    lock->lock();
+    free_slots_.push_back(idx);
+    --num_busy_;
+    cv_.notify_all();
+    throw;
+  }
+  lock->lock();
+  contexts_[idx].pred = std::move(pred);
+  ++num_contexts_;
+  return Handle(this, idx, contexts_[idx].pred.get());
+}
+
+void SharedPredictorPool::Release(size_t idx) {
+  std::vector<size_t> cold;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    contexts_[idx].warm = true;
+    idle_.push_back(idx);
+    --num_busy_;
+    if (++num_released_ % trim_interval_ == 0) {
+      cold = TakeColdLocked();
+    }
+    // wakes the waiting Acquire calls and the destructor
+    cv_.notify_all();
+  }
+  if (!cold.empty()) {
+    ReturnTrimmed(cold);
+  }
+}
+
+std::vector<size_t> SharedPredictorPool::TakeColdLocked() {
+  // busy contexts are warm, the most recently used idle ones make up the rest
+  size_t keep_idle = peak_busy_ > num_busy_ ? peak_busy_ - num_busy_ : 0;
+  size_t num_cold = idle_.size() > keep_idle ? idle_.size() - keep_idle : 0;
+  std::vector<size_t> cold;
+  std::vector<size_t> idle;
+  for (size_t i = 0; i < idle_.size(); ++i) {
+    if (i < num_cold && contexts_[idle_[i]].warm) {
+      cold.push_back(idle_[i]);
+    } else {
+      idle.push_back(idle_[i]);
+    }
+  }
+  idle_.swap(idle);
+  num_trimming_ += cold.size();
+  peak_busy_ = num_busy_;
+  return cold;
+}
+
+void SharedPredictorPool::ReturnTrimmed(const std::vector<size_t> &cold) {
+  for (size_t idx : cold) {
+    VLOG(3) << "SharedPredictorPool frees intermediate tensors of context "
+            << idx;
+    contexts_[idx].pred->ClearIntermediateTensor();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t idx : cold) {
+    contexts_[idx].warm = false;
+  }
+  // the cold contexts are the least recently used ones
+  idle_.insert(idle_.begin(), cold.begin(), cold.end());
+  num_trimming_ -= cold.size();
+  cv_.notify_all();
+}
 }  // namespace services
 
 namespace experimental {
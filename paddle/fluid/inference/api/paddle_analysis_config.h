@@ -1072,6 +1072,39 @@ struct PD_INFER_DECL AnalysisConfig {
   /// \return bool Whether the memory optimization is activated.
   ///
   bool enable_memory_optim() const;
+  ///
+  /// \brief Turn on the static memory plan of memory optimize: the
+  /// intermediate tensors are placed in one arena, allocated once for each
+  /// shape of the inputs. It turns on memory optimize as well.
+  ///
+  /// \param x Whether to enable the static memory plan.
+  ///
+  void EnableStaticMemoryPlan(bool x = true);
+  ///
+  /// \brief A boolean state telling whether the static memory plan is
+  /// activated.
+  ///
+  /// \return bool Whether the static memory plan is activated.
+  ///
+  bool static_memory_plan_enabled() const;
+  ///
+  /// \brief Load the combined params file by mmap instead of reading it.
+  /// The parameters share the pages of the file with the page cache and with
+  /// the other processes serving the same model, so the load is fast and the
+  /// memory is not duplicated. It applies to the CPU place only. Save the
+  /// optimized model with it turned on to align the parameters in the file,
+  /// the parameters which are not aligned are copied.
+  ///
+  /// \param x Whether to load the parameters by mmap.
+  ///
+  void EnableMemoryMappedParams(bool x = true);
+  ///
+  /// \brief A boolean state telling whether the parameters are loaded by
+  /// mmap.
+  ///
+  /// \return bool Whether the parameters are loaded by mmap.
+  ///
+  bool memory_mapped_params_enabled() const;
 
   ///
   /// \brief Turn on profiling report.
@@ -1298,6 +1331,8 @@ struct PD_INFER_DECL AnalysisConfig {
 
   // memory reuse related.
   bool enable_memory_optim_{false};
+  bool static_memory_plan_{false};
+  bool mmap_params_{false};
   bool trt_engine_memory_sharing_{true};
   int trt_engine_memory_sharing_identifier_{0};
 
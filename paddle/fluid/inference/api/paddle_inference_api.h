@@ -22,8 +22,10 @@ limitations under the License. */
 #pragma once
 
 #include <cassert>
+#include <condition_variable>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_set>
 #include <utility>
@@ -273,6 +275,132 @@ class PD_INFER_DECL PredictorPool {
   std::shared_ptr<Predictor> main_pred_;
   std::vector<std::unique_ptr<Predictor>> preds_;
 };
+
+///
+/// \class SharedPredictorPool
+///
+/// \brief SharedPredictorPool serves requests of any number of threads with a
+/// few execution contexts. The contexts are clones of one predictor, so they
+/// share the optimized program and the weights and only own intermediate
+/// tensors. A request borrows an idle context, which is created on demand up
+/// to the max number of contexts, and gives it back when its handle is
+/// destroyed.
+///
+/// Idle contexts keep their intermediate tensors so the next request does not
+/// allocate them again, but only as many as the peak number of concurrent
+/// requests seen in the last trim interval. The intermediate tensors of the
+/// other idle contexts are freed to the allocator, which hands the memory to
+/// the busy ones.
+///
+/// \code{cpp}
+///   services::SharedPredictorPool pool(config, 8);
+///   // on any serving thread
+///   auto pred = pool.Acquire();
+///   pred->GetInputHandle(name)->CopyFromCpu(data);
+///   pred->Run();
+/// \endcode
+///
+class PD_INFER_DECL SharedPredictorPool {
+ public:
+  ///
+  /// \brief A borrowed context, returned to the pool on destruction.
+  ///
+  class PD_INFER_DECL Handle {
+   public:
+    Handle() = default;
+    Handle(const Handle&) = delete;
+    Handle& operator=(const Handle&) = delete;
+    Handle(Handle&& other) noexcept;
+    Handle& operator=(Handle&& other) noexcept;
+    ~Handle();
+
+    Predictor* get() const { return pred_; }
+    Predictor* operator->() const { return pred_; }
+    explicit operator bool() const { return pred_ != nullptr; }
+
+   private:
+    friend class SharedPredictorPool;
+    Handle(SharedPredictorPool* pool, size_t idx, Predictor* pred)
+        : pool_(pool), idx_(idx), pred_(pred) {}
+
+    SharedPredictorPool* pool_{nullptr};
+    size_t idx_{0};
+    Predictor* pred_{nullptr};
+  };
+
+  SharedPredictorPool() = delete;
+  SharedPredictorPool(const SharedPredictorPool&) = delete;
+  SharedPredictorPool& operator=(const SharedPredictorPool&) = delete;
+
+  ///
+  /// \brief Construct the pool with one context.
+  ///
+  /// \param[in] config config of the predictor
+  /// \param[in] max_contexts the most contexts the pool creates
+  /// \param[in] trim_interval the number of requests between two checks of
+  /// the idle contexts whose intermediate tensors are freed
+  ///
+  explicit SharedPredictorPool(const Config& config,
+                               size_t max_contexts = 1,
+                               size_t trim_interval = 1000);
+  ~SharedPredictorPool();
+
+  ///
+  /// \brief Borrow an idle context, or create one. Waits only if all the
+  /// max_contexts contexts are busy. Thread safe.
+  ///
+  Handle Acquire();
+
+  ///
+  /// \brief Like Acquire, but returns an empty handle instead of waiting.
+  ///
+  Handle TryAcquire();
+
+  /// \brief The number of contexts created so far.
+  size_t NumContexts() const;
+
+  /// \brief The number of idle contexts that keep their intermediate
+  /// tensors.
+  size_t NumWarmContexts() const;
+
+ private:
+  struct Context {
+    std::unique_ptr<Predictor> pred;
+    // whether the intermediate tensors of the last run are kept
+    bool warm{false};
+  };
+
+  // Takes an idle context, or reserves a free slot for a new one, with mutex_
+  // locked.
+  Handle TakeLocked(std::unique_lock<std::mutex>* lock);
+  void Release(size_t idx);
+  // Takes the warm idle contexts beyond the peak concurrency of the last
+  // interval out of idle_, with mutex_ locked. Their intermediate tensors are
+  // freed without the lock, then they are given back by ReturnTrimmed.
+  std::vector<size_t> TakeColdLocked();
+  void ReturnTrimmed(const std::vector<size_t>& cold);
+
+  Config config_;
+  const size_t max_contexts_;
+  const size_t trim_interval_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  // contexts_[i] is created before it is used, the slots are reserved so a
+  // context never moves
+  std::vector<Context> contexts_;
+  size_t num_contexts_{0};
+  // indices of the slots without a context, a slot is taken out while its
+  // context is being created and put back if that fails
+  std::vector<size_t> free_slots_;
+  // indices of the idle contexts, the most recently used at the back
+  std::vector<size_t> idle_;
+  size_t num_busy_{0};
+  // contexts out of idle_ while their intermediate tensors are freed
+  size_t num_trimming_{0};
+  size_t peak_busy_{0};
+  size_t num_released_{0};
+};
 }  // namespace services
 
 }  // namespace paddle_infer
@@ -20,6 +20,7 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/block_desc.h"
 #include "paddle/fluid/framework/feed_fetch_type.h"
+#include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/version.h"
 #include "paddle/fluid/platform/cpu_helper.h"
@@ -27,6 +28,7 @@ limitations under the License. */
 #include "paddle/fluid/pybind/pybind.h"
 
 // phi
+#include "paddle/phi/core/memory/allocation/mmap_allocator.h"
 #include "paddle/phi/kernels/declarations.h"
 
 PD_DEFINE_string(devices,  // NOLINT
@@ -76,13 +78,58 @@ bool IsPersistable(const framework::VarDesc* var) {
   return false;
 }
 
+void LoadCombinedParamsByMmap(framework::Scope* scope,
+                              const std::vector<std::string>& param_list,
+                              const std::string& param_filename) {
+#ifndef _WIN32
+  std::shared_ptr<phi::Allocation> mapping =
+      memory::allocation::AllocateMemoryMapFileAllocation(param_filename);
+  size_t offset = 0;
+  size_t num_shared = 0;
+  for (auto& name : param_list) {
+    auto* tensor = scope->Var(name)->GetMutable<phi::DenseTensor>();
+    if (framework::DeserializeFromMemory(
+            mapping, &offset, tensor, memory::allocation::mmap_alignment)) {
+      ++num_shared;
+    }
+  }
+  PADDLE_ENFORCE_EQ(
+      offset,
+      mapping->size(),
+      common::errors::Unavailable(
+          "Not allowed to load partial data via load_combine_op, please use "
+          "load_op instead. The params file %s has %d bytes, but the %d "
+          "parameters of the program take %d bytes.",
+          param_filename,
+          mapping->size(),
+          param_list.size(),
+          offset));
+  LOG(INFO) << "Mapped " << mapping->size() / 1024 / 1024 << " MB of "
+            << param_filename << ", " << num_shared << " of "
+            << param_list.size()
+            << " parameters share the mapping, the others are copied since "
+               "they are not aligned in the file";
+#else
+  PADDLE_THROW(common::errors::Unimplemented(
+      "Loading the parameters by mmap is not supported on Windows."));
+#endif
+}
+
 void LoadPersistables(framework::Executor* executor,
                       framework::Scope* scope,
                       const framework::ProgramDesc& main_program,
                       const std::string& dirname,
                       const std::string& param_filename,
-                      bool model_from_memory = false) {
+                      bool model_from_memory = false,
+                      bool mmap_params) {
   const framework::BlockDesc& global_block = main_program.Block(0);
+  // only the dense tensors can be loaded by mmap, on CPU
+  mmap_params = mmap_params && !param_filename.empty() && !model_from_memory &&
+                phi::is_cpu_place(executor->GetPlace());
+#ifdef _WIN32
+  // Windows keeps the load_combine path
+  mmap_params = false;
+#endif
 
   framework::ProgramDesc* load_program = new framework::ProgramDesc();
   framework::BlockDesc* load_block = load_program->MutableBlock(0);
@@ -97,6 +144,9 @@ void LoadPersistables(framework::Executor* executor,
       new_var->SetDataType(var->GetDataType());
       auto var_type = var->GetType();
       new_var->SetType(var_type);
+      if (var_type != framework::proto::VarType::LOD_TENSOR) {
+        mmap_params = false;
+      }
 
       if ((var_type !=
            framework::proto::VarType::Type::VarType_Type_SELECTED_ROWS) &&
@@ -122,6 +172,11 @@ void LoadPersistables(framework::Executor* executor,
   if (!param_filename.empty()) {
     // sort param_list to have consistent ordering
     std::sort(param_list.begin(), param_list.end());
+    if (mmap_params) {
+      delete load_program;
+      LoadCombinedParamsByMmap(scope, param_list, param_filename);
+      return;
+    }
     // append just the load_combine op
     framework::OpDesc* op = load_block->AppendOp();
     op->SetType("load_combine");
@@ -166,7 +221,8 @@ std::unique_ptr<framework::ProgramDesc> Load(framework::Executor* executor,
                                              framework::Scope* scope,
                                              const std::string& prog_filename,
                                              const std::string& param_filename,
-                                             bool load_params) {
+                                             bool load_params,
+                                             bool mmap_params) {
   std::string program_desc_str;
   ReadBinaryFile(prog_filename, &program_desc_str);
 
@@ -183,7 +239,8 @@ std::unique_ptr<framework::ProgramDesc> Load(framework::Executor* executor,
                      *main_program,
                      "",
                      param_filename,
-                     false /* model_from_memory */);
+                     false /* model_from_memory */,
+                     mmap_params);
   }
   return main_program;
 }
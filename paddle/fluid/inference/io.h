@@ -33,7 +33,16 @@ void LoadPersistables(framework::Executor* executor,
                       const framework::ProgramDesc& main_program,
                       const std::string& dirname,
                       const std::string& param_filename,
-                      bool model_from_memory);
+                      bool model_from_memory,
+                      bool mmap_params = false);
+
+// Load the dense tensors of param_list, in order, from a combined params file
+// by mapping the file. The tensors whose data is aligned in the file share
+// the pages of the mapping, the others are copied. The mapping is private, so
+// a write to a parameter copies the page and never reaches the file.
+void LoadCombinedParamsByMmap(framework::Scope* scope,
+                              const std::vector<std::string>& param_list,
+                              const std::string& param_filename);
 
 std::unique_ptr<framework::ProgramDesc> Load(framework::Executor* executor,
                                              framework::Scope* scope,
@@ -43,7 +52,8 @@ std::unique_ptr<framework::ProgramDesc> Load(framework::Executor* executor,
                                              framework::Scope* scope,
                                              const std::string& prog_filename,
                                              const std::string& param_filename,
-                                             bool load_params = true);
+                                             bool load_params = true,
+                                             bool mmap_params = false);
 
 std::unique_ptr<framework::ProgramDesc> LoadFromMemory(
     framework::Executor* executor,
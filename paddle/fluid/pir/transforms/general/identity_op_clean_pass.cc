@@ -285,6 +285,8 @@ class IdentityOpCleanPass : public pir::PatternRewritePass {
     ps.Add(paddle::drr::Create<ReplaceDropoutWithScalePattern>(context));
     return ps;
   }
+
+  bool IsRegionLocal() const override { return true; }
 };
 
 }  // namespace
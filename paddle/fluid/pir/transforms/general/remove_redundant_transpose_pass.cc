@@ -92,6 +92,8 @@ class RemoveRedundantTransposePass : public pir::PatternRewritePass {
     ps.Add(paddle::drr::Create<RemoveInvalidTransposePattern>(context));
     return ps;
   }
+
+  bool IsRegionLocal() const override { return true; }
 };
 
 }  // namespace
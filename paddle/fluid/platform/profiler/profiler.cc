@@ -26,9 +26,12 @@
 #endif
 #include "paddle/common/flags.h"
 #include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/profiler/chrometracing_logger.h"
+#include "paddle/fluid/platform/profiler/common_event.h"
 #include "paddle/fluid/platform/profiler/cuda_tracer.h"
 #include "paddle/fluid/platform/profiler/custom_device/custom_tracer.h"
 #include "paddle/fluid/platform/profiler/extra_info.h"
+#include "paddle/fluid/platform/profiler/host_event_recorder.h"
 #include "paddle/fluid/platform/profiler/host_tracer.h"
 #include "paddle/fluid/platform/profiler/trace_event_collector.h"
 #include "paddle/fluid/platform/profiler/utils.h"
@@ -181,5 +184,33 @@ std::unique_ptr<ProfilerResult> Profiler::Stop() {
   return std::unique_ptr<ProfilerResult>(profiler_result_ptr);
 }
 
+void SaveContinuousHostTrace(const std::string& file_name) {
+  HostEventSection<CommonEvent> host_events =
+      phi::ContinuousEventRecorder::GetInstance().Snapshot();
+  std::list<HostTraceEvent> events;
+  ExtraInfo extra_info;
+  for (const auto& thr_sec : host_events.thr_sections) {
+    uint64_t tid = thr_sec.thread_id;
+    if (thr_sec.thread_name != phi::kDefaultThreadName) {
+      extra_info.AddExtraInfo(string_format(std::string("%llu"), tid),
+                              std::string("%s"),
+                              thr_sec.thread_name.c_str());
+    }
+    for (const auto& evt : thr_sec.events) {
+      events.emplace_back(evt.name,
+                          evt.type,
+                          evt.start_ns,
+                          evt.end_ns,
+                          host_events.process_id,
+                          tid);
+    }
+  }
+  NodeTrees tree(events, {}, {}, {}, {});
+  ChromeTracingLogger logger(file_name);
+  logger.LogMetaInfo(std::string(Profiler::version), Profiler::span_indx);
+  tree.LogMe(&logger);
+  logger.LogExtraInfo(extra_info.GetExtraInfo());
+}
+
 }  // namespace platform
 }  // namespace paddle
@@ -98,5 +98,9 @@ class Profiler {
   CpuUtilization cpu_utilization_;
 };
 
+// Writes the events kept by the continuous host tracing into a chrome
+// tracing file, without stopping it.
+void SaveContinuousHostTrace(const std::string& file_name);
+
 }  // namespace platform
 }  // namespace paddle
@@ -12,8 +12,16 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <stdlib.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
 #include <set>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "glog/logging.h"
 #include "gtest/gtest.h"
@@ -26,6 +34,7 @@
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/platform/profiler/event_python.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
+#include "paddle/fluid/platform/profiler/host_event_recorder.h"
 #include "paddle/fluid/platform/profiler/profiler.h"
 #include "paddle/phi/common/place.h"
 
@@ -141,3 +150,125 @@ TEST(ProfilerTest, TestHostTracerForMem) {
   auto profiler_result = profiler->Stop();
   auto nodetree = profiler_result->GetNodeTrees();
 }
+
+TEST(ProfilerTest, TestContinuousHostTracing) {
+  using paddle::platform::RecordEvent;
+  using paddle::platform::TracerEventType;
+  auto& recorder = phi::ContinuousEventRecorder::GetInstance();
+  phi::EnableContinuousHostTracing(64, 1, 1);
+  for (int i = 0; i < 200; ++i) {
+    RecordEvent event("TestContinuous_" + std::to_string(i),
+                      TracerEventType::UserDefined,
+                      1);
+  }
+  // filtered by the trace level
+  {
+    RecordEvent event(
+        "TestContinuous_level", TracerEventType::UserDefined, 2);
+  }
+  auto host_events = recorder.Snapshot();
+  ASSERT_EQ(host_events.thr_sections.size(), 1u);
+  const auto& events = host_events.thr_sections[0].events;
+  // keeps the newest events
+  ASSERT_EQ(events.size(), 64u);
+  for (size_t i = 0; i < events.size(); ++i) {
+    EXPECT_EQ(std::string(events[i].name),
+              "TestContinuous_" + std::to_string(136 + i));
+    EXPECT_LE(events[i].start_ns, events[i].end_ns);
+  }
+
+  char dir_template[] = "/tmp/continuous_host_trace_XXXXXX";
+  ASSERT_NE(mkdtemp(dir_template), nullptr);
+  const std::string file_name = std::string(dir_template) + "/trace.json";
+  paddle::platform::SaveContinuousHostTrace(file_name);
+  std::ifstream file(file_name);
+  std::stringstream ss;
+  ss << file.rdbuf();
+  EXPECT_NE(ss.str().find("TestContinuous_199"), std::string::npos);
+  EXPECT_EQ(ss.str().find("TestContinuous_135"), std::string::npos);
+  unlink(file_name.c_str());
+  rmdir(dir_template);
+  phi::DisableContinuousHostTracing();
+}
+
+TEST(ProfilerTest, TestContinuousHostTracingSample) {
+  using paddle::platform::RecordEvent;
+  using paddle::platform::TracerEventType;
+  auto& recorder = phi::ContinuousEventRecorder::GetInstance();
+  phi::EnableContinuousHostTracing(1024, 4, 1);
+  for (int i = 0; i < 400; ++i) {
+    RecordEvent event("TestContinuousSample", TracerEventType::UserDefined, 1);
+  }
+  auto host_events = recorder.Snapshot();
+  ASSERT_EQ(host_events.thr_sections.size(), 1u);
+  EXPECT_EQ(host_events.thr_sections[0].events.size(), 100u);
+  phi::DisableContinuousHostTracing();
+  {
+    RecordEvent event(
+        "TestContinuousSample", TracerEventType::UserDefined, 1);
+  }
+  EXPECT_EQ(recorder.Snapshot().thr_sections[0].events.size(), 100u);
+}
+
+TEST(ProfilerTest, TestContinuousHostTracingThreads) {
+  using paddle::platform::RecordEvent;
+  using paddle::platform::TracerEventType;
+  auto& recorder = phi::ContinuousEventRecorder::GetInstance();
+  phi::EnableContinuousHostTracing(256, 1, 1);
+  const char* names[] = {"TestContinuousThread_a", "TestContinuousThread_b"};
+  std::atomic<bool> done{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&names] {
+      for (int i = 0; i < 20000; ++i) {
+        RecordEvent event(names[i % 2], TracerEventType::UserDefined, 1);
+      }
+    });
+  }
+  // snapshots while the threads overwrite their rings
+  std::thread reader([&] {
+    while (!done.load()) {
+      for (const auto& thr_sec : recorder.Snapshot().thr_sections) {
+        EXPECT_LE(thr_sec.events.size(), 256u);
+        for (const auto& evt : thr_sec.events) {
+          EXPECT_EQ(std::string(evt.name).rfind("TestContinuousThread_", 0),
+                    0u);
+        }
+      }
+    }
+  });
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  done = true;
+  reader.join();
+  auto host_events = recorder.Snapshot();
+  EXPECT_EQ(host_events.thr_sections.size(), 4u);
+  for (const auto& thr_sec : host_events.thr_sections) {
+    EXPECT_EQ(thr_sec.events.size(), 256u);
+  }
+  phi::DisableContinuousHostTracing();
+}
+
+TEST(Benchmark, ContinuousHostTracing) {
+  using paddle::platform::RecordEvent;
+  using paddle::platform::TracerEventType;
+  const int num_events = 1000000;
+  auto run = [](const char* mode) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_events; ++i) {
+      RecordEvent event("BenchmarkContinuous", TracerEventType::Operator, 1);
+    }
+    double ns = std::chrono::duration<double, std::nano>(
+                    std::chrono::steady_clock::now() - start)
+                    .count() /
+                num_events;
+    std::cout << mode << ": " << ns << " ns/event" << std::endl;
+  };
+  run("disabled");
+  phi::EnableContinuousHostTracing(16384, 1, 1);
+  run("continuous");
+  phi::EnableContinuousHostTracing(16384, 16, 1);
+  run("continuous, 1 in 16 sampled");
+  phi::DisableContinuousHostTracing();
+}
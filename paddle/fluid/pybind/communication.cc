@@ -120,7 +120,42 @@ void BindTCPStore(py::module *m) {
                         py::call_guard<py::gil_scoped_release>())
                    .def("wait",
                         &phi::distributed::Store::wait,
-                        py::call_guard<py::gil_scoped_release>());
+                        py::call_guard<py::gil_scoped_release>())
+                   .def(
+                       "compare_set",
+                       [](phi::distributed::Store &self,
+                          const std::string &key,
+                          const std::string &expected,
+                          const std::string &desired) -> py::bytes {
+                         auto data = self.compare_set(
+                             key,
+                             std::vector<uint8_t>(expected.begin(),
+                                                  expected.end()),
+                             std::vector<uint8_t>(desired.begin(),
+                                                  desired.end()));
+                         std::string s(data.begin(), data.end());
+                         py::gil_scoped_acquire acquire;
+                         return py::bytes(s);
+                       },
+                       py::arg("key"),
+                       py::arg("expected"),
+                       py::arg("desired"),
+                       py::call_guard<py::gil_scoped_release>())
+                   .def(
+                       "multi_get",
+                       [](phi::distributed::Store &self,
+                          const std::vector<std::string> &keys) {
+                         auto values = self.multi_get(keys);
+                         py::gil_scoped_acquire acquire;
+                         py::list result;
+                         for (auto &value : values) {
+                           result.append(py::bytes(
+                               std::string(value.begin(), value.end())));
+                         }
+                         return result;
+                       },
+                       py::arg("keys"),
+                       py::call_guard<py::gil_scoped_release>());
 
   py::class_<TCPStore, std::shared_ptr<TCPStore>>(*m, "TCPStore", Store)
       .def(py::init([](std::string hostname,
@@ -1453,7 +1453,7 @@ PYBIND11_MODULE(libpaddle, m) {
   // unloaded. We need manually clear symbols(may contain plugins' symbols)
   // stored in this static instance to avoid illegal memory access.
   m.def("clear_kernel_factory",
-        []() { phi::KernelFactory::Instance().kernels().clear(); });
+        []() { phi::KernelFactory::Instance().ClearKernels(); });
   m.def("clear_device_manager", []() {
 #ifdef PADDLE_WITH_CUSTOM_DEVICE
     platform::XCCLCommContext::Release();
@@ -2946,6 +2946,14 @@ All parameter, weight, gradient are variables in Paddle.
   m.def("disable_memory_recorder", &paddle::platform::DisableMemoryRecorder);
   m.def("enable_op_info_recorder", &phi::EnableOpInfoRecorder);
   m.def("disable_op_info_recorder", &phi::DisableOpInfoRecorder);
+  m.def("enable_continuous_host_tracing",
+        &phi::EnableContinuousHostTracing,
+        py::arg("events_per_thread") = 16384,
+        py::arg("sample_period") = 1,
+        py::arg("trace_level") = phi::kDefaultTraceLevel);
+  m.def("disable_continuous_host_tracing", &phi::DisableContinuousHostTracing);
+  m.def("save_continuous_host_trace",
+        &paddle::platform::SaveContinuousHostTrace);
 
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   m.def("set_cublas_switch", phi::SetAllowTF32Cublas);
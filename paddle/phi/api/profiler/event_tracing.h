@@ -79,6 +79,11 @@ class TEST_API RecordEvent {
                          const EventRole role,
                          const std::string& attr);
 
+  // Starts an event of the ContinuousEventRecorder
+  void ContinuousConstruct(uint32_t name_id,
+                           const TracerEventType type,
+                           const EventRole role);
+
   bool is_enabled_{false};
   bool is_pushed_{false};
   // Event name
@@ -92,6 +97,9 @@ class TEST_API RecordEvent {
   TracerEventType type_{TracerEventType::UserDefined};
   std::string* attr_{nullptr};
   bool finished_{false};
+  // Recorded by the ContinuousEventRecorder
+  bool is_continuous_{false};
+  uint32_t name_id_{0};
 };
 
 }  // namespace phi
@@ -0,0 +1,243 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/api/profiler/host_event_recorder.h"
+
+#include <cstring>
+
+#include "paddle/phi/api/profiler/common_event.h"
+#include "paddle/phi/core/enforce.h"
+
+namespace phi {
+
+namespace {
+
+// Names beyond it share one id, e.g. names made of a step number.
+constexpr uint32_t kMaxEventNames = 1 << 16;
+constexpr char kOverflowEventName[] = "<too many event names>";
+
+struct ThreadRing {
+  ~ThreadRing() {
+    if (ring) ring->MarkThreadExited();
+  }
+  std::shared_ptr<EventRingBuffer> ring;
+  uint64_t generation{0};
+};
+
+thread_local ThreadRing thread_ring;
+
+}  // namespace
+
+uint32_t EventNameTable::InternLocked(const std::string &name) {
+  auto iter = ids_.find(name);
+  if (iter != ids_.end()) return iter->second;
+  // keeps the last id for the overflow name
+  if (names_.size() + 1 >= kMaxEventNames && name != kOverflowEventName) {
+    return InternLocked(kOverflowEventName);
+  }
+  uint32_t id = static_cast<uint32_t>(names_.size());
+  names_.push_back(name);
+  ids_.emplace(name, id);
+  return id;
+}
+
+uint32_t EventNameTable::Intern(const char *name) {
+  struct CachedName {
+    uint32_t id;
+    const char *name;
+  };
+  thread_local std::unordered_map<const char *, CachedName> cache;
+  auto iter = cache.find(name);
+  // the storage of `name` may have been reused by another name
+  if (iter != cache.end() && strcmp(iter->second.name, name) == 0) {
+    return iter->second.id;
+  }
+  std::lock_guard<std::mutex> guard(mutex_);
+  uint32_t id = InternLocked(name);
+  cache[name] = {id, names_[id].c_str()};
+  return id;
+}
+
+uint32_t EventNameTable::Intern(const std::string &name) {
+  thread_local std::unordered_map<std::string, uint32_t> cache;
+  auto iter = cache.find(name);
+  if (iter != cache.end()) return iter->second;
+  std::lock_guard<std::mutex> guard(mutex_);
+  uint32_t id = InternLocked(name);
+  if (names_[id] == name) cache.emplace(name, id);
+  return id;
+}
+
+const char *EventNameTable::Name(uint32_t id) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  PADDLE_ENFORCE_LT(
+      id,
+      names_.size(),
+      common::errors::OutOfRange("The event name id %d is not interned.", id));
+  return names_[id].c_str();
+}
+
+EventRingBuffer::EventRingBuffer(size_t capacity)
+    : thread_id_(GetCurrentThreadSysId()),
+      thread_name_(GetCurrentThreadName()) {
+  size_t size = 1;
+  while (size < capacity) size <<= 1;
+  slots_.reset(new Slot[size]);
+  mask_ = size - 1;
+}
+
+void EventRingBuffer::Push(uint32_t name_id,
+                           uint64_t start_ns,
+                           uint64_t end_ns,
+                           EventRole role,
+                           TracerEventType type) {
+  const uint64_t pos = head_.load(std::memory_order_relaxed);
+  Slot &slot = slots_[pos & mask_];
+  slot.seq.store(2 * pos + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.info.store(static_cast<uint64_t>(name_id) << 32 |
+                      static_cast<uint64_t>(role) << 8 |
+                      static_cast<uint64_t>(type),
+                  std::memory_order_relaxed);
+  slot.start_ns.store(start_ns, std::memory_order_relaxed);
+  slot.end_ns.store(end_ns, std::memory_order_relaxed);
+  slot.seq.store(2 * pos + 2, std::memory_order_release);
+  head_.store(pos + 1, std::memory_order_release);
+}
+
+void EventRingBuffer::Snapshot(std::vector<Event> *events) const {
+  const uint64_t head = head_.load(std::memory_order_acquire);
+  const uint64_t begin = head > capacity() ? head - capacity() : 0;
+  for (uint64_t pos = begin; pos < head; ++pos) {
+    const Slot &slot = slots_[pos & mask_];
+    const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+    // overwritten since head was read
+    if (seq != 2 * pos + 2) continue;
+    const uint64_t info = slot.info.load(std::memory_order_relaxed);
+    Event event;
+    event.name_id = static_cast<uint32_t>(info >> 32);
+    event.role = static_cast<EventRole>((info >> 8) & 0xff);
+    event.type = static_cast<TracerEventType>(info & 0xff);
+    event.start_ns = slot.start_ns.load(std::memory_order_relaxed);
+    event.end_ns = slot.end_ns.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) != seq) continue;
+    events->push_back(event);
+  }
+}
+
+void ContinuousEventRecorder::Enable(size_t events_per_thread,
+                                     uint32_t sample_period,
+                                     uint32_t trace_level) {
+  PADDLE_ENFORCE_GT(events_per_thread,
+                    0,
+                    common::errors::InvalidArgument(
+                        "events_per_thread of the continuous host event "
+                        "recorder should be positive."));
+  PADDLE_ENFORCE_GT(sample_period,
+                    0,
+                    common::errors::InvalidArgument(
+                        "sample_period of the continuous host event "
+                        "recorder should be positive."));
+  std::lock_guard<std::mutex> guard(mutex_);
+  events_per_thread_ = events_per_thread;
+  rings_.clear();
+  sample_period_.store(sample_period, std::memory_order_relaxed);
+  generation_.fetch_add(1, std::memory_order_release);
+  trace_level_.store(trace_level, std::memory_order_relaxed);
+}
+
+void ContinuousEventRecorder::Disable() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  trace_level_.store(-1, std::memory_order_relaxed);
+  generation_.fetch_add(1, std::memory_order_release);
+}
+
+bool ContinuousEventRecorder::Sample() {
+  const uint32_t period = sample_period_.load(std::memory_order_relaxed);
+  if (period <= 1) return true;
+  thread_local uint32_t count = 0;
+  if (++count < period) return false;
+  count = 0;
+  return true;
+}
+
+std::shared_ptr<EventRingBuffer> ContinuousEventRecorder::RegisterThread(
+    uint64_t *generation) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (!IsEnabled()) return nullptr;
+  size_t num_exited = 0;
+  for (auto &ring : rings_) {
+    num_exited += ring->thread_exited();
+  }
+  // drops the oldest ring of an exited thread
+  if (num_exited >= kMaxExitedThreads) {
+    for (auto iter = rings_.begin(); iter != rings_.end(); ++iter) {
+      if ((*iter)->thread_exited()) {
+        rings_.erase(iter);
+        break;
+      }
+    }
+  }
+  auto ring = std::make_shared<EventRingBuffer>(events_per_thread_);
+  rings_.push_back(ring);
+  *generation = generation_.load(std::memory_order_relaxed);
+  return ring;
+}
+
+void ContinuousEventRecorder::RecordEvent(uint32_t name_id,
+                                          uint64_t start_ns,
+                                          uint64_t end_ns,
+                                          EventRole role,
+                                          TracerEventType type) {
+  ThreadRing &local = thread_ring;
+  if (UNLIKELY(local.generation !=
+               generation_.load(std::memory_order_acquire))) {
+    local.ring = RegisterThread(&local.generation);
+    if (local.ring == nullptr) return;
+  }
+  local.ring->Push(name_id, start_ns, end_ns, role, type);
+}
+
+HostEventSection<CommonEvent> ContinuousEventRecorder::Snapshot() {
+  std::vector<std::shared_ptr<EventRingBuffer>> rings;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    rings = rings_;
+  }
+  auto &names = EventNameTable::GetInstance();
+  HostEventSection<CommonEvent> host_sec;
+  host_sec.process_id = GetProcessId();
+  host_sec.thr_sections.reserve(rings.size());
+  std::vector<EventRingBuffer::Event> events;
+  for (auto &ring : rings) {
+    events.clear();
+    ring->Snapshot(&events);
+    ThreadEventSection<CommonEvent> thr_sec;
+    thr_sec.thread_name = ring->thread_name();
+    thr_sec.thread_id = ring->thread_id();
+    thr_sec.events.reserve(events.size());
+    for (const auto &event : events) {
+      thr_sec.events.emplace_back(names.Name(event.name_id),
+                                  event.start_ns,
+                                  event.end_ns,
+                                  event.role,
+                                  event.type);
+    }
+    host_sec.thr_sections.emplace_back(std::move(thr_sec));
+  }
+  return host_sec;
+}
+
+}  // namespace phi
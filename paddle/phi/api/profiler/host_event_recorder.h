@@ -14,11 +14,18 @@
 
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #include "paddle/common/macros.h"
+#include "paddle/phi/api/profiler/event.h"
+#include "paddle/phi/api/profiler/trace_event.h"
 #include "paddle/phi/common/thread_data_registry.h"
 #include "paddle/phi/core/os_info.h"
 
@@ -289,4 +296,158 @@ class HostEventRecorder {
   std::vector<std::shared_ptr<ThreadEventRecorder<EventType>>> thr_recorders_;
 };
 
+struct CommonEvent;
+
+// Interns event names, so that the ContinuousEventRecorder stores an id of
+// 4 bytes per event instead of a copy of the name. Names are never freed,
+// so pointers returned by Name stay valid.
+class EventNameTable {
+ public:
+  static EventNameTable &GetInstance() {
+    static EventNameTable instance;
+    return instance;
+  }
+
+  // thread-safe, takes no lock once the calling thread has seen the name
+  uint32_t Intern(const char *name);
+  uint32_t Intern(const std::string &name);
+
+  // thread-safe
+  const char *Name(uint32_t id);
+
+ private:
+  EventNameTable() = default;
+  DISABLE_COPY_AND_ASSIGN(EventNameTable);
+
+  uint32_t InternLocked(const std::string &name);
+
+  std::mutex mutex_;
+  std::deque<std::string> names_;
+  std::unordered_map<std::string, uint32_t> ids_;
+};
+
+// A fixed-size ring of events, written by one thread and read by snapshots
+// from any thread. The writer overwrites the oldest events and never waits.
+// Every slot carries a sequence number that the writer makes odd while it
+// writes the slot, so a reader drops the slots it did not read whole.
+class EventRingBuffer {
+ public:
+  struct Event {
+    uint32_t name_id;
+    EventRole role;
+    TracerEventType type;
+    uint64_t start_ns;
+    uint64_t end_ns;
+  };
+
+  // `capacity` is rounded up to a power of 2
+  explicit EventRingBuffer(size_t capacity);
+  DISABLE_COPY_AND_ASSIGN(EventRingBuffer);
+
+ public:
+  // Only the owner thread may call it
+  void Push(uint32_t name_id,
+            uint64_t start_ns,
+            uint64_t end_ns,
+            EventRole role,
+            TracerEventType type);
+
+  // Appends the events in the ring to `events`, from the oldest one
+  void Snapshot(std::vector<Event> *events) const;
+
+  size_t capacity() const { return mask_ + 1; }
+  uint64_t thread_id() const { return thread_id_; }
+  const std::string &thread_name() const { return thread_name_; }
+
+  bool thread_exited() const {
+    return thread_exited_.load(std::memory_order_acquire);
+  }
+  void MarkThreadExited() {
+    thread_exited_.store(true, std::memory_order_release);
+  }
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> seq{0};
+    // name_id << 32 | role << 8 | type
+    std::atomic<uint64_t> info{0};
+    std::atomic<uint64_t> start_ns{0};
+    std::atomic<uint64_t> end_ns{0};
+  };
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t mask_;
+  std::atomic<uint64_t> head_{0};
+  uint64_t thread_id_;
+  std::string thread_name_;
+  std::atomic<bool> thread_exited_{false};
+};
+
+/**
+ * Records host events with a bounded memory, so that host tracing can stay
+ * on in production. Each thread writes into a lock-free EventRingBuffer of
+ * a fixed size that overwrites its oldest events, 1 in `sample_period`
+ * events is recorded and names are interned by the EventNameTable.
+ *
+ * RecordEvent feeds it when the HostTracer is not tracing. Snapshot copies
+ * the events at any time without stopping the recording.
+ */
+class ContinuousEventRecorder {
+ public:
+  static ContinuousEventRecorder &GetInstance() {
+    static ContinuousEventRecorder instance;
+    return instance;
+  }
+
+  // Drops the events recorded so far.
+  void Enable(size_t events_per_thread,
+              uint32_t sample_period,
+              uint32_t trace_level);
+
+  void Disable();
+
+  bool IsEnabled() const {
+    return trace_level_.load(std::memory_order_relaxed) >= 0;
+  }
+
+  // thread-safe
+  // Decides whether to record an event of `level` that starts now.
+  bool NeedTrace(uint32_t level) {
+    if (LIKELY(trace_level_.load(std::memory_order_relaxed) <
+               static_cast<int64_t>(level))) {
+      return false;
+    }
+    return Sample();
+  }
+
+  // thread-safe
+  void RecordEvent(uint32_t name_id,
+                   uint64_t start_ns,
+                   uint64_t end_ns,
+                   EventRole role,
+                   TracerEventType type);
+
+  // thread-safe
+  // The names of the events point into the EventNameTable.
+  HostEventSection<CommonEvent> Snapshot();
+
+ private:
+  // rings of exited threads kept for snapshots
+  static constexpr size_t kMaxExitedThreads = 32;
+
+  ContinuousEventRecorder() = default;
+  DISABLE_COPY_AND_ASSIGN(ContinuousEventRecorder);
+
+  bool Sample();
+
+  std::shared_ptr<EventRingBuffer> RegisterThread(uint64_t *generation);
+
+  std::atomic<int64_t> trace_level_{-1};
+  std::atomic<uint32_t> sample_period_{1};
+  std::atomic<uint64_t> generation_{0};
+  size_t events_per_thread_{0};
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<EventRingBuffer>> rings_;
+};
+
 }  // namespace phi
@@ -109,6 +109,10 @@ RecordEvent::RecordEvent(const char *name,
 #endif
 #endif
   if (UNLIKELY(HostTraceLevel::GetInstance().NeedTrace(level) == false)) {
+    if (UNLIKELY(ContinuousEventRecorder::GetInstance().NeedTrace(level))) {
+      ContinuousConstruct(
+          EventNameTable::GetInstance().Intern(name), type, role);
+    }
     return;
   }
   if (FLAGS_enable_host_event_recorder_hook == false) {
@@ -143,6 +147,10 @@ RecordEvent::RecordEvent(const std::string &name,
 #endif
 #endif
   if (UNLIKELY(HostTraceLevel::GetInstance().NeedTrace(level) == false)) {
+    if (UNLIKELY(ContinuousEventRecorder::GetInstance().NeedTrace(level))) {
+      ContinuousConstruct(
+          EventNameTable::GetInstance().Intern(name), type, role);
+    }
     return;
   }
 
@@ -177,6 +185,10 @@ RecordEvent::RecordEvent(const std::string &name,
 #endif
 
   if (UNLIKELY(HostTraceLevel::GetInstance().NeedTrace(level) == false)) {
+    if (UNLIKELY(ContinuousEventRecorder::GetInstance().NeedTrace(level))) {
+      ContinuousConstruct(
+          EventNameTable::GetInstance().Intern(name), type, role);
+    }
     return;
   }
 
@@ -215,6 +227,16 @@ void RecordEvent::OriginalConstruct(const std::string &name,
   *name_ = e->name();
 }
 
+void RecordEvent::ContinuousConstruct(uint32_t name_id,
+                                      const TracerEventType type,
+                                      const EventRole role) {
+  is_continuous_ = true;
+  name_id_ = name_id;
+  type_ = type;
+  role_ = role;
+  start_ns_ = PosixInNsec();
+}
+
 void RecordEvent::End() {
 #ifndef _WIN32
 #ifdef PADDLE_WITH_CUDA
@@ -224,6 +246,13 @@ void RecordEvent::End() {
   }
 #endif
 #endif
+  if (UNLIKELY(is_continuous_)) {
+    ContinuousEventRecorder::GetInstance().RecordEvent(
+        name_id_, start_ns_, PosixInNsec(), role_, type_);
+    // use this flag to avoid double End();
+    is_continuous_ = false;
+    return;
+  }
   if (LIKELY(FLAGS_enable_host_event_recorder_hook && is_enabled_)) {
     uint64_t end_ns = PosixInNsec();
     if (LIKELY(shallow_copy_name_ != nullptr)) {
@@ -292,4 +321,15 @@ void EnableOpInfoRecorder() { FLAGS_enable_record_op_info = true; }
 
 void DisableOpInfoRecorder() { FLAGS_enable_record_op_info = false; }
 
+void EnableContinuousHostTracing(size_t events_per_thread,
+                                 uint32_t sample_period,
+                                 uint32_t trace_level) {
+  ContinuousEventRecorder::GetInstance().Enable(
+      events_per_thread, sample_period, trace_level);
+}
+
+void DisableContinuousHostTracing() {
+  ContinuousEventRecorder::GetInstance().Disable();
+}
+
 }  // namespace phi
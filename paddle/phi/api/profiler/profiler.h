@@ -92,4 +92,11 @@ void PopEvent(const std::string& name,
 void EnableOpInfoRecorder();
 void DisableOpInfoRecorder();
 
+// Keeps the last `events_per_thread` host events of every thread, taking 1
+// in `sample_period` events whose level is not above `trace_level`.
+void EnableContinuousHostTracing(size_t events_per_thread,
+                                 uint32_t sample_period,
+                                 uint32_t trace_level);
+void DisableContinuousHostTracing();
+
 }  // namespace phi
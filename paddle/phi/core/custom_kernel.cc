@@ -39,7 +39,8 @@ void CustomKernelMap::RegisterCustomKernels() {
     LOG(INFO) << "No custom kernel info found in loaded lib(s).";
     return;
   }
-  auto& kernels = KernelFactory::Instance().kernels();
+  auto& factory = KernelFactory::Instance();
+  auto& kernels = factory.kernels();
   for (auto& pair : kernels_) {
     for (auto& info_pair : pair.second) {
       PADDLE_ENFORCE_EQ(
@@ -53,7 +54,7 @@ void CustomKernelMap::RegisterCustomKernels() {
               pair.first,
               info_pair.first));
 
-      kernels[pair.first][info_pair.first] = info_pair.second;
+      factory.AddKernel(pair.first, info_pair.first, info_pair.second);
 
       VLOG(3) << "Succeed in registering kernel [" << pair.first << ":"
               << info_pair.first
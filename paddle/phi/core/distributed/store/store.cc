@@ -43,5 +43,22 @@ void Store::set(const std::string& key, const std::vector<uint8_t>& value) {
       errors::InvalidArgument("Implement the set method in the subclass."));
 }
 
+std::vector<uint8_t> Store::compare_set(const std::string& key,
+                                        const std::vector<uint8_t>& expected,
+                                        const std::vector<uint8_t>& desired) {
+  PADDLE_THROW(errors::InvalidArgument(
+      "Implement the compare_set method in the subclass."));
+}
+
+std::vector<std::vector<uint8_t>> Store::multi_get(
+    const std::vector<std::string>& keys) {
+  std::vector<std::vector<uint8_t>> values;
+  values.reserve(keys.size());
+  for (auto& key : keys) {
+    values.emplace_back(get(key));
+  }
+  return values;
+}
+
 }  // namespace distributed
 }  // namespace phi
@@ -32,6 +32,15 @@ class Store {
   virtual bool check(const std::string& key);
   virtual void wait(const std::string& key);
   virtual void set(const std::string& key, const std::vector<uint8_t>& value);
+  // Sets key to desired if its value is expected, or if it does not exist and
+  // expected is empty. Returns the value of key after the operation, or
+  // expected if key does not exist.
+  virtual std::vector<uint8_t> compare_set(const std::string& key,
+                                           const std::vector<uint8_t>& expected,
+                                           const std::vector<uint8_t>& desired);
+  // Waits for all the keys and returns their values.
+  virtual std::vector<std::vector<uint8_t>> multi_get(
+      const std::vector<std::string>& keys);
 
   virtual int timeout() { return _timeout; }
 
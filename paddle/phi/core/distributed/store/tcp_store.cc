@@ -14,6 +14,7 @@
 
 #include "paddle/phi/core/distributed/store/tcp_store.h"
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <thread>
@@ -23,6 +24,8 @@
 #include "paddle/common/flags.h"
 #include "paddle/phi/core/distributed/store/tcp_utils.h"
 
+COMMON_DECLARE_int32(tcp_store_reactor_threads);
+
 namespace phi::distributed::detail {
 
 constexpr int INFTIME = 10000;  // 10 seconds
@@ -82,6 +85,41 @@ void MasterDaemon::_do_set(SocketType socket) {
   _notify_waiting_sockets(key);
 }
 
+void MasterDaemon::_do_compare_set(SocketType socket) {
+  std::string key = tcputils::receive_string(socket);
+  auto expected = tcputils::receive_vector<uint8_t>(socket);
+  auto desired = tcputils::receive_vector<uint8_t>(socket);
+  VLOG(8) << "MasterDaemon::_do_compare_set key(" << key << ") "
+          << GetSockName(socket);
+
+  auto iter = _store.find(key);
+  if (iter == _store.end() && !expected.empty()) {
+    tcputils::send_vector<uint8_t>(socket, expected);
+  } else if (iter != _store.end() && iter->second != expected) {
+    tcputils::send_vector<uint8_t>(socket, iter->second);
+  } else {
+    _store[key] = desired;
+    tcputils::send_vector<uint8_t>(socket, desired);
+    _notify_waiting_sockets(key);
+  }
+}
+
+void MasterDaemon::_do_multi_get(SocketType socket) {
+  size_t num_keys = tcputils::receive_value<size_t>(socket);
+  std::vector<std::string> keys(num_keys);
+  for (auto& key : keys) {
+    key = tcputils::receive_string(socket);
+  }
+  for (auto& key : keys) {
+    auto iter = _store.find(key);
+    PADDLE_ENFORCE_NE(
+        iter,
+        _store.end(),
+        common::errors::InvalidArgument("Key %s not found in TCPStore.", key));
+    tcputils::send_vector<uint8_t>(socket, iter->second);
+  }
+}
+
 void MasterDaemon::_notify_waiting_sockets(const std::string& key) {
   if (_waiting_sockets.find(key) != _waiting_sockets.end()) {
     for (auto waiting_socket : _waiting_sockets.at(key)) {
@@ -209,6 +247,12 @@ void MasterDaemon::ProcessCommands(std::vector<struct pollfd>* p_fds) {
         case Command::WAIT:
           _do_wait(fds[i].fd);
           break;
+        case Command::COMPARE_SET:
+          _do_compare_set(fds[i].fd);
+          break;
+        case Command::MULTI_GET:
+          _do_multi_get(fds[i].fd);
+          break;
         default:
           VLOG(8) << "Unknown command: " << static_cast<int>(command)
                   << " from addr info:" << GetSockName(fds[i].fd);
@@ -309,13 +353,25 @@ void MasterDaemon::run() {
   }
 }
 
+TCPServer::~TCPServer() = default;
+
 std::unique_ptr<TCPServer> TCPServer::create(uint16_t port,
                                              int nranks,
                                              int stop_check_timeout) {
   int socket = tcputils::tcp_listen("", std::to_string(port), AF_INET);
   auto server = std::make_unique<TCPServer>();
+#ifdef __linux__
+  int num_reactors = FLAGS_tcp_store_reactor_threads;
+  if (num_reactors <= 0) {
+    num_reactors = static_cast<int>(
+        std::clamp(std::thread::hardware_concurrency(), 1U, 4U));
+  }
+  server->_reactor_daemon =
+      std::make_unique<ReactorMasterDaemon>(socket, num_reactors);
+#else
   server->_master_daemon =
       MasterDaemon::start(socket, nranks, stop_check_timeout);
+#endif
   return server;
 }
 
@@ -325,21 +381,39 @@ std::unique_ptr<TCPClient> TCPClient::connect(const std::string host,
   return std::make_unique<TCPClient>(socket);
 }
 
+template <typename T>
+void TCPClient::append_bytes(const T* buffer, size_t len) {
+  auto ptr = reinterpret_cast<const char*>(buffer);
+  _send_buffer.insert(_send_buffer.end(), ptr, ptr + len * sizeof(T));
+}
+
+void TCPClient::flush() {
+  tcputils::send_bytes<char>(_socket, _send_buffer.data(), _send_buffer.size());
+  _send_buffer.clear();
+}
+
 void TCPClient::send_command_for_key(Command type, const std::string& key) {
-  tcputils::send_value<Command>(_socket, type);
+  append_bytes<Command>(&type, 1);
   if (key.empty()) {
     return;
   }
-  tcputils::send_string(_socket, key);
+  send_string(key);
+}
+
+void TCPClient::send_string(const std::string& s) {
+  std::string::size_type size = s.size();
+  append_bytes<std::string::size_type>(&size, 1);
+  append_bytes<char>(s.data(), size);
 }
 
 template <typename T>
 void TCPClient::send_value(const T& value) {
-  tcputils::send_bytes<T>(_socket, &value, 1);
+  append_bytes<T>(&value, 1);
 }
 
 template <typename T>
 T TCPClient::receive_value() {
+  flush();
   T res;
   tcputils::receive_bytes<T>(_socket, &res, 1);
   return res;
@@ -347,11 +421,14 @@ T TCPClient::receive_value() {
 
 template <typename T>
 void TCPClient::send_vector(const std::vector<T>& value) {
-  tcputils::send_vector<T>(_socket, value);
+  size_t size = value.size();
+  append_bytes<size_t>(&size, 1);
+  append_bytes<T>(value.data(), size);
 }
 
 template <typename T>
 std::vector<T> TCPClient::receive_vector() {
+  flush();
   return tcputils::receive_vector<T>(_socket);
 }
 
@@ -431,6 +508,44 @@ void TCPStore::set(const std::string& key, const std::vector<uint8_t>& value) {
   VLOG(7) << "TCPStore set.";
   _client->send_command_for_key(Command::SET, _key_prefix + key);
   _client->send_vector<uint8_t>(value);
+  _client->flush();
+}
+
+std::vector<uint8_t> TCPStore::compare_set(
+    const std::string& key,
+    const std::vector<uint8_t>& expected,
+    const std::vector<uint8_t>& desired) {
+  VLOG(7) << "TCPStore compare_set.";
+  _client->send_command_for_key(Command::COMPARE_SET, _key_prefix + key);
+  _client->send_vector<uint8_t>(expected);
+  _client->send_vector<uint8_t>(desired);
+  return _client->receive_vector<uint8_t>();
+}
+
+std::vector<std::vector<uint8_t>> TCPStore::multi_get(
+    const std::vector<std::string>& keys) {
+  VLOG(7) << "TCPStore multi_get.";
+  // the waits of all the keys go out in one write
+  for (auto& key : keys) {
+    _client->send_command_for_key(Command::WAIT, _key_prefix + key);
+  }
+  for (size_t i = 0; i < keys.size(); ++i) {
+    PADDLE_ENFORCE_EQ(
+        _client->receive_value<ReplyType>() == ReplyType::STOP_WAIT,
+        true,
+        common::errors::InvalidArgument("Stop_waiting response is expected"));
+  }
+  _client->send_command_for_key(Command::MULTI_GET, "");
+  _client->send_value<size_t>(keys.size());
+  for (auto& key : keys) {
+    _client->send_string(_key_prefix + key);
+  }
+  std::vector<std::vector<uint8_t>> values;
+  values.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    values.emplace_back(_client->receive_vector<uint8_t>());
+  }
+  return values;
 }
 
 std::vector<uint8_t> TCPStore::get(const std::string& key) {
@@ -32,13 +32,23 @@
 
 #include "paddle/phi/core/distributed/store/socket.h"
 #include "paddle/phi/core/distributed/store/store.h"
+#include "paddle/phi/core/distributed/store/tcp_store_reactor.h"
 #include "paddle/phi/core/distributed/store/tcp_utils.h"
 
 namespace phi {
 namespace distributed {
 
 enum class ReplyType { WAITING, STOP_WAIT, READY, NOT_READY };
-enum class Command { ADD, GET, CHECK, SET, WAIT, STOP };
+enum class Command {
+  ADD,
+  GET,
+  CHECK,
+  SET,
+  WAIT,
+  STOP,
+  COMPARE_SET,
+  MULTI_GET
+};
 
 namespace detail {
 
@@ -61,6 +71,8 @@ class MasterDaemon {
   void _do_get(SocketType socket);
   void _do_check(SocketType socket);
   void _do_set(SocketType socket);
+  void _do_compare_set(SocketType socket);
+  void _do_multi_get(SocketType socket);
   void _notify_waiting_sockets(const std::string&);
   SocketType _listen_socket;
   std::vector<SocketType> _sockets;
@@ -84,12 +96,16 @@ class MasterDaemon {
 class TCPServer {
  public:
   TCPServer() = default;
+  ~TCPServer();
   static std::unique_ptr<TCPServer> create(std::uint16_t port,
                                            int nranks,
                                            int stop_check_timeout);
 
  private:
   std::unique_ptr<MasterDaemon> _master_daemon;
+#ifdef __linux__
+  std::unique_ptr<ReactorMasterDaemon> _reactor_daemon;
+#endif
 };
 
 class TCPClient {
@@ -98,7 +114,11 @@ class TCPClient {
   static std::unique_ptr<TCPClient> connect(const std::string host,
                                             uint16_t port);
   ~TCPClient() { tcputils::close_socket(_socket); }
+  // The requests are buffered, and sent by flush or before a reply is
+  // received, so the commands of a request go out in one write.
   void send_command_for_key(Command type, const std::string& key);
+  void send_string(const std::string& s);
+  void flush();
 
   template <typename T>
   void send_value(const T& value);
@@ -112,7 +132,11 @@ class TCPClient {
   T receive_value();
 
  private:
+  template <typename T>
+  void append_bytes(const T* buffer, size_t len);
+
   SocketType _socket;
+  std::vector<char> _send_buffer;
 };
 
 }  // namespace detail
@@ -134,6 +158,12 @@ class TCPStore : public Store {
   bool check(const std::string& key) override;
   void wait(const std::string& key) override;
   void set(const std::string& key, const std::vector<uint8_t>& value) override;
+  std::vector<uint8_t> compare_set(
+      const std::string& key,
+      const std::vector<uint8_t>& expected,
+      const std::vector<uint8_t>& desired) override;
+  std::vector<std::vector<uint8_t>> multi_get(
+      const std::vector<std::string>& keys) override;
 
  private:
   void waitWorkers();
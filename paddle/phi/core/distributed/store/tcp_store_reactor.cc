@@ -0,0 +1,678 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/core/distributed/store/tcp_store_reactor.h"
+
+#ifdef __linux__
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+
+#include "glog/logging.h"
+
+#include "paddle/phi/core/distributed/store/tcp_store.h"
+
+namespace phi::distributed::detail {
+
+namespace {
+
+constexpr size_t kNumShards = 64;
+constexpr int kMaxEvents = 256;
+constexpr size_t kReadSize = 64 * 1024;
+// The epoll data of the wakeup eventfd and of the listen socket, the
+// connections of a reactor are numbered from kFirstConnection.
+constexpr uint64_t kWakeupTag = 0;
+constexpr uint64_t kListenTag = 1;
+constexpr uint64_t kFirstConnection = 2;
+
+// Reads the arguments of a command from the bytes received so far, in the
+// format of tcputils. A read returns false when its bytes are not all there.
+class CommandReader {
+ public:
+  CommandReader(const std::string& input, size_t pos)
+      : input_(input), pos_(pos) {}
+
+  template <typename T>
+  bool Read(T* value) {
+    if (input_.size() - pos_ < sizeof(T)) return false;
+    std::memcpy(value, input_.data() + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+
+  bool ReadString(std::string* s) {
+    std::string::size_type size = 0;
+    if (!Read(&size) || input_.size() - pos_ < size) return false;
+    s->assign(input_, pos_, size);
+    pos_ += size;
+    return true;
+  }
+
+  bool ReadVector(std::vector<uint8_t>* v) {
+    size_t size = 0;
+    if (!Read(&size) || input_.size() - pos_ < size) return false;
+    v->assign(input_.begin() + pos_, input_.begin() + pos_ + size);
+    pos_ += size;
+    return true;
+  }
+
+  size_t position() const { return pos_; }
+
+ private:
+  const std::string& input_;
+  size_t pos_;
+};
+
+template <typename T>
+void Append(std::string* output, const T& value) {
+  output->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void AppendVector(std::string* output, const std::vector<uint8_t>& value) {
+  Append<size_t>(output, value.size());
+  output->append(value.begin(), value.end());
+}
+
+using Waiter = ReactorMasterDaemon::Waiter;
+using Shard = ReactorMasterDaemon::Shard;
+
+// Moves the waiters of key out of shard, which is locked.
+void TakeWaiters(Shard* shard,
+                 const std::string& key,
+                 std::vector<Waiter>* out) {
+  auto iter = shard->waiters.find(key);
+  if (iter == shard->waiters.end()) return;
+  out->insert(out->end(), iter->second.begin(), iter->second.end());
+  shard->waiters.erase(iter);
+}
+
+struct Connection {
+  SocketType socket;
+  // the bytes received and not run yet start at input_begin
+  std::string input;
+  size_t input_begin{0};
+  // the replies not sent yet start at output_begin
+  std::string output;
+  size_t output_begin{0};
+  // whether the socket is polled for EPOLLOUT
+  bool writing{false};
+  // whether a WAIT for waiting_key pauses the connection, its socket is not
+  // polled for EPOLLIN meanwhile so a client can not grow input without bound
+  bool waiting{false};
+  std::string waiting_key;
+};
+
+}  // namespace
+
+class StoreReactor {
+ public:
+  StoreReactor(ReactorMasterDaemon* daemon,
+               size_t index,
+               SocketType listen_socket);
+  ~StoreReactor();
+
+  void Start() { thread_ = std::thread(&StoreReactor::Run, this); }
+  void Stop();
+
+  // Called from any thread.
+  void AddConnection(SocketType socket);
+  void Notify(uint64_t connection);
+  // Called on the thread of the reactor.
+  void NotifyLocal(uint64_t connection) { local_ready_.push_back(connection); }
+
+ private:
+  void Run();
+  void Wakeup();
+  void HandleWakeup();
+  void Accept();
+  void HandleEvent(uint64_t id, uint32_t events);
+  void Receive(Connection* conn);
+  void RunCommands(uint64_t id, Connection* conn);
+  bool RunCommand(uint64_t id,
+                  Connection* conn,
+                  Command command,
+                  CommandReader* reader);
+  void Resume(uint64_t id);
+  void Send(uint64_t id, Connection* conn);
+  void Close(uint64_t id);
+  void Control(int op, SocketType socket, uint64_t id, uint32_t events);
+  // Polls the socket of conn for the events its waiting and writing ask for.
+  void UpdateEvents(uint64_t id, Connection* conn);
+
+  ReactorMasterDaemon* daemon_;
+  size_t index_;
+  SocketType listen_socket_;
+  int epoll_fd_{-1};
+  int wakeup_fd_{-1};
+  std::thread thread_;
+  std::atomic<bool> stop_{false};
+
+  std::mutex queue_mutex_;
+  std::vector<SocketType> new_sockets_;
+  std::vector<uint64_t> ready_;
+  std::vector<uint64_t> local_ready_;
+
+  std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections_;
+  uint64_t next_id_{kFirstConnection};
+  std::vector<char> read_buffer_;
+};
+
+StoreReactor::StoreReactor(ReactorMasterDaemon* daemon,
+                           size_t index,
+                           SocketType listen_socket)
+    : daemon_(daemon),
+      index_(index),
+      listen_socket_(listen_socket),
+      read_buffer_(kReadSize) {
+  epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+  PADDLE_ENFORCE_NE(
+      epoll_fd_,
+      -1,
+      common::errors::Fatal("failed to create epoll errno:%d", errno));
+  wakeup_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  PADDLE_ENFORCE_NE(
+      wakeup_fd_,
+      -1,
+      common::errors::Fatal("failed to create eventfd errno:%d", errno));
+  Control(EPOLL_CTL_ADD, wakeup_fd_, kWakeupTag, EPOLLIN);
+  if (listen_socket_ != -1) {
+    Control(EPOLL_CTL_ADD, listen_socket_, kListenTag, EPOLLIN);
+  }
+}
+
+StoreReactor::~StoreReactor() {
+  if (thread_.joinable()) Stop();
+  for (auto& item : connections_) {
+    tcputils::close_socket(item.second->socket);
+  }
+  ::close(wakeup_fd_);
+  ::close(epoll_fd_);
+}
+
+void StoreReactor::Stop() {
+  stop_ = true;
+  Wakeup();
+  thread_.join();
+}
+
+void StoreReactor::Control(int op,
+                           SocketType socket,
+                           uint64_t id,
+                           uint32_t events) {
+  struct epoll_event event {};
+  event.events = events;
+  event.data.u64 = id;
+  PADDLE_ENFORCE_NE(
+      ::epoll_ctl(epoll_fd_, op, socket, &event),
+      -1,
+      common::errors::Fatal("failed to control epoll errno:%d", errno));
+}
+
+void StoreReactor::UpdateEvents(uint64_t id, Connection* conn) {
+  // a waiting connection still notices the peer closing
+  uint32_t events = conn->waiting ? EPOLLRDHUP : EPOLLIN;
+  if (conn->writing) {
+    events |= EPOLLOUT;
+  }
+  Control(EPOLL_CTL_MOD, conn->socket, id, events);
+}
+
+void StoreReactor::Wakeup() {
+  uint64_t one = 1;
+  PADDLE_ENFORCE_EQ(
+      ::write(wakeup_fd_, &one, sizeof(one)),
+      static_cast<ssize_t>(sizeof(one)),
+      common::errors::Fatal("failed to write eventfd errno:%d", errno));
+}
+
+// The queues are drained all at once after the eventfd is read, so only the
+// producer which finds them empty has to write the eventfd.
+void StoreReactor::AddConnection(SocketType socket) {
+  bool wakeup = false;
+  {
+    std::lock_guard<std::mutex> guard(queue_mutex_);
+    wakeup = new_sockets_.empty() && ready_.empty();
+    new_sockets_.push_back(socket);
+  }
+  if (wakeup) Wakeup();
+}
+
+void StoreReactor::Notify(uint64_t connection) {
+  bool wakeup = false;
+  {
+    std::lock_guard<std::mutex> guard(queue_mutex_);
+    wakeup = new_sockets_.empty() && ready_.empty();
+    ready_.push_back(connection);
+  }
+  if (wakeup) Wakeup();
+}
+
+void StoreReactor::Run() {
+  std::vector<struct epoll_event> events(kMaxEvents);
+  while (!stop_) {
+    int num_events = ::epoll_wait(epoll_fd_, events.data(), kMaxEvents, -1);
+    if (num_events == -1) {
+      if (errno == EINTR) continue;
+      PADDLE_THROW(
+          common::errors::Fatal("failed to wait epoll errno:%d", errno));
+    }
+    for (int i = 0; i < num_events; ++i) {
+      uint64_t id = events[i].data.u64;
+      if (id == kWakeupTag) {
+        HandleWakeup();
+      } else if (id == kListenTag) {
+        Accept();
+      } else {
+        HandleEvent(id, events[i].events);
+      }
+    }
+    // the waiters of the keys set by the connections of this reactor
+    while (!local_ready_.empty()) {
+      std::vector<uint64_t> ready;
+      ready.swap(local_ready_);
+      for (uint64_t id : ready) {
+        Resume(id);
+      }
+    }
+  }
+  VLOG(3) << "TCPStore: reactor " << index_ << " quits";
+}
+
+void StoreReactor::HandleWakeup() {
+  uint64_t count = 0;
+  // fails with EAGAIN when another wakeup has been read already
+  if (::read(wakeup_fd_, &count, sizeof(count)) == -1 && errno != EAGAIN) {
+    PADDLE_THROW(
+        common::errors::Fatal("failed to read eventfd errno:%d", errno));
+  }
+  std::vector<SocketType> sockets;
+  std::vector<uint64_t> ready;
+  {
+    std::lock_guard<std::mutex> guard(queue_mutex_);
+    sockets.swap(new_sockets_);
+    ready.swap(ready_);
+  }
+  for (SocketType socket : sockets) {
+    uint64_t id = next_id_++;
+    auto conn = std::make_unique<Connection>();
+    conn->socket = socket;
+    connections_.emplace(id, std::move(conn));
+    // a socket epoll refuses is closed, the reactor keeps serving the others
+    try {
+      Control(EPOLL_CTL_ADD, socket, id, EPOLLIN);
+    } catch (const std::exception& ex) {
+      LOG(WARNING) << "TCPStore: failed to watch a connection: " << ex.what();
+      Close(id);
+    }
+  }
+  for (uint64_t id : ready) {
+    Resume(id);
+  }
+}
+
+void StoreReactor::Accept() {
+  while (true) {
+    SocketType socket = ::accept4(
+        listen_socket_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (socket == -1) {
+      if (errno == EINTR) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        LOG(WARNING) << "TCPStore: failed to accept a connection: "
+                     << tcputils::socket_error().message();
+      }
+      return;
+    }
+    int value = 1;
+    ::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+    // the socket is queued before the wakeup of its reactor is written, so it
+    // is still served at the next wakeup when the write fails
+    try {
+      daemon_->Dispatch(socket);
+    } catch (const std::exception& ex) {
+      LOG(WARNING) << "TCPStore: failed to wake up a reactor: " << ex.what();
+    }
+  }
+}
+
+void StoreReactor::HandleEvent(uint64_t id, uint32_t events) {
+  auto iter = connections_.find(id);
+  // closed by an earlier event of the batch
+  if (iter == connections_.end()) return;
+  Connection* conn = iter->second.get();
+  try {
+    if (events & ~EPOLLOUT) {
+      Receive(conn);
+      RunCommands(id, conn);
+    }
+    Send(id, conn);
+  } catch (const std::exception& ex) {
+    std::string s(ex.what());
+    if (s.find("TCP connection reset by peer") != std::string::npos) {
+      VLOG(5) << "TCP connection reset by peer";
+    } else {
+      VLOG(5) << "Meet some exceptions during run:" << ex.what();
+    }
+    Close(id);
+  }
+}
+
+void StoreReactor::Receive(Connection* conn) {
+  while (true) {
+    auto received = ::recv(conn->socket, read_buffer_.data(), kReadSize, 0);
+    if (received > 0) {
+      conn->input.append(read_buffer_.data(), received);
+      if (static_cast<size_t>(received) < kReadSize) return;
+      continue;
+    }
+    if (received == 0) {
+      PADDLE_THROW(common::errors::InvalidArgument(
+          "TCP connection reset by peer. Details: %s.",
+          tcputils::socket_error().message()));
+    }
+    if (errno == EINTR) continue;
+    if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+    PADDLE_THROW(
+        common::errors::InvalidArgument("TCP receive error. Details: %s.",
+                                        tcputils::socket_error().message()));
+  }
+}
+
+void StoreReactor::RunCommands(uint64_t id, Connection* conn) {
+  while (!conn->waiting) {
+    CommandReader reader(conn->input, conn->input_begin);
+    Command command;
+    if (!reader.Read(&command) || !RunCommand(id, conn, command, &reader)) {
+      break;
+    }
+    conn->input_begin = reader.position();
+  }
+  if (conn->input_begin == conn->input.size()) {
+    conn->input.clear();
+    conn->input_begin = 0;
+  } else if (conn->input_begin >= kReadSize) {
+    conn->input.erase(0, conn->input_begin);
+    conn->input_begin = 0;
+  }
+}
+
+// Runs command if its arguments have all been received, and returns whether
+// it has run.
+bool StoreReactor::RunCommand(uint64_t id,
+                              Connection* conn,
+                              Command command,
+                              CommandReader* reader) {
+  std::string key;
+  std::vector<Waiter> waiters;
+  switch (command) {
+    case Command::ADD: {
+      int64_t value = 0;
+      if (!reader->ReadString(&key) || !reader->Read(&value)) return false;
+      {
+        auto& shard = daemon_->GetShard(key);
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        auto iter = shard.data.find(key);
+        if (iter != shard.data.end()) {
+          value += std::stoll(
+              std::string(iter->second.begin(), iter->second.end()));
+        }
+        std::string value_str = std::to_string(value);
+        shard.data[key] =
+            std::vector<uint8_t>(value_str.begin(), value_str.end());
+        TakeWaiters(&shard, key, &waiters);
+      }
+      VLOG(8) << "TCPStore: new value (" << value << ") for key (" << key
+              << ")";
+      Append(&conn->output, value);
+      break;
+    }
+    case Command::SET: {
+      std::vector<uint8_t> value;
+      if (!reader->ReadString(&key) || !reader->ReadVector(&value)) {
+        return false;
+      }
+      auto& shard = daemon_->GetShard(key);
+      std::lock_guard<std::mutex> guard(shard.mutex);
+      shard.data[key] = std::move(value);
+      TakeWaiters(&shard, key, &waiters);
+      break;
+    }
+    case Command::GET: {
+      if (!reader->ReadString(&key)) return false;
+      auto& shard = daemon_->GetShard(key);
+      std::lock_guard<std::mutex> guard(shard.mutex);
+      auto iter = shard.data.find(key);
+      PADDLE_ENFORCE_NE(
+          iter,
+          shard.data.end(),
+          common::errors::InvalidArgument("Key %s not found in TCPStore.",
+                                          key));
+      AppendVector(&conn->output, iter->second);
+      break;
+    }
+    case Command::CHECK: {
+      if (!reader->ReadString(&key)) return false;
+      auto& shard = daemon_->GetShard(key);
+      std::lock_guard<std::mutex> guard(shard.mutex);
+      Append(&conn->output,
+             shard.data.count(key) ? ReplyType::READY : ReplyType::NOT_READY);
+      break;
+    }
+    case Command::WAIT: {
+      if (!reader->ReadString(&key)) return false;
+      auto& shard = daemon_->GetShard(key);
+      std::lock_guard<std::mutex> guard(shard.mutex);
+      if (shard.data.count(key)) {
+        Append(&conn->output, ReplyType::STOP_WAIT);
+      } else {
+        shard.waiters[key].push_back({index_, id});
+        conn->waiting = true;
+        conn->waiting_key = key;
+        UpdateEvents(id, conn);
+      }
+      break;
+    }
+    case Command::COMPARE_SET: {
+      std::vector<uint8_t> expected;
+      std::vector<uint8_t> desired;
+      if (!reader->ReadString(&key) || !reader->ReadVector(&expected) ||
+          !reader->ReadVector(&desired)) {
+        return false;
+      }
+      auto& shard = daemon_->GetShard(key);
+      std::lock_guard<std::mutex> guard(shard.mutex);
+      auto iter = shard.data.find(key);
+      if (iter == shard.data.end() && !expected.empty()) {
+        AppendVector(&conn->output, expected);
+      } else if (iter != shard.data.end() && iter->second != expected) {
+        AppendVector(&conn->output, iter->second);
+      } else {
+        AppendVector(&conn->output, desired);
+        shard.data[key] = std::move(desired);
+        TakeWaiters(&shard, key, &waiters);
+      }
+      break;
+    }
+    case Command::MULTI_GET: {
+      size_t num_keys = 0;
+      if (!reader->Read(&num_keys)) return false;
+      std::vector<std::string> keys(num_keys);
+      for (auto& each : keys) {
+        if (!reader->ReadString(&each)) return false;
+      }
+      for (auto& each : keys) {
+        auto& shard = daemon_->GetShard(each);
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        auto iter = shard.data.find(each);
+        PADDLE_ENFORCE_NE(
+            iter,
+            shard.data.end(),
+            common::errors::InvalidArgument("Key %s not found in TCPStore.",
+                                            each));
+        AppendVector(&conn->output, iter->second);
+      }
+      break;
+    }
+    default:
+      PADDLE_THROW(common::errors::InvalidArgument(
+          "Unknown command %d of TCPStore.", static_cast<int>(command)));
+  }
+  if (!waiters.empty()) {
+    VLOG(7) << "TCPStore: notify " << waiters.size()
+            << " sockets that key: " << key << " is ready.";
+    daemon_->Notify(waiters, index_);
+  }
+  return true;
+}
+
+void StoreReactor::Resume(uint64_t id) {
+  auto iter = connections_.find(id);
+  if (iter == connections_.end() || !iter->second->waiting) return;
+  Connection* conn = iter->second.get();
+  conn->waiting = false;
+  conn->waiting_key.clear();
+  Append(&conn->output, ReplyType::STOP_WAIT);
+  try {
+    UpdateEvents(id, conn);
+    RunCommands(id, conn);
+    Send(id, conn);
+  } catch (const std::exception& ex) {
+    VLOG(5) << "Meet some exceptions during run:" << ex.what();
+    Close(id);
+  }
+}
+
+void StoreReactor::Send(uint64_t id, Connection* conn) {
+  while (conn->output_begin < conn->output.size()) {
+    auto sent = ::send(conn->socket,
+                       conn->output.data() + conn->output_begin,
+                       conn->output.size() - conn->output_begin,
+                       MSG_NOSIGNAL);
+    if (sent >= 0) {
+      conn->output_begin += sent;
+      continue;
+    }
+    if (errno == EINTR) continue;
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      // the rest is sent when the socket is writable
+      if (!conn->writing) {
+        conn->writing = true;
+        UpdateEvents(id, conn);
+      }
+      return;
+    }
+    PADDLE_THROW(
+        common::errors::InvalidArgument("TCP send error. Details: %s.",
+                                        tcputils::socket_error().message()));
+  }
+  conn->output.clear();
+  conn->output_begin = 0;
+  if (conn->writing) {
+    conn->writing = false;
+    UpdateEvents(id, conn);
+  }
+}
+
+void StoreReactor::Close(uint64_t id) {
+  auto iter = connections_.find(id);
+  if (iter == connections_.end()) return;
+  Connection* conn = iter->second.get();
+  if (conn->waiting) {
+    auto& shard = daemon_->GetShard(conn->waiting_key);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    auto waiters = shard.waiters.find(conn->waiting_key);
+    if (waiters != shard.waiters.end()) {
+      auto& list = waiters->second;
+      list.erase(std::remove_if(list.begin(),
+                                list.end(),
+                                [&](const Waiter& waiter) {
+                                  return waiter.reactor == index_ &&
+                                         waiter.connection == id;
+                                }),
+                 list.end());
+      if (list.empty()) shard.waiters.erase(waiters);
+    }
+  }
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn->socket, nullptr);
+  tcputils::close_socket(conn->socket);
+  connections_.erase(iter);
+}
+
+ReactorMasterDaemon::ReactorMasterDaemon(SocketType listen_socket,
+                                         int num_reactors)
+    : listen_socket_(listen_socket) {
+  PADDLE_ENFORCE_GT(num_reactors,
+                    0,
+                    common::errors::InvalidArgument(
+                        "The number of reactors of TCPStore should be "
+                        "positive, but received %d.",
+                        num_reactors));
+  int flags = ::fcntl(listen_socket_, F_GETFL, 0);
+  PADDLE_ENFORCE_NE(
+      ::fcntl(listen_socket_, F_SETFL, flags | O_NONBLOCK),
+      -1,
+      common::errors::Fatal("failed to set the listen socket nonblocking "
+                            "errno:%d",
+                            errno));
+  for (size_t i = 0; i < kNumShards; ++i) {
+    shards_.emplace_back(std::make_unique<Shard>());
+  }
+  // the first reactor accepts the connections for all
+  for (int i = 0; i < num_reactors; ++i) {
+    reactors_.emplace_back(
+        std::make_unique<StoreReactor>(this, i, i == 0 ? listen_socket_ : -1));
+  }
+  for (auto& reactor : reactors_) {
+    reactor->Start();
+  }
+  VLOG(3) << "TCPStore: serve on " << num_reactors << " reactors";
+}
+
+ReactorMasterDaemon::~ReactorMasterDaemon() {
+  VLOG(8) << ("begin to destruct ReactorMasterDaemon");
+  // all stop before any is destroyed, since they notify each other
+  for (auto& reactor : reactors_) {
+    reactor->Stop();
+  }
+  reactors_.clear();
+  tcputils::close_socket(listen_socket_);
+}
+
+ReactorMasterDaemon::Shard& ReactorMasterDaemon::GetShard(
+    const std::string& key) {
+  return *shards_[std::hash<std::string>{}(key) % shards_.size()];
+}
+
+void ReactorMasterDaemon::Dispatch(SocketType socket) {
+  reactors_[next_reactor_++ % reactors_.size()]->AddConnection(socket);
+}
+
+void ReactorMasterDaemon::Notify(const std::vector<Waiter>& waiters,
+                                 size_t from_reactor) {
+  for (auto& waiter : waiters) {
+    if (waiter.reactor == from_reactor) {
+      reactors_[waiter.reactor]->NotifyLocal(waiter.connection);
+    } else {
+      reactors_[waiter.reactor]->Notify(waiter.connection);
+    }
+  }
+}
+
+}  // namespace phi::distributed::detail
+
+#endif
@@ -0,0 +1,83 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#ifdef __linux__
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/phi/core/distributed/store/tcp_utils.h"
+
+namespace phi {
+namespace distributed {
+namespace detail {
+
+class StoreReactor;
+
+// The TCPStore server on Linux, which serves the same commands as
+// MasterDaemon on several reactor threads, each waiting on its own epoll
+// instance for the connections it owns.
+//
+// A reactor reads all the bytes a client has sent, runs the complete
+// commands in order and sends their replies in one write, so a client may
+// pipeline its requests. A WAIT for a missing key pauses its connection until
+// the key is set, the later commands stay buffered to keep the replies in
+// order. The keys are sharded by hash, and each shard keeps the connections
+// waiting for its keys, so setting a key notifies exactly its waiters.
+class ReactorMasterDaemon {
+ public:
+  ReactorMasterDaemon(SocketType listen_socket, int num_reactors);
+  ~ReactorMasterDaemon();
+
+  ReactorMasterDaemon(const ReactorMasterDaemon&) = delete;
+  ReactorMasterDaemon& operator=(const ReactorMasterDaemon&) = delete;
+
+  // A connection waiting for a key, by the reactor owning it.
+  struct Waiter {
+    size_t reactor;
+    uint64_t connection;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::vector<uint8_t>> data;
+    std::unordered_map<std::string, std::vector<Waiter>> waiters;
+  };
+
+  Shard& GetShard(const std::string& key);
+  // Hands an accepted connection to the next reactor.
+  void Dispatch(SocketType socket);
+  // Tells the reactors of waiters that their key is ready.
+  void Notify(const std::vector<Waiter>& waiters, size_t from_reactor);
+
+ private:
+  SocketType listen_socket_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::vector<std::unique_ptr<StoreReactor>> reactors_;
+  std::atomic<size_t> next_reactor_{0};
+};
+
+}  // namespace detail
+}  // namespace distributed
+}  // namespace phi
+
+#endif
@@ -368,6 +368,63 @@ KernelResult KernelFactory::SelectKernelOrThrowError(
   return {kernel_iter->second, false, false};
 }
 
+void KernelFactory::AddKernel(const std::string& kernel_name,
+                              const KernelKey& kernel_key,
+                              const Kernel& kernel) {
+  kernels_[kernel_name][kernel_key] = kernel;
+  version_.fetch_add(1, std::memory_order_release);
+}
+
+void KernelFactory::RemoveKernels(const std::string& kernel_name) {
+  kernels_.erase(kernel_name);
+  version_.fetch_add(1, std::memory_order_release);
+}
+
+void KernelFactory::ClearKernels() {
+  kernels_.clear();
+  version_.fetch_add(1, std::memory_order_release);
+}
+
+KernelResult KernelDispatchCache::SelectKernelOrThrowError(
+    const KernelKey& kernel_key, bool use_strided_kernel) {
+  auto& factory = KernelFactory::Instance();
+  const uint64_t version = factory.version();
+  if (version != version_) {
+    version_ = version;
+    num_entries_ = 0;
+    next_entry_ = 0;
+  }
+  uint8_t options = static_cast<uint8_t>(use_strided_kernel) |
+                    static_cast<uint8_t>(FLAGS_use_stride_kernel) << 1 |
+                    static_cast<uint8_t>(FLAGS_enable_api_kernel_fallback)
+                        << 2;
+#if defined(PADDLE_WITH_XPU_KP)
+  options |= static_cast<uint8_t>(FLAGS_run_kp_kernel) << 3;
+#endif
+  for (size_t i = 0; i < num_entries_; ++i) {
+    const Entry& entry = entries_[i];
+    if (entry.kernel_key == kernel_key && entry.options == options) {
+      return {*entry.kernel, entry.has_fallback_cpu, entry.is_stride_kernel};
+    }
+  }
+
+  KernelResult result = factory.SelectKernelOrThrowError(
+      kernel_name_, kernel_key, use_strided_kernel);
+  Entry* entry;
+  if (num_entries_ < kNumEntries) {
+    entry = &entries_[num_entries_++];
+  } else {
+    entry = &entries_[next_entry_];
+    next_entry_ = (next_entry_ + 1) % kNumEntries;
+  }
+  entry->kernel_key = kernel_key;
+  entry->options = options;
+  entry->kernel = &result.kernel;
+  entry->has_fallback_cpu = result.has_fallback_cpu;
+  entry->is_stride_kernel = result.is_stride_kernel;
+  return result;
+}
+
 const KernelArgsDef& KernelFactory::GetFirstKernelArgsDef(
     const std::string& kernel_name) const {
   auto iter = kernels_.find(kernel_name);
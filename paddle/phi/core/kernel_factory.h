@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <map>
 #include <ostream>
 #include <unordered_map>
@@ -319,6 +321,21 @@ class KernelFactory {
 
   KernelNameMap& kernels() { return kernels_; }
 
+  // Registers or replaces a kernel. Use it instead of writing to kernels(),
+  // so that the KernelDispatchCaches drop what they hold.
+  void AddKernel(const std::string& kernel_name,
+                 const KernelKey& kernel_key,
+                 const Kernel& kernel);
+
+  // Removes every kernel of kernel_name.
+  void RemoveKernels(const std::string& kernel_name);
+
+  void ClearKernels();
+
+  // Changes whenever kernels are added or removed, which may move the
+  // registered kernels.
+  uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
   bool HasCompatiblePhiKernel(const std::string& op_type) const;
 
   bool HasStructuredKernel(const std::string& op_type) const;
@@ -353,10 +370,50 @@ class KernelFactory {
 
   KernelNameMap kernels_;
 
+  std::atomic<uint64_t> version_{0};
+
   // Get the low precision kernel list of current module.
   std::map<const std::string, OpCount> low_precision_kernels_;
 };
 
+/**
+ * Remembers the kernels that KernelFactory::SelectKernelOrThrowError picked
+ * for one kernel name, so that repeated selections with the same key skip
+ * the lookup of the name and the fallback logic. The generated API keeps a
+ * thread_local cache per call site, so a cache is not thread safe.
+ *
+ * An entry is keyed by the kernel key and the options of the selection,
+ * including the flags it reads. The cache drops all entries when the
+ * version of the KernelFactory changes, e.g. when custom kernels register.
+ */
+class KernelDispatchCache {
+ public:
+  explicit KernelDispatchCache(const std::string& kernel_name)
+      : kernel_name_(kernel_name) {}
+
+  KernelResult SelectKernelOrThrowError(const KernelKey& kernel_key,
+                                        bool use_strided_kernel = false);
+
+  const std::string& kernel_name() const { return kernel_name_; }
+
+ private:
+  static constexpr size_t kNumEntries = 4;
+
+  struct Entry {
+    KernelKey kernel_key;
+    uint8_t options{0};
+    const Kernel* kernel{nullptr};
+    bool has_fallback_cpu{false};
+    bool is_stride_kernel{false};
+  };
+
+  std::string kernel_name_;
+  uint64_t version_{0};
+  std::array<Entry, kNumEntries> entries_;
+  size_t num_entries_{0};
+  size_t next_entry_{0};
+};
+
 inline std::ostream& operator<<(std::ostream& os, const KernelKey& kernel_key) {
   os << "(" << kernel_key.backend() << ", " << kernel_key.layout() << ", "
      << kernel_key.dtype() << ")";
@@ -27,6 +27,7 @@
 #include "paddle/phi/core/memory/allocation/cpu_allocator.h"
 #include "paddle/phi/core/memory/allocation/naive_best_fit_allocator.h"
 #include "paddle/phi/core/memory/allocation/retry_allocator.h"
+#include "paddle/phi/core/memory/allocation/size_class_cpu_allocator.h"
 #include "paddle/phi/core/memory/allocation/stat_allocator.h"
 
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
@@ -111,6 +112,25 @@ PHI_DEFINE_EXPORTED_bool(
     "Whether to use AutoGrowthBestFitAllocatorV2 for auto_growth "
     "strategy");
 
+PHI_DEFINE_EXPORTED_bool(
+    use_size_class_cpu_allocator,
+    false,
+    "Whether to use SizeClassCPUAllocator, which caches freed blocks by size "
+    "class in per-thread and per-NUMA-node free lists, for CPU memory");
+
+PHI_DEFINE_EXPORTED_uint64(
+    size_class_cpu_allocator_thread_cache_kb,
+    2048,
+    "The bytes (KB) of freed blocks every thread may cache in "
+    "SizeClassCPUAllocator before moving them to the central free lists");
+
+PHI_DEFINE_EXPORTED_int64(
+    size_class_cpu_allocator_release_interval_ms,
+    10000,
+    "The interval (milliseconds) of returning the central free lists of "
+    "SizeClassCPUAllocator that were not used in it to the OS. No periodic "
+    "release if this value is not greater than 0");
+
 COMMON_DECLARE_string(allocator_strategy);
 COMMON_DECLARE_uint64(auto_growth_chunk_size_in_mb);
 COMMON_DECLARE_bool(use_auto_growth_pinned_allocator);
@@ -822,7 +842,15 @@ class AllocatorFacadePrivate {
     allocators_[phi::CPUPlace()] =
         std::make_shared<NaiveBestFitAllocator>(phi::CPUPlace());
 #else
-    allocators_[phi::CPUPlace()] = std::make_shared<CPUAllocator>();
+    if (FLAGS_use_size_class_cpu_allocator) {
+      VLOG(4) << "FLAGS_size_class_cpu_allocator_thread_cache_kb is "
+              << FLAGS_size_class_cpu_allocator_thread_cache_kb;
+      allocators_[phi::CPUPlace()] = std::make_shared<SizeClassCPUAllocator>(
+          FLAGS_size_class_cpu_allocator_thread_cache_kb << 10,
+          FLAGS_size_class_cpu_allocator_release_interval_ms);
+    } else {
+      allocators_[phi::CPUPlace()] = std::make_shared<CPUAllocator>();
+    }
 #endif
   }
 
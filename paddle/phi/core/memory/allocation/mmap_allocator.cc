@@ -18,6 +18,8 @@
 
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <cstdlib>
 
 #include <atomic>
@@ -247,6 +249,50 @@ void RefcountedMemoryMapAllocation::close() {
   }
 }
 
+std::shared_ptr<MemoryMapFileAllocation> AllocateMemoryMapFileAllocation(
+    const std::string &filename) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_NE(
+      fd,
+      -1,
+      common::errors::Unavailable(
+          "Failed to open file %s: %s.", filename, strerror(errno)));
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == -1 || file_stat.st_size == 0) {
+    ::close(fd);
+    PADDLE_THROW(common::errors::Unavailable(
+        "Failed to map file %s: it is empty or cannot be read.", filename));
+  }
+  size_t size = static_cast<size_t>(file_stat.st_size);
+  // The mapping is writable for the passes which update parameters in place,
+  // and private so that the writes stay in this process.
+  void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if (ptr == MAP_FAILED) {
+    ::close(fd);
+    PADDLE_THROW(common::errors::Unavailable(
+        "Failed to map file %s: %s.", filename, strerror(errno)));
+  }
+  VLOG(4) << "Map file " << filename << " of " << size << " bytes";
+  return std::make_shared<MemoryMapFileAllocation>(ptr, size, filename, fd);
+}
+
+void MemoryMapFileAllocation::close() {
+  if (closed_) {
+    return;
+  }
+  closed_ = true;
+  closed_fd_ = true;
+  PADDLE_ENFORCE_NE(munmap(map_ptr_, map_size_),
+                    -1,
+                    common::errors::Unavailable(
+                        "could not unmap the file: ",
+                        strerror(errno),
+                        " (",
+                        errno,
+                        ")"));
+  ::close(fd_);
+}
+
 MemoryMapWriterAllocation::~MemoryMapWriterAllocation() {
   if (munmap(this->ptr(), this->size()) == -1) {
     common::errors::Unavailable("could not unmap the shared memory file %s",
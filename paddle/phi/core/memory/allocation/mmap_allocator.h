@@ -112,6 +112,22 @@ AllocateRefcountedMemoryMapAllocation(std::string filename,
                                       size_t size,
                                       int buffer_id = -1);
 
+// A private mapping of a whole file, e.g. the parameters of an inference
+// model. The pages come from the page cache and are shared by all the
+// processes which map the file, until a process writes to a page and gets
+// its own copy.
+class MemoryMapFileAllocation : public MemoryMapAllocation {
+ public:
+  MemoryMapFileAllocation(void *ptr, size_t size, std::string filename, int fd)
+      : MemoryMapAllocation(ptr, size, std::move(filename), fd) {}
+
+  void close() override;
+  ~MemoryMapFileAllocation() override { close(); }
+};
+
+std::shared_ptr<MemoryMapFileAllocation> AllocateMemoryMapFileAllocation(
+    const std::string &filename);
+
 class MemoryMapWriterAllocation : public Allocation {
  public:
   explicit MemoryMapWriterAllocation(void *ptr,
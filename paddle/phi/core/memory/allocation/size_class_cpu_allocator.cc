@@ -0,0 +1,598 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/core/memory/allocation/size_class_cpu_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <intrin.h>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "glog/logging.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/memory/allocation/cpu_allocator.h"
+#include "paddle/phi/core/memory/stats.h"
+
+namespace paddle::memory::allocation {
+
+namespace {
+
+constexpr size_t kSmallClassNum = 16;
+constexpr size_t kSmallClassStep = 64;
+constexpr size_t kClassesPerOctave = 4;
+// 1KB < size <= 1MB takes ten octaves
+constexpr size_t kClassNum = kSmallClassNum + kClassesPerOctave * 10;
+constexpr size_t kPageSize = 4096;
+constexpr uint32_t kMaxThreadCacheBlocks = 256;
+constexpr int kMaxArenaNum = 64;
+
+// Header written into a cached block, only touched by the thread owning it.
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+// A run of cached blocks in a central list. Batches are recycled but never
+// freed before the central cache, so a stale reader of `next` in
+// BatchStack::Pop() always reads a valid atomic.
+struct Batch {
+  std::atomic<Batch*> next{nullptr};
+  FreeBlock* blocks = nullptr;
+  size_t count = 0;
+};
+
+void* AllocateFromSystem(size_t size, size_t alignment) {
+  void* p = nullptr;
+#ifdef _WIN32
+  p = _aligned_malloc(size, alignment);
+  PADDLE_ENFORCE_NOT_NULL(
+      p,
+      common::errors::ResourceExhausted("Fail to alloc memory of %ld size.",
+                                        size));
+#else
+  int error = posix_memalign(&p, alignment, size);
+  PADDLE_ENFORCE_EQ(
+      error,
+      0,
+      common::errors::ResourceExhausted(
+          "Fail to alloc memory of %ld size, error code is %d.", size, error));
+#endif
+  HOST_MEMORY_STAT_UPDATE(Reserved, 0, size);
+  return p;
+}
+
+void FreeToSystem(void* p, size_t size) {
+#ifdef _WIN32
+  _aligned_free(p);
+#else
+  free(p);  // NOLINT
+#endif
+  HOST_MEMORY_STAT_UPDATE(Reserved, 0, -size);
+}
+
+// Index of the highest set bit of a non zero `x`.
+size_t HighestBit(uint64_t x) {
+#ifdef _WIN32
+  unsigned long index = 0;  // NOLINT
+  _BitScanReverse64(&index, x);
+  return index;
+#else
+  return 63 - __builtin_clzll(x);
+#endif
+}
+
+size_t ClassAlignment(size_t cls) {
+  return SizeClassCPUAllocator::ClassToSize(cls) >= kPageSize
+             ? kPageSize
+             : SizeClassCPUAllocator::kAlignment;
+}
+
+int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+int NumaNodeNum() {
+  int num = 1;
+#ifdef __linux__
+  for (int node = 1; node < kMaxArenaNum; ++node) {
+    std::string path = "/sys/devices/system/node/node" + std::to_string(node);
+    if (access(path.c_str(), F_OK) == 0) {
+      num = node + 1;
+    }
+  }
+#endif
+  return num;
+}
+
+// Treiber stack of batches. The head packs a 48 bit pointer with a 16 bit
+// version against ABA.
+class BatchStack {
+ public:
+  void Push(Batch* batch) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    do {
+      batch->next.store(Pointer(head), std::memory_order_relaxed);
+    } while (!head_.compare_exchange_weak(head,
+                                          Pack(batch, head),
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+  }
+
+  Batch* Pop() {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    Batch* top = Pointer(head);
+    while (top != nullptr) {
+      Batch* next = top->next.load(std::memory_order_relaxed);
+      if (head_.compare_exchange_weak(head,
+                                      Pack(next, head),
+                                      std::memory_order_acquire,
+                                      std::memory_order_acquire)) {
+        break;
+      }
+      top = Pointer(head);
+    }
+    return top;
+  }
+
+  // Detaches all batches, linked by their `next`.
+  Batch* PopAll() {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    while (Pointer(head) != nullptr &&
+           !head_.compare_exchange_weak(head,
+                                        Pack(nullptr, head),
+                                        std::memory_order_acquire,
+                                        std::memory_order_acquire)) {
+    }
+    return Pointer(head);
+  }
+
+  static bool Fits(const void* p) {
+    return (reinterpret_cast<uintptr_t>(p) & ~kPointerMask) == 0;
+  }
+
+ private:
+  static constexpr uint64_t kPointerBits = 48;
+  static constexpr uint64_t kPointerMask = (1ULL << kPointerBits) - 1;
+
+  static Batch* Pointer(uint64_t head) {
+    return reinterpret_cast<Batch*>(head & kPointerMask);
+  }
+
+  // next version of `head`, pointing to `batch`
+  static uint64_t Pack(Batch* batch, uint64_t head) {
+    return ((head & ~kPointerMask) + (1ULL << kPointerBits)) |
+           reinterpret_cast<uintptr_t>(batch);
+  }
+
+  std::atomic<uint64_t> head_{0};
+};
+
+struct alignas(64) CentralFreeList {
+  BatchStack batches;
+  // whether the list was popped since the last periodic release
+  std::atomic<bool> popped{false};
+};
+
+}  // namespace
+
+// Central lists of all classes, one set per NUMA node.
+class SizeClassCentralCache {
+ public:
+  SizeClassCentralCache(size_t thread_cache_bytes, int64_t release_interval_ms)
+      : thread_cache_bytes_(thread_cache_bytes),
+        release_interval_ms_(release_interval_ms),
+        arena_num_(NumaNodeNum()),
+        lists_(new CentralFreeList[arena_num_ * kClassNum]),
+        next_release_ms_(NowMs() + release_interval_ms) {
+    VLOG(4) << "SizeClassCPUAllocator uses " << arena_num_ << " arena(s), "
+            << thread_cache_bytes_ << " bytes of thread cache";
+  }
+
+  ~SizeClassCentralCache() { Release(false); }
+
+  size_t thread_cache_bytes() const { return thread_cache_bytes_; }
+
+  size_t CachedBytes() const {
+    return cached_bytes_.load(std::memory_order_relaxed);
+  }
+
+  // arena of the NUMA node the calling thread runs on
+  int CurrentArena() const {
+#ifdef __linux__
+    unsigned cpu = 0, node = 0;
+    if (arena_num_ > 1 && syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+      return static_cast<int>(node) % arena_num_;
+    }
+#endif
+    return 0;
+  }
+
+  // Moves `count` blocks linked from `blocks` to the list of the arena.
+  void Push(int arena, size_t cls, FreeBlock* blocks, size_t count) {
+    Batch* batch = NewBatch();
+    batch->blocks = blocks;
+    batch->count = count;
+    // counted first, so that a concurrent Pop() never makes it negative
+    cached_bytes_.fetch_add(count * SizeClassCPUAllocator::ClassToSize(cls),
+                            std::memory_order_relaxed);
+    List(arena, cls).batches.Push(batch);
+  }
+
+  // Pops a batch of the arena, or of another one if it has none.
+  FreeBlock* Pop(int arena, size_t cls, size_t* count) {
+    for (int i = 0; i < arena_num_; ++i) {
+      CentralFreeList& list = List((arena + i) % arena_num_, cls);
+      if (!list.popped.load(std::memory_order_relaxed)) {
+        list.popped.store(true, std::memory_order_relaxed);
+      }
+      Batch* batch = list.batches.Pop();
+      if (batch != nullptr) {
+        FreeBlock* blocks = batch->blocks;
+        *count = batch->count;
+        cached_bytes_.fetch_sub(
+            *count * SizeClassCPUAllocator::ClassToSize(cls),
+            std::memory_order_relaxed);
+        free_batches_.Push(batch);
+        return blocks;
+      }
+    }
+    return nullptr;
+  }
+
+  // Returns the lists to the OS, only those not popped since the last
+  // release if `idle_only`.
+  uint64_t Release(bool idle_only) {
+    uint64_t bytes = 0;
+    for (int arena = 0; arena < arena_num_; ++arena) {
+      for (size_t cls = 0; cls < kClassNum; ++cls) {
+        CentralFreeList& list = List(arena, cls);
+        if (list.popped.exchange(false, std::memory_order_relaxed) &&
+            idle_only) {
+          continue;
+        }
+        size_t size = SizeClassCPUAllocator::ClassToSize(cls);
+        Batch* batch = list.batches.PopAll();
+        while (batch != nullptr) {
+          Batch* next = batch->next.load(std::memory_order_relaxed);
+          cached_bytes_.fetch_sub(batch->count * size,
+                                  std::memory_order_relaxed);
+          bytes += batch->count * size;
+          FreeBlocks(batch->blocks, size);
+          free_batches_.Push(batch);
+          batch = next;
+        }
+      }
+    }
+    VLOG(10) << "SizeClassCPUAllocator releases " << bytes << " bytes";
+    return bytes;
+  }
+
+  // Runs the periodic release on the thread that first sees it is due.
+  void MaybeRelease() {
+    if (release_interval_ms_ <= 0) {
+      return;
+    }
+    int64_t now = NowMs();
+    int64_t due = next_release_ms_.load(std::memory_order_relaxed);
+    if (now >= due && next_release_ms_.compare_exchange_strong(
+                          due,
+                          now + release_interval_ms_,
+                          std::memory_order_relaxed)) {
+      Release(true);
+    }
+  }
+
+ private:
+  CentralFreeList& List(int arena, size_t cls) {
+    return lists_[arena * kClassNum + cls];
+  }
+
+  Batch* NewBatch() {
+    Batch* batch = free_batches_.Pop();
+    if (batch != nullptr) {
+      return batch;
+    }
+    std::unique_ptr<Batch[]> chunk(new Batch[kBatchChunkSize]);
+    PADDLE_ENFORCE_EQ(
+        BatchStack::Fits(chunk.get() + kBatchChunkSize),
+        true,
+        common::errors::Unavailable(
+            "SizeClassCPUAllocator needs heap addresses below 2^48."));
+    for (size_t i = 1; i < kBatchChunkSize; ++i) {
+      free_batches_.Push(&chunk[i]);
+    }
+    batch = &chunk[0];
+    std::lock_guard<std::mutex> guard(chunks_mutex_);
+    batch_chunks_.emplace_back(std::move(chunk));
+    return batch;
+  }
+
+  static void FreeBlocks(FreeBlock* blocks, size_t size) {
+    while (blocks != nullptr) {
+      FreeBlock* next = blocks->next;
+      FreeToSystem(blocks, size);
+      blocks = next;
+    }
+  }
+
+  static constexpr size_t kBatchChunkSize = 256;
+
+  const size_t thread_cache_bytes_;
+  const int64_t release_interval_ms_;
+  const int arena_num_;
+  std::unique_ptr<CentralFreeList[]> lists_;
+  std::atomic<int64_t> next_release_ms_;
+  std::atomic<size_t> cached_bytes_{0};
+  BatchStack free_batches_;
+  std::mutex chunks_mutex_;
+  std::vector<std::unique_ptr<Batch[]>> batch_chunks_;
+};
+
+namespace {
+
+// Per thread free lists of one allocator, no synchronization needed.
+class SizeClassThreadCache {
+ public:
+  explicit SizeClassThreadCache(std::shared_ptr<SizeClassCentralCache> central)
+      : central_(std::move(central)), arena_(central_->CurrentArena()) {
+    for (size_t cls = 0; cls < kClassNum; ++cls) {
+      // a class may take 1/8 of the budget, flushed half at a time
+      size_t blocks = central_->thread_cache_bytes() / 8 /
+                      SizeClassCPUAllocator::ClassToSize(cls);
+      limits_[cls] = static_cast<uint32_t>(
+          std::min<size_t>(std::max<size_t>(blocks, 2), kMaxThreadCacheBlocks));
+    }
+  }
+
+  ~SizeClassThreadCache() { FlushAll(); }
+
+  SizeClassCentralCache* central() const { return central_.get(); }
+
+  // whether the allocator of the central cache is gone
+  bool Orphaned() const { return central_.use_count() == 1; }
+
+  // Returns nullptr if neither this thread nor the central lists cache a
+  // block of the class.
+  void* Allocate(size_t cls) {
+    Bin& bin = bins_[cls];
+    if (bin.head == nullptr) {
+      Refill(cls);
+      if (bin.head == nullptr) {
+        return nullptr;
+      }
+    }
+    FreeBlock* block = bin.head;
+    bin.head = block->next;
+    --bin.count;
+    cached_bytes_ -= SizeClassCPUAllocator::ClassToSize(cls);
+    return block;
+  }
+
+  void Free(void* p, size_t cls) {
+    Bin& bin = bins_[cls];
+    FreeBlock* block = new (p) FreeBlock;
+    block->next = bin.head;
+    bin.head = block;
+    ++bin.count;
+    cached_bytes_ += SizeClassCPUAllocator::ClassToSize(cls);
+    if (bin.count > limits_[cls]) {
+      Flush(cls, limits_[cls] / 2);
+      central_->MaybeRelease();
+    } else if (cached_bytes_ > central_->thread_cache_bytes()) {
+      Flush(cls, bin.count);
+      central_->MaybeRelease();
+    }
+  }
+
+  void FlushAll() {
+    for (size_t cls = 0; cls < kClassNum; ++cls) {
+      if (bins_[cls].count > 0) {
+        Flush(cls, bins_[cls].count);
+      }
+    }
+  }
+
+ private:
+  struct Bin {
+    FreeBlock* head = nullptr;
+    uint32_t count = 0;
+  };
+
+  void Refill(size_t cls) {
+    central_->MaybeRelease();
+    arena_ = central_->CurrentArena();
+    size_t count = 0;
+    FreeBlock* blocks = central_->Pop(arena_, cls, &count);
+    if (blocks != nullptr) {
+      bins_[cls].head = blocks;
+      bins_[cls].count = static_cast<uint32_t>(count);
+      cached_bytes_ += count * SizeClassCPUAllocator::ClassToSize(cls);
+    }
+  }
+
+  // Moves the first `num` blocks of the class to the central list.
+  void Flush(size_t cls, uint32_t num) {
+    Bin& bin = bins_[cls];
+    FreeBlock* batch = bin.head;
+    FreeBlock* tail = batch;
+    for (uint32_t i = 1; i < num; ++i) {
+      tail = tail->next;
+    }
+    bin.head = tail->next;
+    bin.count -= num;
+    tail->next = nullptr;
+    cached_bytes_ -= num * SizeClassCPUAllocator::ClassToSize(cls);
+    central_->Push(arena_, cls, batch, num);
+  }
+
+  std::shared_ptr<SizeClassCentralCache> central_;
+  int arena_;
+  size_t cached_bytes_ = 0;
+  uint32_t limits_[kClassNum];
+  Bin bins_[kClassNum];
+};
+
+// The cache is kept behind a trivially destructible pointer, so blocks freed
+// while the thread exits, after the reaper ran, bypass it safely.
+struct ThreadCacheSlot {
+  SizeClassThreadCache* cache;
+  bool exited;
+};
+
+thread_local ThreadCacheSlot tls_cache_slot = {nullptr, false};
+
+struct ThreadCacheReaper {
+  ~ThreadCacheReaper() {
+    tls_cache_slot.exited = true;
+    delete tls_cache_slot.cache;
+    tls_cache_slot.cache = nullptr;
+  }
+};
+
+thread_local ThreadCacheReaper tls_cache_reaper;
+
+// Returns the cache of the calling thread for `central`, or nullptr if the
+// thread exits or caches for another allocator which is still alive.
+SizeClassThreadCache* GetThreadCache(
+    const std::shared_ptr<SizeClassCentralCache>& central) {
+  SizeClassThreadCache* cache = tls_cache_slot.cache;
+  if (cache != nullptr && cache->central() == central.get()) {
+    return cache;
+  }
+  if (tls_cache_slot.exited) {
+    return nullptr;
+  }
+  if (cache != nullptr) {
+    if (!cache->Orphaned()) {
+      return nullptr;
+    }
+    delete cache;
+  }
+  // constructs the reaper of this thread
+  static_cast<void>(&tls_cache_reaper);
+  tls_cache_slot.cache = new SizeClassThreadCache(central);
+  return tls_cache_slot.cache;
+}
+
+}  // namespace
+
+SizeClassCPUAllocator::SizeClassCPUAllocator(size_t thread_cache_bytes,
+                                             int64_t release_interval_ms)
+    : central_(std::make_shared<SizeClassCentralCache>(thread_cache_bytes,
+                                                       release_interval_ms)) {}
+
+SizeClassCPUAllocator::~SizeClassCPUAllocator() {
+  // caches of other threads keep the central lists until they exit
+  if (tls_cache_slot.cache != nullptr &&
+      tls_cache_slot.cache->central() == central_.get()) {
+    delete tls_cache_slot.cache;
+    tls_cache_slot.cache = nullptr;
+  }
+}
+
+size_t SizeClassCPUAllocator::NumClasses() { return kClassNum; }
+
+size_t SizeClassCPUAllocator::SizeToClass(size_t size) {
+  if (size <= kSmallClassNum * kSmallClassStep) {
+    return size == 0 ? 0 : (size - 1) / kSmallClassStep;
+  }
+  // 2^octave < size <= 2^(octave + 1)
+  size_t octave = HighestBit(size - 1);
+  size_t shift = octave - 2;
+  size_t step =
+      (size - (size_t{1} << octave) + (size_t{1} << shift) - 1) >> shift;
+  return kSmallClassNum + (octave - 10) * kClassesPerOctave + step - 1;
+}
+
+size_t SizeClassCPUAllocator::ClassToSize(size_t cls) {
+  if (cls < kSmallClassNum) {
+    return (cls + 1) * kSmallClassStep;
+  }
+  size_t octave = 10 + (cls - kSmallClassNum) / kClassesPerOctave;
+  size_t step = (cls - kSmallClassNum) % kClassesPerOctave + 1;
+  return (size_t{1} << octave) + (step << (octave - 2));
+}
+
+size_t SizeClassCPUAllocator::CentralCachedBytes() const {
+  return central_->CachedBytes();
+}
+
+phi::Allocation* SizeClassCPUAllocator::AllocateImpl(size_t size) {
+  void* p = nullptr;
+  if (size > kMaxClassSize) {
+    p = AllocateFromSystem(size, kPageSize);
+    return new Allocation(p, size, phi::CPUPlace());
+  }
+  size_t cls = SizeToClass(size);
+  SizeClassThreadCache* cache = GetThreadCache(central_);
+  if (cache != nullptr) {
+    p = cache->Allocate(cls);
+  } else {
+    int arena = central_->CurrentArena();
+    size_t count = 0;
+    FreeBlock* blocks = central_->Pop(arena, cls, &count);
+    if (blocks != nullptr) {
+      if (count > 1) {
+        central_->Push(arena, cls, blocks->next, count - 1);
+      }
+      p = blocks;
+    }
+  }
+  if (p == nullptr) {
+    p = AllocateFromSystem(ClassToSize(cls), ClassAlignment(cls));
+  }
+  return new Allocation(p, size, phi::CPUPlace());
+}
+
+void SizeClassCPUAllocator::FreeImpl(phi::Allocation* allocation) {
+  size_t size = allocation->size();
+  void* p = allocation->ptr();
+  delete allocation;
+  if (size > kMaxClassSize) {
+    FreeToSystem(p, size);
+    return;
+  }
+  size_t cls = SizeToClass(size);
+  SizeClassThreadCache* cache = GetThreadCache(central_);
+  if (cache != nullptr) {
+    cache->Free(p, cls);
+  } else {
+    FreeBlock* block = new (p) FreeBlock;
+    block->next = nullptr;
+    central_->Push(central_->CurrentArena(), cls, block, 1);
+  }
+}
+
+uint64_t SizeClassCPUAllocator::ReleaseImpl(const phi::Place& place) {
+  if (tls_cache_slot.cache != nullptr &&
+      tls_cache_slot.cache->central() == central_.get()) {
+    tls_cache_slot.cache->FlushAll();
+  }
+  return central_->Release(false);
+}
+
+}  // namespace paddle::memory::allocation
@@ -0,0 +1,81 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "paddle/phi/core/memory/allocation/allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+class SizeClassCentralCache;
+
+// CPU allocator that caches freed blocks by size class instead of handing
+// every tensor to posix_memalign/free.
+//
+// Requests up to kMaxClassSize are rounded up to one of NumClasses() size
+// classes: multiples of 64 bytes up to 1KB, then four classes per power of
+// two, so blocks of 256 bytes or more waste at most 25%. Freed blocks go to
+// a cache of the freeing thread first, which needs no synchronization. Blocks
+// that overflow it move in batches to a central lock-free free list per
+// class, one set of lists per NUMA node, so a refill prefers memory freed on
+// the same node. Lists that saw no refill during a whole release interval
+// are returned to the OS. Larger requests go to posix_memalign directly,
+// like CPUAllocator.
+//
+// Memory taken from and returned to the OS is counted in the Reserved host
+// stat, the Allocated stat is kept by the StatAllocator on top.
+class SizeClassCPUAllocator : public Allocator {
+ public:
+  static constexpr size_t kMaxClassSize = 1UL << 20;
+  // alignment of the blocks smaller than a page, larger ones are page aligned
+  static constexpr size_t kAlignment = 64UL;
+
+  // thread_cache_bytes: blocks a thread may cache before flushing them to
+  //   the central lists.
+  // release_interval_ms: period of returning idle central lists to the OS,
+  //   no periodic release if not greater than 0.
+  SizeClassCPUAllocator(size_t thread_cache_bytes,
+                        int64_t release_interval_ms);
+  ~SizeClassCPUAllocator() override;
+
+  bool IsAllocThreadSafe() const override { return true; }
+
+  static size_t NumClasses();
+  // class of a request of `size` <= kMaxClassSize bytes
+  static size_t SizeToClass(size_t size);
+  // bytes of the blocks of class `cls`
+  static size_t ClassToSize(size_t cls);
+
+  // bytes of the blocks kept in the central lists
+  size_t CentralCachedBytes() const;
+
+ protected:
+  phi::Allocation* AllocateImpl(size_t size) override;
+  void FreeImpl(phi::Allocation* allocation) override;
+  // Returns the central lists and the cache of the calling thread to the OS.
+  uint64_t ReleaseImpl(const phi::Place& place) override;
+
+ private:
+  std::shared_ptr<SizeClassCentralCache> central_;
+};
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
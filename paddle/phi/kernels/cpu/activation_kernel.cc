@@ -17,6 +17,7 @@ limitations under the License. */
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/kernels/funcs/activation_functor.h"
+#include "paddle/phi/kernels/funcs/jit/kernels.h"
 #include "paddle/phi/kernels/impl/activation_impl.h"
 
 namespace phi {
@@ -85,7 +86,6 @@ DEFINE_CPU_ACTIVATION_KERNEL(Atanh, AtanhFunctor)
 DEFINE_CPU_ACTIVATION_KERNEL(Relu, ReluCPUFunctor)
 DEFINE_CPU_ACTIVATION_KERNEL(Tanh, TanhFunctor)
 DEFINE_CPU_ACTIVATION_KERNEL(TanhShrink, TanhShrinkFunctor)
-DEFINE_CPU_ACTIVATION_KERNEL(Silu, SiluFunctor)
 DEFINE_CPU_ACTIVATION_KERNEL(Reciprocal, ReciprocalFunctor)
 DEFINE_CPU_ACTIVATION_KERNEL(Square, SquareFunctor)
 DEFINE_CPU_ACTIVATION_KERNEL(Sqrt, SqrtFunctor)
@@ -123,6 +123,21 @@ DEFINE_CPU_ACT_KERNEL_WITH_TWO_ATTRS(ThresholdedRelu,
                                      threshold,
                                      value)
 
+template <typename T, typename Context>
+void SiluKernel(const Context& dev_ctx,
+                const DenseTensor& x,
+                DenseTensor* out) {
+  if constexpr (std::is_same<T, float>::value) {
+    dev_ctx.template Alloc<T>(out);
+    jit::ComputeXYNInBlocks<jit::VSiluTuple<T>, phi::CPUPlace>(
+        x.data<T>(), out->data<T>(), x.numel());
+  } else {
+    funcs::SiluFunctor<T> functor;
+    ActivationImpl<T, T, Context, funcs::SiluFunctor<T>>(
+        dev_ctx, x, out, functor);
+  }
+}
+
 template <typename T, typename Context>
 void HardSwishKernel(const Context& dev_ctx,
                      const DenseTensor& x,
@@ -25,6 +25,7 @@
 #include "paddle/phi/kernels/funcs/blas/blas_impl.h"
 #include "paddle/phi/kernels/funcs/eigen/common.h"
 #include "paddle/phi/kernels/funcs/eigen/eigen_function.h"
+#include "paddle/phi/kernels/funcs/jit/kernels.h"
 
 namespace phi {
 
@@ -93,6 +94,11 @@ void GeluKernel(const Context& dev_ctx,
                 bool approximate,
                 DenseTensor* out) {
   dev_ctx.template Alloc<T>(out);
+  if (approximate && std::is_same<T, float>::value) {
+    jit::ComputeXYNInBlocks<jit::VGeluTuple<T>, phi::CPUPlace>(
+        x.data<T>(), out->data<T>(), x.numel());
+    return;
+  }
   auto eigen_out = EigenVector<T>::Flatten(*out);
   auto eigen_x = EigenVector<T>::Flatten(x);
   auto& dev = *dev_ctx.eigen_device();
@@ -426,6 +426,22 @@ void BenchKernelLayerNorm() {
   }
 }
 
+template <typename KernelTuple, typename PlaceType>
+void BenchKernelSoftmax() {
+  using T = typename KernelTuple::data_type;
+  for (int bs : {1, 2, 10}) {
+    for (int n : TestSizes()) {
+      phi::DenseTensor x, y;
+      x.Resize({bs, n});
+      y.Resize({bs, n});
+      RandomVec<T>(bs * n, x.mutable_data<T>(PlaceType()), -2.f, 2.f);
+      const T* x_data = x.data<T>();
+      T* y_data = y.mutable_data<T>(PlaceType());
+      BenchAllImpls<KernelTuple, PlaceType>(n, x_data, y_data, n, bs);
+    }
+  }
+}
+
 template <typename KernelTuple, typename PlaceType>
 void BenchKernelCRFDecoding() {
   using T = typename KernelTuple::data_type;
@@ -487,6 +503,8 @@ void BenchKernelVBroadcast() {
 #define BenchKernelVSigmoid BenchKernelXYN
 #define BenchKernelVTanh BenchKernelXYN
 #define BenchKernelVCopy BenchKernelXYN
+#define BenchKernelVGelu BenchKernelXYN
+#define BenchKernelVSilu BenchKernelXYN
 
 #define BenchKernelLSTMCtHt BenchKernelLSTM
 #define BenchKernelLSTMC1H1 BenchKernelLSTM
@@ -520,6 +538,8 @@ BENCH_FP32_CPU(VExp);
 BENCH_FP32_CPU(VSigmoid);
 BENCH_FP32_CPU(VTanh);
 BENCH_FP32_CPU(VCopy);
+BENCH_FP32_CPU(VGelu);
+BENCH_FP32_CPU(VSilu);
 
 // LSTM
 BENCH_FP32_CPU(LSTMCtHt);
@@ -531,6 +551,7 @@ BENCH_FP32_CPU(GRUHtPart1);
 BENCH_FP32_CPU(GRUHtPart2);
 
 BENCH_FP32_CPU(LayerNorm);
+BENCH_FP32_CPU(Softmax);
 BENCH_FP32_CPU(CRFDecoding);
 
 BENCH_FP32_CPU(SeqPool);
@@ -39,7 +39,9 @@ const float ALIGN32_BEG exp_float_consts[] ALIGN32_END = {  // NOLINT
     REPEAT_8TIMES(CEPHES_EXP_P5),
     REPEAT_8TIMES(EXP_MAX_INPUT),
     REPEAT_8TIMES(SIGMOID_THRESHOLD_MAX),
-    REPEAT_8TIMES(SIGMOID_THRESHOLD_MIN)};
+    REPEAT_8TIMES(SIGMOID_THRESHOLD_MIN),
+    REPEAT_8TIMES(GELU_SQRT_2_PI),
+    REPEAT_8TIMES(GELU_CUBE_COEFF)};
 
 const int ALIGN32_BEG exp_int_0x7f[] ALIGN32_END = {  // NOLINT
     REPEAT_8TIMES(0x7f)};                             // NOLINT
@@ -96,6 +98,8 @@ DECLARE_ACT_CREATOR(VIdentity);
 DECLARE_ACT_CREATOR(VExp);
 DECLARE_ACT_CREATOR(VSigmoid);
 DECLARE_ACT_CREATOR(VTanh);
+DECLARE_ACT_CREATOR(VGelu);
+DECLARE_ACT_CREATOR(VSilu);
 
 // TODO(TJ): tuning use me
 bool VReluCreator::CanBeUsed(const int& d) const {
@@ -122,6 +126,14 @@ bool VTanhCreator::CanBeUsed(const int& d) const {
   return phi::backends::cpu::MayIUse(phi::backends::cpu::avx);
 }
 
+bool VGeluCreator::CanBeUsed(const int& d) const {
+  return phi::backends::cpu::MayIUse(phi::backends::cpu::avx);
+}
+
+bool VSiluCreator::CanBeUsed(const int& d) const {
+  return phi::backends::cpu::MayIUse(phi::backends::cpu::avx);
+}
+
 size_t VReluCreator::CodeSize(const int& d) const {
   return 96 /* init size */ + (d / YMM_FLOAT_BLOCK + 3) * 4 /* instructions */ *
                                   8 /* average bytes for each instruction */;
@@ -147,6 +159,14 @@ size_t VTanhCreator::CodeSize(const int& d) const {
   return 96 + (d / YMM_FLOAT_BLOCK + 3) * 84 * 8;
 }
 
+size_t VGeluCreator::CodeSize(const int& d) const {
+  return 96 + (d / YMM_FLOAT_BLOCK + 3) * 100 * 8;
+}
+
+size_t VSiluCreator::CodeSize(const int& d) const {
+  return 96 + (d / YMM_FLOAT_BLOCK + 3) * 84 * 8;
+}
+
 #undef DECLARE_ACT_CREATOR
 
 }  // namespace gen
@@ -161,3 +181,5 @@ REGISTER_JITKERNEL_GEN(kVIdentity, gen::VIdentityCreator);
 REGISTER_JITKERNEL_GEN(kVExp, gen::VExpCreator);
 REGISTER_JITKERNEL_GEN(kVSigmoid, gen::VSigmoidCreator);
 REGISTER_JITKERNEL_GEN(kVTanh, gen::VTanhCreator);
+REGISTER_JITKERNEL_GEN(kVGelu, gen::VGeluCreator);
+REGISTER_JITKERNEL_GEN(kVSilu, gen::VSiluCreator);
@@ -61,7 +61,9 @@ typedef enum {
   SQUARE,
   SIGMOID,
   TANH,
-  IDENTITY
+  IDENTITY,
+  GELU,
+  SILU
 } operand_type;
 
 #define DECLARE_JIT_CODE(codename) \
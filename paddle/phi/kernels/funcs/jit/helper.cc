@@ -47,6 +47,8 @@ const char* to_string(KernelType kt) {
     ONE_CASE(kVSquare);
     ONE_CASE(kVSigmoid);
     ONE_CASE(kVTanh);
+    ONE_CASE(kVGelu);
+    ONE_CASE(kVSilu);
     ONE_CASE(kLSTMCtHt);
     ONE_CASE(kLSTMC1H1);
     ONE_CASE(kGRUH1);
@@ -54,6 +56,7 @@ const char* to_string(KernelType kt) {
     ONE_CASE(kGRUHtPart2);
     ONE_CASE(kCRFDecoding);
     ONE_CASE(kLayerNorm);
+    ONE_CASE(kSoftmax);
     ONE_CASE(kSeqPool);
     ONE_CASE(kMatMul);
     ONE_CASE(kAdam);
@@ -246,6 +246,29 @@ class KernelFuncs {
   DISABLE_COPY_AND_ASSIGN(KernelFuncs);
 };
 
+// The jit code of an XYN kernel is generated for its length n, so long inputs
+// are computed in blocks, which takes at most two kernels for any n. The
+// blocks are computed on several threads.
+template <typename KernelTuple, typename PlaceType>
+void ComputeXYNInBlocks(const typename KernelTuple::data_type* x,
+                        typename KernelTuple::data_type* y,
+                        int64_t n,
+                        int block = 256) {
+  auto compute = KernelFuncs<KernelTuple, PlaceType>::Cache().At(block);
+  const int64_t num_blocks = n / block;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (num_blocks > 16)
+#endif
+  for (int64_t b = 0; b < num_blocks; ++b) {
+    compute(x + b * block, y + b * block, block);
+  }
+  const int64_t i = num_blocks * block;
+  if (i < n) {
+    const int rest = static_cast<int>(n - i);
+    KernelFuncs<KernelTuple, PlaceType>::Cache().At(rest)(x + i, y + i, rest);
+  }
+}
+
 const char* to_string(KernelType kt);
 const char* to_string(SeqPoolType kt);
 
@@ -36,18 +36,21 @@ typedef enum {
   kLayerNorm,
   kMatMul,
   kSeqPool,
+  kSoftmax,
   kVAdd,
   kVAddBias,
   kVAddRelu,
   kVBroadcast,
   kVCopy,
   kVExp,
+  kVGelu,
   kVIdentity,
   kVMul,
   kVRelu,
   kVScal,
   kSgd,
   kVSigmoid,
+  kVSilu,
   kVSquare,
   kVSub,
   kVTanh,
@@ -118,6 +121,8 @@ DECLARE_KERNELTUPLE(XYNTuple, VExp);
 DECLARE_KERNELTUPLE(XYNTuple, VSigmoid);
 DECLARE_KERNELTUPLE(XYNTuple, VTanh);
 DECLARE_KERNELTUPLE(XYNTuple, VCopy);
+DECLARE_KERNELTUPLE(XYNTuple, VGelu);
+DECLARE_KERNELTUPLE(XYNTuple, VSilu);
 
 typedef struct lstm_t {
   void* gates;  // gates: x_ch, x_ih, x_fh, x_oh
@@ -334,6 +339,15 @@ struct LayerNormTuple {
       T*, T*, T*, T*, const T*, const T*, int, const float, int);
 };
 
+// x, y, width, height
+template <typename T>
+struct SoftmaxTuple {
+  static constexpr KernelType kernel_type = kSoftmax;
+  typedef T data_type;
+  typedef int attr_type;
+  typedef void (*func_type)(const T*, T*, int, int);
+};
+
 // Just for adding to kernel pool without template
 class Kernel {
  public:
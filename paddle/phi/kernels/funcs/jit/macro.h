@@ -21,6 +21,8 @@ namespace jit {
 #define SIGMOID_THRESHOLD_MIN -40.0
 #define SIGMOID_THRESHOLD_MAX 13.0
 #define EXP_MAX_INPUT 40.0
+#define GELU_SQRT_2_PI 0.7978845608028654  // sqrt(2 / pi)
+#define GELU_CUBE_COEFF 0.044715
 
 #define XMM_FLOAT_BLOCK 4
 #define YMM_FLOAT_BLOCK 8
@@ -0,0 +1,137 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+
+#include "paddle/phi/kernels/funcs/jit/more/intrinsic/softmax.h"
+
+#include <algorithm>
+
+#include "paddle/phi/backends/cpu/cpu_info.h"
+#include "paddle/phi/kernels/funcs/jit/kernels.h"
+#include "paddle/phi/kernels/funcs/jit/registry.h"
+
+namespace phi {
+namespace jit {
+namespace more {
+namespace intrinsic {
+
+namespace {
+
+float ReduceMax(__m256 x) {
+  __m128 lo =
+      _mm_max_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+  lo = _mm_max_ps(lo, _mm_movehl_ps(lo, lo));
+  lo = _mm_max_ss(lo, _mm_movehdup_ps(lo));
+  return _mm_cvtss_f32(lo);
+}
+
+float ReduceSum(__m256 x) {
+  __m128 lo =
+      _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+  lo = _mm_hadd_ps(lo, lo);
+  lo = _mm_hadd_ps(lo, lo);
+  return _mm_cvtss_f32(lo);
+}
+
+constexpr int kExpBlock = 256;
+
+// The code of a VExp kernel is generated for its length, so y is computed in
+// blocks of kExpBlock and YMM_FLOAT_BLOCK, whatever the row length is. The
+// last partial block is padded.
+void ExpInBlocks(float* y,
+                 int n,
+                 VExpTuple<float>::func_type exp_block,
+                 VExpTuple<float>::func_type exp_ymm) {
+  int j = 0;
+  for (; j + kExpBlock <= n; j += kExpBlock) {
+    exp_block(y + j, y + j, kExpBlock);
+  }
+  for (; j + YMM_FLOAT_BLOCK <= n; j += YMM_FLOAT_BLOCK) {
+    exp_ymm(y + j, y + j, YMM_FLOAT_BLOCK);
+  }
+  if (j < n) {
+    float tail[YMM_FLOAT_BLOCK] = {0.f};
+    std::copy(y + j, y + n, tail);
+    exp_ymm(tail, tail, YMM_FLOAT_BLOCK);
+    std::copy(tail, tail + n - j, y + j);
+  }
+}
+
+}  // namespace
+
+// The exp of each row is done by the best VExp kernels.
+void Softmax(const float* x, float* y, int n, int bs) {
+  constexpr float kMin = -64.f;
+  const int end = n - n % YMM_FLOAT_BLOCK;
+  const __m256 min_vec = _mm256_set1_ps(kMin);
+  auto& exp_funcs = KernelFuncs<VExpTuple<float>, phi::CPUPlace>::Cache();
+  auto exp_block = exp_funcs.At(kExpBlock);
+  auto exp_ymm = exp_funcs.At(YMM_FLOAT_BLOCK);
+  for (int i = 0; i < bs; ++i) {
+    __m256 max_vec = _mm256_set1_ps(x[0]);
+    int j = 0;
+    for (; j < end; j += YMM_FLOAT_BLOCK) {
+      max_vec = _mm256_max_ps(max_vec, _mm256_loadu_ps(x + j));
+    }
+    float max = ReduceMax(max_vec);
+    for (; j < n; ++j) {
+      max = std::max(max, x[j]);
+    }
+
+    const __m256 neg_max_vec = _mm256_set1_ps(-max);
+    for (j = 0; j < end; j += YMM_FLOAT_BLOCK) {
+      __m256 tmp = _mm256_add_ps(_mm256_loadu_ps(x + j), neg_max_vec);
+      _mm256_storeu_ps(y + j, _mm256_max_ps(tmp, min_vec));
+    }
+    for (; j < n; ++j) {
+      y[j] = std::max(x[j] - max, kMin);
+    }
+    ExpInBlocks(y, n, exp_block, exp_ymm);
+
+    __m256 sum_vec = _mm256_setzero_ps();
+    for (j = 0; j < end; j += YMM_FLOAT_BLOCK) {
+      sum_vec = _mm256_add_ps(sum_vec, _mm256_loadu_ps(y + j));
+    }
+    float sum = ReduceSum(sum_vec);
+    for (; j < n; ++j) {
+      sum += y[j];
+    }
+
+    const float scalar = 1.f / sum;
+    const __m256 scalar_vec = _mm256_set1_ps(scalar);
+    for (j = 0; j < end; j += YMM_FLOAT_BLOCK) {
+      _mm256_storeu_ps(y + j,
+                       _mm256_mul_ps(_mm256_loadu_ps(y + j), scalar_vec));
+    }
+    for (; j < n; ++j) {
+      y[j] *= scalar;
+    }
+    x += n;
+    y += n;
+  }
+}
+
+bool SoftmaxKernel::CanBeUsed(const int& d) const {
+  return phi::backends::cpu::MayIUse(phi::backends::cpu::avx) &&
+         d >= YMM_FLOAT_BLOCK;
+}
+
+}  // namespace intrinsic
+}  // namespace more
+}  // namespace jit
+}  // namespace phi
+
+namespace intrinsic = phi::jit::more::intrinsic;
+
+REGISTER_JITKERNEL_MORE(kSoftmax, intrinsic, intrinsic::SoftmaxKernel);
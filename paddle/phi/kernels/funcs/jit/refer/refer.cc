@@ -37,6 +37,8 @@ REGISTER_REFER_KERNEL(VSquare);
 REGISTER_REFER_KERNEL(VExp);
 REGISTER_REFER_KERNEL(VSigmoid);
 REGISTER_REFER_KERNEL(VTanh);
+REGISTER_REFER_KERNEL(VGelu);
+REGISTER_REFER_KERNEL(VSilu);
 
 REGISTER_REFER_KERNEL(LSTMCtHt);
 REGISTER_REFER_KERNEL(LSTMC1H1);
@@ -54,5 +56,6 @@ REGISTER_REFER_KERNEL(Adam);
 REGISTER_REFER_KERNEL(AdamW);
 REGISTER_REFER_KERNEL(Sgd);
 REGISTER_REFER_KERNEL(VBroadcast);
+REGISTER_REFER_KERNEL(Softmax);
 
 #undef REGISTER_REFER_KERNEL
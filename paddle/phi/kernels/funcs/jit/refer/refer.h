@@ -135,6 +135,28 @@ void VTanh(const T* x, T* y, int n) {
   }
 }
 
+template <typename T>
+void VGelu(const T* x, T* y, int n) {
+  // y = 0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+  const T a = static_cast<T>(GELU_SQRT_2_PI);
+  const T b = static_cast<T>(GELU_CUBE_COEFF);
+  for (int i = 0; i < n; ++i) {
+    T tmp = std::tanh(a * (x[i] + b * x[i] * x[i] * x[i]));
+    y[i] = static_cast<T>(0.5) * x[i] * (static_cast<T>(1) + tmp);
+  }
+}
+
+template <typename T>
+void VSilu(const T* x, T* y, int n) {
+  // y = x * sigmoid(x)
+  const T min = SIGMOID_THRESHOLD_MIN;
+  const T max = SIGMOID_THRESHOLD_MAX;
+  for (int i = 0; i < n; ++i) {
+    T tmp = (x[i] < min) ? min : ((x[i] > max) ? max : x[i]);
+    y[i] = x[i] / (static_cast<T>(1) + std::exp(-tmp));
+  }
+}
+
 template <typename T>
 void (*getActFunc(KernelType type))(const T*, T*, int) {  // NOLINT
   if (type == kVSigmoid) {
@@ -562,6 +584,31 @@ void AdamW(T beta1,
   }
 }
 
+// y = e^(x - max(x)) / sum(e^(x - max(x))) for each row, where x - max(x)
+// is clipped to -64 as SoftmaxFunctor does
+template <typename T>
+void Softmax(const T* x, T* y, int n, int bs) {
+  const T min = static_cast<T>(-64);
+  for (int i = 0; i < bs; ++i) {
+    T max = x[0];
+    for (int j = 1; j < n; ++j) {
+      max = x[j] > max ? x[j] : max;
+    }
+    T sum = 0;
+    for (int j = 0; j < n; ++j) {
+      T tmp = x[j] - max;
+      y[j] = std::exp(tmp < min ? min : tmp);
+      sum += y[j];
+    }
+    T scalar = static_cast<T>(1) / sum;
+    for (int j = 0; j < n; ++j) {
+      y[j] *= scalar;
+    }
+    x += n;
+    y += n;
+  }
+}
+
 #define DECLARE_REFER_KERNEL(name)                          \
   template <typename T>                                     \
   class name##Kernel : public ReferKernel<name##Tuple<T>> { \
@@ -587,6 +634,8 @@ DECLARE_REFER_KERNEL(VSigmoid);
 DECLARE_REFER_KERNEL(VTanh);
 DECLARE_REFER_KERNEL(VSquare);
 DECLARE_REFER_KERNEL(VCopy);
+DECLARE_REFER_KERNEL(VGelu);
+DECLARE_REFER_KERNEL(VSilu);
 
 // lstm_t*, const lstm_attr_t*
 DECLARE_REFER_KERNEL(LSTMCtHt);
@@ -607,6 +656,7 @@ DECLARE_REFER_KERNEL(Adam);
 DECLARE_REFER_KERNEL(AdamW);
 DECLARE_REFER_KERNEL(Sgd);
 DECLARE_REFER_KERNEL(VBroadcast);
+DECLARE_REFER_KERNEL(Softmax);
 
 #undef DECLARE_REFER_KERNEL
 
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include <array>
 #include <iostream>
+#include <numeric>
 #include <random>
 
 #include "glog/logging.h"
@@ -487,6 +488,42 @@ void TestKernelLayerNorm() {
   }
 }
 
+template <typename KernelTuple, typename PlaceType>
+void TestKernelSoftmax() {
+  using T = typename KernelTuple::data_type;
+  VLOG(10) << "Test JITKernel: " << jit::to_string(KernelTuple::kernel_type);
+  for (int bs : {1, 2, 10}) {
+    for (int n : TestSizes()) {
+      auto ref = jit::GetReferFunc<KernelTuple>();
+      EXPECT_TRUE(ref != nullptr);
+      std::vector<T> x(bs * n), yref(bs * n);
+      RandomVec<T>(bs * n, x.data(), -20.f, 20.f);
+      ref(x.data(), yref.data(), n, bs);
+      for (int i = 0; i < bs; ++i) {
+        T sum = std::accumulate(
+            yref.begin() + i * n, yref.begin() + (i + 1) * n, T(0));
+        EXPECT_NEAR(sum, static_cast<T>(1), FLAGS_acc);
+      }
+
+      auto verifier = [](const typename KernelTuple::func_type tgt,
+                         const std::vector<T>& x,
+                         const std::vector<T>& yref,
+                         const int n,
+                         const int bs) {
+        EXPECT_TRUE(tgt != nullptr);
+        std::vector<T> ytgt(yref.size());
+        tgt(x.data(), ytgt.data(), n, bs);
+        ExpectEQ<T>(ytgt.data(), yref.data(), yref.size());
+        // test inplace
+        std::copy(x.begin(), x.end(), ytgt.begin());
+        tgt(ytgt.data(), ytgt.data(), n, bs);
+        ExpectEQ<T>(ytgt.data(), yref.data(), yref.size());
+      };
+      TestAllImpls<KernelTuple, PlaceType>(n, verifier, x, yref, n, bs);
+    }
+  }
+}
+
 template <typename KernelTuple, typename PlaceType>
 void TestKernelCRFDecoding() {
   using T = typename KernelTuple::data_type;
@@ -1425,6 +1462,8 @@ TEST(JITKernel_key, sgd) {
 #define TestKernelVSigmoid TestKernelXYN
 #define TestKernelVTanh TestKernelXYN
 #define TestKernelVCopy TestKernelXYN
+#define TestKernelVGelu TestKernelXYN
+#define TestKernelVSilu TestKernelXYN
 
 #define TestKernelLSTMCtHt TestKernelLSTM
 #define TestKernelLSTMC1H1 TestKernelLSTM
@@ -1454,6 +1493,8 @@ TEST_CPU_KERNEL(VExp);
 TEST_CPU_KERNEL(VSigmoid);
 TEST_CPU_KERNEL(VTanh);
 TEST_CPU_KERNEL(VCopy);
+TEST_CPU_KERNEL(VGelu);
+TEST_CPU_KERNEL(VSilu);
 
 TEST_CPU_KERNEL(LSTMCtHt);
 TEST_CPU_KERNEL(LSTMC1H1);
@@ -1463,6 +1504,7 @@ TEST_CPU_KERNEL(GRUHtPart1);
 TEST_CPU_KERNEL(GRUHtPart2);
 
 TEST_CPU_KERNEL(LayerNorm);
+TEST_CPU_KERNEL(Softmax);
 TEST_CPU_KERNEL(CRFDecoding);
 
 TEST_CPU_KERNEL(SeqPool);
@@ -0,0 +1,276 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "paddle/phi/core/selected_rows.h"
+
+namespace phi {
+namespace funcs {
+namespace scatter {
+
+// Runs fn(tid) for tid in [0, num_threads), in parallel with OpenMP.
+template <typename Fn>
+void ParallelRun(int num_threads, Fn&& fn) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(num_threads)
+#endif
+  for (int tid = 0; tid < num_threads; ++tid) {
+    fn(tid);
+  }
+}
+
+/**
+ * Merges the duplicated rows of SelectedRows without a hash map, for the
+ * inputs with millions of rows.
+ *
+ * The (row, value) pairs of all inputs are sorted by row with a parallel LSD
+ * radix sort: each thread counts the digits of a contiguous chunk and then
+ * scatters the chunk to its own offsets, so a pass needs no locks and no
+ * allocation per row. The sort is stable, so the values of a row are added
+ * in the order of the inputs, as the hash map path of MergeAdd does, and the
+ * distinct rows come out sorted.
+ */
+template <typename T>
+class RadixRowMerger {
+ public:
+  RadixRowMerger(const std::vector<const phi::SelectedRows*>& inputs,
+                 size_t row_num,
+                 int64_t input_width) {
+#ifdef PADDLE_WITH_MKLML
+    num_threads_ = std::max(omp_get_max_threads(), 1);
+#endif
+    refs_.resize(row_num);
+    size_t offset = 0;
+    for (auto* input : inputs) {
+      if (input->rows().empty()) {
+        continue;
+      }
+      const int64_t* rows = input->rows().data();
+      const T* data = input->value().data<T>();
+      const int64_t size = static_cast<int64_t>(input->rows().size());
+      RowRef* refs = refs_.data() + offset;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(num_threads_)
+#endif
+      for (int64_t i = 0; i < size; ++i) {
+        refs[i].row = rows[i];
+        refs[i].value = data + i * input_width;
+      }
+      offset += size;
+    }
+    Sort();
+    Segment();
+  }
+
+  // The number of distinct rows.
+  size_t size() const { return starts_.size() - 1; }
+
+  // Writes the distinct rows in ascending order.
+  void GetRows(std::vector<int64_t>* rows) const {
+    rows->resize(size());
+    int64_t* out = rows->data();
+    const int64_t num = static_cast<int64_t>(size());
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(num_threads_)
+#endif
+    for (int64_t i = 0; i < num; ++i) {
+      out[i] = refs_[starts_[i]].row;
+    }
+  }
+
+  // Writes the sum of the values of the i-th distinct row to the i-th row of
+  // out, which needs no zero filling.
+  void Sum(int64_t input_width, T* out) const {
+    ParallelForRows([&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        AddValues(i, input_width, out + i * input_width);
+      }
+    });
+  }
+
+  // Calls fn(row, value) once for each distinct row in parallel, where value
+  // is the sum of the values of the row. The value of a row that appears
+  // once is passed without a copy.
+  template <typename Fn>
+  void ForEachRow(int64_t input_width, Fn&& fn) const {
+    ParallelForRows([&](int64_t begin, int64_t end) {
+      std::vector<T> sum(input_width);
+      for (int64_t i = begin; i < end; ++i) {
+        const RowRef& first = refs_[starts_[i]];
+        if (starts_[i + 1] - starts_[i] == 1) {
+          fn(first.row, first.value);
+        } else {
+          AddValues(i, input_width, sum.data());
+          fn(first.row, static_cast<const T*>(sum.data()));
+        }
+      }
+    });
+  }
+
+ private:
+  static constexpr int kRadixBits = 8;
+  static constexpr int kRadixSize = 1 << kRadixBits;
+
+  struct RowRef {
+    int64_t row;
+    const T* value;
+  };
+
+  // Returns the [begin, end) of the chunk of thread tid.
+  std::pair<size_t, size_t> Chunk(int tid) const {
+    size_t chunk = (refs_.size() + num_threads_ - 1) / num_threads_;
+    size_t begin = std::min(refs_.size(), tid * chunk);
+    return {begin, std::min(refs_.size(), begin + chunk)};
+  }
+
+  void Sort() {
+    if (refs_.empty()) {
+      return;
+    }
+    std::vector<int64_t> thread_min(num_threads_, refs_[0].row);
+    std::vector<int64_t> thread_max(num_threads_, refs_[0].row);
+    ParallelRun(num_threads_, [&](int tid) {
+      auto [begin, end] = Chunk(tid);
+      for (size_t i = begin; i < end; ++i) {
+        thread_min[tid] = std::min(thread_min[tid], refs_[i].row);
+        thread_max[tid] = std::max(thread_max[tid], refs_[i].row);
+      }
+    });
+    const int64_t min_row =
+        *std::min_element(thread_min.begin(), thread_min.end());
+    const int64_t max_row =
+        *std::max_element(thread_max.begin(), thread_max.end());
+    // the digits are taken from row - min_row, which fits in uint64_t
+    const uint64_t base = static_cast<uint64_t>(min_row);
+    const uint64_t range = static_cast<uint64_t>(max_row) - base;
+    int num_bits = 0;
+    while (num_bits < 64 && (range >> num_bits) != 0) {
+      ++num_bits;
+    }
+
+    std::vector<RowRef> buffer(refs_.size());
+    std::vector<size_t> offsets(static_cast<size_t>(num_threads_) *
+                                kRadixSize);
+    for (int shift = 0; shift < num_bits; shift += kRadixBits) {
+      auto digit = [&](int64_t row) {
+        return ((static_cast<uint64_t>(row) - base) >> shift) &
+               (kRadixSize - 1);
+      };
+      ParallelRun(num_threads_, [&](int tid) {
+        size_t* counts = offsets.data() + tid * kRadixSize;
+        std::fill(counts, counts + kRadixSize, 0);
+        auto [begin, end] = Chunk(tid);
+        for (size_t i = begin; i < end; ++i) {
+          ++counts[digit(refs_[i].row)];
+        }
+      });
+      // the chunks of a digit are laid out in the order of the threads,
+      // which keeps the sort stable
+      size_t sum = 0;
+      for (int d = 0; d < kRadixSize; ++d) {
+        for (int tid = 0; tid < num_threads_; ++tid) {
+          size_t count = offsets[tid * kRadixSize + d];
+          offsets[tid * kRadixSize + d] = sum;
+          sum += count;
+        }
+      }
+      ParallelRun(num_threads_, [&](int tid) {
+        size_t* next = offsets.data() + tid * kRadixSize;
+        auto [begin, end] = Chunk(tid);
+        for (size_t i = begin; i < end; ++i) {
+          buffer[next[digit(refs_[i].row)]++] = refs_[i];
+        }
+      });
+      refs_.swap(buffer);
+    }
+  }
+
+  // Runs fn(begin, end) on ranges of the distinct rows in parallel. The hot
+  // rows of a skewed distribution have many more values than the others, so
+  // the work is split by values rather than by rows: task t takes the rows
+  // that start in its share of refs_.
+  template <typename Fn>
+  void ParallelForRows(Fn&& fn) const {
+    const int num_tasks = num_threads_ * 8;
+    auto task_begin = [&](int t) {
+      size_t ref = refs_.size() * t / num_tasks;
+      return std::lower_bound(starts_.begin(), starts_.end() - 1, ref) -
+             starts_.begin();
+    };
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(num_threads_) schedule(dynamic)
+#endif
+    for (int t = 0; t < num_tasks; ++t) {
+      fn(task_begin(t), task_begin(t + 1));
+    }
+  }
+
+  // Writes the sum of the values of the i-th distinct row to out.
+  void AddValues(int64_t i, int64_t input_width, T* out) const {
+    const T* first = refs_[starts_[i]].value;
+    std::copy(first, first + input_width, out);
+    for (size_t j = starts_[i] + 1; j < starts_[i + 1]; ++j) {
+      const T* src = refs_[j].value;
+      for (int64_t k = 0; k < input_width; ++k) {
+        out[k] += src[k];
+      }
+    }
+  }
+
+  // Finds where each distinct row starts in the sorted refs_.
+  void Segment() {
+    std::vector<size_t> thread_starts(num_threads_ + 1, 0);
+    ParallelRun(num_threads_, [&](int tid) {
+      auto [begin, end] = Chunk(tid);
+      for (size_t i = begin; i < end; ++i) {
+        thread_starts[tid + 1] += IsStart(i);
+      }
+    });
+    for (int tid = 0; tid < num_threads_; ++tid) {
+      thread_starts[tid + 1] += thread_starts[tid];
+    }
+    starts_.resize(thread_starts[num_threads_] + 1);
+    starts_.back() = refs_.size();
+    ParallelRun(num_threads_, [&](int tid) {
+      size_t next = thread_starts[tid];
+      auto [begin, end] = Chunk(tid);
+      for (size_t i = begin; i < end; ++i) {
+        if (IsStart(i)) {
+          starts_[next++] = i;
+        }
+      }
+    });
+  }
+
+  bool IsStart(size_t i) const {
+    return i == 0 || refs_[i].row != refs_[i - 1].row;
+  }
+
+  int num_threads_{1};
+  std::vector<RowRef> refs_;
+  std::vector<size_t> starts_;
+};
+
+}  // namespace scatter
+}  // namespace funcs
+}  // namespace phi
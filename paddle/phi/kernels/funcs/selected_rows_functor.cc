@@ -16,11 +16,14 @@ limitations under the License. */
 
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <set>
 #include <vector>
 
 #include "paddle/common/ddim.h"
+#include "paddle/common/flags.h"
 #include "paddle/phi/core/mixed_vector.h"
+#include "paddle/phi/kernels/funcs/radix_row_merger.h"
 
 #ifdef PADDLE_WITH_XPU
 #include "paddle/phi/backends/xpu/enforce_xpu.h"
@@ -32,6 +35,8 @@ limitations under the License. */
 
 #include "glog/logging.h"
 
+COMMON_DECLARE_int64(selected_rows_radix_merge_threshold);
+
 namespace phi {
 namespace funcs {
 template <typename T>
@@ -499,6 +504,12 @@ add_sparse_inputs(const std::vector<const phi::SelectedRows*>& inputs,
   }
 }
 
+inline bool UseRadixMerge(size_t row_num) {
+  return FLAGS_selected_rows_radix_merge_threshold >= 0 &&
+         row_num >= static_cast<size_t>(
+                        FLAGS_selected_rows_radix_merge_threshold);
+}
+
 template <typename DeviceContext, typename T>
 struct MergeAddImpl {
   phi::SelectedRows operator()(const DeviceContext& context,
@@ -540,7 +551,6 @@ struct MergeAddImpl {
     auto input_width = has_value_input->value().dims()[1];
     auto input_height = has_value_input->height();
     phi::SelectedRows& out = *output;
-    std::set<int64_t> merged_row_set;
     size_t row_num = 0;
     for (auto* input : inputs) {
       if (input->rows().empty()) {
@@ -556,16 +566,30 @@ struct MergeAddImpl {
                         common::errors::InvalidArgument(
                             "All inputs should have same height."));
       row_num += input->rows().size();
-      merged_row_set.insert(input->rows().begin(), input->rows().end());
+    }
+
+    std::set<int64_t> merged_row_set;
+    std::unique_ptr<RadixRowMerger<T>> radix_merger;
+    size_t merged_row_num = 0;
+    if (std::is_same<DeviceContext, phi::CPUContext>::value &&
+        UseRadixMerge(row_num)) {
+      radix_merger =
+          std::make_unique<RadixRowMerger<T>>(inputs, row_num, input_width);
+      merged_row_num = radix_merger->size();
+    } else {
+      for (auto* input : inputs) {
+        merged_row_set.insert(input->rows().begin(), input->rows().end());
+      }
+      merged_row_num = merged_row_set.size();
     }
 
     out.set_height(input_height);
     DenseTensor* out_tensor = out.mutable_value();
     out_tensor->Resize(common::make_ddim(
-        {static_cast<int64_t>(merged_row_set.size()), input_width}));
+        {static_cast<int64_t>(merged_row_num), input_width}));
     auto* out_data = context.template Alloc<T>(out_tensor);
 
-    if (merged_row_set.size() == row_num && !sorted_result) {
+    if (merged_row_num == row_num && !sorted_result) {
       // no duplicated ids, just concat the result together
       std::vector<int64_t> merge_rows;
       merge_rows.reserve(row_num);
@@ -588,6 +612,9 @@ struct MergeAddImpl {
                            in_numel * sizeof(T));
         copied_numel += static_cast<int64_t>(in_numel);
       }
+    } else if (radix_merger) {
+      radix_merger->GetRows(out.mutable_rows());
+      radix_merger->Sum(input_width, out_data);
     } else {
       std::vector<int64_t> merge_rows(merged_row_set.begin(),
                                       merged_row_set.end());
@@ -855,7 +882,7 @@ struct MergeAverage<phi::CPUContext, T> {
     auto input_width = has_value_input->value().dims()[1];
     auto input_height = has_value_input->height();
     phi::SelectedRows& out = *output;
-    std::set<int64_t> merged_row_set;
+    size_t row_num = 0;
     for (auto* input : inputs) {
       if (input->rows().empty()) {
         continue;
@@ -869,10 +896,34 @@ struct MergeAverage<phi::CPUContext, T> {
                         input->height(),
                         common::errors::InvalidArgument(
                             "All input should have same height."));
-      merged_row_set.insert(input->rows().begin(), input->rows().end());
+      row_num += input->rows().size();
     }
 
     out.set_height(input_height);
+    T count = static_cast<T>(inputs.size());
+
+    if (UseRadixMerge(row_num)) {
+      RadixRowMerger<T> radix_merger(inputs, row_num, input_width);
+      DenseTensor* out_tensor = out.mutable_value();
+      out_tensor->Resize(common::make_ddim(
+          {static_cast<int64_t>(radix_merger.size()), input_width}));
+      auto* out_data = context.template Alloc<T>(out_tensor);
+      radix_merger.GetRows(out.mutable_rows());
+      radix_merger.Sum(input_width, out_data);
+      const int64_t numel = out_tensor->numel();
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+      for (int64_t i = 0; i < numel; ++i) {
+        out_data[i] = out_data[i] / count;
+      }
+      return;
+    }
+
+    std::set<int64_t> merged_row_set;
+    for (auto* input : inputs) {
+      merged_row_set.insert(input->rows().begin(), input->rows().end());
+    }
 
     DenseTensor* out_tensor = out.mutable_value();
     out_tensor->Resize(common::make_ddim(
@@ -910,7 +961,6 @@ struct MergeAverage<phi::CPUContext, T> {
       }
     }
     size_t input_width_cast = static_cast<size_t>(input_width);
-    T count = static_cast<T>(inputs.size());
     for (size_t i = 0; i < merge_rows.size(); i++) {
       for (size_t j = 0; j < input_width_cast; j++) {
         out_data[i * input_width + j] = out_data[i * input_width + j] / count;
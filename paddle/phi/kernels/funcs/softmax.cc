@@ -14,11 +14,48 @@ limitations under the License. */
 
 #include "paddle/phi/kernels/funcs/softmax.h"
 
+#include <algorithm>
+
 #include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/funcs/jit/kernels.h"
 #include "paddle/phi/kernels/funcs/softmax_impl.h"
 
 namespace phi::funcs {
 
+template <typename T>
+void SoftmaxRowsCPU(const T* x, T* y, int num_classes, int batch_size) {
+  auto compute =
+      jit::KernelFuncs<jit::SoftmaxTuple<T>, phi::CPUPlace>::Cache().At(
+          num_classes);
+  compute(x, y, num_classes, batch_size);
+}
+
+template void SoftmaxRowsCPU<float>(const float*, float*, int, int);
+
+// kSoftmax has only a scalar kernel for double, while vec_exp runs vdExp
+// with MKL.
+template <>
+void SoftmaxRowsCPU<double>(const double* x,
+                            double* y,
+                            int num_classes,
+                            int batch_size) {
+  for (int bs = 0; bs < batch_size; ++bs) {
+    double max_val = *std::max_element(x, x + num_classes);
+    max_val *= -1.0;
+    vec_add_bias<double, phi::backends::cpu::avx>(num_classes, max_val, x, y);
+    vec_clip<double, phi::backends::cpu::avx>(num_classes, -64.0, y, y);
+    vec_exp<double>(num_classes, y, y);
+
+    double sum = 0;
+    vec_sum<double, phi::backends::cpu::avx>(num_classes, y, &sum);
+    sum = 1.0 / sum;
+    vec_scal<double, phi::backends::cpu::avx>(num_classes, sum, y, y);
+
+    x += num_classes;
+    y += num_classes;
+  }
+}
+
 template class SoftmaxFunctor<phi::CPUContext, float>;
 template class SoftmaxFunctor<phi::CPUContext, double>;
 template class SoftmaxGradFunctor<phi::CPUContext, float>;
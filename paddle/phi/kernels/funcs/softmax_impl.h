@@ -230,6 +230,18 @@ template <class DeviceContext>
 using enable_if_CPU = typename std::enable_if<
     std::is_same<DeviceContext, phi::CPUContext>::value>::type;
 
+// Softmax of each of the `batch_size` rows of `num_classes`, which is defined
+// in softmax.cc. float goes through the phi::jit kernel, double through the
+// vec_* functions.
+template <typename T>
+void SoftmaxRowsCPU(const T* x, T* y, int num_classes, int batch_size);
+
+template <>
+void SoftmaxRowsCPU<double>(const double* x,
+                            double* y,
+                            int num_classes,
+                            int batch_size);
+
 template <typename DeviceContext, typename T>
 class SoftmaxFunctor<DeviceContext, T, enable_if_CPU<DeviceContext>> {
  public:
@@ -247,26 +259,7 @@ class SoftmaxFunctor<DeviceContext, T, enable_if_CPU<DeviceContext>> {
 
     if (num_remain == 1 &&
         phi::backends::cpu::MayIUse(phi::backends::cpu::avx)) {
-      const T* in_data = X->data<T>();
-      T* out_data = Y->data<T>();
-      for (int bs = 0; bs < batch_size; ++bs) {
-        T max_val = *std::max_element(in_data, in_data + num_classes);
-        max_val *= static_cast<T>(-1);
-        vec_add_bias<T, phi::backends::cpu::avx>(
-            num_classes, max_val, in_data, out_data);
-        vec_clip<T, phi::backends::cpu::avx>(
-            num_classes, static_cast<T>(-64), out_data, out_data);
-        vec_exp<T>(num_classes, out_data, out_data);
-
-        T sum = 0;
-        vec_sum<T, phi::backends::cpu::avx>(num_classes, out_data, &sum);
-        sum = static_cast<T>(1) / sum;
-        vec_scal<T, phi::backends::cpu::avx>(
-            num_classes, sum, out_data, out_data);
-
-        in_data += num_classes;
-        out_data += num_classes;
-      }
+      SoftmaxRowsCPU<T>(X->data<T>(), Y->data<T>(), num_classes, batch_size);
     } else {
       SoftmaxEigen<DeviceContext, T>()(context, axis_dim, X, Y);
     }
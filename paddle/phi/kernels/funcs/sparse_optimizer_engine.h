@@ -0,0 +1,143 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/selected_rows.h"
+#include "paddle/phi/kernels/funcs/radix_row_merger.h"
+
+namespace phi {
+namespace funcs {
+
+/**
+ * Drives the row updates of the CPU optimizers of a dense parameter with a
+ * SelectedRows gradient.
+ *
+ * The duplicated rows of the gradient are not merged into a new
+ * SelectedRows up front: the rows are grouped by RadixRowMerger and each
+ * update receives the sum of the values of its row, so the merge and the
+ * update of a row run in one pass while the row is in cache. The rows are
+ * updated in parallel with OpenMP, and an update runs on a whole row, so it
+ * can be a SIMD kernel of phi::jit.
+ *
+ * A gradient whose rows are strictly ascending, such as the output of
+ * MergeAdd, is used as it is.
+ */
+template <typename T>
+class SparseOptimizerEngine {
+ public:
+  SparseOptimizerEngine(const phi::SelectedRows& grad, int64_t param_height)
+      : param_height_(param_height) {
+#ifdef PADDLE_WITH_MKLML
+    num_threads_ = std::max(omp_get_max_threads(), 1);
+#endif
+    const auto& rows = grad.rows();
+    PADDLE_ENFORCE_GT(rows.size(),
+                      0,
+                      common::errors::InvalidArgument(
+                          "The gradient of a sparse optimizer has no rows."));
+    width_ = grad.value().numel() / static_cast<int64_t>(rows.size());
+    for (size_t i = 1; i < rows.size(); ++i) {
+      if (rows[i - 1] >= rows[i]) {
+        merger_ = std::make_unique<scatter::RadixRowMerger<T>>(
+            std::vector<const phi::SelectedRows*>{&grad}, rows.size(), width_);
+        return;
+      }
+    }
+    rows_ = rows.data();
+    values_ = grad.value().data<T>();
+    num_rows_ = static_cast<int64_t>(rows.size());
+  }
+
+  // The number of elements in a row.
+  int64_t width() const { return width_; }
+
+  // Calls update(row, grad) once for each distinct row of the gradient, in
+  // parallel, where grad is the sum of the values of the row. This is the
+  // lazy mode of the optimizers.
+  template <typename Update>
+  void ForEachGradRow(Update&& update) const {
+    if (merger_) {
+      merger_->ForEachRow(width_, update);
+      return;
+    }
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(num_threads_)
+#endif
+    for (int64_t i = 0; i < num_rows_; ++i) {
+      update(rows_[i], values_ + i * width_);
+    }
+  }
+
+  // Calls update(row, grad) once for each row of the parameter, in parallel,
+  // where grad is nullptr for the rows without a gradient.
+  template <typename Update>
+  void ForEachParamRow(Update&& update) {
+    if (merger_) {
+      // the rows of the parameter are visited in order, so the merged rows
+      // are materialized to look them up
+      merger_->GetRows(&merged_rows_);
+      merged_values_.resize(merged_rows_.size() * width_);
+      merger_->Sum(width_, merged_values_.data());
+      rows_ = merged_rows_.data();
+      values_ = merged_values_.data();
+      num_rows_ = static_cast<int64_t>(merged_rows_.size());
+      merger_.reset();
+    }
+    const int num_tasks = num_threads_ * 4;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(num_threads_)
+#endif
+    for (int t = 0; t < num_tasks; ++t) {
+      const int64_t begin = param_height_ * t / num_tasks;
+      const int64_t end = param_height_ * (t + 1) / num_tasks;
+      int64_t j = std::lower_bound(rows_, rows_ + num_rows_, begin) - rows_;
+      for (int64_t row = begin; row < end; ++row) {
+        if (j < num_rows_ && rows_[j] == row) {
+          update(row, values_ + j * width_);
+          ++j;
+        } else {
+          update(row, static_cast<const T*>(nullptr));
+        }
+      }
+    }
+  }
+
+ private:
+  int num_threads_{1};
+  int64_t param_height_;
+  int64_t width_;
+
+  // set when the rows of the gradient need to be merged
+  std::unique_ptr<scatter::RadixRowMerger<T>> merger_;
+
+  // the strictly ascending rows and their values
+  const int64_t* rows_{nullptr};
+  const T* values_{nullptr};
+  int64_t num_rows_{0};
+  std::vector<int64_t> merged_rows_;
+  std::vector<T> merged_values_;
+};
+
+}  // namespace funcs
+}  // namespace phi
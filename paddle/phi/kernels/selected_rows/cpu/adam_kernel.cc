@@ -15,16 +15,12 @@
 #include "paddle/phi/kernels/selected_rows/adam_kernel.h"
 
 #include "glog/logging.h"
-#include "paddle/common/flags.h"
 
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/core/tensor_utils.h"
-#include "paddle/phi/core/threadpool.h"
-#include "paddle/phi/kernels/funcs/adam_functors.h"
-#include "paddle/phi/kernels/funcs/selected_rows_functor.h"
-
-PD_DECLARE_int32(inner_op_parallelism);
+#include "paddle/phi/kernels/funcs/jit/kernels.h"
+#include "paddle/phi/kernels/funcs/sparse_optimizer_engine.h"
 
 namespace phi {
 namespace sr {
@@ -45,7 +41,7 @@ void AdamDenseParamSparseGradKernel(
     const Scalar& beta2,
     const Scalar& epsilon,
     bool lazy_mode,
-    int64_t min_row_size_to_use_multithread,
+    int64_t min_row_size_to_use_multithread UNUSED,
     bool multi_precision UNUSED,
     bool use_global_beta_pow,
     DenseTensor* param_out,
@@ -108,132 +104,57 @@ void AdamDenseParamSparseGradKernel(
     return;
   }
 
-  std::vector<int64_t> cpu_rows(grad.rows().begin(), grad.rows().end());
-  bool is_strict_sorted = true;
-  for (size_t i = 1; i < cpu_rows.size(); ++i) {
-    if (cpu_rows[i - 1] >= cpu_rows[i]) {
-      is_strict_sorted = false;
-      break;
-    }
-  }
-
-  phi::SelectedRows tmp_grad_merge;
-  const phi::SelectedRows* grad_merge_ptr = nullptr;
-  if (is_strict_sorted) {
-    grad_merge_ptr = &grad;
-  } else {
-    // merge duplicated rows if any.
-    // The rows of grad_merge have been sorted inside MergeAdd functor
-    phi::funcs::scatter::MergeAdd<Context, T> merge_func;
-    merge_func(dev_ctx, grad, &tmp_grad_merge, true);
-    grad_merge_ptr = &tmp_grad_merge;
-  }
-
-  auto& grad_merge = *grad_merge_ptr;
-  auto& grad_tensor = grad_merge.value();
-  const T* grad_data = grad_tensor.template data<T>();
-  auto* grad_merge_rows = &grad_merge.rows();
-  phi::MixVector<int64_t> mixv_grad_merge_rows(grad_merge_rows);
-  const int64_t* rows = mixv_grad_merge_rows.Data(dev_ctx.GetPlace());
-  auto row_numel = grad_tensor.numel() / grad_merge.rows().size();
-
-  funcs::SparseAdamFunctor<T, funcs::CPUAdam> functor(
-      beta1_,
-      beta2_,
-      epsilon_,
-      beta1_pow.data<T>(),
-      beta2_pow.data<T>(),
-      moment1.data<T>(),
-      dev_ctx.template Alloc<T>(moment1_out),
-      moment2.data<T>(),
-      dev_ctx.template Alloc<T>(moment2_out),
-      learning_rate.data<T>(),
-      grad_data,
-      param.data<T>(),
-      dev_ctx.template Alloc<T>(param_out),
-      rows,
-      row_numel,
-      grad_merge.rows().size(),
-      lazy_mode);
+  T beta1_p = beta1_pow.data<T>()[0];
+  T beta2_p = beta2_pow.data<T>()[0];
   // update beta1 and beta2
   if (!use_global_beta_pow) {
-    dev_ctx.template Alloc<T>(beta1_pow_out)[0] =
-        beta1_ * beta1_pow.data<T>()[0];
-    dev_ctx.template Alloc<T>(beta2_pow_out)[0] =
-        beta2_ * beta2_pow.data<T>()[0];
+    dev_ctx.template Alloc<T>(beta1_pow_out)[0] = beta1_ * beta1_p;
+    dev_ctx.template Alloc<T>(beta2_pow_out)[0] = beta2_ * beta2_p;
   }
+
+  const T* param_ptr = param.data<T>();
+  const T* mom1_ptr = moment1.data<T>();
+  const T* mom2_ptr = moment2.data<T>();
+  T* param_out_ptr = dev_ctx.template Alloc<T>(param_out);
+  T* mom1_out_ptr = dev_ctx.template Alloc<T>(moment1_out);
+  T* mom2_out_ptr = dev_ctx.template Alloc<T>(moment2_out);
+
+  T learning_rate_ =
+      learning_rate.data<T>()[0] * (sqrt(1 - beta2_p) / (1 - beta1_p));
+  T eps = epsilon_ * sqrt(1 - beta2_p);
+
+  phi::jit::adam_attr_t attr(beta1_, beta2_);
+  auto adam =
+      phi::jit::KernelFuncs<phi::jit::AdamTuple<T>, phi::CPUPlace>::Cache().At(
+          attr);
+
+  // duplicated rows are merged by the engine while updating
+  phi::funcs::SparseOptimizerEngine<T> engine(grad, param.dims()[0]);
+  const int64_t row_numel = engine.width();
+  auto update = [&](int64_t row, const T* grad_row) {
+    const int64_t offset = row * row_numel;
+    adam(beta1_,
+         beta2_,
+         -learning_rate_,
+         eps,
+         row_numel,
+         grad_row,
+         mom1_ptr + offset,
+         mom2_ptr + offset,
+         param_ptr + offset,
+         mom1_out_ptr + offset,
+         mom2_out_ptr + offset,
+         param_out_ptr + offset);
+  };
   if (lazy_mode) {
     VLOG(3) << "run cpu lazy mode";
-    size_t row_count = grad_merge.rows().size();
-    std::vector<int64_t> cpu_rows(grad_merge.rows());
-    for (size_t row_index = 0; row_index < row_count; ++row_index) {
-      for (size_t offset = 0; offset < row_numel; ++offset) {
-        size_t i = cpu_rows[row_index] * row_numel + offset;
-        functor.adam_update(i, grad_data[row_index * row_numel + offset]);
-      }
-    }
-  }
-#ifndef _WIN32
-  else if (FLAGS_inner_op_parallelism > 1 &&  // NOLINT
-           min_row_size_to_use_multithread > 0 &&
-           param.dims()[0] > min_row_size_to_use_multithread) {
-    VLOG(3) << "use multi thread, inner_op_parallelism="
-            << FLAGS_inner_op_parallelism << " min_row_size_to_use_multithread="
-            << min_row_size_to_use_multithread;
-    if (FLAGS_inner_op_parallelism > 10) {
-      VLOG(1) << "FLAGS_inner_op_parallelism " << FLAGS_inner_op_parallelism
-              << " is two large!";
-    }
-    auto& grad_rows = grad_merge.rows();
-    std::unordered_map<size_t, int> row_id_to_grad_row_offset;
-    size_t param_row_count = param.numel() / row_numel;
-    if (param_row_count < 1000) {
-      VLOG(1) << "param_row_count should be larger then 1000 to use "
-                 "multi thread, currently "
-              << param_row_count;
-    }
-    for (int i = 0; i < static_cast<int>(grad_rows.size()); ++i) {
-      row_id_to_grad_row_offset[grad_rows[i]] = i;
-    }
-    std::vector<std::future<void>> fs;
-    int64_t line_in_each_thread = static_cast<int64_t>(
-        param_row_count / FLAGS_inner_op_parallelism + static_cast<int64_t>(1));
-    for (int i = 0; i < FLAGS_inner_op_parallelism; ++i) {
-      int64_t start = i * line_in_each_thread;
-      int64_t end = (i + 1) * line_in_each_thread;
-      if (start >= static_cast<int64_t>(param_row_count)) {
-        break;
-      }
-      if (end > static_cast<int64_t>(param_row_count)) {
-        end = static_cast<int64_t>(param_row_count);
-      }
-      fs.push_back(phi::Async([&functor,
-                               &row_id_to_grad_row_offset,
-                               &grad_data,
-                               row_numel,
-                               start,
-                               end]() {
-        for (int64_t row_id = start; row_id < end; ++row_id) {
-          auto iter = row_id_to_grad_row_offset.find(row_id);
-          if (iter != row_id_to_grad_row_offset.end()) {
-            for (size_t row_offset = 0U; row_offset < row_numel; ++row_offset) {
-              functor.adam_update(
-                  row_id * row_numel + row_offset,
-                  grad_data[iter->second * row_numel + row_offset]);
-            }
-          } else {
-            for (size_t row_offset = 0U; row_offset < row_numel; ++row_offset) {
-              functor.adam_update(row_id * row_numel + row_offset, 0);
-            }
-          }
-        }
-      }));
-    }
-    for (auto& item : fs) item.wait();
-  }
-#endif    // !_WIN32
-  else {  // NOLINT
-    functor(param.numel());
+    engine.ForEachGradRow(update);
+  } else {
+    // the moments of the rows without gradient decay as with a zero one
+    std::vector<T> zeros(row_numel, static_cast<T>(0));
+    engine.ForEachParamRow([&](int64_t row, const T* grad_row) {
+      update(row, grad_row ? grad_row : zeros.data());
+    });
   }
 }
 
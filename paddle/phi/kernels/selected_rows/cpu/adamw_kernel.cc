@@ -22,6 +22,8 @@
 #include "paddle/phi/core/tensor_utils.h"
 #include "paddle/phi/kernels/adam_kernel.h"
 #include "paddle/phi/kernels/funcs/adam_functors.h"
+#include "paddle/phi/kernels/funcs/jit/kernels.h"
+#include "paddle/phi/kernels/funcs/sparse_optimizer_engine.h"
 #include "paddle/phi/kernels/selected_rows/adam_kernel.h"
 
 namespace phi::sr {
@@ -94,40 +96,120 @@ void AdamwDenseParamSparseGradKernel(
     return;
   }
 
-  auto* param_ =
-      master_param.is_initialized() ? master_param.get_ptr() : &param;
+  // decays the master parameter in place and runs Adam on the parameter
+  if (master_param.is_initialized()) {
+    auto* param_ = master_param.get_ptr();
+    T coeff_ = static_cast<T>(coeff);
+    T lr_ratio_ = static_cast<T>(lr_ratio);
+    funcs::AdamWFunctor<T, funcs::CPUAdamW> functor(
+        coeff_,
+        lr_ratio_,
+        learning_rate.data<T>(),
+        const_cast<T*>(param_->data<T>()));
+    functor(param_->numel());
+
+    AdamDenseParamSparseGradKernel<T, Context>(dev_ctx,
+                                               param,
+                                               grad,
+                                               learning_rate,
+                                               moment1,
+                                               moment2,
+                                               beta1_pow,
+                                               beta2_pow,
+                                               master_param,
+                                               skip_update,
+                                               beta1,
+                                               beta2,
+                                               epsilon,
+                                               lazy_mode,
+                                               min_row_size_to_use_multithread,
+                                               multi_precision,
+                                               use_global_beta_pow,
+                                               param_out,
+                                               moment1_out,
+                                               moment2_out,
+                                               beta1_pow_out,
+                                               beta2_pow_out,
+                                               master_param_outs);
+    return;
+  }
+
+  PADDLE_ENFORCE_EQ(
+      beta1_pow_out->numel(),
+      1,
+      errors::InvalidArgument("beta1 pow output size should be 1, but received "
+                              "value is:%d.",
+                              beta1_pow_out->numel()));
+  PADDLE_ENFORCE_EQ(
+      beta2_pow_out->numel(),
+      1,
+      errors::InvalidArgument("beta2 pow output size should be 1, but received "
+                              "value is:%d.",
+                              beta2_pow_out->numel()));
+
+  if (grad.rows().empty()) {
+    VLOG(3) << "grad row size is 0!!";
+    return;
+  }
+
+  T beta1_ = beta1.to<T>();
+  T beta2_ = beta2.to<T>();
+  T epsilon_ = epsilon.to<T>();
   T coeff_ = static_cast<T>(coeff);
   T lr_ratio_ = static_cast<T>(lr_ratio);
-  funcs::AdamWFunctor<T, funcs::CPUAdamW> functor(
-      coeff_,
-      lr_ratio_,
-      learning_rate.data<T>(),
-      const_cast<T*>(param_->data<T>()));
-  functor(param_->numel());
-
-  AdamDenseParamSparseGradKernel<T, Context>(dev_ctx,
-                                             param,
-                                             grad,
-                                             learning_rate,
-                                             moment1,
-                                             moment2,
-                                             beta1_pow,
-                                             beta2_pow,
-                                             master_param,
-                                             skip_update,
-                                             beta1,
-                                             beta2,
-                                             epsilon,
-                                             lazy_mode,
-                                             min_row_size_to_use_multithread,
-                                             multi_precision,
-                                             use_global_beta_pow,
-                                             param_out,
-                                             moment1_out,
-                                             moment2_out,
-                                             beta1_pow_out,
-                                             beta2_pow_out,
-                                             master_param_outs);
+
+  T beta1_p = beta1_pow.data<T>()[0];
+  T beta2_p = beta2_pow.data<T>()[0];
+  if (!use_global_beta_pow) {
+    dev_ctx.template Alloc<T>(beta1_pow_out)[0] = beta1_ * beta1_p;
+    dev_ctx.template Alloc<T>(beta2_pow_out)[0] = beta2_ * beta2_p;
+  }
+
+  const T* param_ptr = param.data<T>();
+  const T* mom1_ptr = moment1.data<T>();
+  const T* mom2_ptr = moment2.data<T>();
+  T* param_out_ptr = dev_ctx.template Alloc<T>(param_out);
+  T* mom1_out_ptr = dev_ctx.template Alloc<T>(moment1_out);
+  T* mom2_out_ptr = dev_ctx.template Alloc<T>(moment2_out);
+
+  T old_lr = learning_rate.data<T>()[0];
+  T learning_rate_ = old_lr * (sqrt(1 - beta2_p) / (1 - beta1_p));
+  T eps = epsilon_ * sqrt(1 - beta2_p);
+
+  auto adamw =
+      phi::jit::KernelFuncs<phi::jit::AdamWTuple<T>, phi::CPUPlace>::Cache().At(
+          1);
+
+  // The decay and the moment update of a row run in one pass. The decay
+  // applies to all rows, also to those without gradient in lazy mode.
+  phi::funcs::SparseOptimizerEngine<T> engine(grad, param.dims()[0]);
+  const int64_t row_numel = engine.width();
+  std::vector<T> zeros(row_numel, static_cast<T>(0));
+  const T decay = old_lr * lr_ratio_ * coeff_;
+  engine.ForEachParamRow([&](int64_t row, const T* grad_row) {
+    const int64_t offset = row * row_numel;
+    if (grad_row == nullptr && lazy_mode) {
+      for (int64_t i = offset; i < offset + row_numel; ++i) {
+        param_out_ptr[i] = param_ptr[i] - decay * param_ptr[i];
+      }
+      return;
+    }
+    adamw(beta1_,
+          beta2_,
+          -learning_rate_,
+          eps,
+          old_lr,
+          lr_ratio_,
+          coeff_,
+          row_numel,
+          grad_row ? grad_row : zeros.data(),
+          mom1_ptr + offset,
+          mom2_ptr + offset,
+          param_ptr + offset,
+          mom1_out_ptr + offset,
+          mom2_out_ptr + offset,
+          param_out_ptr + offset);
+  });
 }
 
 }  // namespace phi::sr
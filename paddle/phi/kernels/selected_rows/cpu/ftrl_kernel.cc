@@ -12,7 +12,69 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "paddle/phi/kernels/selected_rows/ftrl_kernel.h"
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/funcs/sparse_optimizer_engine.h"
 #include "paddle/phi/kernels/selected_rows/impl/ftrl_kernel_impl.h"
 
-PD_REGISTER_KERNEL(ftrl_sr, CPU, ALL_LAYOUT, phi::sr::FTRLOpKernel, float) {}
+namespace phi {
+namespace sr {
+
+template <typename T, typename Context>
+void FTRLDenseParamSparseGradKernel(
+    const Context& dev_ctx,
+    const DenseTensor& param,
+    const DenseTensor& squared_accumulator,
+    const DenseTensor& linear_accumulator UNUSED,
+    const SelectedRows& grad,
+    const DenseTensor& learning_rate,
+    float l1_in,
+    float l2_in,
+    float lr_power_in,
+    DenseTensor* param_out,
+    DenseTensor* squared_accum_out,
+    DenseTensor* linear_accum_out) {
+  T* param_out_ptr = dev_ctx.template Alloc<T>(param_out);
+  T* sq_accum_out_ptr = dev_ctx.template Alloc<T>(squared_accum_out);
+  T* lin_accum_out_ptr = dev_ctx.template Alloc<T>(linear_accum_out);
+  if (grad.rows().empty()) {
+    return;
+  }
+
+  auto l1 = static_cast<T>(l1_in) + static_cast<T>(1e-10);
+  auto l2 = static_cast<T>(l2_in) + static_cast<T>(1e-10);
+  auto lr_power = static_cast<T>(lr_power_in);
+
+  // FTRL only updates the rows with gradient, the duplicated rows are merged
+  // by the engine while updating
+  phi::funcs::SparseOptimizerEngine<T> engine(grad, param.dims()[0]);
+  const int64_t row_numel = engine.width();
+  engine.ForEachGradRow([&](int64_t row, const T* grad_row) {
+    SparseFTRLFunctor<T> functor(grad_row,
+                                 param.data<T>(),
+                                 squared_accumulator.data<T>(),
+                                 learning_rate.data<T>(),
+                                 l1,
+                                 l2,
+                                 lr_power,
+                                 &row,
+                                 row_numel,
+                                 param_out_ptr,
+                                 sq_accum_out_ptr,
+                                 lin_accum_out_ptr);
+    for (int64_t i = 0; i < row_numel; ++i) {
+      functor(i);
+    }
+  });
+}
+
+}  // namespace sr
+}  // namespace phi
+
+PD_REGISTER_KERNEL(ftrl_sr,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::sr::FTRLDenseParamSparseGradKernel,
+                   float) {}
@@ -13,9 +13,133 @@
 // limitations under the License.
 
 #include "paddle/phi/kernels/selected_rows/lamb_kernel.h"
+
+#include <cmath>
+
+#include "glog/logging.h"
+
 #include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/kernel_registry.h"
-#include "paddle/phi/kernels/selected_rows/impl/lamb_kernel_impl.h"
+#include "paddle/phi/core/selected_rows.h"
+#include "paddle/phi/kernels/funcs/sparse_optimizer_engine.h"
+
+namespace phi {
+namespace sr {
+
+template <typename T, typename Context>
+void LambDenseParamSparseGradKernel(
+    const Context& dev_ctx,
+    const DenseTensor& param,
+    const SelectedRows& grad,
+    const DenseTensor& learning_rate,
+    const DenseTensor& moment1,
+    const DenseTensor& moment2,
+    const DenseTensor& beta1_pow,
+    const DenseTensor& beta2_pow,
+    const paddle::optional<DenseTensor>& master_param UNUSED,
+    const paddle::optional<DenseTensor>& skip_update,
+    float weight_decay_f,
+    float beta1_f,
+    float beta2_f,
+    float epsilon_f,
+    bool always_adapt,
+    bool multi_precision,
+    DenseTensor* param_out,
+    DenseTensor* moment1_out,
+    DenseTensor* moment2_out,
+    DenseTensor* beta1_pow_out,
+    DenseTensor* beta2_pow_out,
+    DenseTensor* master_param_outs UNUSED) {
+  const auto* skip_update_ptr = skip_update.get_ptr();
+  if (skip_update_ptr && skip_update_ptr->IsInitialized() &&
+      *skip_update_ptr->data<bool>()) {
+    return;
+  }
+  PADDLE_ENFORCE_EQ(multi_precision,
+                    false,
+                    common::errors::Unimplemented(
+                        "SelectedRows gradient is not supported when "
+                        "multi_precision=True."));
+  if (grad.rows().empty()) {
+    VLOG(3) << "grad row size is 0!!";
+    return;
+  }
+
+  auto weight_decay = static_cast<T>(weight_decay_f);
+  auto beta1 = static_cast<T>(beta1_f);
+  auto beta2 = static_cast<T>(beta2_f);
+  auto epsilon = static_cast<T>(epsilon_f);
+  const T beta1_p = beta1_pow.data<T>()[0];
+  const T beta2_p = beta2_pow.data<T>()[0];
+  const int64_t numel = param.numel();
+
+  DenseTensor trust_ratio_div;
+  trust_ratio_div.Resize(param.dims());
+  T* trust_ratio_div_ptr = dev_ctx.template Alloc<T>(&trust_ratio_div);
+  const T* param_ptr = param.data<T>();
+  const T* mom1_ptr = moment1.data<T>();
+  const T* mom2_ptr = moment2.data<T>();
+  T* mom1_out_ptr = dev_ctx.template Alloc<T>(moment1_out);
+  T* mom2_out_ptr = dev_ctx.template Alloc<T>(moment2_out);
+
+  // Lamb updates the moments of all rows, a row without gradient as with a
+  // zero one
+  phi::funcs::SparseOptimizerEngine<T> engine(grad, param.dims()[0]);
+  const int64_t row_numel = engine.width();
+  engine.ForEachParamRow([&](int64_t row, const T* grad_row) {
+    const int64_t offset = row * row_numel;
+    for (int64_t k = 0; k < row_numel; ++k) {
+      const int64_t i = offset + k;
+      T g = grad_row ? grad_row[k] : static_cast<T>(0);
+      T mom1 = beta1 * mom1_ptr[i] + (static_cast<T>(1) - beta1) * g;
+      T mom2 = beta2 * mom2_ptr[i] + (static_cast<T>(1) - beta2) * g * g;
+      mom1_out_ptr[i] = mom1;
+      mom2_out_ptr[i] = mom2;
+      T mom1_unbiased = mom1 / (static_cast<T>(1) - beta1_p);
+      T mom2_unbiased = mom2 / (static_cast<T>(1) - beta2_p);
+      trust_ratio_div_ptr[i] =
+          mom1_unbiased / (std::sqrt(mom2_unbiased) + epsilon) +
+          weight_decay * param_ptr[i];
+    }
+  });
+
+  T p_norm = static_cast<T>(0);
+  T trust_ratio_div_norm = static_cast<T>(0);
+  if (weight_decay > static_cast<T>(0) || always_adapt) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for reduction(+ : p_norm, trust_ratio_div_norm)
+#endif
+    for (int64_t i = 0; i < numel; ++i) {
+      p_norm += param_ptr[i] * param_ptr[i];
+      trust_ratio_div_norm += trust_ratio_div_ptr[i] * trust_ratio_div_ptr[i];
+    }
+  }
+  T pn = std::sqrt(p_norm);
+  T tn = std::sqrt(trust_ratio_div_norm);
+  VLOG(1) << "Param pn = " << pn << " , tn = " << tn;
+  T r = (pn > static_cast<T>(0) && tn > static_cast<T>(0))
+            ? pn / tn
+            : static_cast<T>(1);
+  T lr = learning_rate.data<T>()[0] * r;
+
+  T* param_out_ptr = dev_ctx.template Alloc<T>(param_out);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t i = 0; i < numel; ++i) {
+    param_out_ptr[i] = param_ptr[i] - lr * trust_ratio_div_ptr[i];
+  }
+  dev_ctx.template Alloc<T>(beta1_pow_out)[0] = beta1_p * beta1;
+  dev_ctx.template Alloc<T>(beta2_pow_out)[0] = beta2_p * beta2;
+}
+
+}  // namespace sr
+}  // namespace phi
 
-PD_REGISTER_KERNEL(
-    lamb_sr, CPU, ALL_LAYOUT, phi::sr::LambKernel, float, double) {}
+PD_REGISTER_KERNEL(lamb_sr,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::sr::LambDenseParamSparseGradKernel,
+                   float,
+                   double) {}
@@ -0,0 +1,38 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/selected_rows.h"
+
+namespace phi {
+namespace sr {
+
+template <typename T, typename Context>
+void FTRLDenseParamSparseGradKernel(const Context& dev_ctx,
+                                    const DenseTensor& param,
+                                    const DenseTensor& squared_accumulator,
+                                    const DenseTensor& linear_accumulator,
+                                    const SelectedRows& grad,
+                                    const DenseTensor& learning_rate,
+                                    float l1,
+                                    float l2,
+                                    float lr_power,
+                                    DenseTensor* param_out,
+                                    DenseTensor* squared_accum_out,
+                                    DenseTensor* linear_accum_out);
+
+}  // namespace sr
+}  // namespace phi
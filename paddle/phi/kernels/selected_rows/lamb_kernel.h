@@ -43,5 +43,30 @@ void LambKernel(const Context& dev_ctx,
                 DenseTensor* beta2_pow_out,
                 DenseTensor* master_param_outs);
 
+template <typename T, typename Context>
+void LambDenseParamSparseGradKernel(
+    const Context& dev_ctx,
+    const DenseTensor& param,
+    const SelectedRows& grad,
+    const DenseTensor& learning_rate,
+    const DenseTensor& moment1,
+    const DenseTensor& moment2,
+    const DenseTensor& beta1_pow,
+    const DenseTensor& beta2_pow,
+    const paddle::optional<DenseTensor>& master_param,
+    const paddle::optional<DenseTensor>& skip_update,
+    float weight_decay,
+    float beta1,
+    float beta2,
+    float epsilon,
+    bool always_adapt,
+    bool multi_precision,
+    DenseTensor* param_out,
+    DenseTensor* moment1_out,
+    DenseTensor* moment2_out,
+    DenseTensor* beta1_pow_out,
+    DenseTensor* beta2_pow_out,
+    DenseTensor* master_param_outs);
+
 }  // namespace sr
 }  // namespace phi
@@ -161,20 +161,19 @@ class IR_API Pass {
 
   virtual bool CanApplyOn(Operation* op) const;
 
+  // A region-local pass only reads and writes the IR nested in the regions of
+  // the operation it runs on, and reaches its execution state through
+  // pass_state() or analysis_manager() only. The pass manager may run it on
+  // several sibling operations at the same time.
+  virtual bool IsRegionLocal() const { return false; }
+
   virtual bool Initialize(IrContext* context) { return true; }
 
-  void AddStatistics(int64_t match_count) {
-    Set<int64_t>("__match_count__", new int64_t{match_count});
-  }
+  void AddStatistics(int64_t match_count);
 
-  void AddStatistics(int64_t match_count_1, int64_t match_count_2) {
-    Set<int64_t>("__match_count_1__", new int64_t{match_count_1});
-    Set<int64_t>("__match_count_2__", new int64_t{match_count_2});
-  }
+  void AddStatistics(int64_t match_count_1, int64_t match_count_2);
 
-  void AddStatistics(const std::string& custom_log) {
-    Set<std::string>("__custom_log__", new std::string{custom_log});
-  }
+  void AddStatistics(const std::string& custom_log);
 
   AnalysisManager analysis_manager();
 
@@ -115,6 +115,13 @@ class IR_API PassManager {
 
   void AddInstrumentation(std::unique_ptr<PassInstrumentation> pi);
 
+  // If all the passes are region-local, runs the pipeline on the operations
+  // with regions of a block on `num_threads` threads. Operations whose
+  // regions use the same value defined outside of them run on one thread.
+  void EnableParallelExecution(int num_threads) { num_threads_ = num_threads; }
+
+  int num_threads() const { return num_threads_; }
+
  private:
   bool Initialize(IrContext *context);
 
@@ -129,6 +136,8 @@ class IR_API PassManager {
 
   bool disable_log_{false};
 
+  int num_threads_;
+
   std::vector<std::unique_ptr<Pass>> passes_;
 
   std::unique_ptr<Pass> pass_adaptor_;
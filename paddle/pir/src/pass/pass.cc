@@ -13,6 +13,19 @@
 // limitations under the License.
 
 #include "paddle/pir/include/pass/pass.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+
+#include "paddle/pir/include/core/block_argument.h"
 #include "paddle/pir/include/core/ir_context.h"
 #include "paddle/pir/include/core/operation.h"
 #include "paddle/pir/include/core/program.h"
@@ -24,9 +37,133 @@
 #include "paddle/pir/src/pass/pass_adaptor.h"
 
 #include "paddle/common/enforce.h"
+#include "paddle/common/flags.h"
+
+COMMON_DECLARE_int32(pir_pass_manager_num_threads);
 
 namespace pir {
 
+namespace {
+// The execution states of the passes run by a thread of a parallel pass
+// adaptor. Other threads keep them in Pass::pass_state_.
+thread_local std::unordered_map<const Pass*,
+                                std::optional<detail::PassExecutionState>>*
+    worker_pass_states = nullptr;
+
+class ParallelWorkerScope {
+ public:
+  ParallelWorkerScope() : prev_states_(worker_pass_states) {
+    worker_pass_states = &states_;
+  }
+
+  ~ParallelWorkerScope() { worker_pass_states = prev_states_; }
+
+ private:
+  std::unordered_map<const Pass*, std::optional<detail::PassExecutionState>>
+      states_;
+  decltype(worker_pass_states) prev_states_;
+};
+
+// Guards the statistics of the passes and the instrumentations, which the
+// threads of a parallel pass adaptor share.
+std::mutex& InstrumentationMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+// The threads of the parallel pass adaptors. They are created on first use
+// and kept for the life of the process, so that running a pass manager does
+// not spawn threads.
+class PassThreadPool {
+ public:
+  static PassThreadPool* Instance() {
+    static auto* pool = new PassThreadPool();
+    return pool;
+  }
+
+  // Runs `task` on `num_workers` threads of the pool and on the calling
+  // thread, and returns when all of them are done.
+  void Run(size_t num_workers, const std::function<void()>& task) {
+    size_t pending = num_workers;
+    std::mutex done_mutex;
+    std::condition_variable done;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      while (threads_.size() < num_workers) {
+        threads_.emplace_back([this] { Loop(); });
+      }
+      for (size_t i = 0; i < num_workers; ++i) {
+        tasks_.emplace_back([&] {
+          task();
+          std::lock_guard<std::mutex> guard(done_mutex);
+          if (--pending == 0) done.notify_one();
+        });
+      }
+    }
+    cv_.notify_all();
+    task();
+    std::unique_lock<std::mutex> lock(done_mutex);
+    done.wait(lock, [&] { return pending == 0; });
+  }
+
+ private:
+  void Loop() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !tasks_.empty(); });
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  std::vector<std::thread> threads_;
+};
+
+bool IsDefinedIn(Value value, Operation* op) {
+  Operation* owner = value.defining_op();
+  if (!owner && value.isa<BlockArgument>()) {
+    owner = value.dyn_cast<BlockArgument>().owner()->GetParentOp();
+  }
+  for (; owner; owner = owner->GetParentOp()) {
+    if (owner == op) return true;
+  }
+  return false;
+}
+
+// Collects the values defined outside of `op` that operations nested in
+// `inner` use.
+void CollectCaptures(Operation* op,
+                     Operation* inner,
+                     std::vector<Value>* captures) {
+  for (auto& region : *inner) {
+    for (auto& block : region) {
+      for (auto& nested_op : block) {
+        for (uint32_t i = 0; i < nested_op.num_operands(); ++i) {
+          Value value = nested_op.operand_source(i);
+          if (value && !IsDefinedIn(value, op)) captures->push_back(value);
+        }
+        CollectCaptures(op, &nested_op, captures);
+      }
+    }
+  }
+}
+
+size_t FindRoot(std::vector<size_t>* parents, size_t i) {
+  while ((*parents)[i] != i) {
+    (*parents)[i] = (*parents)[(*parents)[i]];
+    i = (*parents)[i];
+  }
+  return i;
+}
+}  // namespace
+
 //===----------------------------------------------------------------------===//
 // Pass
 //===----------------------------------------------------------------------===//
@@ -43,21 +180,40 @@ Pass::~Pass() {
 bool Pass::CanApplyOn(Operation* op) const { return op->num_regions() > 0; }
 
 std::optional<detail::PassExecutionState>& Pass::pass_state() {
+  if (worker_pass_states) return (*worker_pass_states)[this];
   return pass_state_;
 }
 
 void Pass::SignalPassFailure() {
-  PADDLE_ENFORCE_EQ(pass_state_.has_value(),
+  auto& pass_state = this->pass_state();
+  PADDLE_ENFORCE_EQ(pass_state.has_value(),
                     true,
                     common::errors::InvalidArgument("pass state has no value"));
-  pass_state_->pass_failed = true;
+  pass_state->pass_failed = true;
 }
 
 AnalysisManager Pass::analysis_manager() {
-  PADDLE_ENFORCE_EQ(pass_state_.has_value(),
+  auto& pass_state = this->pass_state();
+  PADDLE_ENFORCE_EQ(pass_state.has_value(),
                     true,
                     common::errors::InvalidArgument("pass state has no value"));
-  return pass_state_->am;
+  return pass_state->am;
+}
+
+void Pass::AddStatistics(int64_t match_count) {
+  std::lock_guard<std::mutex> guard(InstrumentationMutex());
+  Set<int64_t>("__match_count__", new int64_t{match_count});
+}
+
+void Pass::AddStatistics(int64_t match_count_1, int64_t match_count_2) {
+  std::lock_guard<std::mutex> guard(InstrumentationMutex());
+  Set<int64_t>("__match_count_1__", new int64_t{match_count_1});
+  Set<int64_t>("__match_count_2__", new int64_t{match_count_2});
+}
+
+void Pass::AddStatistics(const std::string& custom_log) {
+  std::lock_guard<std::mutex> guard(InstrumentationMutex());
+  Set<std::string>("__custom_log__", new std::string{custom_log});
 }
 //===----------------------------------------------------------------------===//
 // PatternRewritePass
@@ -103,6 +259,13 @@ void detail::PassAdaptor::RunImpl(Operation* op,
                                   bool verify) {
   auto last_am = analysis_manager();
 
+  if (pm_->num_threads() > 1 && !pm_->empty() && !worker_pass_states &&
+      std::all_of(pm_->passes().begin(),
+                  pm_->passes().end(),
+                  [](const auto& pass) { return pass->IsRegionLocal(); })) {
+    return RunParallelImpl(op, opt_level, verify);
+  }
+
   for (size_t i = 0; i < op->num_regions(); ++i) {
     auto& region = op->region(i);
     for (auto& block : region) {
@@ -116,6 +279,92 @@ void detail::PassAdaptor::RunImpl(Operation* op,
   return;
 }
 
+void detail::PassAdaptor::RunParallelImpl(Operation* op,
+                                          uint8_t opt_level,
+                                          bool verify) {
+  auto* instrumentor = analysis_manager().GetPassInstrumentor();
+
+  // The operations with regions are grouped so that no two groups use the
+  // same value defined outside of them, as the bodies of control flow
+  // operations use the values of the enclosing block. A region-local pass
+  // leaves those values read-only, but may add or remove their uses, which
+  // only the group using them sees. The groups run in parallel, the
+  // operations of a group in order on one thread.
+  std::vector<Operation*> region_ops;
+  std::vector<Operation*> other_ops;
+  for (size_t i = 0; i < op->num_regions(); ++i) {
+    for (auto& block : op->region(i)) {
+      for (auto& inner_op : block) {
+        if (inner_op.num_regions() > 0) {
+          region_ops.push_back(&inner_op);
+        } else {
+          other_ops.push_back(&inner_op);
+        }
+      }
+    }
+  }
+  std::vector<size_t> parents(region_ops.size());
+  std::iota(parents.begin(), parents.end(), 0);
+  std::unordered_map<Value, size_t> capture_owners;
+  for (size_t i = 0; i < region_ops.size(); ++i) {
+    std::vector<Value> captures;
+    CollectCaptures(region_ops[i], region_ops[i], &captures);
+    for (Value value : captures) {
+      auto [iter, inserted] = capture_owners.emplace(value, i);
+      if (!inserted) {
+        parents[FindRoot(&parents, i)] = FindRoot(&parents, iter->second);
+      }
+    }
+  }
+  std::vector<std::vector<Operation*>> groups;
+  std::unordered_map<size_t, size_t> group_of_root;
+  for (size_t i = 0; i < region_ops.size(); ++i) {
+    auto [iter, inserted] =
+        group_of_root.emplace(FindRoot(&parents, i), groups.size());
+    if (inserted) groups.emplace_back();
+    groups[iter->second].push_back(region_ops[i]);
+  }
+
+  // The threads take the groups one by one.
+  std::atomic<size_t> next_group{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto RunGroups = [&]() {
+    ParallelWorkerScope scope;
+    for (size_t i = next_group++; i < groups.size() && !failed;
+         i = next_group++) {
+      for (Operation* group_op : groups[i]) {
+        try {
+          AnalysisManagerHolder am(group_op, instrumentor);
+          if (!RunPipeline(*pm_, group_op, am, opt_level, verify)) {
+            failed = true;
+          }
+        } catch (...) {
+          std::lock_guard<std::mutex> guard(error_mutex);
+          if (!error) error = std::current_exception();
+          failed = true;
+        }
+        if (failed) break;
+      }
+    }
+  };
+  size_t num_threads = std::min<size_t>(pm_->num_threads(), groups.size());
+  if (num_threads > 1) {
+    PassThreadPool::Instance()->Run(num_threads - 1, RunGroups);
+  } else {
+    RunGroups();
+  }
+  if (error) std::rethrow_exception(error);
+  if (failed) return SignalPassFailure();
+
+  for (auto* other_op : other_ops) {
+    AnalysisManagerHolder am(other_op, instrumentor);
+    if (!RunPipeline(*pm_, other_op, am, opt_level, verify))
+      return SignalPassFailure();
+  }
+}
+
 bool detail::PassAdaptor::RunPipeline(const PassManager& pm,
                                       Operation* op,
                                       AnalysisManager am,
@@ -134,15 +383,16 @@ bool detail::PassAdaptor::RunPipeline(const PassManager& pm,
     }
   }
 
-  if (instrumentor) {
-    instrumentor->RunAfterPipeline(op);
-  }
-
   // Apply pass manager on all nested ir.
   if (!RunPass(pm.pass_adaptor_.get(), op, am, opt_level, verify)) {
     return false;
   }
 
+  // The pipeline covers the nested ir as well.
+  if (instrumentor) {
+    instrumentor->RunAfterPipeline(op);
+  }
+
   return true;
 }
 
@@ -153,7 +403,7 @@ bool detail::PassAdaptor::RunPass(Pass* pass,
                                   bool verify) {
   if (opt_level < pass->pass_info().opt_level) return true;
 
-  pass->pass_state_ = PassExecutionState(op, am);
+  pass->pass_state() = PassExecutionState(op, am);
 
   PassInstrumentor* instrumentor = am.GetPassInstrumentor();
 
@@ -178,7 +428,9 @@ bool detail::PassAdaptor::RunPass(Pass* pass,
 // PassManager
 //----------------------------------------------------------------------------------------------//
 PassManager::PassManager(IrContext* context, uint8_t opt_level)
-    : context_(context), opt_level_(opt_level) {
+    : context_(context),
+      opt_level_(opt_level),
+      num_threads_(FLAGS_pir_pass_manager_num_threads) {
   pass_adaptor_ = std::make_unique<detail::PassAdaptor>(this);
 }
 
@@ -215,7 +467,8 @@ void PassManager::AddInstrumentation(std::unique_ptr<PassInstrumentation> pi) {
 //----------------------------------------------------------------------------------------------//
 namespace detail {
 struct PassInstrumentorImpl {
-  // TODO(wilber): Support multi-thread.
+  // Called under InstrumentationMutex(), for a parallel pass adaptor calls
+  // them from several threads.
   std::vector<std::unique_ptr<PassInstrumentation>> instrumentations;
 };
 }  // namespace detail
@@ -227,6 +480,7 @@ PassInstrumentor::~PassInstrumentor() = default;
 
 void PassInstrumentor::RunBeforePipeline(Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(InstrumentationMutex());
   for (auto& instr : impl_->instrumentations) {
     instr->RunBeforePipeline(op);
   }
@@ -234,6 +488,7 @@ void PassInstrumentor::RunBeforePipeline(Operation* op) {
 
 void PassInstrumentor::RunAfterPipeline(Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(InstrumentationMutex());
   for (auto it = impl_->instrumentations.rbegin();
        it != impl_->instrumentations.rend();
        ++it) {
@@ -243,6 +498,7 @@ void PassInstrumentor::RunAfterPipeline(Operation* op) {
 
 void PassInstrumentor::RunBeforePass(Pass* pass, Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(InstrumentationMutex());
   for (auto& instr : impl_->instrumentations) {
     instr->RunBeforePass(pass, op);
   }
@@ -250,6 +506,7 @@ void PassInstrumentor::RunBeforePass(Pass* pass, Operation* op) {
 
 void PassInstrumentor::RunAfterPass(Pass* pass, Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(InstrumentationMutex());
   for (auto it = impl_->instrumentations.rbegin();
        it != impl_->instrumentations.rend();
        ++it) {
@@ -261,6 +518,7 @@ void PassInstrumentor::RunBeforeAnalysis(const std::string& name,
                                          TypeId id,
                                          Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(InstrumentationMutex());
   for (auto& instr : impl_->instrumentations) {
     instr->RunBeforeAnalysis(name, id, op);
   }
@@ -270,6 +528,7 @@ void PassInstrumentor::RunAfterAnalysis(const std::string& name,
                                         TypeId id,
                                         Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(InstrumentationMutex());
   for (auto it = impl_->instrumentations.rbegin();
        it != impl_->instrumentations.rend();
        ++it) {
@@ -34,6 +34,8 @@ class PassAdaptor final : public Pass {
  private:
   void RunImpl(Operation* op, uint8_t opt_level, bool verify);
 
+  void RunParallelImpl(Operation* op, uint8_t opt_level, bool verify);
+
   static bool RunPass(Pass* pass,
                       Operation* op,
                       AnalysisManager am,
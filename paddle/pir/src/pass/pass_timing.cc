@@ -18,6 +18,7 @@
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "paddle/common/macros.h"
 #include "paddle/pir/include/core/operation.h"
@@ -40,6 +41,8 @@ class Timer {
 
   void Stop() { walk_time += std::chrono::steady_clock::now() - start_time_; }
 
+  void Merge(const Timer& other) { walk_time += other.walk_time; }
+
   double GetTimePerSecond() const {
     return std::chrono::duration_cast<std::chrono::duration<double>>(walk_time)
         .count();
@@ -58,6 +61,7 @@ class PassTimer : public PassInstrumentation {
   ~PassTimer() override = default;
 
   void RunBeforePipeline(pir::Operation* op) override {
+    if (!root_op_) root_op_ = op;
     pipeline_timers_[op] = Timer();
     pipeline_timers_[op].Start();
   }
@@ -67,6 +71,11 @@ class PassTimer : public PassInstrumentation {
     std::ostringstream oss;
     PrintTime(op, oss);
     std::cout << oss.str() << std::endl;
+    if (op == root_op_) {
+      root_op_ = nullptr;
+      nested_ops_.clear();
+      nested_pass_timers_.clear();
+    }
   }
 
   void RunBeforePass(Pass* pass, Operation* op) override {
@@ -78,7 +87,12 @@ class PassTimer : public PassInstrumentation {
   }
 
   void RunAfterPass(Pass* pass, Operation* op) override {
-    pass_timers_[op][pass->name()].Stop();
+    auto& timer = pass_timers_[op][pass->name()];
+    timer.Stop();
+    if (op != root_op_) {
+      nested_ops_.insert(op);
+      nested_pass_timers_[pass->name()].Merge(timer);
+    }
   }
 
  private:
@@ -93,6 +107,20 @@ class PassTimer : public PassInstrumentation {
     os << "  ----Walk Time----  ----Name----\n";
 
     auto& map = pass_timers_[op];
+    PrintPassTimes(map, pipeline_timers_[op], os);
+
+    if (op != root_op_ || nested_ops_.empty()) return;
+    // Passes on sibling regions may overlap, so the walk times of the nested
+    // ir can add up to more than the total.
+    os << "\n  Nested Regions: " << nested_ops_.size() << " operations\n\n";
+    os << "  ----Walk Time----  ----Name----\n";
+    PrintPassTimes(nested_pass_timers_, pipeline_timers_[op], os);
+  }
+
+  static void PrintPassTimes(
+      const std::unordered_map<std::string, Timer>& map,
+      const Timer& total,
+      std::ostream& os) {
     std::vector<std::pair<std::string, Timer>> pairs(map.begin(), map.end());
     std::sort(pairs.begin(),
               pairs.end(),
@@ -106,8 +134,7 @@ class PassTimer : public PassInstrumentation {
       os << "  " << std::fixed << std::setw(8) << std::setprecision(3)
          << v.second.GetTimePerSecond() << " (" << std::setw(5)
          << std::setprecision(1)
-         << 100 * v.second.GetTimePerSecond() /
-                pipeline_timers_[op].GetTimePerSecond()
+         << 100 * v.second.GetTimePerSecond() / total.GetTimePerSecond()
          << "%)"
          << "  " << v.first << "\n";
     }
@@ -116,11 +143,18 @@ class PassTimer : public PassInstrumentation {
  private:
   bool print_module_;
 
+  // The operation the outermost pipeline runs on.
+  Operation* root_op_{nullptr};
+
   std::unordered_map<Operation*, Timer> pipeline_timers_;
 
   std::unordered_map<Operation*,
                      std::unordered_map<std::string /*pass name*/, Timer>>
       pass_timers_;
+
+  std::unordered_set<Operation*> nested_ops_;
+
+  std::unordered_map<std::string /*pass name*/, Timer> nested_pass_timers_;
 };
 
 void PassManager::EnablePassTiming(bool print_module) {
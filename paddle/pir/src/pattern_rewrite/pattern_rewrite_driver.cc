@@ -158,6 +158,7 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
 
   /// Add the given operation to the worklist.
   void AddToWorklist(pir::Operation* op) {
+    if (!IsInRegion(op)) return;
     if (config_.strict_mode == pir::GreedyRewriteStrictness::AnyOp ||
         strict_mode_filtered_ops_.count(op)) {
       if (worklist_map_.count(op)) return;
@@ -167,6 +168,17 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
     }
   }
 
+  /// Whether the operation is nested in the region being rewritten. The
+  /// operations defining the values the region uses are left untouched.
+  bool IsInRegion(pir::Operation* op) const {
+    for (pir::Region* region = op->GetParentRegion(); region;) {
+      if (region == &region_) return true;
+      pir::Operation* parent = region->GetParent();
+      region = parent ? parent->GetParentRegion() : nullptr;
+    }
+    return false;
+  }
+
   void AddOperandToWorklist(pir::Value operand) {
     // If the use count of this operand is now < 2, we re-add the defining
     // operation to the worklist.
@@ -36,6 +36,8 @@
 using namespace egr;            // NOLINT
 using namespace egr_utils_api;  // NOLINT
 
+COMMON_DECLARE_int32(eager_parallel_backward_threads);
+
 TEST(Benchmark, EagerScaleCPU) {
   // Prepare Device Contexts
   eager_test::InitEnv(phi::CPUPlace());
@@ -240,3 +242,82 @@ TEST(Benchmark, EagerIntermediateMLPCPU) {
     }
   }
 }
+
+TEST(Benchmark, EagerMultiBranchMLPCPU) {
+  // Prepare Device Contexts
+  eager_test::InitEnv(phi::CPUPlace());
+
+  auto tracer = std::make_shared<paddle::imperative::Tracer>();
+  paddle::imperative::SetCurrentTracer(tracer);
+
+  const size_t num_runs = 20;
+  int default_threads = FLAGS_eager_parallel_backward_threads;
+  double sequential_ms = 0.0;
+  // 0 runs the sequential engine
+  for (int threads : {0, 2, 4, 8}) {
+    FLAGS_eager_parallel_backward_threads = threads;
+    for (const std::string mode : {"Accuracy", "Performance"}) {
+      phi::DDim ddimX = common::make_ddim({MULTI_BRANCH_M, MULTI_BRANCH_N});
+      paddle::Tensor X =
+          eager_test::CreateTensorWithValue(ddimX,
+                                            phi::CPUPlace(),
+                                            phi::DataType::FLOAT32,
+                                            phi::DataLayout::NCHW,
+                                            MULTI_BRANCH_X_VAL,
+                                            true);
+      RetainGradForTensor(X);
+
+      std::vector<paddle::Tensor> Ws;
+      std::vector<paddle::Tensor> Bs;
+      for (size_t i = 0; i < MULTI_BRANCH_NUM_TOWERS * MULTI_BRANCH_DEPTH;
+           i++) {
+        phi::DDim ddimW =
+            common::make_ddim({MULTI_BRANCH_N, MULTI_BRANCH_N});
+        paddle::Tensor W =
+            eager_test::CreateTensorWithValue(ddimW,
+                                              phi::CPUPlace(),
+                                              phi::DataType::FLOAT32,
+                                              phi::DataLayout::NCHW,
+                                              MULTI_BRANCH_W_VAL,
+                                              true);
+        RetainGradForTensor(W);
+
+        phi::DDim ddimB = common::make_ddim({MULTI_BRANCH_N});
+        paddle::Tensor B =
+            eager_test::CreateTensorWithValue(ddimB,
+                                              phi::CPUPlace(),
+                                              phi::DataType::FLOAT32,
+                                              phi::DataLayout::NCHW,
+                                              MULTI_BRANCH_B_VAL,
+                                              true);
+        RetainGradForTensor(B);
+
+        Ws.emplace_back(std::move(W));
+        Bs.emplace_back(std::move(B));
+      }
+
+      if (mode == "Accuracy") {
+        benchmark_eager_multi_branch_mlp(
+            X, Ws, Bs, 2, true /* accuracy_check */);
+
+      } else if (mode == "Performance") {
+        auto t_start = std::chrono::high_resolution_clock::now();
+        benchmark_eager_multi_branch_mlp(X, Ws, Bs, num_runs);
+        auto t_end = std::chrono::high_resolution_clock::now();
+        double elapsed_time_ms =
+            std::chrono::duration<double, std::milli>(t_end - t_start).count();
+        if (threads == 0) {
+          sequential_ms = elapsed_time_ms;
+        }
+        std::cout << "Backward threads: " << threads
+                  << ", Duration: " << elapsed_time_ms
+                  << " ms, Speedup: " << sequential_ms / elapsed_time_ms
+                  << std::endl;
+
+      } else {
+        PADDLE_THROW(common::errors::Fatal("Unknown benchmark mode"));
+      }
+    }
+  }
+  FLAGS_eager_parallel_backward_threads = default_threads;
+}
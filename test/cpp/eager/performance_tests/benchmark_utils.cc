@@ -152,6 +152,46 @@ void benchmark_eager_intermediate_mlp(const paddle::Tensor& X,
   }
 }
 
+/* -------------------------------- */
+/* ---- Eager Multi-branch MLP ---- */
+/* -------------------------------- */
+void benchmark_eager_multi_branch_mlp(const paddle::Tensor& X,
+                                      const std::vector<paddle::Tensor>& Ws,
+                                      const std::vector<paddle::Tensor>& Bs,
+                                      size_t num_runs,
+                                      bool accuracy_check) {
+  paddle::Tensor Out;
+  for (size_t run = 0; run < num_runs; run++) {
+    for (size_t t = 0; t < MULTI_BRANCH_NUM_TOWERS; t++) {
+      paddle::Tensor input0 = X;
+      for (size_t i = 0; i < MULTI_BRANCH_DEPTH; i++) {
+        size_t layer = t * MULTI_BRANCH_DEPTH + i;
+        paddle::Tensor Linear = matmul_v2_dygraph_function(
+            input0, Ws[layer], {{"trans_x", false}, {"trans_y", false}});
+        input0 = elementwise_add_dygraph_function(Linear, Bs[layer], {});
+      }
+      paddle::Tensor Tower =
+          reduce_sum_dygraph_function(input0, {{"reduce_all", true}});
+      Out = t == 0 ? Tower : elementwise_add_dygraph_function(Out, Tower, {});
+    }
+
+    std::vector<paddle::Tensor> target_tensors = {Out};
+    Backward(target_tensors, {});
+  }
+
+  if (accuracy_check) {
+    std::unordered_map<std::string, float> result =
+        compute_multi_branch_expected_results();
+
+    // Grads accumulate over the runs
+    eager_test::CompareTensorWithValue<float>(Out, result["Out"]);
+    eager_test::CompareGradTensorWithValue<float>(
+        X, result["GradX"] * num_runs);
+    eager_test::CompareGradTensorWithValue<float>(
+        Ws[0], result["GradW"] * num_runs);
+  }
+}
+
 }  // namespace egr
 
 namespace paddle {
@@ -32,6 +32,18 @@
 #define MLP_B_VAL 3.0
 #define MLP_NUM_LINEAR 1000
 
+/* Multi-branch MLP Configurations */
+// Tower_t = Linear_t_D(... Linear_t_1(X[M, N]) ...), Linear = x W[N, N] + B[N]
+// Out     = ReduceSum(Tower_1) + ... + ReduceSum(Tower_T)
+// The towers only meet at X and Out, so their grad nodes are independent.
+#define MULTI_BRANCH_M 64
+#define MULTI_BRANCH_N 256
+#define MULTI_BRANCH_NUM_TOWERS 8
+#define MULTI_BRANCH_DEPTH 8
+#define MULTI_BRANCH_X_VAL 1.0
+#define MULTI_BRANCH_W_VAL (1.0 / MULTI_BRANCH_N)
+#define MULTI_BRANCH_B_VAL 0.5
+
 namespace egr {
 
 inline std::unordered_map<std::string, float> compute_mlp_expected_results() {
@@ -47,6 +59,18 @@ inline std::unordered_map<std::string, float> compute_mlp_expected_results() {
   return {{"Out", Out}, {"GradX", GradX}, {"GradW", GradW0}};
 }
 
+inline std::unordered_map<std::string, float>
+compute_multi_branch_expected_results() {
+  // every linear maps a row of v to v * N * W + B = v + B
+  float Tower = MULTI_BRANCH_X_VAL + MULTI_BRANCH_DEPTH * MULTI_BRANCH_B_VAL;
+  float Out =
+      Tower * MULTI_BRANCH_M * MULTI_BRANCH_N * MULTI_BRANCH_NUM_TOWERS;
+  // and passes a grad of ones back as ones, since N * W = 1
+  float GradX = MULTI_BRANCH_NUM_TOWERS;
+  float GradW0 = MULTI_BRANCH_X_VAL * MULTI_BRANCH_M;
+  return {{"Out", Out}, {"GradX", GradX}, {"GradW", GradW0}};
+}
+
 /* ---- Eager Scale ---- */
 void benchmark_eager_scale(const paddle::Tensor& tensor,
                            bool accuracy_check = false);
@@ -65,6 +89,14 @@ void benchmark_eager_intermediate_mlp(const paddle::Tensor& X,
                                       const std::vector<paddle::Tensor>& Bs,
                                       bool accuracy_check = false);
 
+/* ---- Eager Multi-branch MLP ---- */
+// Ws and Bs hold the layers of tower t at [t * MULTI_BRANCH_DEPTH, ...)
+void benchmark_eager_multi_branch_mlp(const paddle::Tensor& X,
+                                      const std::vector<paddle::Tensor>& Ws,
+                                      const std::vector<paddle::Tensor>& Bs,
+                                      size_t num_runs,
+                                      bool accuracy_check = false);
+
 }  // namespace egr
 
 namespace paddle {
@@ -0,0 +1,100 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "paddle/common/flags.h"
+#include "paddle/fluid/framework/channel.h"
+
+PD_DEFINE_int32(channel_bench_item_num,
+                4000000,
+                "total item num moved through the channel in every run");
+PD_DEFINE_int32(channel_bench_max_threads,
+                32,
+                "max producer and consumer thread num of the benchmark");
+
+namespace framework = paddle::framework;
+using framework::ChannelMode;
+
+// Moves FLAGS_channel_bench_item_num records through one channel with
+// `threads` producers writing blocks via ChannelWriter and `threads`
+// consumers reading with ReadOnce, the same pattern as the data feed reader
+// threads. Returns the throughput in million records per second.
+static double RunChannel(ChannelMode mode, int threads, size_t block_size) {
+  auto chan = framework::MakeChannel<uint64_t>(64 * 1024, mode);
+  chan->SetBlockSize(block_size);
+  const int64_t per_thread = FLAGS_channel_bench_item_num / threads;
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> producers;
+  for (int t = 0; t < threads; ++t) {
+    producers.emplace_back([&chan, per_thread, t]() {
+      framework::ChannelWriter<uint64_t> writer(chan.get());
+      for (int64_t i = 0; i < per_thread; ++i) {
+        writer << static_cast<uint64_t>(t * per_thread + i);
+      }
+      writer.Flush();
+    });
+  }
+  std::vector<uint64_t> sums(threads, 0);
+  std::vector<std::thread> consumers;
+  for (int t = 0; t < threads; ++t) {
+    consumers.emplace_back([&chan, &sums, block_size, t]() {
+      std::vector<uint64_t> batch;
+      while (chan->ReadOnce(batch, block_size) != 0) {
+        for (auto v : batch) {
+          sums[t] += v;
+        }
+      }
+    });
+  }
+  for (auto& th : producers) {
+    th.join();
+  }
+  chan->Close();
+  for (auto& th : consumers) {
+    th.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  uint64_t total = per_thread * threads;
+  uint64_t sum = 0;
+  for (auto s : sums) {
+    sum += s;
+  }
+  EXPECT_EQ(sum, total * (total - 1) / 2);
+  return static_cast<double>(total) / seconds / 1e6;
+}
+
+TEST(Benchmark, ChannelContention) {
+  for (size_t block_size : {1, 64}) {
+    for (int threads = 1; threads <= FLAGS_channel_bench_max_threads;
+         threads *= 2) {
+      double mutex_rate = RunChannel(ChannelMode::kMutex, threads, block_size);
+      double ring_rate =
+          RunChannel(ChannelMode::kLockFreeRing, threads, block_size);
+      std::cout << "block_size " << block_size << " threads " << threads
+                << "x" << threads << ": mutex " << mutex_rate
+                << " M/s, lock-free ring " << ring_rate << " M/s, speedup "
+                << ring_rate / mutex_rate << std::endl;
+    }
+  }
+}
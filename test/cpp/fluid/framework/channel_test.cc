@@ -0,0 +1,140 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/channel.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace framework = paddle::framework;
+using framework::ChannelMode;
+
+class ChannelModeTest : public ::testing::TestWithParam<ChannelMode> {};
+
+TEST_P(ChannelModeTest, ReadWriteClose) {
+  auto chan = framework::MakeChannel<std::string>(16, GetParam());
+  ASSERT_EQ(chan->Capacity(), 16u);
+  std::vector<std::string> in = {"a", "b", "c"};
+  ASSERT_EQ(chan->Write(in), 3u);
+  ASSERT_EQ(chan->Size(), 3u);
+  ASSERT_TRUE(chan->Put(std::string("d")));
+
+  std::string val;
+  ASSERT_TRUE(chan->Get(val));
+  ASSERT_EQ(val, "a");
+  std::vector<std::string> out;
+  // ReadOnce returns what is buffered without waiting for more
+  ASSERT_EQ(chan->ReadOnce(out, 8), 3u);
+  ASSERT_EQ(out, std::vector<std::string>({"b", "c", "d"}));
+
+  chan->Close();
+  ASSERT_FALSE(chan->Put(std::string("e")));
+  ASSERT_FALSE(chan->Get(val));
+  ASSERT_TRUE(chan->Empty());
+}
+
+TEST_P(ChannelModeTest, WriteMoveClearsInput) {
+  auto chan = framework::MakeChannel<std::unique_ptr<int>>(4, GetParam());
+  std::vector<std::unique_ptr<int>> in;
+  in.emplace_back(new int(1));
+  in.emplace_back(new int(2));
+  ASSERT_EQ(chan->WriteMove(in.size(), in.data()), 2u);
+  ASSERT_EQ(in[0], nullptr);
+  std::vector<std::unique_ptr<int>> out(2);
+  ASSERT_EQ(chan->Read(2, out.data()), 2u);
+  ASSERT_EQ(*out[1], 2);
+  chan->Close();
+}
+
+TEST_P(ChannelModeTest, ConcurrentProducersConsumers) {
+  const int producer_num = 4;
+  const int consumer_num = 4;
+  const int item_num = 100000;
+  auto chan = framework::MakeChannel<int>(256, GetParam());
+  chan->SetBlockSize(32);
+
+  std::vector<std::thread> producers;
+  for (int t = 0; t < producer_num; ++t) {
+    producers.emplace_back([&chan, t]() {
+      framework::ChannelWriter<int> writer(chan.get());
+      for (int i = 0; i < item_num; ++i) {
+        writer << (t * item_num + i);
+      }
+      writer.Flush();
+    });
+  }
+  std::vector<int64_t> sums(consumer_num, 0);
+  std::vector<int64_t> counts(consumer_num, 0);
+  std::vector<std::thread> consumers;
+  for (int t = 0; t < consumer_num; ++t) {
+    consumers.emplace_back([&, t]() {
+      std::vector<int> batch;
+      while (chan->ReadOnce(batch, 64) != 0) {
+        for (int v : batch) {
+          sums[t] += v;
+        }
+        counts[t] += batch.size();
+      }
+    });
+  }
+  for (auto& th : producers) {
+    th.join();
+  }
+  chan->Close();
+  for (auto& th : consumers) {
+    th.join();
+  }
+
+  int64_t total = int64_t(producer_num) * item_num;
+  int64_t sum = 0;
+  int64_t count = 0;
+  for (int t = 0; t < consumer_num; ++t) {
+    sum += sums[t];
+    count += counts[t];
+  }
+  ASSERT_EQ(count, total);
+  ASSERT_EQ(sum, total * (total - 1) / 2);
+}
+
+INSTANTIATE_TEST_SUITE_P(Channel,
+                         ChannelModeTest,
+                         ::testing::Values(ChannelMode::kMutex,
+                                           ChannelMode::kLockFreeRing));
+
+TEST(Channel, LockFreeRingProperties) {
+  auto chan = framework::MakeChannel<int>(100, ChannelMode::kLockFreeRing);
+  // the ring is rounded up to a power of two
+  ASSERT_EQ(chan->Capacity(), 128u);
+  ASSERT_EQ(chan->Mode(), ChannelMode::kLockFreeRing);
+  auto other = framework::MakeChannel<int64_t>(chan);
+  ASSERT_EQ(other->Mode(), ChannelMode::kLockFreeRing);
+  ASSERT_EQ(other->Capacity(), 128u);
+  ASSERT_ANY_THROW(chan->SetCapacity(10));
+  ASSERT_ANY_THROW(chan->GetData());
+  // an unbounded channel can not be a ring
+  ASSERT_ANY_THROW(framework::MakeChannel<int>(
+      std::numeric_limits<size_t>::max(), ChannelMode::kLockFreeRing));
+
+  std::vector<int> in(128, 1);
+  ASSERT_EQ(chan->Write(in), 128u);
+  chan->Clear();
+  ASSERT_TRUE(chan->Empty());
+  ASSERT_EQ(chan->Write(in), 128u);
+  chan->Close();
+}
@@ -0,0 +1,175 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/io/read_stream.h"
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+
+#include "paddle/common/flags.h"
+#include "paddle/fluid/framework/io/fs.h"
+
+COMMON_DECLARE_bool(fs_read_in_process);
+
+#if defined _WIN32 || defined __APPLE__
+#else
+#define _LINUX
+#endif
+
+namespace framework = paddle::framework;
+
+static std::string MakeLines(int num) {
+  std::mt19937_64 rng(0);
+  std::string text;
+  for (int i = 0; i < num; ++i) {
+    text += std::to_string(i) + " " + std::to_string(rng()) + "\n";
+  }
+  return text;
+}
+
+static void WriteFile(const std::string& path, const std::string& text) {
+  std::ofstream out(path, std::ios::binary);
+  out.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+// Writes `text` as `members` concatenated gzip members, like `cat a.gz b.gz`.
+static void WriteGzip(const std::string& path,
+                      const std::string& text,
+                      int members) {
+  std::remove(path.c_str());
+  size_t step = text.size() / members + 1;
+  for (size_t begin = 0; begin < text.size(); begin += step) {
+    gzFile gz = gzopen(path.c_str(), "ab");
+    ASSERT_NE(gz, nullptr);
+    size_t len = std::min(step, text.size() - begin);
+    ASSERT_EQ(gzwrite(gz, text.data() + begin, static_cast<unsigned>(len)),
+              static_cast<int>(len));
+    gzclose(gz);
+  }
+}
+
+static std::string ReadAll(framework::ReadStream* stream) {
+  std::string out;
+  char* data = nullptr;
+  size_t size = 0;
+  while (stream->Next(&data, &size)) {
+    out.append(data, size);
+  }
+  return out;
+}
+
+static framework::ReadStreamOptions SmallBuffers() {
+  framework::ReadStreamOptions options;
+  options.buffer_size = 4096;
+  options.buffer_num = 3;
+  return options;
+}
+
+TEST(ReadStream, ReadAheadFile) {
+  std::string text = MakeLines(20000);
+  WriteFile("read_stream_test.txt", text);
+  for (bool direct_io : {false, true}) {
+    auto options = SmallBuffers();
+    options.direct_io = direct_io;
+    auto stream = framework::MakeReadAheadStream(
+        framework::MakeFileReadSource("read_stream_test.txt", options),
+        options);
+    ASSERT_EQ(ReadAll(stream.get()), text);
+    // the end is sticky
+    char* data = nullptr;
+    size_t size = 0;
+    ASSERT_FALSE(stream->Next(&data, &size));
+  }
+  ASSERT_ANY_THROW(framework::MakeFileReadSource("read_stream_test.none",
+                                                 SmallBuffers()));
+}
+
+TEST(ReadStream, GzipMembers) {
+  std::string text = MakeLines(20000);
+  WriteGzip("read_stream_test.gz", text, 3);
+  auto options = SmallBuffers();
+  auto stream = framework::MakeReadAheadStream(
+      framework::MakeGzipReadSource(framework::MakeReadAheadStream(
+          framework::MakeFileReadSource("read_stream_test.gz", options),
+          options)),
+      options);
+  ASSERT_EQ(ReadAll(stream.get()), text);
+
+  // a truncated gzip file is an error of the consumer
+  std::ifstream in("read_stream_test.gz", std::ios::binary);
+  std::string gz((std::istreambuf_iterator<char>(in)),
+                 std::istreambuf_iterator<char>());
+  WriteFile("read_stream_test_cut.gz", gz.substr(0, gz.size() / 2));
+  auto cut = framework::MakeReadAheadStream(
+      framework::MakeGzipReadSource(framework::MakeReadAheadStream(
+          framework::MakeFileReadSource("read_stream_test_cut.gz", options),
+          options)),
+      options);
+  ASSERT_ANY_THROW(ReadAll(cut.get()));
+}
+
+TEST(ReadStream, Destroy) {
+  std::string text = MakeLines(20000);
+  WriteGzip("read_stream_test.gz", text, 1);
+  auto options = SmallBuffers();
+  // stop in the middle, the reader threads have to be joined cleanly
+  auto stream = framework::MakeReadAheadStream(
+      framework::MakeGzipReadSource(framework::MakeReadAheadStream(
+          framework::MakeFileReadSource("read_stream_test.gz", options),
+          options)),
+      options);
+  char* data = nullptr;
+  size_t size = 0;
+  ASSERT_TRUE(stream->Next(&data, &size));
+  stream.reset();
+}
+
+#ifdef _LINUX
+TEST(ReadStream, FsOpenRead) {
+  std::string text = MakeLines(20000);
+  WriteFile("read_stream_test.txt", text);
+  WriteGzip("read_stream_test.gz", text, 2);
+  int err_no = 0;
+  for (bool in_process : {true, false}) {
+    FLAGS_fs_read_in_process = in_process;
+    for (const char* path : {"read_stream_test.txt", "read_stream_test.gz"}) {
+      // in process for an identity converter, through the shell otherwise
+      for (const char* converter : {"", "cat", "tr -d '\\r'"}) {
+        auto stream =
+            framework::fs_open_read_stream(path, &err_no, converter, true);
+        if (in_process && std::string(converter) != "tr -d '\\r'") {
+          ASSERT_NE(stream, nullptr) << path << " " << converter;
+          ASSERT_EQ(ReadAll(stream.get()), text) << path << " " << converter;
+        } else {
+          ASSERT_EQ(stream, nullptr) << path << " " << converter;
+        }
+
+        auto fp = framework::fs_open_read(path, &err_no, converter, true);
+        paddle::string::LineFileReader reader;
+        std::string lines;
+        while (reader.getline(&*fp)) {
+          lines.append(reader.get(), reader.length()).append("\n");
+        }
+        ASSERT_EQ(lines, text) << path << " " << converter;
+      }
+    }
+  }
+  FLAGS_fs_read_in_process = false;
+}
+#endif
@@ -17,7 +17,13 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
 #include "paddle/phi/core/lod_utils.h"
+#include "paddle/phi/core/memory/allocation/mmap_allocator.h"
 
 namespace paddle {
 namespace framework {
@@ -304,5 +310,121 @@ TEST(LoD, ConvertToOffsetBasedLoD) {
   EXPECT_EQ(offset_lod, expected);
 }
 
+TEST(LoD, SerializeToStreamAligned) {
+  phi::CPUPlace cpu;
+  std::vector<phi::DenseTensor> tensors(3);
+  tensors[0].Resize({3});
+  tensors[1].Resize({2, 5});
+  tensors[1].set_lod({{0, 1, 2}});
+  tensors[2].Resize({7, 11});
+  for (int i = 0; i < 3; ++i) {
+    auto* data = tensors[i].mutable_data<float>(cpu);
+    for (int64_t j = 0; j < tensors[i].numel(); ++j) {
+      data[j] = static_cast<float>(i * 1000 + j);
+    }
+  }
+  std::ostringstream os;
+  for (auto& tensor : tensors) {
+    SerializeToStreamAligned(os, tensor, 64);
+  }
+  const std::string file = os.str();
+
+  auto expect_equal = [](const phi::DenseTensor& a, const phi::DenseTensor& b) {
+    EXPECT_EQ(a.dims(), b.dims());
+    EXPECT_EQ(a.lod(), b.lod());
+    EXPECT_EQ(a.dtype(), b.dtype());
+    for (int64_t j = 0; j < a.numel(); ++j) {
+      EXPECT_EQ(a.data<float>()[j], b.data<float>()[j]);
+    }
+  };
+
+  // the layout is still read as a stream
+  std::istringstream is(file);
+  for (auto& tensor : tensors) {
+    phi::DenseTensor loaded;
+    DeserializeFromStream(is, &loaded);
+    expect_equal(tensor, loaded);
+  }
+
+  // the memory is shared when the file is mapped at an aligned address, and
+  // copied when it is not
+  std::unique_ptr<char[]> buffer(new char[file.size() + 128]);
+  uintptr_t aligned_begin =
+      (reinterpret_cast<uintptr_t>(buffer.get()) + 63) / 64 * 64;
+  for (size_t shift : {0, 4}) {
+    char* begin = reinterpret_cast<char*>(aligned_begin + shift);
+    std::memcpy(begin, file.data(), file.size());
+    auto holder = std::make_shared<phi::Allocation>(begin, file.size(), cpu);
+    size_t offset = 0;
+    for (auto& tensor : tensors) {
+      phi::DenseTensor loaded;
+      bool shared = DeserializeFromMemory(holder, &offset, &loaded, 64);
+      EXPECT_EQ(shared, shift == 0);
+      EXPECT_EQ(loaded.data() >= begin && loaded.data() < begin + file.size(),
+                shared);
+      expect_equal(tensor, loaded);
+    }
+    EXPECT_EQ(offset, file.size());
+  }
+}
+
+#ifndef _WIN32
+TEST(LoD, DeserializeFromMappedFile) {
+  phi::CPUPlace cpu;
+  std::vector<phi::DenseTensor> tensors(3);
+  tensors[0].Resize({5});
+  tensors[1].Resize({3, 4});
+  tensors[2].Resize({13, 17});
+  for (int i = 0; i < 3; ++i) {
+    auto* data = tensors[i].mutable_data<float>(cpu);
+    for (int64_t j = 0; j < tensors[i].numel(); ++j) {
+      data[j] = static_cast<float>(i * 1000 + j);
+    }
+  }
+  const size_t alignment = memory::allocation::mmap_alignment;
+  const std::string filename = "lod_tensor_test_mapped_params";
+  {
+    std::ofstream fout(filename, std::ios::binary);
+    for (auto& tensor : tensors) {
+      SerializeToStreamAligned(fout, tensor, alignment);
+    }
+  }
+
+  std::vector<phi::DenseTensor> loaded(tensors.size());
+  {
+    std::shared_ptr<phi::Allocation> mapping =
+        memory::allocation::AllocateMemoryMapFileAllocation(filename);
+    const char* begin = static_cast<const char*>(mapping->ptr());
+    size_t offset = 0;
+    for (auto& tensor : loaded) {
+      // the mapping starts at a page, so every tensor shares it
+      EXPECT_TRUE(
+          DeserializeFromMemory(mapping, &offset, &tensor, alignment));
+      const char* data = static_cast<const char*>(tensor.data());
+      EXPECT_TRUE(data >= begin && data < begin + mapping->size());
+    }
+    EXPECT_EQ(offset, mapping->size());
+  }
+
+  // the tensors keep the mapping alive, and a write to them does not reach
+  // the file
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    EXPECT_EQ(loaded[i].dims(), tensors[i].dims());
+    for (int64_t j = 0; j < tensors[i].numel(); ++j) {
+      EXPECT_EQ(loaded[i].data<float>()[j], tensors[i].data<float>()[j]);
+    }
+    loaded[i].data<float>()[0] = -1.f;
+  }
+  std::ifstream fin(filename, std::ios::binary);
+  for (auto& tensor : tensors) {
+    phi::DenseTensor reloaded;
+    DeserializeFromStream(fin, &reloaded);
+    EXPECT_EQ(reloaded.data<float>()[0], tensor.data<float>()[0]);
+  }
+  fin.close();
+  std::remove(filename.c_str());
+}
+#endif
+
 }  // namespace framework
 }  // namespace paddle
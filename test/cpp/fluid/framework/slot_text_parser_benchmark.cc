@@ -0,0 +1,170 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "paddle/common/flags.h"
+#include "paddle/fluid/framework/slot_text_parser.h"
+
+PD_DEFINE_int32(slot_parser_bench_lines,
+                20000,
+                "line num of the synthetic slot file");
+PD_DEFINE_int32(slot_parser_bench_slots,
+                200,
+                "slot num of every line of the synthetic slot file");
+PD_DEFINE_int32(slot_parser_bench_float_slots,
+                10,
+                "float slot num among the slots of every line");
+PD_DEFINE_double(slot_parser_bench_used_ratio,
+                 0.8,
+                 "ratio of the slots that are parsed, the rest are skipped");
+
+namespace {
+
+using paddle::framework::SlotTextParser;
+
+// A CTR style slot file: hashed uint64 feasigns with 1 ~ 5 values per slot
+// and a few dense float slots.
+std::vector<std::string> MakeSlotLines(std::vector<char>* used,
+                                       std::vector<char>* is_float) {
+  std::mt19937_64 rng(0);
+  int slots = FLAGS_slot_parser_bench_slots;
+  used->resize(slots);
+  is_float->resize(slots);
+  for (int i = 0; i < slots; ++i) {
+    (*used)[i] = (rng() % 1000) < FLAGS_slot_parser_bench_used_ratio * 1000;
+    (*is_float)[i] = i < FLAGS_slot_parser_bench_float_slots;
+  }
+  std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+  std::vector<std::string> lines(FLAGS_slot_parser_bench_lines);
+  char buf[32];
+  for (auto& line : lines) {
+    for (int i = 0; i < slots; ++i) {
+      int num = (*is_float)[i] ? 1 : static_cast<int>(rng() % 5) + 1;
+      line += std::to_string(num);
+      for (int j = 0; j < num; ++j) {
+        line += ' ';
+        if ((*is_float)[i]) {
+          snprintf(buf, sizeof(buf), "%.6f", dist(rng));
+          line += buf;
+        } else {
+          line += std::to_string(rng());
+        }
+      }
+      line += ' ';
+    }
+  }
+  return lines;
+}
+
+// The tokenizer the data feeds used before SlotTextParser.
+uint64_t ParseWithStrto(const std::string& line,
+                        const std::vector<char>& used,
+                        const std::vector<char>& is_float) {
+  const char* str = line.c_str();
+  char* endptr = const_cast<char*>(str);
+  size_t pos = 0;
+  uint64_t checksum = 0;
+  for (size_t i = 0; i < used.size(); ++i) {
+    int num = static_cast<int>(strtol(&str[pos], &endptr, 10));
+    if (used[i]) {
+      for (int j = 0; j < num; ++j) {
+        if (is_float[i]) {
+          checksum += static_cast<uint64_t>(strtof(endptr, &endptr) * 1e6f);
+        } else {
+          checksum += strtoull(endptr, &endptr, 10);
+        }
+      }
+      pos = endptr - str;
+    } else {
+      for (int j = 0; j <= num; ++j) {
+        pos = line.find_first_of(' ', pos + 1);
+      }
+    }
+  }
+  return checksum;
+}
+
+uint64_t ParseWithSlotTextParser(const std::string& line,
+                                 const std::vector<char>& used,
+                                 const std::vector<char>& is_float) {
+  SlotTextParser parser(line.c_str(), line.c_str() + line.size());
+  uint64_t checksum = 0;
+  for (size_t i = 0; i < used.size(); ++i) {
+    int num = static_cast<int>(parser.NextInt());
+    if (used[i]) {
+      for (int j = 0; j < num; ++j) {
+        if (is_float[i]) {
+          checksum += static_cast<uint64_t>(parser.NextFloat() * 1e6f);
+        } else {
+          checksum += parser.NextUint64();
+        }
+      }
+    } else {
+      parser.SkipTokens(num);
+    }
+  }
+  return checksum;
+}
+
+template <typename ParseFn>
+double MeasureGBps(const std::vector<std::string>& lines,
+                   size_t bytes,
+                   uint64_t* checksum,
+                   ParseFn fn) {
+  auto start = std::chrono::steady_clock::now();
+  *checksum = 0;
+  for (auto& line : lines) {
+    *checksum += fn(line);
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return static_cast<double>(bytes) / seconds / 1e9;
+}
+
+}  // namespace
+
+TEST(Benchmark, SlotTextParser) {
+  std::vector<char> used;
+  std::vector<char> is_float;
+  auto lines = MakeSlotLines(&used, &is_float);
+  size_t bytes = 0;
+  for (auto& line : lines) {
+    bytes += line.size() + 1;
+  }
+
+  uint64_t strto_checksum = 0;
+  uint64_t parser_checksum = 0;
+  double strto_rate =
+      MeasureGBps(lines, bytes, &strto_checksum, [&](const std::string& l) {
+        return ParseWithStrto(l, used, is_float);
+      });
+  double parser_rate =
+      MeasureGBps(lines, bytes, &parser_checksum, [&](const std::string& l) {
+        return ParseWithSlotTextParser(l, used, is_float);
+      });
+  ASSERT_EQ(strto_checksum, parser_checksum);
+  std::cout << "slot file " << bytes / (1 << 20) << " MB, " << lines.size()
+            << " lines x " << used.size() << " slots: strtoull/strtof "
+            << strto_rate << " GB/s, SlotTextParser " << parser_rate
+            << " GB/s, speedup " << parser_rate / strto_rate << std::endl;
+}
@@ -0,0 +1,132 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/slot_text_parser.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using paddle::framework::SlotTextParser;
+
+TEST(SlotTextParser, Uint64MatchesStrtoull) {
+  std::vector<std::string> tokens = {"0",
+                                     "7",
+                                     "12345678",
+                                     "123456789012345678",
+                                     "9999999999999999999",
+                                     "18446744073709551615",
+                                     "18446744073709551616",
+                                     "99999999999999999999",
+                                     "000000000000000000000042",
+                                     "+15",
+                                     "-1"};
+  std::mt19937_64 rng(0);
+  for (int i = 0; i < 1000; ++i) {
+    tokens.push_back(std::to_string(rng() >> (rng() % 64)));
+  }
+  std::string line;
+  for (auto& token : tokens) {
+    line += token + " ";
+  }
+  SlotTextParser parser(line.c_str(), line.c_str() + line.size());
+  char* endptr = const_cast<char*>(line.c_str());
+  for (auto& token : tokens) {
+    uint64_t expected = strtoull(endptr, &endptr, 10);
+    ASSERT_EQ(parser.NextUint64(), expected) << token;
+    ASSERT_EQ(parser.pos(), endptr) << token;
+  }
+  ASSERT_TRUE(parser.Done());
+}
+
+TEST(SlotTextParser, FloatMatchesStrtof) {
+  std::vector<std::string> tokens = {"0",
+                                     "-0",
+                                     "1",
+                                     "0.5",
+                                     "-3.25",
+                                     ".125",
+                                     "5.",
+                                     "0.1",
+                                     "0.3333333",
+                                     "16777216",
+                                     "16777217",
+                                     "0.123456789",
+                                     "1.00000000001",
+                                     "1e-5",
+                                     "2.5E3",
+                                     "inf",
+                                     "-nan",
+                                     "3.4028235e38"};
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-100.0f, 100.0f);
+  for (int i = 0; i < 1000; ++i) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", i % 9, dist(rng));
+    tokens.push_back(buf);
+  }
+  std::string line;
+  for (auto& token : tokens) {
+    line += token + " ";
+  }
+  SlotTextParser parser(line.c_str(), line.c_str() + line.size());
+  char* endptr = const_cast<char*>(line.c_str());
+  for (auto& token : tokens) {
+    float expected = strtof(endptr, &endptr);
+    float value = parser.NextFloat();
+    // compare the bits, so the sign of zero and NaN are checked as well
+    ASSERT_EQ(memcmp(&value, &expected, sizeof(float)), 0) << token;
+    ASSERT_EQ(parser.pos(), endptr) << token;
+  }
+}
+
+TEST(SlotTextParser, SkipTokensAndCounts) {
+  // long enough for several SIMD blocks, with runs of spaces across them
+  std::string line = "2 ins_id_0001 1 ";
+  std::vector<int> counts;
+  for (int slot = 0; slot < 64; ++slot) {
+    int num = slot % 7 + 1;
+    counts.push_back(num);
+    line += std::to_string(num);
+    for (int j = 0; j < num; ++j) {
+      line += (slot % 5 == 0) ? "   " : " ";
+      line += std::to_string(slot * 1000 + j);
+    }
+    line += " ";
+  }
+  SlotTextParser parser(line.c_str(), line.c_str() + line.size());
+  ASSERT_EQ(parser.NextInt(), 2);
+  size_t len = 0;
+  const char* token = parser.NextToken(&len);
+  ASSERT_EQ(std::string(token, len), "ins_id_0001");
+  ASSERT_EQ(parser.NextInt(), 1);
+  for (int slot = 0; slot < 64; ++slot) {
+    ASSERT_EQ(parser.NextInt(), counts[slot]);
+    if (slot % 2 == 0) {
+      parser.SkipTokens(counts[slot]);
+    } else {
+      for (int j = 0; j < counts[slot]; ++j) {
+        ASSERT_EQ(parser.NextUint64(), uint64_t(slot * 1000 + j));
+      }
+    }
+  }
+  ASSERT_TRUE(parser.Done());
+  // skipping past the end stops at the end
+  SlotTextParser short_parser(line.c_str(), line.c_str() + line.size());
+  short_parser.SkipTokens(1 << 20);
+  ASSERT_TRUE(short_parser.Done());
+}
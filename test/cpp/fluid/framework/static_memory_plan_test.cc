@@ -0,0 +1,105 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/static_memory_plan.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+MemoryBlock MakeBlock(size_t size, int first, int last) {
+  MemoryBlock block;
+  block.name = "t" + std::to_string(first) + "_" + std::to_string(last);
+  block.size = size;
+  block.lifetime = {first, last};
+  return block;
+}
+
+void ExpectValidPlan(const std::vector<MemoryBlock>& blocks,
+                     size_t arena_size,
+                     size_t alignment) {
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    EXPECT_EQ(blocks[i].offset % alignment, 0UL);
+    EXPECT_LE(blocks[i].offset + blocks[i].size, arena_size);
+    for (size_t j = i + 1; j < blocks.size(); ++j) {
+      const auto& a = blocks[i];
+      const auto& b = blocks[j];
+      bool live_together = b.lifetime.second >= a.lifetime.first &&
+                           a.lifetime.second >= b.lifetime.first;
+      bool share_memory = b.offset < a.offset + a.size &&
+                          a.offset < b.offset + b.size;
+      EXPECT_FALSE(live_together && share_memory)
+          << a.name << " and " << b.name << " overlap";
+    }
+  }
+}
+
+TEST(StaticMemoryPlan, Chain) {
+  // Each tensor of a chain of operators lives with its neighbors only, so
+  // the arena holds the two largest neighbors.
+  std::vector<MemoryBlock> blocks = {MakeBlock(1024, 0, 1),
+                                     MakeBlock(4096, 1, 2),
+                                     MakeBlock(2048, 2, 3),
+                                     MakeBlock(4096, 3, 4),
+                                     MakeBlock(1024, 4, 5)};
+  size_t arena_size = AssignMemoryOffsets(&blocks, 64);
+  ExpectValidPlan(blocks, arena_size, 64);
+  EXPECT_EQ(arena_size, 4096UL + 2048UL);
+}
+
+TEST(StaticMemoryPlan, BestFit) {
+  // The small tensor goes into the smallest gap which fits it.
+  std::vector<MemoryBlock> blocks = {MakeBlock(4096, 0, 3),
+                                     MakeBlock(2048, 0, 0),
+                                     MakeBlock(1024, 0, 3),
+                                     MakeBlock(1024, 2, 3)};
+  size_t arena_size = AssignMemoryOffsets(&blocks, 64);
+  ExpectValidPlan(blocks, arena_size, 64);
+  EXPECT_EQ(arena_size, 4096UL + 2048UL + 1024UL);
+  EXPECT_EQ(blocks[3].offset, 4096UL);
+}
+
+TEST(StaticMemoryPlan, Alignment) {
+  std::vector<MemoryBlock> blocks = {
+      MakeBlock(3, 0, 2), MakeBlock(100, 1, 2), MakeBlock(7, 2, 2)};
+  size_t arena_size = AssignMemoryOffsets(&blocks, 64);
+  ExpectValidPlan(blocks, arena_size, 64);
+  EXPECT_EQ(arena_size, 128UL + 64UL + 64UL);
+}
+
+TEST(StaticMemoryPlan, Random) {
+  std::mt19937 engine(0);
+  std::uniform_int_distribution<int> op_dist(0, 200);
+  std::uniform_int_distribution<size_t> size_dist(1, 1 << 20);
+  std::vector<MemoryBlock> blocks;
+  size_t total_size = 0;
+  for (int i = 0; i < 500; ++i) {
+    int first = op_dist(engine);
+    int last = std::min(first + op_dist(engine) / 20, 200);
+    blocks.push_back(MakeBlock(size_dist(engine), first, last));
+    total_size += blocks.back().size;
+  }
+  size_t arena_size = AssignMemoryOffsets(&blocks, 256);
+  ExpectValidPlan(blocks, arena_size, 256);
+  EXPECT_LT(arena_size, total_size);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -14,10 +14,18 @@ limitations under the License. */
 
 #include "paddle/phi/kernels/funcs/selected_rows_functor.h"
 
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
 #include "gtest/gtest.h"
+#include "paddle/common/flags.h"
 #include "paddle/phi/core/memory/allocation/allocator_facade.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
 
+COMMON_DECLARE_int64(selected_rows_radix_merge_threshold);
+
 TEST(selected_rows_functor, cpu_add) {
   phi::CPUPlace cpu_place;
   phi::CPUContext ctx(cpu_place);
@@ -516,3 +524,132 @@ TEST(selected_rows_functor, cpu_sum_to) {
   // row9: 2.0 + 3.0
   EXPECT_EQ(tensor1_data[9 * row_numel + 6], 5.0);
 }
+
+// Draws rows from a Zipf distribution over [0, height), as the ids of an
+// embedding gradient.
+std::unique_ptr<phi::SelectedRows> MakeZipfSelectedRows(
+    const phi::CPUContext& ctx,
+    int64_t num_rows,
+    int64_t height,
+    int64_t row_numel,
+    double exponent,
+    unsigned seed) {
+  std::vector<double> weights(height);
+  for (int64_t i = 0; i < height; ++i) {
+    weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), exponent);
+  }
+  std::mt19937 engine(seed);
+  std::discrete_distribution<int64_t> zipf(weights.begin(), weights.end());
+  std::vector<int64_t> rows(num_rows);
+  for (auto& row : rows) {
+    // spreads the hot rows over the table
+    row = zipf(engine) * 7919 % height;
+  }
+  std::unique_ptr<phi::SelectedRows> selected_rows{
+      new phi::SelectedRows(rows, height)};
+  auto* value = selected_rows->mutable_value();
+  auto* data = value->mutable_data<float>(
+      common::make_ddim({num_rows, row_numel}), ctx.GetPlace());
+  std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+  for (int64_t i = 0; i < num_rows * row_numel; ++i) {
+    data[i] = uniform(engine);
+  }
+  return selected_rows;
+}
+
+void ExpectSameSelectedRows(const phi::SelectedRows& x,
+                            const phi::SelectedRows& y) {
+  EXPECT_EQ(x.height(), y.height());
+  EXPECT_EQ(x.rows(), y.rows());
+  ASSERT_EQ(x.value().dims(), y.value().dims());
+  auto* x_data = x.value().data<float>();
+  auto* y_data = y.value().data<float>();
+  for (int64_t i = 0; i < x.value().numel(); ++i) {
+    ASSERT_EQ(x_data[i], y_data[i]) << " at index : " << i;
+  }
+}
+
+TEST(selected_rows_functor, cpu_merge_add_radix) {
+  phi::CPUPlace cpu_place;
+  phi::CPUContext ctx(cpu_place);
+  ctx.SetAllocator(paddle::memory::allocation::AllocatorFacade::Instance()
+                       .GetAllocator(cpu_place)
+                       .get());
+  const int64_t height = 100000;
+  const int64_t row_numel = 13;
+  auto last_threshold = FLAGS_selected_rows_radix_merge_threshold;
+
+  auto selected_rows1 =
+      MakeZipfSelectedRows(ctx, 20000, height, row_numel, 1.1, 1);
+  auto selected_rows2 =
+      MakeZipfSelectedRows(ctx, 30000, height, row_numel, 1.1, 2);
+  // no duplicated rows
+  std::vector<int64_t> rows3{99999, 7, 42, 3};
+  std::unique_ptr<phi::SelectedRows> selected_rows3{
+      new phi::SelectedRows(rows3, height)};
+  auto* in3_value = selected_rows3->mutable_value();
+  in3_value->mutable_data<float>(
+      common::make_ddim({static_cast<int64_t>(rows3.size()), row_numel}),
+      cpu_place);
+  phi::funcs::SetConstant<phi::CPUContext, float> set_const;
+  set_const(ctx, in3_value, 1.0);
+
+  std::vector<std::vector<const phi::SelectedRows*>> cases{
+      {selected_rows1.get(), selected_rows2.get()},
+      {selected_rows1.get()},
+      {selected_rows3.get()}};
+  for (const auto& inputs : cases) {
+    for (bool sorted_result : {false, true}) {
+      phi::funcs::scatter::MergeAdd<phi::CPUContext, float> merge_add_functor;
+      phi::SelectedRows hash_output, radix_output;
+      FLAGS_selected_rows_radix_merge_threshold = -1;
+      merge_add_functor(ctx, inputs, &hash_output, sorted_result);
+      FLAGS_selected_rows_radix_merge_threshold = 0;
+      merge_add_functor(ctx, inputs, &radix_output, sorted_result);
+      ExpectSameSelectedRows(hash_output, radix_output);
+    }
+
+    phi::funcs::scatter::MergeAverage<phi::CPUContext, float>
+        merge_average_functor;
+    phi::SelectedRows hash_output, radix_output;
+    FLAGS_selected_rows_radix_merge_threshold = -1;
+    merge_average_functor(ctx, inputs, &hash_output);
+    FLAGS_selected_rows_radix_merge_threshold = 0;
+    merge_average_functor(ctx, inputs, &radix_output);
+    ExpectSameSelectedRows(hash_output, radix_output);
+  }
+  FLAGS_selected_rows_radix_merge_threshold = last_threshold;
+}
+
+TEST(Benchmark, MergeAddZipf) {
+  phi::CPUPlace cpu_place;
+  phi::CPUContext ctx(cpu_place);
+  ctx.SetAllocator(paddle::memory::allocation::AllocatorFacade::Instance()
+                       .GetAllocator(cpu_place)
+                       .get());
+  const int64_t height = 1000000;
+  const int64_t num_rows = 2000000;
+  const int64_t row_numel = 64;
+  auto last_threshold = FLAGS_selected_rows_radix_merge_threshold;
+  for (double exponent : {0.8, 1.1}) {
+    auto input = MakeZipfSelectedRows(
+        ctx, num_rows, height, row_numel, exponent, 1);
+    double seconds[2];
+    for (int radix = 0; radix < 2; ++radix) {
+      FLAGS_selected_rows_radix_merge_threshold = radix ? 0 : -1;
+      phi::funcs::scatter::MergeAdd<phi::CPUContext, float> merge_add_functor;
+      phi::SelectedRows output;
+      auto start = std::chrono::steady_clock::now();
+      merge_add_functor(ctx, *input, &output, false);
+      seconds[radix] = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+    }
+    std::cout << num_rows << " rows of width " << row_numel
+              << ", zipf exponent " << exponent
+              << ", hash map: " << seconds[0] << " s, radix: " << seconds[1]
+              << " s, speedup: " << seconds[0] / seconds[1] << "x"
+              << std::endl;
+  }
+  FLAGS_selected_rows_radix_merge_threshold = last_threshold;
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/core/memory/allocation/size_class_cpu_allocator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/phi/core/memory/stats.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+TEST(SizeClassCPUAllocatorTest, SizeClasses) {
+  size_t prev_size = 0;
+  for (size_t cls = 0; cls < SizeClassCPUAllocator::NumClasses(); ++cls) {
+    size_t class_size = SizeClassCPUAllocator::ClassToSize(cls);
+    EXPECT_GT(class_size, prev_size);
+    EXPECT_EQ(class_size % SizeClassCPUAllocator::kAlignment, 0UL);
+    EXPECT_EQ(SizeClassCPUAllocator::SizeToClass(class_size), cls);
+    EXPECT_EQ(SizeClassCPUAllocator::SizeToClass(prev_size + 1), cls);
+    if (class_size >= 256) {
+      // at most 25% of a block is wasted
+      EXPECT_LE((class_size - prev_size - 1) * 4, class_size);
+    }
+    prev_size = class_size;
+  }
+  EXPECT_EQ(prev_size, SizeClassCPUAllocator::kMaxClassSize);
+  EXPECT_EQ(SizeClassCPUAllocator::SizeToClass(0), 0UL);
+}
+
+TEST(SizeClassCPUAllocatorTest, ReuseAndAlignment) {
+  SizeClassCPUAllocator allocator(1 << 20, 0);
+  for (size_t size : {1UL, 100UL, 3000UL, 5000UL, 1UL << 20, 3UL << 20}) {
+    void* ptr = nullptr;
+    {
+      auto allocation = allocator.Allocate(size);
+      ptr = allocation->ptr();
+      EXPECT_EQ(allocation->size(), size);
+      size_t alignment =
+          size >= 4096 ? 4096 : SizeClassCPUAllocator::kAlignment;
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % alignment, 0UL);
+      memset(ptr, 1, size);
+    }
+    auto allocation = allocator.Allocate(size);
+    if (size <= SizeClassCPUAllocator::kMaxClassSize) {
+      // served from the cache of this thread
+      EXPECT_EQ(allocation->ptr(), ptr);
+    }
+  }
+}
+
+TEST(SizeClassCPUAllocatorTest, ReleaseToSystem) {
+  int64_t reserved = HOST_MEMORY_STAT_CURRENT_VALUE(Reserved, 0);
+  {
+    SizeClassCPUAllocator allocator(64 << 10, 0);
+    std::vector<phi::Allocator::AllocationPtr> allocations;
+    for (int i = 0; i < 1000; ++i) {
+      allocations.emplace_back(allocator.Allocate(1024));
+    }
+    EXPECT_EQ(HOST_MEMORY_STAT_CURRENT_VALUE(Reserved, 0) - reserved,
+              1000 * 1024);
+    allocations.clear();
+    // the thread cache keeps at most 64KB
+    EXPECT_GE(allocator.CentralCachedBytes(), 1000UL * 1024 - (64UL << 10));
+    EXPECT_EQ(allocator.Release(phi::CPUPlace()), 1000UL * 1024);
+    EXPECT_EQ(allocator.CentralCachedBytes(), 0UL);
+    EXPECT_EQ(HOST_MEMORY_STAT_CURRENT_VALUE(Reserved, 0), reserved);
+
+    allocations.emplace_back(allocator.Allocate(100));
+  }
+  EXPECT_EQ(HOST_MEMORY_STAT_CURRENT_VALUE(Reserved, 0), reserved);
+}
+
+TEST(SizeClassCPUAllocatorTest, MultiThread) {
+  int64_t reserved = HOST_MEMORY_STAT_CURRENT_VALUE(Reserved, 0);
+  {
+    SizeClassCPUAllocator allocator(256 << 10, 1);
+    const int kThreadNum = 4;
+    // every thread frees the blocks the previous one allocated
+    std::vector<std::vector<phi::Allocator::AllocationPtr>> handoff(
+        kThreadNum);
+    for (int round = 0; round < 4; ++round) {
+      std::vector<std::thread> threads;
+      for (int t = 0; t < kThreadNum; ++t) {
+        threads.emplace_back([&, t, round] {
+          std::mt19937 rng(round * kThreadNum + t);
+          std::uniform_int_distribution<size_t> dist(1, 64 << 10);
+          std::vector<phi::Allocator::AllocationPtr> mine;
+          for (int i = 0; i < 2000; ++i) {
+            size_t size = dist(rng);
+            auto allocation = allocator.Allocate(size);
+            memset(allocation->ptr(), t, size);
+            if (i % 2 == 0) {
+              mine.emplace_back(std::move(allocation));
+            }
+          }
+          for (auto& allocation : mine) {
+            auto* data = static_cast<unsigned char*>(allocation->ptr());
+            EXPECT_EQ(data[0], t);
+            EXPECT_EQ(data[allocation->size() - 1], t);
+          }
+          handoff[t].clear();
+          handoff[t] = std::move(mine);
+        });
+      }
+      for (auto& thread : threads) {
+        thread.join();
+      }
+      std::rotate(handoff.begin(), handoff.begin() + 1, handoff.end());
+    }
+    handoff.clear();
+  }
+  // caches of the exited threads went back to the central lists, which are
+  // freed with the allocator
+  EXPECT_EQ(HOST_MEMORY_STAT_CURRENT_VALUE(Reserved, 0), reserved);
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -93,4 +93,95 @@ TEST(PredictorPool, basic) {
   }
 }
 
+TEST(SharedPredictorPool, multi_thread) {
+  std::string model_dir = FLAGS_infer_model + "/model";
+  Config config;
+  config.SetModel(model_dir + "/model", model_dir + "/params");
+  config.EnableUseGpu(100, 0);
+
+  const size_t max_contexts = 2;
+  services::SharedPredictorPool pool(config, max_contexts, 4);
+  std::vector<int> in_shape = {1, 3, 318, 318};
+  int in_num =
+      std::accumulate(in_shape.begin(), in_shape.end(), 1, [](int &a, int &b) {
+        return a * b;
+      });
+  std::vector<float> input(in_num, 0);
+
+  auto run = [&](std::vector<float> *out_data) {
+    auto pred = pool.Acquire();
+    auto input_t = pred->GetInputHandle(pred->GetInputNames()[0]);
+    input_t->Reshape(in_shape);
+    input_t->CopyFromCpu(input.data());
+    ASSERT_TRUE(pred->Run());
+    auto output_t = pred->GetOutputHandle(pred->GetOutputNames()[0]);
+    std::vector<int> output_shape = output_t->shape();
+    out_data->resize(std::accumulate(
+        output_shape.begin(), output_shape.end(), 1, std::multiplies<int>()));
+    output_t->CopyToCpu(out_data->data());
+  };
+
+  std::vector<float> expected;
+  run(&expected);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 5; ++j) {
+        std::vector<float> out_data;
+        run(&out_data);
+        ASSERT_EQ(out_data.size(), expected.size());
+        for (size_t k = 0; k < expected.size(); ++k) {
+          EXPECT_NEAR(out_data[k], expected[k], 1e-5);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_LE(pool.NumContexts(), max_contexts);
+
+  auto first = pool.TryAcquire();
+  auto second = pool.TryAcquire();
+  ASSERT_TRUE(first && second);
+  EXPECT_NE(first.get(), second.get());
+  EXPECT_FALSE(pool.TryAcquire());
+}
+
+TEST(SharedPredictorPool, trim) {
+  std::string model_dir = FLAGS_infer_model + "/model";
+  Config config;
+  config.SetModel(model_dir + "/model", model_dir + "/params");
+  config.EnableUseGpu(100, 0);
+
+  // checks the idle contexts on every release
+  services::SharedPredictorPool pool(config, 3, 1);
+  {
+    auto first = pool.Acquire();
+    auto second = pool.Acquire();
+    EXPECT_EQ(pool.NumContexts(), 2UL);
+  }
+  // the peak of two requests keeps both warm until the second release, which
+  // sees only one busy context since the first check
+  EXPECT_EQ(pool.NumWarmContexts(), 1UL);
+
+  // one request at a time reuses the warm context
+  for (int i = 0; i < 3; ++i) {
+    auto pred = pool.Acquire();
+    EXPECT_EQ(pool.NumWarmContexts(), 0UL);
+  }
+  EXPECT_EQ(pool.NumWarmContexts(), 1UL);
+  EXPECT_EQ(pool.NumContexts(), 2UL);
+
+  // the cold context is handed out once both are busy again
+  {
+    auto first = pool.Acquire();
+    auto second = pool.Acquire();
+    EXPECT_NE(first.get(), second.get());
+    EXPECT_EQ(pool.NumContexts(), 2UL);
+  }
+  EXPECT_EQ(pool.NumWarmContexts(), 1UL);
+}
+
 }  // namespace paddle_infer
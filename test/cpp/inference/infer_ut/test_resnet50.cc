@@ -204,6 +204,48 @@ TEST(tensorrt_tester_resnet50, trt_int8_bz2) {
   std::cout << "finish test" << std::endl;
 }
 
+TEST(cpu_tester_resnet50, static_memory_plan_diff_batch) {
+  int repeat_time = 100;
+  // prepare the reuse plan and the static memory plan of memory optimize
+  paddle_infer::Config config, config_plan;
+  config.SetModel(FLAGS_modeldir + "/inference.pdmodel",
+                  FLAGS_modeldir + "/inference.pdiparams");
+  config.DisableGpu();
+  config.EnableMemoryOptim();
+  config_plan.SetModel(FLAGS_modeldir + "/inference.pdmodel",
+                       FLAGS_modeldir + "/inference.pdiparams");
+  config_plan.DisableGpu();
+  config_plan.EnableStaticMemoryPlan();
+  paddle_infer::services::PredictorPool pred_pool(config, 1);
+  paddle_infer::services::PredictorPool pred_pool_plan(config_plan, 1);
+
+  // the batch size changes between runs to switch the arena
+  for (int batch_size : {1, 2, 1}) {
+    std::map<std::string, paddle::test::Record> my_input_data_map;
+    my_input_data_map["inputs"] = PrepareInput(batch_size);
+    std::map<std::string, paddle::test::Record> infer_output_data,
+        truth_output_data;
+    SingleThreadPrediction(
+        pred_pool.Retrieve(0), &my_input_data_map, &truth_output_data, 1);
+    SingleThreadPrediction(
+        pred_pool_plan.Retrieve(0), &my_input_data_map, &infer_output_data);
+    CompareRecord(&truth_output_data, &infer_output_data);
+  }
+
+  for (int batch_size : {1, 4}) {
+    std::map<std::string, paddle::test::Record> my_input_data_map;
+    my_input_data_map["inputs"] = PrepareInput(batch_size);
+    double reuse_time = paddle::test::SingleThreadProfile(
+        pred_pool.Retrieve(0), &my_input_data_map, repeat_time);
+    double plan_time = paddle::test::SingleThreadProfile(
+        pred_pool_plan.Retrieve(0), &my_input_data_map, repeat_time);
+    std::cout << "batch size " << batch_size << ", " << repeat_time
+              << " runs: reuse plan " << reuse_time
+              << " ms, static memory plan " << plan_time << " ms" << std::endl;
+  }
+  std::cout << "finish static memory plan test" << std::endl;
+}
+
 TEST(DISABLED_tensorrt_tester_resnet50, profile_multi_thread_trt_fp32) {
   int batch_size = 2;
   int thread_num = 4;
@@ -0,0 +1,119 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "paddle/common/flags.h"
+#include "paddle/fluid/framework/new_executor/standalone_executor.h"
+#include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
+#include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
+#include "paddle/fluid/pir/transforms/pd_op_to_kernel_pass.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/pir/include/core/builder.h"
+#include "paddle/pir/include/core/ir_context.h"
+#include "paddle/pir/include/core/program.h"
+
+PD_DECLARE_KERNEL(full, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(matmul, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(relu, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(add, CPU, ALL_LAYOUT);
+
+COMMON_DECLARE_bool(new_executor_critical_path_scheduling);
+
+PD_DEFINE_int32(towers, 8, "independent matmul towers in the program");
+PD_DEFINE_int32(layers, 4, "matmul+relu layers of the shortest tower");
+PD_DEFINE_int32(hidden, 256, "size of the square matrices");
+PD_DEFINE_int32(steps, 50, "measured steps per scheduling mode");
+
+namespace paddle {
+namespace framework {
+
+// Tower t has (t + 1) * layers layers, so the towers started first decide
+// the step latency unless the longest ones are dispatched first.
+static void BuildTowerProgram(pir::Program* program,
+                              const std::string& out_name) {
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  pir::Builder builder = pir::Builder(ctx, program->block());
+
+  std::vector<int64_t> shape{FLAGS_hidden, FLAGS_hidden};
+  float scale = 1.0f / static_cast<float>(FLAGS_hidden);
+  pir::Value sum;
+  for (int t = 0; t < FLAGS_towers; ++t) {
+    pir::Value x = builder
+                       .Build<paddle::dialect::FullOp>(
+                           shape, 1.0, phi::DataType::FLOAT32, phi::CPUPlace())
+                       .out();
+    pir::Value w =
+        builder
+            .Build<paddle::dialect::FullOp>(
+                shape, scale, phi::DataType::FLOAT32, phi::CPUPlace())
+            .out();
+    for (int l = 0; l < (t + 1) * FLAGS_layers; ++l) {
+      x = builder.Build<paddle::dialect::MatmulOp>(x, w).out();
+      x = builder.Build<paddle::dialect::ReluOp>(x).out();
+    }
+    sum = t == 0 ? x : builder.Build<paddle::dialect::AddOp>(sum, x).out();
+  }
+  builder.Build<pir::ShadowOutputOp>(sum, out_name);
+}
+
+static double RunSteps(bool critical_path_scheduling) {
+  FLAGS_new_executor_critical_path_scheduling = critical_path_scheduling;
+  std::string out_name = "tower_sum";
+  pir::Program program(pir::IrContext::Instance());
+  BuildTowerProgram(&program, out_name);
+  auto kernel_program = paddle::dialect::PdOpLowerToKernelPass(&program);
+
+  Scope scope;
+  InterpreterCore core(phi::CPUPlace(), {}, kernel_program->block(), &scope);
+  core.SetSkipGcVars({out_name});
+  // the first run builds the instructions and the dependencies
+  core.Run({});
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_steps; ++i) {
+    core.Run({});
+  }
+  std::chrono::duration<double, std::milli> cost =
+      std::chrono::steady_clock::now() - start;
+
+  Scope* out_scope =
+      core.local_scope() == nullptr ? &scope : core.local_scope();
+  const auto& out = out_scope->FindVar(out_name)->Get<phi::DenseTensor>();
+  EXPECT_EQ(out.numel(), static_cast<int64_t>(FLAGS_hidden) * FLAGS_hidden);
+  // every layer keeps the all-one matrix all-one
+  EXPECT_NEAR(out.data<float>()[0], FLAGS_towers, 1e-3);
+  return cost.count() / FLAGS_steps;
+}
+
+TEST(Benchmark, PirInterpreterCriticalPathScheduling) {
+  double fifo_ms = RunSteps(false);
+  double critical_path_ms = RunSteps(true);
+  FLAGS_new_executor_critical_path_scheduling = false;
+  std::cout << "towers: " << FLAGS_towers << ", layers: " << FLAGS_layers
+            << ", hidden: " << FLAGS_hidden << std::endl;
+  std::cout << "default scheduling: " << fifo_ms << " ms/step" << std::endl;
+  std::cout << "critical path scheduling: " << critical_path_ms
+            << " ms/step" << std::endl;
+}
+
+}  // namespace framework
+}  // namespace paddle
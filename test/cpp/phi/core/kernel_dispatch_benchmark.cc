@@ -0,0 +1,66 @@
+/* Copyright (c) 2026 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <chrono>
+#include <iostream>
+
+#include "gtest/gtest.h"
+#include "paddle/phi/core/kernel_factory.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+PD_DECLARE_KERNEL(scale, CPU, ALL_LAYOUT);
+
+namespace phi {
+namespace tests {
+
+TEST(Benchmark, KernelDispatch) {
+  auto& factory = phi::KernelFactory::Instance();
+  phi::KernelKey key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT32);
+  const int num_calls = 1000000;
+  size_t checksum = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_calls; ++i) {
+    checksum += factory.SelectKernelOrThrowError("scale", key, true)
+                    .kernel.args_def()
+                    .input_defs()
+                    .size();
+  }
+  double factory_ns = std::chrono::duration<double, std::nano>(
+                          std::chrono::steady_clock::now() - start)
+                          .count() /
+                      num_calls;
+
+  static thread_local phi::KernelDispatchCache cache("scale");
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_calls; ++i) {
+    checksum += cache.SelectKernelOrThrowError(key, true)
+                    .kernel.args_def()
+                    .input_defs()
+                    .size();
+  }
+  double cache_ns = std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - start)
+                        .count() /
+                    num_calls;
+  EXPECT_GT(checksum, 0UL);
+  std::cout << "kernel selection of scale, KernelFactory: " << factory_ns
+            << " ns/call, KernelDispatchCache: " << cache_ns
+            << " ns/call, speedup: " << factory_ns / cache_ns << "x"
+            << std::endl;
+}
+
+}  // namespace tests
+}  // namespace phi
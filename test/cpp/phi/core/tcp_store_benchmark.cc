@@ -0,0 +1,119 @@
+// Copyright (c) 2026 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "paddle/phi/core/distributed/store/tcp_store.h"
+#include "paddle/phi/core/distributed/store/tcp_utils.h"
+
+namespace phi {
+namespace distributed {
+
+// A port which is free now, so that runs do not collide on a fixed one.
+uint16_t GetFreePort() {
+  int socket = tcputils::tcp_listen("", std::to_string(0), AF_INET);
+  ::sockaddr_in addr{};
+  ::socklen_t addr_len = sizeof(addr);
+  ::getsockname(socket, reinterpret_cast<::sockaddr*>(&addr), &addr_len);
+  tcputils::close_socket(socket);
+  return ntohs(addr.sin_port);
+}
+
+std::vector<uint8_t> ToBytes(const std::string& s) {
+  return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+// Every client adds itself to a counter, the last one sets a key the others
+// wait for, and then all read the key and the counter. Returns the seconds
+// from the start of the clients to the end of the last one.
+double RunRendezvous(uint16_t port, int num_clients) {
+  std::mutex mutex;
+  std::condition_variable cv;
+  int connected = 0;
+  bool started = false;
+  std::vector<std::thread> clients;
+  for (int i = 0; i < num_clients; ++i) {
+    clients.emplace_back([&] {
+      TCPStore store("127.0.0.1", port, false, 1);
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        ++connected;
+        cv.notify_all();
+        cv.wait(lock, [&] { return started; });
+      }
+      if (store.add("arrived", 1) == num_clients) {
+        store.set("done", ToBytes("1"));
+      }
+      store.wait("done");
+      auto values = store.multi_get({"done", "arrived"});
+      EXPECT_EQ(values[1], ToBytes(std::to_string(num_clients)));
+    });
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return connected == num_clients; });
+    started = true;
+  }
+  auto start = std::chrono::steady_clock::now();
+  cv.notify_all();
+  for (auto& client : clients) {
+    client.join();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// Takes up to 4096 descriptors and threads.
+TEST(Benchmark, TCPStoreRendezvous) {
+  // a client and its connection on the server take a descriptor each
+  ::rlimit limit{};
+  ::getrlimit(RLIMIT_NOFILE, &limit);
+  limit.rlim_cur = limit.rlim_max;
+  ::setrlimit(RLIMIT_NOFILE, &limit);
+  ::getrlimit(RLIMIT_NOFILE, &limit);
+  int num_clients = static_cast<int>(
+      std::min<rlim_t>(2048, (limit.rlim_cur - 64) / 2));
+
+  std::vector<std::pair<std::string, std::function<std::shared_ptr<void>(int)>>>
+      servers;
+  servers.emplace_back("poll", [](int socket) -> std::shared_ptr<void> {
+    return detail::MasterDaemon::start(socket, 1, 100);
+  });
+#ifdef __linux__
+  servers.emplace_back("epoll", [](int socket) -> std::shared_ptr<void> {
+    return std::make_shared<detail::ReactorMasterDaemon>(socket, 4);
+  });
+#endif
+  for (auto& server : servers) {
+    uint16_t port = GetFreePort();
+    int socket = tcputils::tcp_listen("", std::to_string(port), AF_INET);
+    auto daemon = server.second(socket);
+    double seconds = RunRendezvous(port, num_clients);
+    std::cout << num_clients << " clients, " << server.first
+              << " server: " << seconds << " s" << std::endl;
+  }
+}
+
+}  // namespace distributed
+}  // namespace phi
@@ -48,6 +48,71 @@ TEST(KernelFactory, SelectedKernelMap) {
   }
 }
 
+void FakeKernelFn(KernelContext* ctx) {}
+
+TEST(KernelDispatchCache, SameKernelAsFactory) {
+  auto& factory = phi::KernelFactory::Instance();
+  phi::KernelDispatchCache cache("scale");
+  for (int i = 0; i < 3; ++i) {
+    for (auto dtype : {phi::DataType::FLOAT32,
+                       phi::DataType::FLOAT64,
+                       phi::DataType::INT32,
+                       phi::DataType::INT64,
+                       phi::DataType::FLOAT16,
+                       phi::DataType::BFLOAT16}) {
+      phi::KernelKey key(phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, dtype);
+      auto expected = factory.SelectKernelOrThrowError("scale", key, true);
+      auto result = cache.SelectKernelOrThrowError(key, true);
+      EXPECT_EQ(&result.kernel, &expected.kernel);
+      EXPECT_EQ(result.has_fallback_cpu, expected.has_fallback_cpu);
+      EXPECT_EQ(result.is_stride_kernel, expected.is_stride_kernel);
+    }
+  }
+  phi::KernelKey missing_key(phi::Backend::CPU,
+                             phi::DataLayout::ALL_LAYOUT,
+                             phi::DataType::PSTRING);
+  EXPECT_ANY_THROW(cache.SelectKernelOrThrowError(missing_key));
+}
+
+TEST(KernelDispatchCache, InvalidatedByRegistration) {
+  auto& factory = phi::KernelFactory::Instance();
+  static int first_fn, second_fn;
+  phi::KernelKey key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT32);
+  factory.AddKernel(
+      "dispatch_cache_test", key, phi::Kernel(FakeKernelFn, &first_fn));
+  phi::KernelDispatchCache cache("dispatch_cache_test");
+  EXPECT_EQ(
+      cache.SelectKernelOrThrowError(key).kernel.GetVariadicKernelFn<int*>(),
+      &first_fn);
+
+  // replaces the kernel and rehashes the kernels of the name
+  const uint64_t version = factory.version();
+  factory.AddKernel(
+      "dispatch_cache_test", key, phi::Kernel(FakeKernelFn, &second_fn));
+  for (auto dtype : {phi::DataType::FLOAT64,
+                     phi::DataType::INT32,
+                     phi::DataType::INT64,
+                     phi::DataType::INT8,
+                     phi::DataType::UINT8,
+                     phi::DataType::BOOL,
+                     phi::DataType::FLOAT16,
+                     phi::DataType::BFLOAT16}) {
+    factory.AddKernel("dispatch_cache_test",
+                      {phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, dtype},
+                      phi::Kernel(FakeKernelFn, &first_fn));
+  }
+  EXPECT_GT(factory.version(), version);
+  auto result = cache.SelectKernelOrThrowError(key);
+  EXPECT_EQ(&result.kernel,
+            &factory.SelectKernelOrThrowError("dispatch_cache_test", key)
+                 .kernel);
+  EXPECT_EQ(result.kernel.GetVariadicKernelFn<int*>(), &second_fn);
+  factory.RemoveKernels("dispatch_cache_test");
+  EXPECT_EQ(factory.kernels().count("dispatch_cache_test"), 0UL);
+  EXPECT_ANY_THROW(cache.SelectKernelOrThrowError(key));
+}
+
 template <typename T, typename Context>
 void TestKernel(const Context& dev_ctx,
                 const DenseTensor& x,
@@ -18,8 +18,13 @@
 
 #ifdef _WIN32
 #include <windows.h>
+#else
+#include <fcntl.h>
 #endif
 
+#include <chrono>
+#include <thread>
+
 namespace phi {
 namespace distributed {
 
@@ -48,5 +53,73 @@ TEST(TCPStore, init) {
     paddle::errors::Fatal("result of add is not right"));
 }
 */
+// A port which is free now, so that tests do not collide on a fixed one.
+uint16_t GetFreePort() {
+  int socket = tcputils::tcp_listen("", std::to_string(0), AF_INET);
+  ::sockaddr_in addr{};
+  ::socklen_t addr_len = sizeof(addr);
+  ::getsockname(socket, reinterpret_cast<::sockaddr*>(&addr), &addr_len);
+  tcputils::close_socket(socket);
+  return ntohs(addr.sin_port);
+}
+
+std::vector<uint8_t> ToBytes(const std::string& s) {
+  return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+TEST(TCPStore, Commands) {
+  uint16_t port = GetFreePort();
+  TCPStore store("127.0.0.1", port, true, 1);
+
+  store.set("key", ToBytes("value"));
+  EXPECT_EQ(store.get("key"), ToBytes("value"));
+  EXPECT_TRUE(store.check("key"));
+  EXPECT_FALSE(store.check("missing"));
+  EXPECT_EQ(store.add("counter", 3), 3);
+  EXPECT_EQ(store.add("counter", 4), 7);
+
+  // compare_set creates a missing key only when expected is empty
+  EXPECT_EQ(store.compare_set("cas", ToBytes("x"), ToBytes("y")),
+            ToBytes("x"));
+  EXPECT_FALSE(store.check("cas"));
+  EXPECT_EQ(store.compare_set("cas", {}, ToBytes("a")), ToBytes("a"));
+  EXPECT_EQ(store.compare_set("cas", ToBytes("b"), ToBytes("c")),
+            ToBytes("a"));
+  EXPECT_EQ(store.compare_set("cas", ToBytes("a"), ToBytes("c")),
+            ToBytes("c"));
+  EXPECT_EQ(store.get("cas"), ToBytes("c"));
+
+  // multi_get waits for the keys set by another client
+  std::thread setter([port] {
+    TCPStore client("127.0.0.1", port, false, 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    client.set("late/0", ToBytes("0"));
+    client.set("late/1", ToBytes("1"));
+  });
+  auto values = store.multi_get({"late/1", "key", "late/0"});
+  setter.join();
+  ASSERT_EQ(values.size(), 3UL);
+  EXPECT_EQ(values[0], ToBytes("1"));
+  EXPECT_EQ(values[1], ToBytes("value"));
+  EXPECT_EQ(values[2], ToBytes("0"));
+}
+
+#ifdef __linux__
+TEST(ReactorMasterDaemon, RefusedConnection) {
+  uint16_t port = GetFreePort();
+  int socket = tcputils::tcp_listen("", std::to_string(port), AF_INET);
+  detail::ReactorMasterDaemon daemon(socket, 1);
+  // epoll refuses a descriptor which does not support poll, the reactor
+  // closes it and goes on
+  int bad_socket = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+  ASSERT_NE(bad_socket, -1);
+  daemon.Dispatch(bad_socket);
+
+  TCPStore store("127.0.0.1", port, false, 1);
+  store.set("key", ToBytes("value"));
+  EXPECT_EQ(store.get("key"), ToBytes("value"));
+}
+#endif
+
 }  // namespace distributed
 }  // namespace phi
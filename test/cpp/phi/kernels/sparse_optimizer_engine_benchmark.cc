@@ -0,0 +1,98 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/selected_rows.h"
+#include "paddle/phi/kernels/funcs/adam_functors.h"
+#include "paddle/phi/kernels/funcs/selected_rows_functor.h"
+#include "test/cpp/phi/kernels/sparse_optimizer_engine_test_helper.h"
+
+namespace phi {
+
+// The lazy update of the rows of grad as before the engine: MergeAdd and
+// then an element by element update on one thread.
+void RunMergeThenUpdateAdam(const AdamState& state,
+                            const SelectedRows& grad,
+                            AdamOutputs* out) {
+  const auto& ctx = GetCPUContext();
+  SelectedRows merged;
+  funcs::scatter::MergeAdd<CPUContext, float> merge_func;
+  merge_func(ctx, grad, &merged, true);
+  const int64_t width = state.param.dims()[1];
+  funcs::SparseAdamFunctor<float, funcs::CPUAdam> functor(
+      0.9f,
+      0.999f,
+      1e-8f,
+      state.beta1_pow.data<float>(),
+      state.beta2_pow.data<float>(),
+      state.moment1.data<float>(),
+      ctx.template Alloc<float>(&out->moment1),
+      state.moment2.data<float>(),
+      ctx.template Alloc<float>(&out->moment2),
+      state.lr.data<float>(),
+      merged.value().data<float>(),
+      state.param.data<float>(),
+      ctx.template Alloc<float>(&out->param),
+      merged.rows().data(),
+      width,
+      merged.rows().size(),
+      true);
+  const float* grad_data = merged.value().data<float>();
+  for (size_t i = 0; i < merged.rows().size(); ++i) {
+    for (int64_t k = 0; k < width; ++k) {
+      functor.adam_update(merged.rows()[i] * width + k,
+                          grad_data[i * width + k]);
+    }
+  }
+}
+
+TEST(Benchmark, SparseAdam) {
+  std::mt19937 engine(3);
+  const int64_t height = 1000000;
+  const int64_t width = 64;
+  AdamState state(height, width, &engine);
+  for (double density : {0.001, 0.01, 0.1}) {
+    SelectedRows grad = MakeGrad(
+        static_cast<int64_t>(height * density), height, width, &engine);
+    // the outputs are allocated once so that both runs write in place
+    AdamOutputs out;
+    for (auto* tensor : {&out.param, &out.moment1, &out.moment2}) {
+      tensor->Resize(state.param.dims());
+      GetCPUContext().template Alloc<float>(tensor);
+    }
+    auto start = std::chrono::steady_clock::now();
+    RunMergeThenUpdateAdam(state, grad, &out);
+    double base_seconds = std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+    start = std::chrono::steady_clock::now();
+    RunSparseAdam(state, grad, true, &out);
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    std::cout << grad.rows().size() << " gradient rows of " << height
+              << ", merge then update: " << base_seconds
+              << " s, engine: " << seconds
+              << " s, speedup: " << base_seconds / seconds << "x"
+              << std::endl;
+  }
+}
+
+}  // namespace phi
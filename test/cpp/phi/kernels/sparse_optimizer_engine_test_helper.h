@@ -0,0 +1,129 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "paddle/phi/backends/context_pool.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/selected_rows.h"
+#include "paddle/phi/kernels/selected_rows/adam_kernel.h"
+
+namespace phi {
+
+inline const CPUContext& GetCPUContext() {
+  return *DeviceContextPool::Instance().GetByPlace(CPUPlace());
+}
+
+inline DenseTensor MakeTensor(const std::vector<int64_t>& dims,
+                              float low,
+                              float high,
+                              std::mt19937* engine) {
+  DenseTensor tensor;
+  tensor.Resize(common::make_ddim(dims));
+  float* data = GetCPUContext().template Alloc<float>(&tensor);
+  std::uniform_real_distribution<float> dist(low, high);
+  for (int64_t i = 0; i < tensor.numel(); ++i) {
+    data[i] = dist(*engine);
+  }
+  return tensor;
+}
+
+// A gradient of num_rows rows drawn from [0, height), with duplicates.
+inline SelectedRows MakeGrad(int64_t num_rows,
+                             int64_t height,
+                             int64_t width,
+                             std::mt19937* engine) {
+  std::uniform_int_distribution<int64_t> dist(0, height - 1);
+  std::vector<int64_t> rows(num_rows);
+  for (auto& row : rows) {
+    row = dist(*engine);
+  }
+  SelectedRows grad(rows, height);
+  *grad.mutable_value() = MakeTensor({num_rows, width}, -1.f, 1.f, engine);
+  return grad;
+}
+
+// Adds the rows of grad to a dense tensor of zeros.
+inline DenseTensor ToDense(const SelectedRows& grad, int64_t width) {
+  DenseTensor dense;
+  dense.Resize(common::make_ddim({grad.height(), width}));
+  float* data = GetCPUContext().template Alloc<float>(&dense);
+  std::fill(data, data + dense.numel(), 0.f);
+  const float* values = grad.value().data<float>();
+  for (size_t i = 0; i < grad.rows().size(); ++i) {
+    for (int64_t k = 0; k < width; ++k) {
+      data[grad.rows()[i] * width + k] += values[i * width + k];
+    }
+  }
+  return dense;
+}
+
+struct AdamState {
+  DenseTensor param, moment1, moment2, lr, beta1_pow, beta2_pow;
+
+  AdamState(int64_t height, int64_t width, std::mt19937* engine)
+      : param(MakeTensor({height, width}, -1.f, 1.f, engine)),
+        moment1(MakeTensor({height, width}, -0.1f, 0.1f, engine)),
+        moment2(MakeTensor({height, width}, 0.f, 0.1f, engine)),
+        lr(MakeTensor({1}, 0.01f, 0.01f, engine)),
+        beta1_pow(MakeTensor({1}, 0.9f, 0.9f, engine)),
+        beta2_pow(MakeTensor({1}, 0.999f, 0.999f, engine)) {}
+};
+
+struct AdamOutputs {
+  DenseTensor param, moment1, moment2, beta1_pow, beta2_pow;
+
+  AdamOutputs() {
+    beta1_pow.Resize({1});
+    beta2_pow.Resize({1});
+  }
+};
+
+inline void RunSparseAdam(const AdamState& state,
+                          const SelectedRows& grad,
+                          bool lazy_mode,
+                          AdamOutputs* out) {
+  out->param.Resize(state.param.dims());
+  out->moment1.Resize(state.param.dims());
+  out->moment2.Resize(state.param.dims());
+  sr::AdamDenseParamSparseGradKernel<float, CPUContext>(GetCPUContext(),
+                                                        state.param,
+                                                        grad,
+                                                        state.lr,
+                                                        state.moment1,
+                                                        state.moment2,
+                                                        state.beta1_pow,
+                                                        state.beta2_pow,
+                                                        paddle::none,
+                                                        paddle::none,
+                                                        0.9f,
+                                                        0.999f,
+                                                        1e-8f,
+                                                        lazy_mode,
+                                                        1000,
+                                                        false,
+                                                        false,
+                                                        &out->param,
+                                                        &out->moment1,
+                                                        &out->moment2,
+                                                        &out->beta1_pow,
+                                                        &out->beta2_pow,
+                                                        nullptr);
+}
+
+}  // namespace phi
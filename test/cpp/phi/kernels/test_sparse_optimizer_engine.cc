@@ -0,0 +1,383 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "paddle/phi/kernels/adam_kernel.h"
+#include "paddle/phi/kernels/adamw_kernel.h"
+#include "paddle/phi/kernels/funcs/sparse_optimizer_engine.h"
+#include "paddle/phi/kernels/lamb_kernel.h"
+#include "paddle/phi/kernels/selected_rows/adamw_kernel.h"
+#include "paddle/phi/kernels/selected_rows/ftrl_kernel.h"
+#include "paddle/phi/kernels/selected_rows/impl/ftrl_kernel_impl.h"
+#include "paddle/phi/kernels/selected_rows/lamb_kernel.h"
+#include "test/cpp/phi/kernels/sparse_optimizer_engine_test_helper.h"
+
+namespace phi {
+
+TEST(SparseOptimizerEngine, MergeRows) {
+  std::mt19937 engine(1);
+  const int64_t height = 1000;
+  const int64_t width = 9;
+  for (int64_t num_rows : {1, 100, 5000}) {
+    SelectedRows grad = MakeGrad(num_rows, height, width, &engine);
+    DenseTensor expected = ToDense(grad, width);
+    const float* expected_data = expected.data<float>();
+
+    funcs::SparseOptimizerEngine<float> sparse_engine(grad, height);
+    EXPECT_EQ(sparse_engine.width(), width);
+    std::vector<float> visited(height * width, 0.f);
+    std::vector<int> counts(height, 0);
+    sparse_engine.ForEachGradRow([&](int64_t row, const float* grad_row) {
+      ++counts[row];
+      std::copy(grad_row, grad_row + width, visited.begin() + row * width);
+    });
+    for (int64_t i = 0; i < height * width; ++i) {
+      EXPECT_NEAR(visited[i], expected_data[i], 1e-5);
+    }
+    for (int64_t row = 0; row < height; ++row) {
+      EXPECT_LE(counts[row], 1);
+    }
+
+    std::fill(counts.begin(), counts.end(), 0);
+    sparse_engine.ForEachParamRow([&](int64_t row, const float* grad_row) {
+      ++counts[row];
+      for (int64_t k = 0; k < width; ++k) {
+        float g = grad_row ? grad_row[k] : 0.f;
+        EXPECT_NEAR(g, expected_data[row * width + k], 1e-5);
+      }
+    });
+    for (int64_t row = 0; row < height; ++row) {
+      EXPECT_EQ(counts[row], 1);
+    }
+  }
+}
+
+TEST(SparseOptimizerEngine, Adam) {
+  std::mt19937 engine(2);
+  const int64_t height = 500;
+  const int64_t width = 37;
+  AdamState state(height, width, &engine);
+  SelectedRows grad = MakeGrad(800, height, width, &engine);
+  DenseTensor dense_grad = ToDense(grad, width);
+
+  // the non-lazy mode matches Adam with the dense gradient
+  AdamOutputs dense_out;
+  dense_out.param.Resize(state.param.dims());
+  dense_out.moment1.Resize(state.param.dims());
+  dense_out.moment2.Resize(state.param.dims());
+  AdamDenseKernel<float, CPUContext>(GetCPUContext(),
+                                     state.param,
+                                     dense_grad,
+                                     state.lr,
+                                     state.moment1,
+                                     state.moment2,
+                                     state.beta1_pow,
+                                     state.beta2_pow,
+                                     paddle::none,
+                                     paddle::none,
+                                     0.9f,
+                                     0.999f,
+                                     1e-8f,
+                                     false,
+                                     1000,
+                                     false,
+                                     false,
+                                     &dense_out.param,
+                                     &dense_out.moment1,
+                                     &dense_out.moment2,
+                                     &dense_out.beta1_pow,
+                                     &dense_out.beta2_pow,
+                                     nullptr);
+  AdamOutputs sparse_out;
+  RunSparseAdam(state, grad, false, &sparse_out);
+  for (int64_t i = 0; i < height * width; ++i) {
+    EXPECT_NEAR(sparse_out.param.data<float>()[i],
+                dense_out.param.data<float>()[i],
+                1e-5);
+    EXPECT_NEAR(sparse_out.moment2.data<float>()[i],
+                dense_out.moment2.data<float>()[i],
+                1e-5);
+  }
+  EXPECT_EQ(sparse_out.beta1_pow.data<float>()[0],
+            dense_out.beta1_pow.data<float>()[0]);
+
+  // the lazy mode only updates the rows with gradient
+  AdamOutputs lazy_out;
+  RunSparseAdam(state, grad, true, &lazy_out);
+  std::vector<bool> has_grad(height, false);
+  for (int64_t row : grad.rows()) {
+    has_grad[row] = true;
+  }
+  for (int64_t row = 0; row < height; ++row) {
+    if (!has_grad[row]) continue;
+    for (int64_t k = 0; k < width; ++k) {
+      EXPECT_NEAR(lazy_out.param.data<float>()[row * width + k],
+                  dense_out.param.data<float>()[row * width + k],
+                  1e-5);
+    }
+  }
+}
+
+// The kernels with an output read back its previous value, so the outputs
+// start as copies of the inputs as when the op runs in place.
+DenseTensor Clone(const DenseTensor& tensor) {
+  DenseTensor copy;
+  copy.Resize(tensor.dims());
+  float* data = GetCPUContext().template Alloc<float>(&copy);
+  std::copy(tensor.data<float>(), tensor.data<float>() + tensor.numel(), data);
+  return copy;
+}
+
+void ExpectNear(const DenseTensor& actual,
+                const DenseTensor& expected,
+                float abs_error) {
+  ASSERT_EQ(actual.numel(), expected.numel());
+  for (int64_t i = 0; i < actual.numel(); ++i) {
+    EXPECT_NEAR(actual.data<float>()[i], expected.data<float>()[i], abs_error)
+        << "at " << i;
+  }
+}
+
+void RunAdamw(const AdamState& state,
+              const SelectedRows* grad,
+              const DenseTensor* dense_grad,
+              bool lazy_mode,
+              AdamOutputs* out) {
+  out->param.Resize(state.param.dims());
+  out->moment1.Resize(state.param.dims());
+  out->moment2.Resize(state.param.dims());
+  if (grad) {
+    sr::AdamwDenseParamSparseGradKernel<float, CPUContext>(GetCPUContext(),
+                                                           state.param,
+                                                           *grad,
+                                                           state.lr,
+                                                           state.moment1,
+                                                           state.moment2,
+                                                           state.beta1_pow,
+                                                           state.beta2_pow,
+                                                           paddle::none,
+                                                           paddle::none,
+                                                           0.9f,
+                                                           0.999f,
+                                                           1e-8f,
+                                                           1.0f,
+                                                           0.01f,
+                                                           true,
+                                                           lazy_mode,
+                                                           1000,
+                                                           false,
+                                                           false,
+                                                           &out->param,
+                                                           &out->moment1,
+                                                           &out->moment2,
+                                                           &out->beta1_pow,
+                                                           &out->beta2_pow,
+                                                           nullptr);
+  } else {
+    AdamwDenseKernel<float, CPUContext>(GetCPUContext(),
+                                        state.param,
+                                        *dense_grad,
+                                        state.lr,
+                                        state.moment1,
+                                        state.moment2,
+                                        state.beta1_pow,
+                                        state.beta2_pow,
+                                        paddle::none,
+                                        paddle::none,
+                                        0.9f,
+                                        0.999f,
+                                        1e-8f,
+                                        1.0f,
+                                        0.01f,
+                                        true,
+                                        false,
+                                        1000,
+                                        false,
+                                        false,
+                                        &out->param,
+                                        &out->moment1,
+                                        &out->moment2,
+                                        &out->beta1_pow,
+                                        &out->beta2_pow,
+                                        nullptr);
+  }
+}
+
+TEST(SparseOptimizerEngine, AdamW) {
+  std::mt19937 engine(4);
+  const int64_t height = 500;
+  const int64_t width = 37;
+  AdamState state(height, width, &engine);
+  SelectedRows grad = MakeGrad(800, height, width, &engine);
+  DenseTensor dense_grad = ToDense(grad, width);
+
+  // the non-lazy mode matches AdamW with the dense gradient, decay included
+  AdamOutputs dense_out;
+  RunAdamw(state, nullptr, &dense_grad, false, &dense_out);
+  AdamOutputs sparse_out;
+  RunAdamw(state, &grad, nullptr, false, &sparse_out);
+  ExpectNear(sparse_out.param, dense_out.param, 1e-5);
+  ExpectNear(sparse_out.moment1, dense_out.moment1, 1e-5);
+  ExpectNear(sparse_out.moment2, dense_out.moment2, 1e-5);
+  EXPECT_EQ(sparse_out.beta2_pow.data<float>()[0],
+            dense_out.beta2_pow.data<float>()[0]);
+
+  // the lazy mode only updates the rows with gradient
+  AdamOutputs lazy_out;
+  RunAdamw(state, &grad, nullptr, true, &lazy_out);
+  std::vector<bool> has_grad(height, false);
+  for (int64_t row : grad.rows()) {
+    has_grad[row] = true;
+  }
+  for (int64_t row = 0; row < height; ++row) {
+    if (!has_grad[row]) continue;
+    for (int64_t k = 0; k < width; ++k) {
+      EXPECT_NEAR(lazy_out.param.data<float>()[row * width + k],
+                  dense_out.param.data<float>()[row * width + k],
+                  1e-5);
+    }
+  }
+}
+
+TEST(SparseOptimizerEngine, Ftrl) {
+  std::mt19937 engine(5);
+  const int64_t height = 300;
+  const int64_t width = 23;
+  DenseTensor param = MakeTensor({height, width}, -1.f, 1.f, &engine);
+  DenseTensor squared = MakeTensor({height, width}, 0.1f, 1.f, &engine);
+  DenseTensor linear = MakeTensor({height, width}, -1.f, 1.f, &engine);
+  DenseTensor lr = MakeTensor({1}, 0.01f, 0.01f, &engine);
+
+  for (float lr_power : {-0.5f, -0.7f}) {
+    SelectedRows grad = MakeGrad(600, height, width, &engine);
+
+    // MergeAdd and then the functor over the merged rows, as before the
+    // engine
+    DenseTensor expected_param = Clone(param);
+    DenseTensor expected_squared = Clone(squared);
+    DenseTensor expected_linear = Clone(linear);
+    sr::FTRLOpKernel<float, CPUContext>(GetCPUContext(),
+                                        param,
+                                        squared,
+                                        linear,
+                                        grad,
+                                        lr,
+                                        0.1f,
+                                        0.2f,
+                                        lr_power,
+                                        &expected_param,
+                                        &expected_squared,
+                                        &expected_linear);
+
+    DenseTensor param_out = Clone(param);
+    DenseTensor squared_out = Clone(squared);
+    DenseTensor linear_out = Clone(linear);
+    sr::FTRLDenseParamSparseGradKernel<float, CPUContext>(GetCPUContext(),
+                                                          param,
+                                                          squared,
+                                                          linear,
+                                                          grad,
+                                                          lr,
+                                                          0.1f,
+                                                          0.2f,
+                                                          lr_power,
+                                                          &param_out,
+                                                          &squared_out,
+                                                          &linear_out);
+    ExpectNear(param_out, expected_param, 1e-5);
+    ExpectNear(squared_out, expected_squared, 1e-5);
+    ExpectNear(linear_out, expected_linear, 1e-5);
+  }
+}
+
+TEST(SparseOptimizerEngine, Lamb) {
+  std::mt19937 engine(6);
+  const int64_t height = 400;
+  const int64_t width = 19;
+  AdamState state(height, width, &engine);
+  SelectedRows grad = MakeGrad(500, height, width, &engine);
+  DenseTensor dense_grad = ToDense(grad, width);
+
+  // Lamb updates every row, so it matches Lamb with the dense gradient
+  for (bool always_adapt : {false, true}) {
+    for (float weight_decay : {0.f, 0.01f}) {
+      AdamOutputs dense_out;
+      dense_out.param.Resize(state.param.dims());
+      dense_out.moment1.Resize(state.param.dims());
+      dense_out.moment2.Resize(state.param.dims());
+      LambKernel<float, CPUContext>(GetCPUContext(),
+                                    state.param,
+                                    dense_grad,
+                                    state.lr,
+                                    state.moment1,
+                                    state.moment2,
+                                    state.beta1_pow,
+                                    state.beta2_pow,
+                                    paddle::none,
+                                    paddle::none,
+                                    weight_decay,
+                                    0.9f,
+                                    0.999f,
+                                    1e-6f,
+                                    always_adapt,
+                                    false,
+                                    &dense_out.param,
+                                    &dense_out.moment1,
+                                    &dense_out.moment2,
+                                    &dense_out.beta1_pow,
+                                    &dense_out.beta2_pow,
+                                    nullptr);
+
+      AdamOutputs sparse_out;
+      sparse_out.param.Resize(state.param.dims());
+      sparse_out.moment1.Resize(state.param.dims());
+      sparse_out.moment2.Resize(state.param.dims());
+      sr::LambDenseParamSparseGradKernel<float, CPUContext>(
+          GetCPUContext(),
+          state.param,
+          grad,
+          state.lr,
+          state.moment1,
+          state.moment2,
+          state.beta1_pow,
+          state.beta2_pow,
+          paddle::none,
+          paddle::none,
+          weight_decay,
+          0.9f,
+          0.999f,
+          1e-6f,
+          always_adapt,
+          false,
+          &sparse_out.param,
+          &sparse_out.moment1,
+          &sparse_out.moment2,
+          &sparse_out.beta1_pow,
+          &sparse_out.beta2_pow,
+          nullptr);
+      ExpectNear(sparse_out.param, dense_out.param, 1e-5);
+      ExpectNear(sparse_out.moment1, dense_out.moment1, 1e-5);
+      ExpectNear(sparse_out.moment2, dense_out.moment2, 1e-5);
+      EXPECT_EQ(sparse_out.beta1_pow.data<float>()[0],
+                dense_out.beta1_pow.data<float>()[0]);
+    }
+  }
+}
+
+}  // namespace phi
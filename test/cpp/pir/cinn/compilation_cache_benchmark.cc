@@ -0,0 +1,110 @@
+// Copyright (c) 2026 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "paddle/cinn/hlir/dialect/operator/ir/op_dialect.h"
+#include "paddle/cinn/hlir/framework/pir/compilation_cache.h"
+#include "paddle/cinn/hlir/framework/pir/persistent_compilation_cache.h"
+#include "paddle/cinn/hlir/framework/pir/utils.h"
+#include "paddle/cinn/hlir/framework/pir_compiler.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
+#include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
+#include "paddle/pir/include/core/ir_context.h"
+#include "paddle/pir/include/core/program.h"
+
+PD_DECLARE_string(cinn_compilation_cache_dir);
+PD_DECLARE_bool(enable_cinn_compile_cache);
+
+using cinn::hlir::framework::PersistentCompilationCache;
+using cinn::hlir::framework::pir::CompatibleInfo;
+using cinn::hlir::framework::pir::OpLoweringGroup;
+using cinn::hlir::framework::pir::OpLoweringGroupPtr;
+
+using ProgramInfo = std::tuple<std::shared_ptr<::pir::Program>,
+                               std::vector<OpLoweringGroupPtr>>;
+ProgramInfo BuildProgram(int num_groups) {
+  ::pir::IrContext* ctx = ::pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<cinn::dialect::OperatorDialect>();
+  auto program = std::make_shared<::pir::Program>(ctx);
+  ::pir::Builder builder = ::pir::Builder(ctx, program->block());
+
+  std::vector<OpLoweringGroupPtr> groups;
+  for (int i = 0; i < num_groups; ++i) {
+    // a shape per group, so that no two groups share a kernel
+    auto full_op = builder.Build<paddle::dialect::FullOp>(
+        std::vector<int64_t>{64, 128 + i},
+        1.0,
+        phi::DataType::FLOAT32,
+        phi::GPUPlace());
+    auto exp_op = builder.Build<paddle::dialect::ExpOp>(full_op.result(0));
+    const auto ops = std::initializer_list<::pir::Operation*>(
+        {full_op.operation(), exp_op.operation()});
+    groups.emplace_back(std::make_shared<OpLoweringGroup>(
+        ops, CompatibleInfo::GroupOpsName(ops)));
+    groups.back()->mut_output_values().push_back(exp_op.result(0));
+  }
+  return {program, groups};
+}
+
+// Compiles the same groups twice. The second build starts with an empty
+// in-memory cache, as a new process does, and loads every kernel from the
+// directory that the first build filled.
+TEST(Benchmark, CinnCompilationWarmStart) {
+  char dir_template[] = "/tmp/cinn_compilation_cache_XXXXXX";
+  ASSERT_NE(mkdtemp(dir_template), nullptr);
+  FLAGS_cinn_compilation_cache_dir = dir_template;
+  FLAGS_enable_cinn_compile_cache = true;
+  auto& persistent_cache = PersistentCompilationCache::Instance();
+  auto& compilation_cache =
+      cinn::hlir::framework::CompilationCache::Instance();
+  const int num_groups = 16;
+  auto target = cinn::common::DefaultNVGPUTarget();
+
+  double seconds[2];
+  PersistentCompilationCache::Stats stats[2];
+  for (int run = 0; run < 2; ++run) {
+    compilation_cache.Clear();
+    persistent_cache.ResetStats();
+    auto prog_info = BuildProgram(num_groups);
+    cinn::hlir::framework::PirCompiler ir_compiler(target);
+    auto start = std::chrono::steady_clock::now();
+    auto kernel_infos = ir_compiler.Build(std::get<1>(prog_info));
+    seconds[run] = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    stats[run] = persistent_cache.GetStats();
+    ASSERT_EQ(kernel_infos.size(), static_cast<size_t>(num_groups));
+    for (const auto& kernel_info : kernel_infos) {
+      EXPECT_NE(kernel_info.fn_ptr, nullptr);
+    }
+  }
+  EXPECT_EQ(stats[0].hits, 0u);
+  EXPECT_EQ(stats[0].stores, static_cast<uint64_t>(num_groups));
+  EXPECT_EQ(stats[1].hits, static_cast<uint64_t>(num_groups));
+  EXPECT_EQ(stats[1].errors, 0u);
+  LOG(INFO) << num_groups << " groups, cold start: " << seconds[0]
+            << " s, warm start: " << seconds[1]
+            << " s, speedup: " << seconds[0] / seconds[1] << "x";
+  FLAGS_cinn_compilation_cache_dir = "";
+}
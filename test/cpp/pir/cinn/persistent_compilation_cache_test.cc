@@ -0,0 +1,146 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "paddle/cinn/hlir/dialect/operator/ir/op_dialect.h"
+#include "paddle/cinn/hlir/framework/pir/compilation_cache.h"
+#include "paddle/cinn/hlir/framework/pir/persistent_compilation_cache.h"
+#include "paddle/cinn/hlir/framework/pir/utils.h"
+#include "paddle/cinn/hlir/framework/pir_compiler.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
+#include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
+#include "paddle/pir/include/core/ir_context.h"
+#include "paddle/pir/include/core/program.h"
+
+PD_DECLARE_string(cinn_compilation_cache_dir);
+PD_DECLARE_bool(enable_cinn_compile_cache);
+PD_DECLARE_bool(cinn_use_cuda_vectorize);
+
+using cinn::hlir::framework::DecodePersistentCacheEntry;
+using cinn::hlir::framework::EncodePersistentCacheEntry;
+using cinn::hlir::framework::PersistentCacheEntry;
+using cinn::hlir::framework::PersistentCompilationCache;
+using cinn::hlir::framework::pir::CompatibleInfo;
+using cinn::hlir::framework::pir::OpLoweringGroup;
+using cinn::hlir::framework::pir::OpLoweringGroupPtr;
+
+PersistentCacheEntry MakeEntry() {
+  PersistentCacheEntry entry;
+  entry.key = "version: x86\nfusion_op_0";
+  entry.host_fn_name = "fn_full_0";
+  entry.infer_fn_name = "fn_full_0_infer_shape";
+  entry.int_args_map[2] = {0, 1};
+  entry.int_args_map[3] = {-1, 7};
+  entry.code.host_object = std::string("\x7f" "ELF\0\0\1", 7);
+  entry.code.device_code = "// ptx";
+  entry.code.device_code_is_cubin = true;
+  entry.code.device_fn_names = {"fn_full_0_kernel", "fn_full_1_kernel"};
+  return entry;
+}
+
+TEST(PersistentCompilationCache, EncodeDecode) {
+  const PersistentCacheEntry entry = MakeEntry();
+  PersistentCacheEntry decoded;
+  ASSERT_TRUE(
+      DecodePersistentCacheEntry(EncodePersistentCacheEntry(entry), &decoded));
+  EXPECT_EQ(decoded.key, entry.key);
+  EXPECT_EQ(decoded.host_fn_name, entry.host_fn_name);
+  EXPECT_EQ(decoded.infer_fn_name, entry.infer_fn_name);
+  ASSERT_EQ(decoded.int_args_map.size(), 2u);
+  EXPECT_EQ(decoded.int_args_map[3].arg_idx, -1);
+  EXPECT_EQ(decoded.int_args_map[3].dim_idx, 7);
+  EXPECT_EQ(decoded.code.host_object, entry.code.host_object);
+  EXPECT_EQ(decoded.code.device_code, entry.code.device_code);
+  EXPECT_TRUE(decoded.code.device_code_is_cubin);
+  EXPECT_EQ(decoded.code.device_fn_names, entry.code.device_fn_names);
+}
+
+TEST(PersistentCompilationCache, RejectCorruptedEntry) {
+  const std::string data = EncodePersistentCacheEntry(MakeEntry());
+  PersistentCacheEntry decoded;
+  for (size_t size = 0; size < data.size(); ++size) {
+    EXPECT_FALSE(DecodePersistentCacheEntry(data.substr(0, size), &decoded));
+  }
+  EXPECT_FALSE(DecodePersistentCacheEntry(data + "x", &decoded));
+  std::string bad_magic = data;
+  bad_magic[0] = 'X';
+  EXPECT_FALSE(DecodePersistentCacheEntry(bad_magic, &decoded));
+}
+
+using ProgramInfo = std::tuple<std::shared_ptr<::pir::Program>,
+                               std::vector<OpLoweringGroupPtr>>;
+ProgramInfo BuildProgram(int num_groups) {
+  ::pir::IrContext* ctx = ::pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<cinn::dialect::OperatorDialect>();
+  auto program = std::make_shared<::pir::Program>(ctx);
+  ::pir::Builder builder = ::pir::Builder(ctx, program->block());
+
+  std::vector<OpLoweringGroupPtr> groups;
+  for (int i = 0; i < num_groups; ++i) {
+    // a shape per group, so that no two groups share a kernel
+    auto full_op = builder.Build<paddle::dialect::FullOp>(
+        std::vector<int64_t>{64, 128 + i},
+        1.0,
+        phi::DataType::FLOAT32,
+        phi::GPUPlace());
+    auto exp_op = builder.Build<paddle::dialect::ExpOp>(full_op.result(0));
+    const auto ops = std::initializer_list<::pir::Operation*>(
+        {full_op.operation(), exp_op.operation()});
+    groups.emplace_back(std::make_shared<OpLoweringGroup>(
+        ops, CompatibleInfo::GroupOpsName(ops)));
+    groups.back()->mut_output_values().push_back(exp_op.result(0));
+  }
+  return {program, groups};
+}
+
+// An entry lowered under other codegen flags must not be reused.
+TEST(PersistentCompilationCache, FlagsChangeKey) {
+  char dir_template[] = "/tmp/cinn_compilation_cache_XXXXXX";
+  ASSERT_NE(mkdtemp(dir_template), nullptr);
+  FLAGS_cinn_compilation_cache_dir = dir_template;
+  FLAGS_enable_cinn_compile_cache = true;
+  auto& persistent_cache = PersistentCompilationCache::Instance();
+  auto& compilation_cache =
+      cinn::hlir::framework::CompilationCache::Instance();
+  const int num_groups = 2;
+  auto target = cinn::common::DefaultNVGPUTarget();
+  const bool vectorize = FLAGS_cinn_use_cuda_vectorize;
+
+  PersistentCompilationCache::Stats stats[3];
+  for (int run = 0; run < 3; ++run) {
+    // the last run restores the flag and hits the first run's entries
+    FLAGS_cinn_use_cuda_vectorize = (run == 1) != vectorize;
+    compilation_cache.Clear();
+    persistent_cache.ResetStats();
+    auto prog_info = BuildProgram(num_groups);
+    cinn::hlir::framework::PirCompiler ir_compiler(target);
+    ir_compiler.Build(std::get<1>(prog_info));
+    stats[run] = persistent_cache.GetStats();
+  }
+  FLAGS_cinn_use_cuda_vectorize = vectorize;
+  EXPECT_EQ(stats[0].hits, 0u);
+  EXPECT_EQ(stats[1].hits, 0u);
+  EXPECT_EQ(stats[1].stores, static_cast<uint64_t>(num_groups));
+  EXPECT_EQ(stats[2].hits, static_cast<uint64_t>(num_groups));
+  FLAGS_cinn_compilation_cache_dir = "";
+}
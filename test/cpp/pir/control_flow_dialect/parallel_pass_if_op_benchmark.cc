@@ -0,0 +1,107 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "paddle/fluid/pir/dialect/operator/ir/control_flow_op.h"
+#include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
+#include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
+#include "paddle/fluid/pir/transforms/general/identity_op_clean_pass.h"
+#include "paddle/fluid/pir/transforms/general/remove_redundant_transpose_pass.h"
+#include "paddle/pir/include/core/program.h"
+#include "paddle/pir/include/dialect/control_flow/ir/cf_dialect.h"
+#include "paddle/pir/include/dialect/control_flow/ir/cf_op.h"
+#include "paddle/pir/include/pass/pass_manager.h"
+
+using namespace paddle::dialect;  // NOLINT
+
+// Fills a branch of an if op with `depth` pairs of transposes of `x`, a
+// value of the enclosing block.
+void BuildBranch(pir::Builder* builder,
+                 pir::Block* block,
+                 pir::Value x,
+                 int depth) {
+  builder->SetInsertionPointToStart(block);
+  for (int i = 0; i < depth; ++i) {
+    x = builder->Build<TransposeOp>(x, std::vector<int>{1, 0}).out();
+    x = builder->Build<TransposeOp>(x, std::vector<int>{1, 0}).out();
+  }
+  builder->Build<pir::YieldOp>(std::vector<pir::Value>{x});
+}
+
+// A block of `num_ifs` if ops, each reading its own input from the block.
+void BuildProgram(pir::Program* program, int num_ifs, int depth) {
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Builder builder(ctx, program->block());
+  auto y = builder.Build<FullOp>(std::vector<int64_t>{64, 64}, 2.0f).out();
+  for (int i = 0; i < num_ifs; ++i) {
+    builder.SetInsertionPointToBlockEnd(program->block());
+    auto x = builder
+                 .Build<FullOp>(std::vector<int64_t>{64, 64},
+                                static_cast<float>(i))
+                 .out();
+    auto cond = builder.Build<LessThanOp>(x, y).out();
+    auto if_op = builder.Build<IfOp>(cond, std::vector<pir::Type>{x.type()});
+    BuildBranch(&builder, &if_op.true_block(), x, depth);
+    BuildBranch(&builder, &if_op.false_block(), x, depth);
+  }
+}
+
+size_t CountTransposes(pir::Program* program) {
+  size_t count = 0;
+  for (auto& op : *program->block()) {
+    for (auto& block : op.blocks()) {
+      for (auto& inner_op : block) {
+        count += inner_op.isa<TransposeOp>();
+      }
+    }
+  }
+  return count;
+}
+
+TEST(Benchmark, ParallelPassManagerIfOp) {
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<OperatorDialect>();
+  ctx->GetOrRegisterDialect<pir::ControlFlowDialect>();
+  const int num_ifs = 256;
+  const int depth = 64;
+
+  double base_seconds = 0;
+  size_t base_transposes = 0;
+  for (int num_threads : {1, 2, 4, 8}) {
+    pir::Program program(ctx);
+    BuildProgram(&program, num_ifs, depth);
+    pir::PassManager pm(ctx);
+    pm.AddPass(pir::CreateIdentityOpCleanPass());
+    pm.AddPass(pir::CreateRemoveRedundantTransposePass());
+    pm.EnableParallelExecution(num_threads);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(pm.Run(&program));
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    if (num_threads == 1) {
+      base_seconds = seconds;
+      base_transposes = CountTransposes(&program);
+    }
+    EXPECT_EQ(CountTransposes(&program), base_transposes);
+    std::cout << num_ifs << " if ops, " << num_threads
+              << " threads: " << seconds
+              << " s, speedup: " << base_seconds / seconds << "x"
+              << std::endl;
+  }
+}
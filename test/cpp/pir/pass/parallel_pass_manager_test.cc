@@ -0,0 +1,300 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "paddle/pir/include/core/builder.h"
+#include "paddle/pir/include/core/builtin_attribute.h"
+#include "paddle/pir/include/core/builtin_dialect.h"
+#include "paddle/pir/include/core/builtin_op.h"
+#include "paddle/pir/include/core/builtin_type.h"
+#include "paddle/pir/include/core/ir_context.h"
+#include "paddle/pir/include/core/program.h"
+#include "paddle/pir/include/pass/pass.h"
+#include "paddle/pir/include/pass/pass_manager.h"
+#include "paddle/pir/include/pattern_rewrite/pattern_match.h"
+#include "test/cpp/pir/tools/test_dialect.h"
+#include "test/cpp/pir/tools/test_op.h"
+
+// Halves float constants until they are below one, which creates an
+// attribute and an operation per rewrite.
+class HalveConstantPattern : public pir::OpRewritePattern<pir::ConstantOp> {
+ public:
+  using pir::OpRewritePattern<pir::ConstantOp>::OpRewritePattern;
+
+  bool MatchAndRewrite(
+      pir::ConstantOp op,
+      pir::PatternRewriter &rewriter) const override {  // NOLINT
+    auto value = op.value().dyn_cast<pir::FloatAttribute>();
+    if (!value || value.data() < 1.0f) return false;
+    rewriter.ReplaceOpWithNewOp<pir::ConstantOp>(
+        op,
+        rewriter.float_attr(value.data() / 2),
+        op->result(0).type());
+    return true;
+  }
+};
+
+class EraseDeadCombinePattern : public pir::OpRewritePattern<pir::CombineOp> {
+ public:
+  using pir::OpRewritePattern<pir::CombineOp>::OpRewritePattern;
+
+  bool MatchAndRewrite(
+      pir::CombineOp op,
+      pir::PatternRewriter &rewriter) const override {  // NOLINT
+    if (!op->result(0).use_empty()) return false;
+    rewriter.EraseOp(op);
+    return true;
+  }
+};
+
+class FoldPass : public pir::PatternRewritePass {
+ public:
+  explicit FoldPass(bool region_local)
+      : pir::PatternRewritePass("fold_pass", 1), region_local_(region_local) {}
+
+  pir::RewritePatternSet InitializePatterns(pir::IrContext *context) override {
+    pir::RewritePatternSet ps(context);
+    ps.Add<HalveConstantPattern>(context);
+    ps.Add<EraseDeadCombinePattern>(context);
+    return ps;
+  }
+
+  bool CanApplyOn(pir::Operation *op) const override {
+    return op->num_regions() > 0;
+  }
+
+  bool IsRegionLocal() const override { return region_local_; }
+
+ private:
+  bool region_local_;
+};
+
+class ThreadRecordingPass : public pir::Pass {
+ public:
+  ThreadRecordingPass(bool region_local, std::set<std::thread::id> *threads)
+      : pir::Pass("thread_recording_pass", 1),
+        region_local_(region_local),
+        threads_(threads) {}
+
+  void Run(pir::Operation *op) override {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      threads_->insert(std::this_thread::get_id());
+    }
+    // lets the other threads take a region
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  bool IsRegionLocal() const override { return region_local_; }
+
+ private:
+  bool region_local_;
+  std::mutex mutex_;
+  std::set<std::thread::id> *threads_;
+};
+
+// Builds `num_regions` region ops of `region_size` constants and combines of
+// them. If `shared`, the even regions also combine a constant of the module.
+// If `captured`, each region also combines a constant of its own defined in
+// the module, as the body of a control flow op uses its inputs.
+void BuildProgram(pir::Program *program,
+                  int num_regions,
+                  int region_size,
+                  bool shared,
+                  bool captured = false) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  pir::Builder builder(ctx, program->block());
+  pir::Type type = builder.float32_type();
+  pir::Value outer = builder.Build<pir::ConstantOp>(
+      builder.float_attr(1.0f), type)->result(0);
+  for (int i = 0; i < num_regions; ++i) {
+    pir::Value input;
+    if (captured) {
+      input = builder.Build<pir::ConstantOp>(builder.float_attr(0.5f), type)
+                  ->result(0);
+    }
+    auto region_op = builder.Build<test::RegionOp>();
+    auto &block = region_op->region(0).emplace_back();
+    pir::Builder inner_builder(ctx, &block);
+    std::vector<pir::Value> values;
+    for (int j = 0; j < region_size; ++j) {
+      float value = static_cast<float>(1 << ((i + j) % 8));
+      values.push_back(inner_builder
+                           .Build<pir::ConstantOp>(
+                               inner_builder.float_attr(value), type)
+                           ->result(0));
+      if (j > 0) {
+        inner_builder.Build<pir::CombineOp>(
+            std::vector<pir::Value>{values[j - 1], values[j]});
+      }
+    }
+    if (shared && i % 2 == 0) {
+      inner_builder.Build<pir::CombineOp>(
+          std::vector<pir::Value>{outer, values[0]});
+    }
+    if (captured) {
+      inner_builder.Build<pir::CombineOp>(
+          std::vector<pir::Value>{input, values[0]});
+    }
+  }
+}
+
+std::string Summarize(pir::Program *program) {
+  std::ostringstream os;
+  for (auto &op : *program->block()) {
+    os << op.name() << "{";
+    for (size_t i = 0; i < op.num_regions(); ++i) {
+      for (auto &block : op.region(i)) {
+        for (auto &inner_op : block) {
+          os << inner_op.name();
+          if (auto constant = inner_op.dyn_cast<pir::ConstantOp>()) {
+            os << "="
+               << constant.value().dyn_cast<pir::FloatAttribute>().data();
+          }
+          os << ";";
+        }
+      }
+    }
+    os << "}\n";
+  }
+  return os.str();
+}
+
+std::string RunFoldPass(int num_threads,
+                        bool region_local,
+                        int num_regions,
+                        int region_size,
+                        bool shared,
+                        double *seconds = nullptr,
+                        bool captured = false) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<pir::BuiltinDialect>();
+  ctx->GetOrRegisterDialect<test::TestDialect>();
+  pir::Program program(ctx);
+  BuildProgram(&program, num_regions, region_size, shared, captured);
+
+  pir::PassManager pm(ctx);
+  pm.AddPass(std::make_unique<FoldPass>(region_local));
+  pm.EnableParallelExecution(num_threads);
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(pm.Run(&program));
+  if (seconds) {
+    *seconds = std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+  }
+  return Summarize(&program);
+}
+
+TEST(parallel_pass_manager, SameResultAsSequential) {
+  const std::string expected = RunFoldPass(0, true, 64, 32, false);
+  EXPECT_EQ(expected.find("builtin.combine"), std::string::npos);
+  EXPECT_EQ(expected.find("builtin.constant=1;"), std::string::npos);
+  for (int num_threads : {2, 4, 8}) {
+    EXPECT_EQ(RunFoldPass(num_threads, true, 64, 32, false), expected);
+  }
+}
+
+TEST(parallel_pass_manager, SharedValues) {
+  // Regions using the same value of the module run on one thread.
+  const std::string expected = RunFoldPass(0, true, 64, 32, true);
+  EXPECT_EQ(RunFoldPass(4, true, 64, 32, true), expected);
+  // A pass that is not region-local never runs in parallel.
+  EXPECT_EQ(RunFoldPass(4, false, 64, 32, true), expected);
+}
+
+TEST(parallel_pass_manager, CapturedValues) {
+  // The passes on the regions erase the uses of the constants they capture.
+  const std::string expected =
+      RunFoldPass(0, true, 64, 32, false, nullptr, true);
+  for (int num_threads : {2, 4, 8}) {
+    EXPECT_EQ(RunFoldPass(num_threads, true, 64, 32, false, nullptr, true),
+              expected);
+    EXPECT_EQ(RunFoldPass(num_threads, true, 64, 32, true, nullptr, true),
+              RunFoldPass(0, true, 64, 32, true, nullptr, true));
+  }
+}
+
+std::set<std::thread::id> RecordThreads(bool region_local,
+                                        bool shared,
+                                        bool captured) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<pir::BuiltinDialect>();
+  ctx->GetOrRegisterDialect<test::TestDialect>();
+  pir::Program program(ctx);
+  BuildProgram(&program, 64, 4, shared, captured);
+  std::set<std::thread::id> threads;
+  pir::PassManager pm(ctx);
+  pm.AddPass(std::make_unique<ThreadRecordingPass>(region_local, &threads));
+  pm.EnableParallelExecution(4);
+  EXPECT_TRUE(pm.Run(&program));
+  return threads;
+}
+
+TEST(parallel_pass_manager, RunsOnThreads) {
+  EXPECT_GT(RecordThreads(true, false, false).size(), 1u);
+  EXPECT_GT(RecordThreads(true, false, true).size(), 1u);
+  EXPECT_EQ(RecordThreads(false, false, false).size(), 1u);
+  // every region uses the constant of the module
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  pir::Program program(ctx);
+  BuildProgram(&program, 64, 4, false);
+  pir::Value outer = program.block()->front().result(0);
+  for (auto &op : *program.block()) {
+    if (op.num_regions() == 0) continue;
+    pir::Builder inner_builder(ctx, &op.region(0).front());
+    inner_builder.Build<pir::CombineOp>(std::vector<pir::Value>{outer});
+  }
+  std::set<std::thread::id> threads;
+  pir::PassManager pm(ctx);
+  pm.AddPass(std::make_unique<ThreadRecordingPass>(true, &threads));
+  pm.EnableParallelExecution(4);
+  EXPECT_TRUE(pm.Run(&program));
+  EXPECT_EQ(threads.size(), 1u);
+}
+
+// Takes seconds and prints timings, so it only runs when asked with
+// --gtest_also_run_disabled_tests.
+TEST(Benchmark, DISABLED_ParallelPassManager) {
+  const int num_regions = 512;
+  const int region_size = 256;
+  double base_seconds = 0;
+  const std::string expected =
+      RunFoldPass(0, true, num_regions, region_size, false, &base_seconds);
+  std::cout << num_regions << " regions of " << region_size
+            << " constants, sequential: " << base_seconds << " s" << std::endl;
+  for (int num_threads : {2, 4, 8}) {
+    double seconds = 0;
+    EXPECT_EQ(RunFoldPass(num_threads,
+                          true,
+                          num_regions,
+                          region_size,
+                          false,
+                          &seconds),
+              expected);
+    std::cout << num_threads << " threads: " << seconds
+              << " s, speedup: " << base_seconds / seconds << "x"
+              << std::endl;
+  }
+}
@@ -0,0 +1,80 @@
+# Copyright (c) 2026 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import unittest
+
+import numpy as np
+
+import paddle
+import paddle.distributed as dist
+from paddle.nn import Linear
+
+batch = 8
+in_dim = 64
+out_dim = 256
+num_layers = 6
+
+
+def make_input(rank, step_id):
+    rng = np.random.RandomState(rank * 100 + step_id)
+    return rng.rand(batch, in_dim).astype('float32')
+
+
+class MultiLinearNet(paddle.nn.Layer):
+    def __init__(self):
+        super().__init__()
+        self.layers = paddle.nn.LayerList(
+            [Linear(in_dim, out_dim) for _ in range(num_layers)]
+        )
+
+    def forward(self, x):
+        return paddle.add_n([layer(x).sum() for layer in self.layers])
+
+
+class TestGlooAllReduceGradient(unittest.TestCase):
+    def test_reduced_gradient(self):
+        # Small buckets so that the fused gradients of one backward are
+        # reduced by several background all-reduces.
+        paddle.set_flags({'FLAGS_gloo_allreduce_bucket_size_mb': 1})
+        rank = dist.get_rank()
+        nranks = dist.get_world_size()
+        pg = dist.init_parallel_env()
+
+        paddle.seed(1024)
+        model = paddle.DataParallel(MultiLinearNet(), group=pg)
+
+        for step_id in range(3):
+            x = paddle.to_tensor(make_input(rank, step_id))
+            model(x).backward()
+
+            # d(sum(x @ w + b)) / dw = x^T @ 1, averaged over the ranks.
+            mean_x = np.mean(
+                [make_input(r, step_id) for r in range(nranks)], axis=0
+            )
+            expected_w = np.repeat(
+                mean_x.sum(axis=0, keepdims=True).T, out_dim, axis=1
+            )
+            expected_b = np.full([out_dim], batch, dtype='float32')
+            for layer in model._layers.layers:
+                np.testing.assert_allclose(
+                    layer.weight.grad.numpy(), expected_w, rtol=1e-5
+                )
+                np.testing.assert_allclose(
+                    layer.bias.grad.numpy(), expected_b, rtol=1e-5
+                )
+            model.clear_gradients()
+
+
+if __name__ == '__main__':
+    unittest.main()
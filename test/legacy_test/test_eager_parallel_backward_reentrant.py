@@ -0,0 +1,104 @@
+# Copyright (c) 2026 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import unittest
+
+import numpy as np
+
+import paddle
+from paddle.autograd.py_layer import PyLayer
+from paddle.distributed.fleet.utils import recompute
+
+
+class InnerBackward(PyLayer):
+    # Runs a whole backward pass from inside the backward of the outer one.
+    @staticmethod
+    def forward(ctx, x):
+        ctx.save_for_backward(x)
+        return paddle.tanh(x)
+
+    @staticmethod
+    def backward(ctx, dy):
+        (x,) = ctx.saved_tensor()
+        with paddle.enable_grad():
+            x = x.detach()
+            x.stop_gradient = False
+            y = paddle.tanh(x)
+            paddle.autograd.backward([y], [dy])
+        return x.grad
+
+
+class Block(paddle.nn.Layer):
+    def __init__(self):
+        super().__init__()
+        self.linear1 = paddle.nn.Linear(16, 16)
+        self.linear2 = paddle.nn.Linear(16, 16)
+
+    def forward(self, x):
+        return self.linear2(paddle.nn.functional.relu(self.linear1(x)))
+
+
+class TestParallelBackwardReentrant(unittest.TestCase):
+    def setUp(self):
+        paddle.disable_static()
+        self.threads = paddle.get_flags(
+            ['FLAGS_eager_parallel_backward_threads']
+        )['FLAGS_eager_parallel_backward_threads']
+
+    def tearDown(self):
+        paddle.set_flags(
+            {'FLAGS_eager_parallel_backward_threads': self.threads}
+        )
+
+    def run_pylayer(self, threads):
+        paddle.set_flags({'FLAGS_eager_parallel_backward_threads': threads})
+        paddle.seed(2026)
+        xs = [paddle.randn([4, 16]) for _ in range(4)]
+        for x in xs:
+            x.stop_gradient = False
+        # several independent branches so the outer pass runs the inner
+        # backwards on different threads at the same time
+        loss = paddle.add_n([InnerBackward.apply(x * 2.0).sum() for x in xs])
+        loss.backward()
+        return [x.grad.numpy() for x in xs]
+
+    def run_recompute(self, threads):
+        paddle.set_flags({'FLAGS_eager_parallel_backward_threads': threads})
+        paddle.seed(2026)
+        blocks = paddle.nn.LayerList([Block() for _ in range(4)])
+        x = paddle.randn([8, 16])
+        x.stop_gradient = False
+        loss = paddle.add_n(
+            [recompute(block, x, use_reentrant=True).sum() for block in blocks]
+        )
+        loss.backward()
+        grads = [x.grad.numpy()]
+        grads += [p.grad.numpy() for p in blocks.parameters()]
+        return grads
+
+    def check(self, run):
+        expected = run(0)
+        actual = run(4)
+        for e, a in zip(expected, actual):
+            np.testing.assert_allclose(a, e, rtol=1e-6, atol=1e-6)
+
+    def test_pylayer(self):
+        self.check(self.run_pylayer)
+
+    def test_recompute(self):
+        self.check(self.run_recompute)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -138,5 +138,10 @@ class TestDataParallelGradientCheckInEagerMode(TestMultipleGpus):
         self.run_mnist_2gpu('parallel_dygraph_gradient_check_in_eager_mode.py')
 
 
+class TestDataParallelGlooAllReduceGradient(TestMultipleGpus):
+    def test_multiple_gpus_dynamic(self):
+        self.run_mnist_2gpu('parallel_dygraph_gloo_allreduce_gradient.py')
+
+
 if __name__ == "__main__":
     unittest.main()